@@ -0,0 +1,29 @@
+@echo off
+rem Builds the tests and benchmarks into .\build. Run it from a Visual Studio command prompt in this directory.
+rem "build.bat test" also runs the tests once they're built. The benchmarks are run by hand since they take a while.
+
+setlocal
+
+set TESTS=crc64_test decode_esedb_test entry_checksums_test uncompress_text_test
+set BENCHMARKS=crc64_benchmark entry_checksums_benchmark find_signature_benchmark thumbcache_benchmark uncompress_text_benchmark
+
+if not exist build mkdir build
+
+for %%p in (%TESTS% %BENCHMARKS%) do (
+	cl /nologo /O2 /EHsc /W3 /D_CRT_SECURE_NO_WARNINGS /Fobuild\%%p.obj /Febuild\%%p.exe %%p.cpp || goto failed
+)
+
+if /i not "%1" == "test" goto done
+
+for %%p in (%TESTS%) do (
+	echo %%p
+	build\%%p.exe || goto failed
+)
+
+:done
+echo Done.
+exit /b 0
+
+:failed
+echo Failed.
+exit /b 1
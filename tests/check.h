@@ -0,0 +1,88 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+// Shared by the tests and benchmarks in this directory. Each of them is a single file that build.bat compiles into its own program.
+
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+// Only the first few failures are printed. The rest are usually the same mistake.
+#define MAX_REPORTED_FAILURES	10
+
+static unsigned int g_checks = 0;
+static unsigned int g_failures = 0;
+
+// Counts a check and prints the message if it failed. Returns passed.
+static bool Check( bool passed, const char *format, ... )
+{
+	++g_checks;
+
+	if ( !passed )
+	{
+		if ( g_failures < MAX_REPORTED_FAILURES )
+		{
+			va_list args;
+			va_start( args, format );
+			vprintf( format, args );
+			va_end( args );
+
+			printf( "\n" );
+		}
+
+		++g_failures;
+	}
+
+	return passed;
+}
+
+// Prints the number of checks and failures. Returns the exit code of the program.
+static int FinishChecks()
+{
+	printf( "%u checks, %u failures.\n", g_checks, g_failures );
+	printf( ( g_failures == 0 ? "Passed.\n" : "Failed.\n" ) );
+
+	return ( g_failures == 0 ? 0 : 1 );
+}
+
+// Returns the time in seconds from an arbitrary starting point.
+static double GetSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+
+	return ( double )counter.QuadPart / ( double )frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( double )ts.tv_sec + ( double )ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures the throughput of each CRC-64 kernel.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/crc64.cpp"
+
+#include <stdlib.h>
+
+// Every run checksums this many bytes in total, whatever the buffer size.
+#define BYTES_PER_RUN	( 256 * 1024 * 1024 )
+
+// 1024 bytes is what GetDataChecksum() checksums in full. Anything under 64 bytes never reaches the PCLMULQDQ loop.
+static const unsigned int buffer_sizes[] = { 48, 1024, 64 * 1024, 1024 * 1024 };
+
+// Returns the number of bytes per second. The CRC is added to sink so that the calls can't be removed.
+double TimeKernel( pcrc64 kernel, const unsigned char *buf, unsigned int length, unsigned long long *sink )
+{
+	unsigned int iterations = BYTES_PER_RUN / length;
+	unsigned long long crc = 0;
+
+	double start_time = GetSeconds();
+
+	for ( unsigned int i = 0; i < iterations; ++i )
+	{
+		crc ^= kernel( buf, length, crc );
+	}
+
+	double elapsed_time = GetSeconds() - start_time;
+
+	*sink += crc;
+
+	return ( elapsed_time > 0.0 ? ( ( double )iterations * length ) / elapsed_time : 0.0 );
+}
+
+void RunKernel( const char *name, pcrc64 kernel, const unsigned char *buf, unsigned long long *sink )
+{
+	printf( "%-14s", name );
+
+	for ( unsigned int i = 0; i < sizeof( buffer_sizes ) / sizeof( buffer_sizes[ 0 ] ); ++i )
+	{
+		printf( "%10.2f GB/s", TimeKernel( kernel, buf, buffer_sizes[ i ], sink ) / 1000000000.0 );
+	}
+
+	printf( "\n" );
+}
+
+int main()
+{
+	unsigned char *buf = ( unsigned char * )malloc( 1024 * 1024 );
+	if ( buf == NULL )
+	{
+		printf( "Could not allocate the buffer.\n" );
+		return 1;
+	}
+
+	for ( unsigned int i = 0; i < 1024 * 1024; ++i )
+	{
+		buf[ i ] = ( unsigned char )( i * 131 + ( i >> 8 ) );
+	}
+
+	// Builds the slicing tables.
+	pcrc64 selected = select_crc64();
+
+	unsigned long long sink = 0;
+
+	printf( "%-14s", "Buffer size" );
+	for ( unsigned int i = 0; i < sizeof( buffer_sizes ) / sizeof( buffer_sizes[ 0 ] ); ++i )
+	{
+		printf( "%10u B   ", buffer_sizes[ i ] );
+	}
+	printf( "\n" );
+
+	RunKernel( "bytewise", crc64_bytewise, buf, &sink );
+	RunKernel( "slicing-by-16", crc64_slicing16, buf, &sink );
+
+#ifdef USE_PCLMUL
+	if ( selected == crc64_pclmul )
+	{
+		RunKernel( "PCLMULQDQ", crc64_pclmul, buf, &sink );
+	}
+	else
+	{
+		printf( "PCLMULQDQ is not supported by this processor.\n" );
+	}
+#else
+	printf( "PCLMULQDQ is not supported by this compiler.\n" );
+#endif
+
+	free( buf );
+
+	printf( "(%016llX)\n", sink );
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks that every CRC-64 kernel produces the same CRC as the bytewise kernel.
+// The GUI's crc64.cpp is the same file, so this covers both programs.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/crc64.cpp"
+
+#include <stdlib.h>
+
+#define MAX_LENGTH		2100
+#define ALIGNMENTS		16
+#define LARGE_LENGTH	( 1024 * 1024 )
+
+static const unsigned long long initial_crcs[] = { 0x0000000000000000, 0xFFFFFFFFFFFFFFFF, 0x0123456789ABCDEF, 0x8000000000000001 };
+
+// The data doesn't need to be random, only different at every offset.
+void FillBuffer( unsigned char *buf, unsigned int length )
+{
+	unsigned int state = 0x12345678;
+	for ( unsigned int i = 0; i < length; ++i )
+	{
+		state = state * 1103515245 + 12345;
+		buf[ i ] = ( unsigned char )( state >> 16 );
+	}
+}
+
+void CheckKernel( const char *name, pcrc64 kernel, const unsigned char *buf )
+{
+	unsigned int failures = g_failures;
+
+	for ( unsigned int c = 0; c < sizeof( initial_crcs ) / sizeof( initial_crcs[ 0 ] ); ++c )
+	{
+		for ( unsigned int alignment = 0; alignment < ALIGNMENTS; ++alignment )
+		{
+			for ( unsigned int length = 0; length <= MAX_LENGTH; ++length )
+			{
+				unsigned long long expected = crc64_bytewise( buf + alignment, length, initial_crcs[ c ] );
+				unsigned long long actual = kernel( buf + alignment, length, initial_crcs[ c ] );
+				Check( actual == expected, "%s: length %u, alignment %u, initial CRC %016llX: %016llX != %016llX", name, length, alignment, initial_crcs[ c ], actual, expected );
+			}
+		}
+
+		unsigned long long expected = crc64_bytewise( buf + 1, LARGE_LENGTH, initial_crcs[ c ] );
+		unsigned long long actual = kernel( buf + 1, LARGE_LENGTH, initial_crcs[ c ] );
+		Check( actual == expected, "%s: length %u, initial CRC %016llX: %016llX != %016llX", name, LARGE_LENGTH, initial_crcs[ c ], actual, expected );
+	}
+
+	printf( "%s: %u mismatches.\n", name, g_failures - failures );
+}
+
+// crc64() with the signature of the kernels.
+unsigned long long crc64_selected( const unsigned char *buf, unsigned int length, unsigned long long crc )
+{
+	return crc64( ( char * )buf, length, crc );
+}
+
+// GetDataChecksum() only checksums parts of an entry beyond its first 1024 bytes.
+void CheckDataChecksum( const unsigned char *buf )
+{
+	for ( unsigned int data_size = 0; data_size <= MAX_LENGTH; ++data_size )
+	{
+		unsigned long long first_crc = crc64_bytewise( buf, ( data_size > 1024 ? 1024 : data_size ), 0 );
+		unsigned long long second_crc = 0;
+
+		for ( unsigned int offset = 1024; offset < data_size; offset += 400 )
+		{
+			second_crc = crc64_bytewise( buf + offset, ( data_size - offset > 4 ? 4 : data_size - offset ), second_crc );
+		}
+
+		unsigned long long actual = GetDataChecksum( buf, data_size );
+		Check( actual == ( first_crc ^ second_crc ), "GetDataChecksum: data size %u: %016llX != %016llX", data_size, actual, first_crc ^ second_crc );
+	}
+}
+
+int main()
+{
+	unsigned char *buf = ( unsigned char * )malloc( LARGE_LENGTH + ALIGNMENTS );
+	if ( buf == NULL )
+	{
+		printf( "Could not allocate the buffer.\n" );
+		return 1;
+	}
+
+	FillBuffer( buf, LARGE_LENGTH + ALIGNMENTS );
+
+	// Builds the slicing tables and picks the kernel that crc64() uses.
+	pcrc64 selected = select_crc64();
+
+	CheckKernel( "slicing-by-16", crc64_slicing16, buf );
+
+#ifdef USE_PCLMUL
+	if ( selected == crc64_pclmul )
+	{
+		CheckKernel( "PCLMULQDQ", crc64_pclmul, buf );
+	}
+	else
+	{
+		printf( "PCLMULQDQ: not supported by this processor.\n" );
+	}
+#else
+	printf( "PCLMULQDQ: not supported by this compiler.\n" );
+#endif
+
+	CheckKernel( "crc64", crc64_selected, buf );
+	CheckDataChecksum( buf );
+
+	free( buf );
+
+	return FinishChecks();
+}
@@ -0,0 +1,337 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks the page, record, and value decoding of the native ESE reader on page images that are built here.
+// The images follow the layout that parse_esedb.cpp reads. They weren't taken from a Windows Search database.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/decode_esedb.cpp"
+
+#define TEST_OBJID		27
+#define TEST_NEXT_PAGE	42
+
+// "abcabcabcabc" as 3 literals and a match of 9 bytes at an offset of 3.
+static const unsigned char xpress_short_match[] = { ( ESE_COMPRESSION_XPRESS << 3 ), 12, 0, 0x00, 0x00, 0x00, 0x10, 'a', 'b', 'c', 0x16, 0x00 };
+
+// "ab" 20 times as 2 literals and a match of 38 bytes at an offset of 2. Its length continues into a half byte and then a byte.
+static const unsigned char xpress_long_match[] = { ( ESE_COMPRESSION_XPRESS << 3 ), 40, 0, 0x00, 0x00, 0x00, 0x20, 'a', 'b', 0x0F, 0x00, 0x0F, 13 };
+
+// "Hi!" as 7-bit ASCII. 5 bits of the last byte are used.
+static const unsigned char seven_bit_ascii[] = { ( ESE_COMPRESSION_7BIT_ASCII << 3 ) | 4, 0xC8, 0x74, 0x08 };
+
+// L"Thumb" as 7-bit Unicode. 3 bits of the last byte are used.
+static const unsigned char seven_bit_unicode[] = { ( ESE_COMPRESSION_7BIT_UNICODE << 3 ) | 2, 0x54, 0x74, 0xBD, 0x2D, 0x06 };
+
+// A page image whose values are added after its header in the order of their tags.
+struct TEST_PAGE
+{
+	unsigned char data[ 32768 ];
+	const ESE_FORMAT *format;
+	unsigned int used;				// Bytes of values after the header.
+	unsigned short tag_count;
+};
+
+void PutUShort( unsigned char *data, unsigned int value )
+{
+	data[ 0 ] = ( unsigned char )value;
+	data[ 1 ] = ( unsigned char )( value >> 8 );
+}
+
+void PutUInt( unsigned char *data, unsigned int value )
+{
+	PutUShort( data, value & 0xFFFF );
+	PutUShort( data + 2, value >> 16 );
+}
+
+void InitializePage( TEST_PAGE *tp, const ESE_FORMAT *format, unsigned int flags )
+{
+	memset( tp->data, 0xCD, sizeof( tp->data ) );
+	memset( tp->data, 0, format->page_header_size );
+
+	tp->format = format;
+	tp->used = 0;
+	tp->tag_count = 0;
+
+	PutUInt( tp->data + ESE_PAGE_NEXT_PAGE, TEST_NEXT_PAGE );
+	PutUInt( tp->data + ESE_PAGE_OBJID, TEST_OBJID );
+	PutUInt( tp->data + ESE_PAGE_FLAGS, flags );
+}
+
+// Adds a value and its tag. Small pages store the tag's flags in its offset, and large pages in the upper 3 bits of the value's second byte.
+void AddTag( TEST_PAGE *tp, const unsigned char *value, unsigned int value_length, unsigned char flags )
+{
+	unsigned char *tag_data = tp->data + tp->format->page_size - ( ( tp->tag_count + 1 ) * 4 );
+	unsigned char *value_data = tp->data + tp->format->page_header_size + tp->used;
+
+	memcpy( value_data, value, value_length );
+
+	if ( tp->format->large_pages )
+	{
+		PutUShort( tag_data, value_length );
+		PutUShort( tag_data + 2, tp->used );
+
+		if ( value_length >= 2 )
+		{
+			value_data[ 1 ] |= ( unsigned char )( flags << 5 );
+		}
+	}
+	else
+	{
+		PutUShort( tag_data, value_length );
+		PutUShort( tag_data + 2, tp->used | ( flags << 13 ) );
+	}
+
+	tp->used += value_length;
+	PutUShort( tp->data + ESE_PAGE_TAG_COUNT, ++tp->tag_count );
+}
+
+// Adds a node. If prefix_length isn't 0, then that much of the key is taken from the page's first tag.
+void AddNode( TEST_PAGE *tp, unsigned int prefix_length, const char *key, const unsigned char *data, unsigned int data_length, unsigned char flags )
+{
+	unsigned char value[ 1024 ];
+	unsigned int length = 0;
+	unsigned int key_length = ( unsigned int )strlen( key );
+
+	if ( prefix_length > 0 )
+	{
+		flags |= ESE_TAG_FLAG_COMMON_KEY;
+		PutUShort( value, prefix_length );
+		length += 2;
+	}
+
+	PutUShort( value + length, key_length );
+	length += 2;
+
+	memcpy( value + length, key, key_length );
+	length += key_length;
+
+	memcpy( value + length, data, data_length );
+	length += data_length;
+
+	AddTag( tp, value, length, flags );
+}
+
+// Builds a record of a table with these columns:
+// 1: 4 byte fixed, 2: 2 byte fixed, 3: 8 byte fixed that's NULL
+// 128: "abc", 129: NULL, 130: "de"
+// 256: "XYZ", 257: XPRESS compressed, 258: 7-bit Unicode compressed, 259: NULL
+// Returns the length of the record.
+unsigned int BuildRecord( const ESE_FORMAT *format, unsigned char *record )
+{
+	unsigned int length = 0;
+
+	record[ 0 ] = 3;		// Last fixed column.
+	record[ 1 ] = 130;		// Last variable column.
+	PutUShort( record + 2, 19 );
+
+	PutUInt( record + 4, 0x11223344 );
+	PutUShort( record + 8, 0xBEEF );
+	memset( record + 10, 0xEE, 8 );
+	record[ 18 ] = 0x04;	// Column 3 is NULL.
+
+	// The end of each variable value.
+	PutUShort( record + 19, 3 );
+	PutUShort( record + 21, 0x8000 | 3 );
+	PutUShort( record + 23, 5 );
+	memcpy( record + 25, "abcde", 5 );
+	length = 30;
+
+	// The tagged columns. Small pages flag a value that begins with a flags byte, or that's NULL, in its offset. Large pages always have a flags byte.
+	unsigned char *tagged = record + length;
+	unsigned int offset = 16;
+	unsigned int has_flags = ( format->large_pages ? 0 : 0x4000 );
+
+	PutUShort( tagged, 256 );
+	PutUShort( tagged + 2, offset );
+	if ( format->large_pages )
+	{
+		tagged[ offset++ ] = 0;
+	}
+	memcpy( tagged + offset, "XYZ", 3 );
+	offset += 3;
+
+	PutUShort( tagged + 4, 257 );
+	PutUShort( tagged + 6, offset | has_flags );
+	tagged[ offset++ ] = ESE_VALUE_FLAG_COMPRESSED;
+	memcpy( tagged + offset, xpress_short_match, sizeof( xpress_short_match ) );
+	offset += sizeof( xpress_short_match );
+
+	PutUShort( tagged + 8, 258 );
+	PutUShort( tagged + 10, offset | has_flags );
+	tagged[ offset++ ] = ESE_VALUE_FLAG_COMPRESSED;
+	memcpy( tagged + offset, seven_bit_unicode, sizeof( seven_bit_unicode ) );
+	offset += sizeof( seven_bit_unicode );
+
+	PutUShort( tagged + 12, 259 );
+	if ( format->large_pages )
+	{
+		PutUShort( tagged + 14, offset );
+		tagged[ offset++ ] = ESE_VALUE_FLAG_NULL;
+	}
+	else
+	{
+		PutUShort( tagged + 14, offset | 0x2000 );
+	}
+
+	return length + offset;
+}
+
+void SetTestTable( ESE_TABLE *table )
+{
+	memset( table, 0, sizeof( ESE_TABLE ) );
+	table->objid = TEST_OBJID;
+	table->fixed_size[ 1 ] = 4;
+	table->fixed_size[ 2 ] = 2;
+	table->fixed_size[ 3 ] = 8;
+
+	SetFixedColumnOffsets( table );
+}
+
+bool ValueEquals( const unsigned char *value, unsigned int value_length, const void *expected, unsigned int expected_length )
+{
+	return ( value_length == expected_length && memcmp( value, expected, expected_length ) == 0 );
+}
+
+// Checks that a compressed value decompresses to expected.
+void CheckDecompressed( const char *description, const unsigned char *data, unsigned int data_length, const void *expected, unsigned int expected_length )
+{
+	unsigned char output[ 256 ];
+	unsigned int length = GetDecompressedLength( data, data_length );
+
+	Check( length == expected_length, "%s: got a length of %u, expected %u", description, length, expected_length );
+	Check( length <= sizeof( output ) && DecompressData( data, data_length, output, length ) && memcmp( output, expected, expected_length ) == 0, "%s: the output doesn't match", description );
+}
+
+void CheckRecord( const ESE_FORMAT *format, ESE_TABLE *table, unsigned char *record, unsigned int record_length, const char *description )
+{
+	unsigned char *value = NULL;
+	unsigned int value_length = 0;
+	unsigned char flags = 0;
+
+	Check( GetRecordUInt( format, table, record, record_length, 1 ) == 0x11223344, "%s: fixed column 1", description );
+	Check( GetRecordUInt( format, table, record, record_length, 2 ) == 0xBEEF, "%s: fixed column 2", description );
+	Check( !GetRecordValue( format, table, record, record_length, 3, &value, &value_length, &flags ), "%s: fixed column 3 isn't NULL", description );
+	Check( !GetRecordValue( format, table, record, record_length, 4, &value, &value_length, &flags ), "%s: fixed column 4 was found", description );
+
+	Check( GetRecordValue( format, table, record, record_length, 128, &value, &value_length, &flags ) && ValueEquals( value, value_length, "abc", 3 ), "%s: variable column 128", description );
+	Check( !GetRecordValue( format, table, record, record_length, 129, &value, &value_length, &flags ), "%s: variable column 129 isn't NULL", description );
+	Check( GetRecordValue( format, table, record, record_length, 130, &value, &value_length, &flags ) && ValueEquals( value, value_length, "de", 2 ), "%s: variable column 130", description );
+	Check( !GetRecordValue( format, table, record, record_length, 131, &value, &value_length, &flags ), "%s: variable column 131 was found", description );
+
+	Check( GetRecordValue( format, table, record, record_length, 256, &value, &value_length, &flags ) && flags == 0 && ValueEquals( value, value_length, "XYZ", 3 ), "%s: tagged column 256", description );
+
+	Check( GetRecordValue( format, table, record, record_length, 257, &value, &value_length, &flags ) && flags == ESE_VALUE_FLAG_COMPRESSED, "%s: tagged column 257", description );
+	CheckDecompressed( description, value, value_length, "abcabcabcabc", 12 );
+
+	Check( GetRecordValue( format, table, record, record_length, 258, &value, &value_length, &flags ) && flags == ESE_VALUE_FLAG_COMPRESSED, "%s: tagged column 258", description );
+	CheckDecompressed( description, value, value_length, "T\0h\0u\0m\0b\0", 10 );
+
+	Check( !GetRecordValue( format, table, record, record_length, 259, &value, &value_length, &flags ), "%s: tagged column 259 isn't NULL", description );
+	Check( !GetRecordValue( format, table, record, record_length, 300, &value, &value_length, &flags ), "%s: tagged column 300 was found", description );
+
+	// A record that's cut short can't be read past its end.
+	Check( !GetRecordValue( format, table, record, 20, 128, &value, &value_length, &flags ), "%s: a truncated record was read", description );
+}
+
+void CheckPage( unsigned long revision, unsigned long page_size, const char *description )
+{
+	ESE_FORMAT format;
+	Check( SetESEFormat( &format, revision, page_size ), "%s: the page size wasn't accepted", description );
+
+	static TEST_PAGE tp;
+	InitializePage( &tp, &format, ESE_PAGE_FLAG_LEAF );
+
+	unsigned char record[ 256 ];
+	unsigned int record_length = BuildRecord( &format, record );
+
+	// The first tag is the common key prefix of the nodes.
+	AddTag( &tp, ( const unsigned char * )"\x7F\x01\x02", 3, 0 );
+	AddNode( &tp, 0, "\x7F\x02", record, record_length, 0 );
+	AddNode( &tp, 2, "\x05", record, record_length, 0 );
+	AddNode( &tp, 0, "\x7F\x04", record, record_length, ESE_TAG_FLAG_DELETED );
+
+	ESE_PAGE page;
+	Check( ParsePage( &format, tp.data, 7, &page ), "%s: the page wasn't parsed", description );
+	Check( page.page_number == 7 && page.objid == TEST_OBJID && page.next_page == TEST_NEXT_PAGE && page.flags == ESE_PAGE_FLAG_LEAF && page.tag_count == 4, "%s: the page header doesn't match", description );
+
+	ESE_NODE node;
+	Check( !GetPageNode( &page, 0, &node ), "%s: the first tag was read as a node", description );
+	Check( !GetPageNode( &page, 4, &node ), "%s: a tag past the last one was read", description );
+
+	// A node without a common key prefix.
+	Check( GetPageNode( &page, 1, &node ) && node.prefix_length == 0 && node.key_length == 2 && node.data_length == record_length && ( node.flags & ESE_TAG_FLAG_DELETED ) == 0, "%s: node 1", description );
+	Check( CompareNodeKey( &node, ( const unsigned char * )"\x7F\x02", 2 ) == 0, "%s: node 1's key", description );
+	Check( CompareNodeKey( &node, ( const unsigned char * )"\x7F\x03", 2 ) < 0, "%s: node 1's key isn't less", description );
+	Check( CompareNodeKey( &node, ( const unsigned char * )"\x7F", 1 ) > 0, "%s: node 1's key isn't greater than its prefix", description );
+
+	ESE_TABLE table;
+	SetTestTable( &table );
+	CheckRecord( &format, &table, node.data, node.data_length, description );
+
+	// A node whose key begins with the first 2 bytes of the common key prefix.
+	Check( GetPageNode( &page, 2, &node ) && node.prefix_length == 2 && node.key_length == 1 && node.data_length == record_length, "%s: node 2", description );
+	Check( GetNodeKeyByte( &node, 0 ) == 0x7F && GetNodeKeyByte( &node, 1 ) == 0x01 && GetNodeKeyByte( &node, 2 ) == 0x05, "%s: node 2's key bytes", description );
+	Check( CompareNodeKey( &node, ( const unsigned char * )"\x7F\x01\x05", 3 ) == 0, "%s: node 2's key", description );
+	CheckRecord( &format, &table, node.data, node.data_length, description );
+
+	Check( GetPageNode( &page, 3, &node ) && ( node.flags & ESE_TAG_FLAG_DELETED ), "%s: node 3 isn't deleted", description );
+
+	// Tags that would overlap the page's header.
+	PutUShort( tp.data + ESE_PAGE_TAG_COUNT, ( format.page_size - format.page_header_size ) / 4 + 1 );
+	Check( !ParsePage( &format, tp.data, 7, &page ), "%s: too many tags were accepted", description );
+}
+
+int main()
+{
+	ESE_FORMAT format;
+	Check( !SetESEFormat( &format, 0x11, 1024 ), "An unsupported page size was accepted" );
+	Check( SetESEFormat( &format, 0x11, 8192 ) && !format.large_pages && format.page_header_size == 40, "8 kilobyte pages have the wrong layout" );
+	Check( SetESEFormat( &format, 0x11, 32768 ) && format.large_pages && format.page_header_size == 80, "32 kilobyte pages have the wrong layout" );
+	Check( SetESEFormat( &format, 0x0C, 32768 ) && !format.large_pages, "Old revisions can't have large pages" );
+
+	CheckPage( 0x11, 4096, "4 kilobyte page" );
+	CheckPage( 0x11, 8192, "8 kilobyte page" );
+	CheckPage( 0x14, 32768, "32 kilobyte page" );
+
+	CheckDecompressed( "XPRESS long match", xpress_long_match, sizeof( xpress_long_match ), "abababababababababababababababababababab", 40 );
+	CheckDecompressed( "7-bit ASCII", seven_bit_ascii, sizeof( seven_bit_ascii ), "Hi!", 3 );
+
+	unsigned char output[ 64 ];
+
+	// The compressed data ends before the output is complete, or the match refers to bytes before the output.
+	Check( !DecompressData( xpress_short_match, sizeof( xpress_short_match ) - 1, output, 12 ), "Truncated XPRESS data was accepted" );
+	unsigned char bad_offset[ sizeof( xpress_short_match ) ];
+	memcpy( bad_offset, xpress_short_match, sizeof( xpress_short_match ) );
+	bad_offset[ 10 ] = 0x1E;
+	Check( !DecompressData( bad_offset, sizeof( bad_offset ), output, 12 ), "An XPRESS match before the output was accepted" );
+
+	// The length has to be the one in the data, and unknown schemes aren't decompressed.
+	Check( !DecompressData( xpress_short_match, sizeof( xpress_short_match ), output, 11 ), "The wrong XPRESS length was accepted" );
+	unsigned char unknown_scheme[] = { 5 << 3, 0x01, 0x02 };
+	Check( GetDecompressedLength( unknown_scheme, sizeof( unknown_scheme ) ) == 0, "An unknown compression scheme was accepted" );
+
+	// The chunks of a compressed long value. One that's already the chunk's length is copied, and any other is decompressed.
+	memset( output, 0, sizeof( output ) );
+	Check( ExpandLongValueChunk( ( const unsigned char * )"abcabcabcabc", 12, output, 12 ) && memcmp( output, "abcabcabcabc", 12 ) == 0, "An uncompressed chunk wasn't copied" );
+
+	memset( output, 0, sizeof( output ) );
+	Check( ExpandLongValueChunk( xpress_long_match, sizeof( xpress_long_match ), output, 40 ) && memcmp( output, "abababababababababababababababababababab", 40 ) == 0, "A compressed chunk wasn't decompressed" );
+	Check( !ExpandLongValueChunk( xpress_long_match, sizeof( xpress_long_match ), output, 38 ), "A chunk with the wrong length was accepted" );
+
+	return FinishChecks();
+}
@@ -0,0 +1,90 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures how many entries per second VerifyEntryChecksums() verifies once they've been read into memory.
+
+#include "check.h"
+#include "../thumbcache_viewer/crc64.cpp"
+#include "../thumbcache_viewer/entry_checksums.cpp"
+
+#include <stdlib.h>
+
+// A Windows 8/8.1/10 entry header, its header checksum, and an identifier string of 16 characters.
+#define HEADER_SIZE		48
+#define DATA_START		( HEADER_SIZE + 8 + 32 )
+
+// Every run verifies this many bytes of data in total, whatever the data size.
+#define BYTES_PER_RUN	( 2048U * 1024 * 1024 )
+
+// Thumbnails from the 32, 256, and 1024 pixel caches are roughly these sizes.
+static const unsigned int data_sizes[] = { 2 * 1024, 24 * 1024, 256 * 1024 };
+
+int main()
+{
+	unsigned int max_length = DATA_START + data_sizes[ sizeof( data_sizes ) / sizeof( data_sizes[ 0 ] ) - 1 ];
+
+	unsigned char *entry = ( unsigned char * )malloc( max_length );
+	if ( entry == NULL )
+	{
+		printf( "Could not allocate the entry.\n" );
+		return 1;
+	}
+
+	for ( unsigned int i = 0; i < max_length; ++i )
+	{
+		entry[ i ] = ( unsigned char )( i * 131 + ( i >> 8 ) );
+	}
+
+	printf( "%-12s%16s%16s\n", "Data size", "Entries/s", "Stored MB/s" );
+
+	for ( unsigned int d = 0; d < sizeof( data_sizes ) / sizeof( data_sizes[ 0 ] ); ++d )
+	{
+		unsigned int length = DATA_START + data_sizes[ d ];
+		unsigned int iterations = BYTES_PER_RUN / data_sizes[ d ];
+
+		// The checksums are only wrong for the first entry. The rest have the ones that it calculated.
+		ENTRY_CHECKSUMS verified = { 0, 0 };
+		VerifyEntryChecksums( entry, length, HEADER_SIZE, DATA_START, 0, 0, &verified );
+		unsigned long long header_checksum = verified.header_checksum;
+		unsigned long long data_checksum = verified.data_checksum;
+
+		unsigned int mismatches = 0;
+
+		double start_time = GetSeconds();
+
+		for ( unsigned int i = 0; i < iterations; ++i )
+		{
+			if ( VerifyEntryChecksums( entry, length, HEADER_SIZE, DATA_START, header_checksum, data_checksum, &verified ) != 0 )
+			{
+				++mismatches;
+			}
+		}
+
+		double elapsed_time = GetSeconds() - start_time;
+		double entries_per_second = ( elapsed_time > 0.0 ? iterations / elapsed_time : 0.0 );
+
+		Check( mismatches == 0, "%u entries of %u bytes had mismatched checksums.", mismatches, data_sizes[ d ] );
+
+		// Only part of the data beyond 1024 bytes is checksummed, so the stored size of the entries is what's reported.
+		printf( "%-12u%16.0f%16.0f\n", data_sizes[ d ], entries_per_second, entries_per_second * length / 1000000.0 );
+	}
+
+	free( entry );
+
+	return FinishChecks();
+}
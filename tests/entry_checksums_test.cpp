@@ -0,0 +1,136 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks the verdicts of VerifyEntryChecksums() on synthetic entries.
+
+#include "check.h"
+#include "../thumbcache_viewer/crc64.cpp"
+#include "../thumbcache_viewer/entry_checksums.cpp"
+
+#include <stdlib.h>
+
+// The number of header bytes that the header checksum covers in each layout: Windows Vista, 7, and 8/8.1/10.
+static const unsigned int header_sizes[] = { 48, 40, 48 };
+
+// The data sizes include ones that end before, at, and after the first 1024 bytes and the 400 byte blocks beyond them.
+static const unsigned int data_sizes[] = { 0, 1, 4, 1023, 1024, 1025, 1028, 1029, 1424, 1425, 4096, 65536 + 7 };
+
+#define IDENTIFIER_LENGTH	32
+
+// GetDataChecksum() written out with the bytewise kernel.
+unsigned long long ReferenceDataChecksum( const unsigned char *data, unsigned int data_size )
+{
+	unsigned long long first_crc = crc64_bytewise( data, ( data_size > 1024 ? 1024 : data_size ), 0 );
+	unsigned long long second_crc = 0;
+
+	for ( unsigned int offset = 1024; offset < data_size; offset += 400 )
+	{
+		second_crc = crc64_bytewise( data + offset, ( data_size - offset > 4 ? 4 : data_size - offset ), second_crc );
+	}
+
+	return ( first_crc ^ second_crc );
+}
+
+// Fills in an entry whose header is followed by its header checksum, identifier string, and data. Returns the offset of the data.
+unsigned int MakeEntry( unsigned char *entry, unsigned int header_size, unsigned int data_size, unsigned long long *header_checksum, unsigned long long *data_checksum )
+{
+	unsigned int data_start = header_size + sizeof( unsigned long long ) + IDENTIFIER_LENGTH;
+
+	for ( unsigned int i = 0; i < data_start + data_size; ++i )
+	{
+		entry[ i ] = ( unsigned char )( i * 131 + ( i >> 7 ) + header_size );
+	}
+
+	*header_checksum = crc64_bytewise( entry, header_size, 0xFFFFFFFFFFFFFFFF );
+	*data_checksum = ReferenceDataChecksum( entry + data_start, data_size );
+
+	memcpy( entry + header_size, header_checksum, sizeof( unsigned long long ) );
+
+	return data_start;
+}
+
+void CheckVerdict( unsigned char expected, const unsigned char *entry, unsigned int length, unsigned int header_size, unsigned int data_start,
+				   unsigned long long header_checksum, unsigned long long data_checksum, const char *description, unsigned int data_size )
+{
+	ENTRY_CHECKSUMS verified;
+	unsigned char result = VerifyEntryChecksums( entry, length, header_size, data_start, header_checksum, data_checksum, &verified );
+	Check( result == expected, "%s: header size %u, data size %u: got %u, expected %u", description, header_size, data_size, result, expected );
+}
+
+int main()
+{
+	unsigned char *entry = ( unsigned char * )malloc( 128 + 65536 + 1024 );
+	if ( entry == NULL )
+	{
+		printf( "Could not allocate the entry.\n" );
+		return 1;
+	}
+
+	for ( unsigned int h = 0; h < sizeof( header_sizes ) / sizeof( header_sizes[ 0 ] ); ++h )
+	{
+		for ( unsigned int d = 0; d < sizeof( data_sizes ) / sizeof( data_sizes[ 0 ] ); ++d )
+		{
+			unsigned int header_size = header_sizes[ h ];
+			unsigned int data_size = data_sizes[ d ];
+
+			unsigned long long header_checksum, data_checksum;
+			unsigned int data_start = MakeEntry( entry, header_size, data_size, &header_checksum, &data_checksum );
+			unsigned int length = data_start + data_size;
+
+			CheckVerdict( 0, entry, length, header_size, data_start, header_checksum, data_checksum, "Valid entry", data_size );
+
+			// The stored checksums are wrong.
+			CheckVerdict( ENTRY_BAD_HEADER, entry, length, header_size, data_start, header_checksum ^ 1, data_checksum, "Wrong header checksum", data_size );
+			CheckVerdict( ENTRY_BAD_DATA, entry, length, header_size, data_start, header_checksum, data_checksum ^ 1, "Wrong data checksum", data_size );
+
+			// A changed header byte. The header checksum field and identifier string aren't covered.
+			entry[ header_size - 1 ] ^= 0x80;
+			CheckVerdict( ENTRY_BAD_HEADER, entry, length, header_size, data_start, header_checksum, data_checksum, "Changed header", data_size );
+			entry[ header_size - 1 ] ^= 0x80;
+
+			entry[ header_size + sizeof( unsigned long long ) ] ^= 0x80;
+			CheckVerdict( 0, entry, length, header_size, data_start, header_checksum, data_checksum, "Changed identifier string", data_size );
+			entry[ header_size + sizeof( unsigned long long ) ] ^= 0x80;
+
+			if ( data_size > 0 )
+			{
+				// The first and last bytes of the data. The last byte is only covered if it's in the first 1024 bytes or in the first 4 bytes of a 400 byte block.
+				entry[ data_start ] ^= 0x01;
+				CheckVerdict( ENTRY_BAD_DATA, entry, length, header_size, data_start, header_checksum, data_checksum, "Changed first data byte", data_size );
+				entry[ data_start ] ^= 0x01;
+
+				unsigned int last = data_size - 1;
+				bool sampled = ( last < 1024 || ( last - 1024 ) % 400 < 4 );
+
+				entry[ data_start + last ] ^= 0x01;
+				CheckVerdict( ( sampled ? ENTRY_BAD_DATA : 0 ), entry, length, header_size, data_start, header_checksum, data_checksum, "Changed last data byte", data_size );
+				entry[ data_start + last ] ^= 0x01;
+
+				// A short read, as when the entry runs beyond the end of the database. Like a change, losing a byte that isn't sampled goes unnoticed.
+				CheckVerdict( ( sampled ? ENTRY_BAD_DATA : 0 ), entry, length - 1, header_size, data_start, header_checksum, data_checksum, "Truncated data", data_size );
+			}
+
+			// Nothing was read.
+			CheckVerdict( ENTRY_BAD_HEADER | ( data_checksum != 0 ? ENTRY_BAD_DATA : 0 ), entry, 0, header_size, data_start, header_checksum, data_checksum, "Nothing read", data_size );
+		}
+	}
+
+	free( entry );
+
+	return FinishChecks();
+}
@@ -0,0 +1,147 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures the throughput of each find_signature() variant against the memcmp loop it replaced, and checks that they find the same offsets.
+// The GUI's find_signature.cpp is the same file, so this covers both programs.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/find_signature.cpp"
+
+#include <stdlib.h>
+
+#define BUFFER_SIZE		( 256 * 1024 * 1024 )
+
+// The number of signatures that are planted for the correctness check.
+#define PLANTED_COUNT	1000
+
+// The loop that scan_memory() used before find_signature().
+size_t find_signature_memcmp( const unsigned char *buf, size_t length )
+{
+	for ( size_t i = 0; length >= 4 && i <= length - 4; ++i )
+	{
+		if ( memcmp( buf + i, "CMMM", 4 ) == 0 )
+		{
+			return i;
+		}
+	}
+
+	return length;
+}
+
+// Most bytes are 'C' or 'M' so that every position is a near miss. Nothing spells "CMMM".
+void FillDirtyBuffer( unsigned char *buf, size_t length )
+{
+	unsigned int state = 0x12345678;
+	for ( size_t i = 0; i < length; ++i )
+	{
+		state = state * 1103515245 + 12345;
+		unsigned int r = ( state >> 16 ) & 0x0F;
+		buf[ i ] = ( unsigned char )( r < 6 ? 'C' : ( r < 12 ? 'M' : ( state >> 24 ) ) );
+
+		// Break up any "CMMM" by changing its last byte.
+		if ( i >= 3 && buf[ i - 3 ] == 'C' && buf[ i - 2 ] == 'M' && buf[ i - 1 ] == 'M' && buf[ i ] == 'M' )
+		{
+			buf[ i ] = 'C';
+		}
+	}
+}
+
+// Finds every signature the way scan_memory() walks a view. Returns the number that were found and a checksum of their offsets.
+size_t FindAll( pfind_signature variant, const unsigned char *buf, size_t length, unsigned long long *offset_sum )
+{
+	size_t found = 0;
+	*offset_sum = 0;
+
+	for ( size_t offset = variant( buf, length ); offset < length; offset += 1 + variant( buf + offset + 1, length - offset - 1 ) )
+	{
+		++found;
+		*offset_sum += offset;
+	}
+
+	return found;
+}
+
+// Returns the number of bytes per second over a buffer with no match.
+double TimeVariant( const char *name, pfind_signature variant, const unsigned char *buf, size_t length )
+{
+	double start_time = GetSeconds();
+
+	size_t offset = variant( buf, length );
+
+	double elapsed_time = GetSeconds() - start_time;
+
+	Check( offset == length, "%s found an unexpected signature at %llu.", name, ( unsigned long long )offset );
+
+	return ( elapsed_time > 0.0 ? ( double )length / elapsed_time : 0.0 );
+}
+
+// Checks that the variant finds the same signatures as the memcmp loop, then times it.
+void RunVariant( const char *name, pfind_signature variant, unsigned char *buf, size_t expected_found, unsigned long long expected_sum )
+{
+	// The planted signatures are at the front of the buffer so that the timed scan doesn't see them.
+	unsigned long long offset_sum = 0;
+	size_t found = FindAll( variant, buf, PLANTED_COUNT * 4096, &offset_sum );
+	Check( found == expected_found && offset_sum == expected_sum, "%s found %llu signatures instead of %llu.", name, ( unsigned long long )found, ( unsigned long long )expected_found );
+
+	printf( "%-8s%8.2f GB/s\n", name, TimeVariant( name, variant, buf + PLANTED_COUNT * 4096, BUFFER_SIZE - PLANTED_COUNT * 4096 ) / 1000000000.0 );
+}
+
+int main()
+{
+	unsigned char *buf = ( unsigned char * )malloc( BUFFER_SIZE );
+	if ( buf == NULL )
+	{
+		printf( "Could not allocate the buffer.\n" );
+		return 1;
+	}
+
+	FillDirtyBuffer( buf, BUFFER_SIZE );
+
+	// Plant signatures in the first part of the buffer. Their offsets vary so that they fall in every lane and across vector boundaries.
+	for ( size_t i = 0; i < PLANTED_COUNT; ++i )
+	{
+		memcpy( buf + i * 4096 + ( i * 7 ) % 61, "CMMM", 4 );
+	}
+
+	unsigned long long expected_sum = 0;
+	size_t expected_found = FindAll( find_signature_memcmp, buf, PLANTED_COUNT * 4096, &expected_sum );
+	Check( expected_found == PLANTED_COUNT, "The memcmp loop found %llu of the %u planted signatures.", ( unsigned long long )expected_found, PLANTED_COUNT );
+
+	printf( "%llu MB dirty buffer with no signature.\n", ( unsigned long long )( BUFFER_SIZE - PLANTED_COUNT * 4096 ) / ( 1024 * 1024 ) );
+
+	RunVariant( "memcmp", find_signature_memcmp, buf, expected_found, expected_sum );
+	RunVariant( "scalar", find_signature_scalar, buf, expected_found, expected_sum );
+	RunVariant( "SSE2", find_signature_sse2, buf, expected_found, expected_sum );
+
+#ifdef USE_AVX2
+	if ( select_find_signature() == find_signature_avx2 )
+	{
+		RunVariant( "AVX2", find_signature_avx2, buf, expected_found, expected_sum );
+	}
+	else
+	{
+		printf( "AVX2 is not supported by this processor.\n" );
+	}
+#else
+	printf( "AVX2 is not supported by this compiler.\n" );
+#endif
+
+	free( buf );
+
+	return FinishChecks();
+}
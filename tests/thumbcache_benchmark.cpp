@@ -0,0 +1,317 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures how many entries per second a build of thumbcache_viewer_cmd parses.
+// It writes a synthetic database of each entry layout to the current directory and times the given program while it reads the database with -n.
+// Every release accepts -n and -t, so builds from before and after a change can be compared on the same databases.
+// If a baseline build is given, both builds are timed on each database and the change in entries per second is reported.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/globals.h"
+#include "../thumbcache_viewer_cmd/read_thumbcache.h"
+#include "../thumbcache_viewer_cmd/crc64.cpp"
+
+#define BENCHMARK_DATABASE	L"thumbcache_benchmark.db"
+
+#define DEFAULT_ENTRY_COUNT	100000
+#define DEFAULT_RUN_COUNT	5
+
+// The thumbnails are between 1 and 4 kilobytes.
+#define MIN_DATA_SIZE		1024
+#define MAX_DATA_SIZE		4096
+
+// The identifier string is the entry hash in hexadecimal, without a NULL terminator.
+#define IDENTIFIER_LENGTH	( 16 * sizeof( wchar_t ) )
+
+// The databases that are written. Each version has a different entry layout.
+struct LAYOUT
+{
+	const wchar_t *name;
+	unsigned int version;
+};
+
+static const LAYOUT layouts[] = { { L"Windows Vista", WINDOWS_VISTA }, { L"Windows 7", WINDOWS_7 }, { L"Windows 10", WINDOWS_10 } };
+
+// The names of the programs in the order they're run.
+static const wchar_t *single_program_names[] = { L"program" };
+static const wchar_t *baseline_program_names[] = { L"baseline", L"new" };
+static const wchar_t **program_names = single_program_names;
+
+// Fills in the fields that only one layout has.
+inline void set_entry_fields( database_cache_entry_vista &dce ) { wcscpy_s( dce.extension, 4, L"jpg" ); }
+inline void set_entry_fields( database_cache_entry_8 &dce ) { dce.width = 256; dce.height = 256; }
+template < typename T > inline void set_entry_fields( T & ) {}
+
+// Fills in an entry and its identifier string and data, which follow it in buf. Returns the size of the entry.
+template < typename T >
+unsigned int MakeEntry( unsigned char *buf, unsigned int index )
+{
+	T dce;
+	memset( &dce, 0, sizeof( T ) );
+
+	memcpy( dce.magic_identifier, "CMMM", 4 );
+	dce.entry_hash = ( long long )( ( index + 1 ) * 0x9E3779B97F4A7C15ULL );
+	dce.filename_length = IDENTIFIER_LENGTH;
+	dce.padding_size = 0;
+	dce.data_size = MIN_DATA_SIZE + ( ( index * 2654435761U ) % ( MAX_DATA_SIZE - MIN_DATA_SIZE ) );
+	dce.cache_entry_size = sizeof( T ) + dce.filename_length + dce.padding_size + dce.data_size;
+	set_entry_fields( dce );
+
+	wchar_t identifier[ 17 ];
+	swprintf_s( identifier, 17, L"%016llx", dce.entry_hash );
+	memcpy( buf + sizeof( T ), identifier, IDENTIFIER_LENGTH );
+
+	// The data only needs to look like a JPEG.
+	unsigned char *data = buf + sizeof( T ) + dce.filename_length + dce.padding_size;
+	memcpy( data, FILE_TYPE_JPEG, 4 );
+	for ( unsigned int i = 4; i < dce.data_size; ++i )
+	{
+		data[ i ] = ( unsigned char )( i * 31 + index );
+	}
+
+	dce.data_checksum = ( long long )GetDataChecksum( data, dce.data_size );
+	dce.header_checksum = ( long long )crc64( ( char * )&dce, sizeof( T ) - sizeof( dce.header_checksum ), 0xFFFFFFFFFFFFFFFF );
+
+	memcpy( buf, &dce, sizeof( T ) );
+
+	return dce.cache_entry_size;
+}
+
+// Writes a database of the given version with entry_count entries. Returns the number of bytes that were written, or 0 on failure.
+template < typename T >
+unsigned long long WriteDatabase( const wchar_t *name, unsigned int version, unsigned int entry_count )
+{
+	HANDLE hFile = CreateFileW( name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		return 0;
+	}
+
+	unsigned char *buf = ( unsigned char * )malloc( sizeof( T ) + IDENTIFIER_LENGTH + MAX_DATA_SIZE );
+	if ( buf == NULL )
+	{
+		CloseHandle( hFile );
+		return 0;
+	}
+
+	database_header dh;
+	memcpy( dh.magic_identifier, "CMMM", 4 );
+	dh.version = version;
+	dh.type = ( version == WINDOWS_10 ? 4 : 2 );	// 256
+
+	// Both headers are 24 bytes. The available entry offset is written once the size of the entries is known.
+	database_header_entry_info dhei = { sizeof( database_header ) + sizeof( database_header_entry_info ), 0, entry_count };
+	database_header_entry_info_v3 dhei_v3 = { 0, sizeof( database_header ) + sizeof( database_header_entry_info_v3 ), 0 };
+
+	DWORD written = 0;
+	bool success = ( WriteFile( hFile, &dh, sizeof( database_header ), &written, NULL ) != FALSE &&
+					 ( version == WINDOWS_10 ? WriteFile( hFile, &dhei_v3, sizeof( database_header_entry_info_v3 ), &written, NULL ) :
+											   WriteFile( hFile, &dhei, sizeof( database_header_entry_info ), &written, NULL ) ) != FALSE );
+
+	unsigned long long size = dhei.first_cache_entry;
+
+	for ( unsigned int i = 0; i < entry_count && success; ++i )
+	{
+		unsigned int entry_size = MakeEntry< T >( buf, i );
+		success = ( WriteFile( hFile, buf, entry_size, &written, NULL ) != FALSE && written == entry_size );
+		size += entry_size;
+	}
+
+	// The offset is only 32 bits. It's not used to find the entries.
+	dhei.available_cache_entry = dhei_v3.available_cache_entry = ( unsigned int )size;
+	if ( success && SetFilePointer( hFile, sizeof( database_header ), NULL, FILE_BEGIN ) != INVALID_SET_FILE_POINTER )
+	{
+		success = ( ( version == WINDOWS_10 ? WriteFile( hFile, &dhei_v3, sizeof( database_header_entry_info_v3 ), &written, NULL ) :
+											  WriteFile( hFile, &dhei, sizeof( database_header_entry_info ), &written, NULL ) ) != FALSE );
+	}
+
+	free( buf );
+	CloseHandle( hFile );
+
+	return ( success ? size : 0 );
+}
+
+// Runs the program on the database with its output discarded. Returns the number of seconds it took, or a negative value if it couldn't be run.
+double TimeProgram( const wchar_t *program, const wchar_t *name )
+{
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength = sizeof( SECURITY_ATTRIBUTES );
+	sa.lpSecurityDescriptor = NULL;
+	sa.bInheritHandle = TRUE;
+
+	HANDLE hNull = CreateFileW( L"NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hNull == INVALID_HANDLE_VALUE )
+	{
+		return -1.0;
+	}
+
+	// CreateProcessW can modify the command line.
+	wchar_t command_line[ ( MAX_PATH * 2 ) + 32 ];
+	swprintf_s( command_line, ( MAX_PATH * 2 ) + 32, L"\"%s\" -n -t \"%s\"", program, name );
+
+	STARTUPINFOW si;
+	memset( &si, 0, sizeof( STARTUPINFOW ) );
+	si.cb = sizeof( STARTUPINFOW );
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = GetStdHandle( STD_INPUT_HANDLE );
+	si.hStdOutput = hNull;
+	si.hStdError = hNull;
+
+	PROCESS_INFORMATION pi;
+
+	double start_time = GetSeconds();
+
+	if ( CreateProcessW( NULL, command_line, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi ) == FALSE )
+	{
+		CloseHandle( hNull );
+		return -1.0;
+	}
+
+	WaitForSingleObject( pi.hProcess, INFINITE );
+
+	double elapsed_time = GetSeconds() - start_time;
+
+	CloseHandle( pi.hThread );
+	CloseHandle( pi.hProcess );
+	CloseHandle( hNull );
+
+	return elapsed_time;
+}
+
+// Writes the database of a layout and times each program on it. The runs of the programs alternate so that they see the same system load.
+// The best time of each program is saved in best_times. Returns false if the database couldn't be written or a program couldn't be run.
+bool RunLayout( wchar_t *programs[], unsigned int program_count, const LAYOUT *layout, unsigned int entry_count, unsigned int run_count, double best_times[] )
+{
+	unsigned long long size = 0;
+	if ( layout->version == WINDOWS_VISTA )
+	{
+		size = WriteDatabase< database_cache_entry_vista >( BENCHMARK_DATABASE, layout->version, entry_count );
+	}
+	else if ( layout->version == WINDOWS_7 )
+	{
+		size = WriteDatabase< database_cache_entry_7 >( BENCHMARK_DATABASE, layout->version, entry_count );
+	}
+	else
+	{
+		size = WriteDatabase< database_cache_entry_8 >( BENCHMARK_DATABASE, layout->version, entry_count );
+	}
+
+	if ( size == 0 )
+	{
+		wprintf( L"The %s database could not be written.\n", layout->name );
+		return false;
+	}
+
+	wprintf( L"%s: wrote %lu entries (%llu bytes) to " BENCHMARK_DATABASE L".\n", layout->name, entry_count, size );
+
+	// The first run reads the database into the file cache. The best of the others is reported.
+	for ( unsigned int run = 0; run <= run_count; ++run )
+	{
+		for ( unsigned int p = 0; p < program_count; ++p )
+		{
+			double elapsed_time = TimeProgram( programs[ p ], BENCHMARK_DATABASE );
+			if ( elapsed_time < 0.0 )
+			{
+				wprintf( L"%s could not be run.\n", programs[ p ] );
+				DeleteFileW( BENCHMARK_DATABASE );
+				return false;
+			}
+
+			if ( run > 0 )
+			{
+				wprintf( L"Run %lu, %s: %.3f seconds\n", run, program_names[ p ], elapsed_time );
+
+				if ( run == 1 || elapsed_time < best_times[ p ] )
+				{
+					best_times[ p ] = elapsed_time;
+				}
+			}
+		}
+	}
+
+	// The time includes starting the process, which is the same for every build.
+	for ( unsigned int p = 0; p < program_count; ++p )
+	{
+		wprintf( L"%s, %s: best %.3f seconds (%.0f entries per second)\n", layout->name, program_names[ p ], best_times[ p ], ( best_times[ p ] > 0.0 ? entry_count / best_times[ p ] : 0.0 ) );
+	}
+	wprintf( L"\n" );
+
+	DeleteFileW( BENCHMARK_DATABASE );
+
+	return true;
+}
+
+int wmain( int argc, wchar_t *argv[] )
+{
+	if ( argc < 2 || wcslen( argv[ 1 ] ) >= MAX_PATH || ( argc > 4 && wcslen( argv[ 4 ] ) >= MAX_PATH ) )
+	{
+		wprintf( L"Usage: thumbcache_benchmark <path of thumbcache_viewer_cmd.exe> [number of entries] [number of runs] [path of a baseline thumbcache_viewer_cmd.exe]\n" );
+		return 1;
+	}
+
+	unsigned int entry_count = ( argc > 2 ? wcstoul( argv[ 2 ], NULL, 10 ) : DEFAULT_ENTRY_COUNT );
+	unsigned int run_count = ( argc > 3 ? wcstoul( argv[ 3 ], NULL, 10 ) : DEFAULT_RUN_COUNT );
+	if ( entry_count == 0 || run_count == 0 )
+	{
+		wprintf( L"The number of entries and runs must be greater than 0.\n" );
+		return 1;
+	}
+
+	// The baseline is run first so that its runs are interleaved with the new build's.
+	wchar_t *programs[ 2 ] = { NULL, NULL };
+	unsigned int program_count = 0;
+	if ( argc > 4 )
+	{
+		programs[ program_count++ ] = argv[ 4 ];
+		program_names = baseline_program_names;
+	}
+	else
+	{
+		program_names = single_program_names;
+	}
+	programs[ program_count++ ] = argv[ 1 ];
+
+	const unsigned int layout_count = sizeof( layouts ) / sizeof( layouts[ 0 ] );
+	double best_times[ layout_count ][ 2 ];
+
+	for ( unsigned int i = 0; i < layout_count; ++i )
+	{
+		if ( !RunLayout( programs, program_count, &layouts[ i ], entry_count, run_count, best_times[ i ] ) )
+		{
+			return 1;
+		}
+	}
+
+	// A summary that can be pasted into a commit message.
+	wprintf( L"Entries per second (%lu entries, best of %lu runs):\n", entry_count, run_count );
+	for ( unsigned int i = 0; i < layout_count; ++i )
+	{
+		if ( program_count == 1 )
+		{
+			wprintf( L"  %-13s %10.0f\n", layouts[ i ].name, entry_count / best_times[ i ][ 0 ] );
+		}
+		else
+		{
+			wprintf( L"  %-13s baseline %10.0f  new %10.0f  (%+.1f%%)\n", layouts[ i ].name,
+					 entry_count / best_times[ i ][ 0 ], entry_count / best_times[ i ][ 1 ],
+					 ( ( best_times[ i ][ 0 ] / best_times[ i ][ 1 ] ) - 1.0 ) * 100.0 );
+		}
+	}
+
+	return 0;
+}
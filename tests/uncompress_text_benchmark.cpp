@@ -0,0 +1,175 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures the throughput of UncompressText() for each compression type.
+// The values are made here: run-length values use runs of up to 255 characters, and byte indexed values give every byte an 8-bit code.
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/uncompress_text.cpp"
+
+#include <stdlib.h>
+
+// The uncompressed size of a byte indexed value is 16 bits, so the text has to fit in it with its run-length bytes.
+#define CHARACTER_COUNT		16384
+#define TEXT_SIZE			( CHARACTER_COUNT * sizeof( wchar_t ) )
+
+#define VALUE_BUFFER_SIZE	( 1 + sizeof( unsigned short ) + ( TEXT_HUFFMAN_SYMBOL_COUNT / 2 ) + TEXT_SIZE + 1024 )
+
+#define ITERATIONS			2000
+
+// Obfuscates a value in-place.
+void ObfuscateText( unsigned char *value, size_t value_size )
+{
+	unsigned int key = 0x05000113 ^ ( unsigned int )value_size;
+	for ( size_t i = 0; i < value_size; ++i )
+	{
+		value[ i ] = GetTextByte( value, key, i );
+	}
+}
+
+// Writes the text as runs of characters that share an upper byte. Returns the number of bytes written.
+size_t RunLengthEncode( const wchar_t *text, unsigned int character_count, unsigned char *buffer )
+{
+	size_t length = 0;
+
+	for ( unsigned int i = 0; i < character_count; )
+	{
+		unsigned char upper_byte = ( unsigned char )( text[ i ] >> 8 );
+		unsigned int run_length = 0;
+		while ( i + run_length < character_count && run_length < 255 && ( unsigned char )( text[ i + run_length ] >> 8 ) == upper_byte )
+		{
+			++run_length;
+		}
+
+		buffer[ length++ ] = ( unsigned char )run_length;
+		buffer[ length++ ] = upper_byte;
+
+		for ( ; run_length > 0; --run_length, ++i )
+		{
+			buffer[ length++ ] = ( unsigned char )text[ i ];
+		}
+	}
+
+	return length;
+}
+
+// Writes the bytes with an 8-bit code for every byte value. The code of a byte is the byte itself.
+size_t ByteIndexEncode( const unsigned char *data, size_t data_size, unsigned char *buffer )
+{
+	size_t length = 0;
+
+	buffer[ length++ ] = ( unsigned char )data_size;
+	buffer[ length++ ] = ( unsigned char )( data_size >> 8 );
+
+	memset( buffer + length, 0x88, TEXT_HUFFMAN_SYMBOL_COUNT / 2 );
+	length += TEXT_HUFFMAN_SYMBOL_COUNT / 2;
+
+	// Each 16-bit word holds two codes, and the first one is in its upper byte.
+	for ( size_t i = 0; i < data_size; i += 2 )
+	{
+		buffer[ length++ ] = ( i + 1 < data_size ? data[ i + 1 ] : 0 );
+		buffer[ length++ ] = data[ i ];
+	}
+
+	return length;
+}
+
+// Text that looks like file paths, with some characters outside of ASCII.
+void FillText( wchar_t *text, unsigned int character_count )
+{
+	unsigned int state = 0x12345678;
+	for ( unsigned int i = 0; i < character_count; ++i )
+	{
+		state = state * 1103515245 + 12345;
+		unsigned int r = ( state >> 16 ) & 0x3F;
+		text[ i ] = ( wchar_t )( r < 2 ? L'\\' : ( r < 4 ? 0x0391 + ( ( state >> 24 ) & 0x0F ) : L'a' + ( r % 26 ) ) );
+	}
+}
+
+void RunType( const char *name, unsigned char compression, const unsigned char *data, size_t data_size, const wchar_t *text, wchar_t *output )
+{
+	unsigned char *value = ( unsigned char * )malloc( VALUE_BUFFER_SIZE );
+	if ( value == NULL )
+	{
+		Check( false, "%s: could not allocate the value.", name );
+		return;
+	}
+
+	size_t value_size = 1;
+	value[ 0 ] = compression;
+
+	if ( compression & TEXT_COMPRESSION_BYTE_INDEXED )
+	{
+		value_size += ByteIndexEncode( data, data_size, value + 1 );
+	}
+	else
+	{
+		memcpy( value + 1, data, data_size );
+		value_size += data_size;
+	}
+
+	ObfuscateText( value, value_size );
+
+	memset( output, 0, TEXT_SIZE );
+	int length = UncompressText( value, value_size, output, TEXT_SIZE );
+	Check( length == ( int )TEXT_SIZE && memcmp( output, text, TEXT_SIZE ) == 0, "%s: the output doesn't match the text.", name );
+
+	double start_time = GetSeconds();
+
+	for ( unsigned int i = 0; i < ITERATIONS; ++i )
+	{
+		UncompressText( value, value_size, output, TEXT_SIZE );
+	}
+
+	double elapsed_time = GetSeconds() - start_time;
+
+	printf( "%-24s%8u byte value%10.1f MB/s\n", name, ( unsigned int )value_size, ( elapsed_time > 0.0 ? ( double )TEXT_SIZE * ITERATIONS / elapsed_time / 1000000.0 : 0.0 ) );
+
+	free( value );
+}
+
+int main()
+{
+	wchar_t *text = ( wchar_t * )malloc( TEXT_SIZE );
+	wchar_t *output = ( wchar_t * )malloc( TEXT_SIZE );
+	unsigned char *run_length = ( unsigned char * )malloc( TEXT_SIZE * 2 );
+	if ( text == NULL || output == NULL || run_length == NULL )
+	{
+		printf( "Could not allocate the buffers.\n" );
+		free( text );
+		free( output );
+		free( run_length );
+		return 1;
+	}
+
+	FillText( text, CHARACTER_COUNT );
+	size_t run_length_size = RunLengthEncode( text, CHARACTER_COUNT, run_length );
+
+	printf( "%u characters of output, %u times. The throughput is of the output.\n", CHARACTER_COUNT, ITERATIONS );
+
+	RunType( "Uncompressed", 0, ( unsigned char * )text, TEXT_SIZE, text, output );
+	RunType( "Run-length", TEXT_COMPRESSION_RUN_LENGTH, run_length, run_length_size, text, output );
+	RunType( "Byte indexed", TEXT_COMPRESSION_BYTE_INDEXED, ( unsigned char * )text, TEXT_SIZE, text, output );
+	RunType( "Byte indexed run-length", TEXT_COMPRESSION_BYTE_INDEXED | TEXT_COMPRESSION_RUN_LENGTH, run_length, run_length_size, text, output );
+
+	free( run_length );
+	free( output );
+	free( text );
+
+	return FinishChecks();
+}
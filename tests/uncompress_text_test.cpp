@@ -0,0 +1,210 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks UncompressText() against values in each of its formats, values that it has to reject, and output buffers that are too small.
+// The samples were made with an encoder that was written separately from the format description in uncompress_text.cpp.
+// They weren't captured from a Windows Search database, so they don't prove that the decoder matches MSSUncompressText().
+
+#include "check.h"
+#include "../thumbcache_viewer_cmd/uncompress_text.cpp"
+
+// L"Hi" with no compression.
+static const unsigned char uncompressed_sample[] =
+{
+	0x16, 0x48, 0x02, 0x6F, 0x12
+};
+
+// L"thumbcache_256.db" as a single run.
+static const unsigned char run_length_sample[] =
+{
+	0x06, 0x11, 0x02, 0x72, 0x6B, 0x71, 0x6B, 0x60, 0x6C, 0x69, 0x69, 0x66, 0x6E, 0x53, 0x3C, 0x3F,
+	0x21, 0x3E, 0x76, 0x74
+};
+
+// "Omega Delta" with a Greek capital omega and delta, as runs with three upper bytes. A run with a count of 0 follows the first one.
+static const unsigned char mixed_run_length_sample[] =
+{
+	0x04, 0x01, 0x01, 0xAF, 0x01, 0x7B, 0x03, 0x02, 0x60, 0x6D, 0x6D, 0x6F, 0x29, 0x0D, 0x0D, 0x9E,
+	0x11, 0x10, 0x77, 0x7A, 0x65, 0x75
+};
+
+// L"C:\\Users\\Public\\Pictures\\Sample Pictures\\Koala.jpg" with byte indexing.
+static const unsigned char byte_indexed_sample[] =
+{
+	0xBA, 0x64, 0x02, 0x07, 0xBC, 0x04, 0x06, 0x02, 0xB0, 0x08, 0x0A, 0x0E, 0xB4, 0x0C, 0x0E, 0x0A,
+	0xA8, 0x10, 0x12, 0x11, 0xAC, 0x14, 0x16, 0x12, 0xA0, 0x18, 0x1D, 0x1E, 0xA4, 0x1C, 0x1E, 0x1A,
+	0x9F, 0x20, 0x22, 0x26, 0xEC, 0x24, 0x26, 0x22, 0xE0, 0x28, 0x2A, 0x2B, 0xE4, 0x5C, 0x2E, 0x2A,
+	0x88, 0x34, 0x32, 0x66, 0xDB, 0x64, 0x56, 0x62, 0x86, 0x5D, 0x5A, 0x38, 0xD1, 0x6A, 0x3E, 0x3A,
+	0xF8, 0x40, 0x42, 0x46, 0xFC, 0x44, 0x46, 0x42, 0xF0, 0x48, 0x4A, 0x4E, 0xF4, 0x4C, 0x4E, 0x4A,
+	0xE8, 0x50, 0x52, 0x56, 0xEC, 0x54, 0x56, 0x52, 0xE0, 0x58, 0x5A, 0x5E, 0xE4, 0x5C, 0x5E, 0x5A,
+	0xD8, 0x60, 0x62, 0x66, 0xDC, 0x64, 0x66, 0x62, 0xD0, 0x68, 0x6A, 0x6E, 0xD4, 0x6C, 0x6E, 0x6A,
+	0xC8, 0x70, 0x72, 0x76, 0xCC, 0x74, 0x76, 0x72, 0xC0, 0x78, 0x7A, 0x7E, 0xC4, 0x7C, 0x7E, 0x7A,
+	0x38, 0x80, 0x82, 0x72, 0xCA, 0x62, 0x01, 0xE3, 0x65, 0xAC, 0x1E, 0x74, 0xE7, 0xA4, 0x65, 0x1C,
+	0xAC, 0x4B, 0xC3, 0xBC, 0x60, 0x8B, 0x5C, 0xE2, 0x73, 0xED, 0x73, 0x8C, 0x7A, 0xDB, 0xC7, 0xAA,
+	0x75, 0x88, 0x09, 0xD4, 0x60, 0x4D, 0x3C, 0x15, 0xAC, 0x70, 0xDE
+};
+
+// L"C:\\Users\\Public\\Pictures\\Sample Pictures\\Chrysanthemum.jpg" with byte indexing and run-length encoding.
+static const unsigned char byte_indexed_run_length_sample[] =
+{
+	0xB5, 0x3C, 0x02, 0x00, 0xB2, 0x04, 0x06, 0x02, 0xBE, 0x08, 0x0A, 0x0E, 0xBA, 0x0C, 0x0E, 0x0A,
+	0xA6, 0x10, 0x12, 0x10, 0xA2, 0x14, 0x16, 0x12, 0xAE, 0x18, 0x1C, 0x1E, 0xAA, 0x1C, 0x1E, 0x1A,
+	0x93, 0x20, 0x22, 0x26, 0xC2, 0x24, 0x26, 0x22, 0x9E, 0x28, 0x2A, 0x2A, 0xFA, 0x4C, 0x2E, 0x2A,
+	0x86, 0x34, 0x32, 0x66, 0xC4, 0x74, 0x56, 0x77, 0x88, 0x7D, 0x3F, 0x3B, 0xCE, 0x78, 0x3E, 0x6A,
+	0xF6, 0x40, 0x42, 0x46, 0xF2, 0x44, 0x46, 0x42, 0xFE, 0x48, 0x4A, 0x4E, 0xFA, 0x4C, 0x4E, 0x4A,
+	0xE6, 0x50, 0x52, 0x56, 0xE2, 0x54, 0x56, 0x52, 0xEE, 0x58, 0x5A, 0x5E, 0xEA, 0x5C, 0x5E, 0x5A,
+	0xD6, 0x60, 0x62, 0x66, 0xD2, 0x64, 0x66, 0x62, 0xDE, 0x68, 0x6A, 0x6E, 0xDA, 0x6C, 0x6E, 0x6A,
+	0xC6, 0x70, 0x72, 0x76, 0xC2, 0x74, 0x76, 0x72, 0xCE, 0x78, 0x7A, 0x7E, 0xCA, 0x7C, 0x7E, 0x7A,
+	0x36, 0x80, 0x82, 0x93, 0x95, 0x7C, 0x26, 0x4C, 0xD8, 0xB6, 0xAB, 0x86, 0xDB, 0x86, 0xCF, 0x07,
+	0x03, 0x2B, 0x55, 0x26, 0x0C, 0x16, 0xEA, 0xD9, 0x3A, 0x15, 0x81, 0x45, 0x44, 0xFA, 0xE5, 0xF1,
+	0x38, 0x77, 0x89, 0x5E, 0xE8
+};
+
+#define SAMPLE_BUFFER_SIZE	512
+
+// Obfuscates or unobfuscates a value in-place. Both are the same operation.
+void ObfuscateText( unsigned char *value, size_t value_size )
+{
+	unsigned int key = 0x05000113 ^ ( unsigned int )value_size;
+	for ( size_t i = 0; i < value_size; ++i )
+	{
+		value[ i ] = GetTextByte( value, key, i );
+	}
+}
+
+// Unobfuscates a sample into buffer so that it can be changed and obfuscated again.
+size_t CopyPlainSample( unsigned char *buffer, const unsigned char *sample, size_t sample_size )
+{
+	memcpy( buffer, sample, sample_size );
+	ObfuscateText( buffer, sample_size );
+
+	return sample_size;
+}
+
+void CheckSample( const char *description, const unsigned char *sample, size_t sample_size, const wchar_t *expected )
+{
+	size_t expected_length = 0;
+	while ( expected[ expected_length / sizeof( wchar_t ) ] != L'\0' )
+	{
+		expected_length += sizeof( wchar_t );
+	}
+
+	// The length is returned when there's no output buffer.
+	int length = UncompressText( sample, sample_size, NULL, 0 );
+	Check( length == ( int )expected_length, "%s: got a length of %d, expected %u", description, length, ( unsigned int )expected_length );
+
+	// The value is decoded in full, and nothing is written past it. Only the first 64 characters of the output are compared.
+	wchar_t output[ 64 + 1 ];
+	memset( output, 0xFF, sizeof( output ) );
+
+	length = UncompressText( sample, sample_size, output, sizeof( wchar_t ) * 64 );
+	Check( length == ( int )expected_length && memcmp( output, expected, expected_length ) == 0, "%s: the output doesn't match", description );
+	Check( output[ expected_length / sizeof( wchar_t ) ] == ( wchar_t )0xFFFF, "%s: wrote past the output", description );
+
+	// An output buffer that's too small gets as much as fits, and the full length is still returned.
+	for ( size_t dst_size = 0; dst_size < expected_length; dst_size += 3 )
+	{
+		memset( output, 0xFF, sizeof( output ) );
+
+		length = UncompressText( sample, sample_size, output, dst_size );
+		Check( length == ( int )expected_length && memcmp( output, expected, dst_size ) == 0, "%s: %u byte buffer: the output doesn't match", description, ( unsigned int )dst_size );
+		Check( ( ( unsigned char * )output )[ dst_size ] == 0xFF, "%s: %u byte buffer: wrote past the output", description, ( unsigned int )dst_size );
+	}
+}
+
+// Obfuscates plain and checks that it's rejected.
+void CheckRejected( const char *description, unsigned char *plain, size_t plain_size )
+{
+	ObfuscateText( plain, plain_size );
+
+	wchar_t output[ 64 ];
+	int length = UncompressText( plain, plain_size, output, sizeof( output ) );
+	Check( length == -1, "%s: got %d, expected -1", description, length );
+}
+
+int main()
+{
+	CheckSample( "Uncompressed", uncompressed_sample, sizeof( uncompressed_sample ), L"Hi" );
+	CheckSample( "Run-length", run_length_sample, sizeof( run_length_sample ), L"thumbcache_256.db" );
+	CheckSample( "Mixed run-length", mixed_run_length_sample, sizeof( mixed_run_length_sample ), L"\x03A9mega \x0394" L"elta" );
+	CheckSample( "Byte indexed", byte_indexed_sample, sizeof( byte_indexed_sample ), L"C:\\Users\\Public\\Pictures\\Sample Pictures\\Koala.jpg" );
+	CheckSample( "Byte indexed run-length", byte_indexed_run_length_sample, sizeof( byte_indexed_run_length_sample ), L"C:\\Users\\Public\\Pictures\\Sample Pictures\\Chrysanthemum.jpg" );
+
+	// There's nothing to decode, or nowhere to put it.
+	wchar_t output[ 64 ];
+	Check( UncompressText( NULL, 5, output, sizeof( output ) ) == -1, "A NULL value was accepted" );
+	Check( UncompressText( uncompressed_sample, 0, output, sizeof( output ) ) == -1, "An empty value was accepted" );
+	Check( UncompressText( uncompressed_sample, sizeof( uncompressed_sample ), NULL, sizeof( output ) ) == -1, "A NULL output buffer with a size was accepted" );
+
+	// A compression type with nothing after it is an empty string.
+	unsigned char empty[] = { TEXT_COMPRESSION_RUN_LENGTH };
+	ObfuscateText( empty, sizeof( empty ) );
+	Check( UncompressText( empty, sizeof( empty ), output, sizeof( output ) ) == 0, "An empty run-length value wasn't empty" );
+
+	unsigned char plain[ SAMPLE_BUFFER_SIZE ];
+
+	// Unknown compression type bits.
+	unsigned char unknown_type[] = { 0x04, 'H', 0x00, 'i', 0x00 };
+	CheckRejected( "Unknown compression type", unknown_type, sizeof( unknown_type ) );
+
+	// The output has to be whole UTF-16 characters.
+	unsigned char odd_length[] = { 0x00, 'H', 0x00, 'i' };
+	CheckRejected( "Odd length", odd_length, sizeof( odd_length ) );
+
+	// A run that ends before all of its characters, and a count without its upper byte.
+	unsigned char truncated_run[] = { TEXT_COMPRESSION_RUN_LENGTH, 0x03, 0x00, 'a', 'b' };
+	CheckRejected( "Truncated run", truncated_run, sizeof( truncated_run ) );
+
+	unsigned char missing_upper_byte[] = { TEXT_COMPRESSION_RUN_LENGTH, 0x01, 0x00, 'a', 0x00 };
+	CheckRejected( "Missing upper byte", missing_upper_byte, sizeof( missing_upper_byte ) );
+
+	// The code lengths are cut short.
+	size_t plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	CheckRejected( "Truncated code lengths", plain, 1 + sizeof( unsigned short ) + 100 );
+
+	// A code length that's longer than 11 bits. 'C' is the first character of the sample.
+	plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	plain[ 1 + sizeof( unsigned short ) + ( 'C' / 2 ) ] |= ( 'C' & 1 ? 0xC0 : 0x0C );
+	CheckRejected( "Code length over 11 bits", plain, plain_size );
+
+	// Codes that don't fill the table. Every byte that's in the sample has a code, so dropping one leaves a gap.
+	plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	plain[ 1 + sizeof( unsigned short ) + ( 'C' / 2 ) ] &= ( 'C' & 1 ? 0x0F : 0xF0 );
+	CheckRejected( "Incomplete code table", plain, plain_size );
+
+	// Codes that would overfill the table.
+	plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	plain[ 1 + sizeof( unsigned short ) + ( 0xFE / 2 ) ] = 0x11;
+	CheckRejected( "Overfull code table", plain, plain_size );
+
+	// The bit stream ends before the uncompressed size is reached.
+	plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	CheckRejected( "Truncated bit stream", plain, plain_size - 8 );
+
+	// An uncompressed size that asks for more symbols than there are.
+	plain_size = CopyPlainSample( plain, byte_indexed_sample, sizeof( byte_indexed_sample ) );
+	plain[ 1 ] += 16;
+	CheckRejected( "Uncompressed size too large", plain, plain_size );
+
+	// The decoded bytes of byte_indexed_run_length_sample end in the middle of a run when its size is cut.
+	plain_size = CopyPlainSample( plain, byte_indexed_run_length_sample, sizeof( byte_indexed_run_length_sample ) );
+	plain[ 1 ] -= 1;
+	CheckRejected( "Byte indexed run cut short", plain, plain_size );
+
+	return FinishChecks();
+}
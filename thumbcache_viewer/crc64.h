@@ -19,6 +19,10 @@
 #ifndef CRC64_H
 #define CRC64_H
 
+// Uses the fastest kernel that the processor supports. They all produce the same CRC.
 unsigned long long crc64( char *buf, unsigned int length, unsigned long long init_crc );
 
+// The data checksum that's stored in a cache entry.
+unsigned long long GetDataChecksum( const unsigned char *data, unsigned int data_size );
+
 #endif
@@ -0,0 +1,44 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "entry_checksums.h"
+#include "crc64.h"
+
+// Calculates the checksums of an entry that was read into memory and compares them with the ones that are stored in its header.
+// entry begins at the entry's header and holds length bytes. header_size is the number of header bytes that the header checksum covers.
+// The data begins at data_start and runs to the end of entry. If less than the whole entry was read, then only what was read is checksummed.
+// This doesn't depend on how the entry was read so that it can be tested on its own. Returns ENTRY_BAD_HEADER and/or ENTRY_BAD_DATA, or 0 if both match.
+unsigned char VerifyEntryChecksums( const unsigned char *entry, unsigned int length, unsigned int header_size, unsigned int data_start, unsigned long long header_checksum, unsigned long long data_checksum, ENTRY_CHECKSUMS *verified )
+{
+	unsigned char result = 0;
+
+	// The header checksum uses an initial CRC of -1
+	verified->header_checksum = crc64( ( char * )entry, ( length < header_size ? length : header_size ), 0xFFFFFFFFFFFFFFFF );
+	if ( verified->header_checksum != header_checksum )
+	{
+		result |= ENTRY_BAD_HEADER;
+	}
+
+	verified->data_checksum = GetDataChecksum( entry + data_start, ( length > data_start ? length - data_start : 0 ) );
+	if ( verified->data_checksum != data_checksum )
+	{
+		result |= ENTRY_BAD_DATA;
+	}
+
+	return result;
+}
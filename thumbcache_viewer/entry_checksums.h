@@ -0,0 +1,35 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTRY_CHECKSUMS_H
+#define ENTRY_CHECKSUMS_H
+
+// Flags that VerifyEntryChecksums() returns.
+#define ENTRY_BAD_HEADER	0x01
+#define ENTRY_BAD_DATA		0x02
+
+// The checksums that were calculated for an entry.
+struct ENTRY_CHECKSUMS
+{
+	unsigned long long header_checksum;
+	unsigned long long data_checksum;
+};
+
+unsigned char VerifyEntryChecksums( const unsigned char *entry, unsigned int length, unsigned int header_size, unsigned int data_start, unsigned long long header_checksum, unsigned long long data_checksum, ENTRY_CHECKSUMS *verified );
+
+#endif
@@ -0,0 +1,181 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "entry_index.h"
+
+#include <stddef.h>
+
+// Indices larger than this are ignored so that they can be read at once.
+#define MAX_ENTRY_INDEX_SIZE	0x7FFFFFFF
+
+// Returns the database path with the index extension appended to it.
+wchar_t *GetEntryIndexPath( const wchar_t *database_path )
+{
+	int database_path_length = ( int )wcslen( database_path );
+	int index_path_length = database_path_length + ( sizeof( ENTRY_INDEX_EXTENSION ) / sizeof( wchar_t ) );	// Includes the NULL character.
+
+	wchar_t *index_path = ( wchar_t * )malloc( sizeof( wchar_t ) * index_path_length );
+	if ( index_path != NULL )
+	{
+		swprintf_s( index_path, index_path_length, L"%s" ENTRY_INDEX_EXTENSION, database_path );
+	}
+
+	return index_path;
+}
+
+// Fills in the fields that identify the database. The file pointer is left at an undefined position.
+bool GetEntryIndexKey( HANDLE hFile, unsigned short creator, ENTRY_INDEX_HEADER *eih )
+{
+	LARGE_INTEGER file_size;
+	FILETIME last_write_time;
+	if ( GetFileSizeEx( hFile, &file_size ) == FALSE || GetFileTime( hFile, NULL, NULL, &last_write_time ) == FALSE )
+	{
+		return false;
+	}
+
+	// The largest header is 28 bytes (WINDOWS_8v2).
+	unsigned char header[ 28 ];
+	DWORD read = 0;
+	if ( SetFilePointer( hFile, 0, NULL, FILE_BEGIN ) == INVALID_SET_FILE_POINTER || ReadFile( hFile, header, 28, &read, NULL ) == FALSE )
+	{
+		return false;
+	}
+
+	// FNV-1a
+	unsigned long long header_hash = 14695981039346656037ULL;
+	for ( DWORD i = 0; i < read; ++i )
+	{
+		header_hash ^= header[ i ];
+		header_hash *= 1099511628211ULL;
+	}
+
+	memset( eih, 0, sizeof( ENTRY_INDEX_HEADER ) );
+	memcpy( eih->magic_identifier, "TCIX", 4 );
+	eih->version = ENTRY_INDEX_VERSION;
+	eih->creator = creator;
+	eih->database_size = file_size.QuadPart;
+	eih->database_write_time = ( ( unsigned long long )last_write_time.dwHighDateTime << 32 ) | last_write_time.dwLowDateTime;
+	eih->header_hash = header_hash;
+
+	return true;
+}
+
+// Returns NULL if the index doesn't exist, is damaged, or was saved for a different version of the database.
+// If same_database is false, then the index is returned even if the database has changed since it was saved.
+ENTRY_INDEX *LoadEntryIndex( const wchar_t *database_path, const ENTRY_INDEX_HEADER *key, bool same_database )
+{
+	ENTRY_INDEX *index = NULL;
+
+	wchar_t *index_path = GetEntryIndexPath( database_path );
+	if ( index_path == NULL )
+	{
+		return NULL;
+	}
+
+	HANDLE hFile = CreateFile( index_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+	free( index_path );
+
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		return NULL;
+	}
+
+	LARGE_INTEGER file_size;
+	if ( GetFileSizeEx( hFile, &file_size ) != FALSE && file_size.QuadPart >= sizeof( ENTRY_INDEX_HEADER ) && file_size.QuadPart <= MAX_ENTRY_INDEX_SIZE )
+	{
+		unsigned int index_size = ( unsigned int )file_size.QuadPart;
+		DWORD read = 0;
+
+		unsigned char *buffer = ( unsigned char * )malloc( sizeof( unsigned char ) * index_size );
+		if ( buffer != NULL && ReadFile( hFile, buffer, index_size, &read, NULL ) != FALSE && read == index_size )
+		{
+			ENTRY_INDEX_HEADER *eih = ( ENTRY_INDEX_HEADER * )buffer;
+
+			unsigned int records_size = index_size - sizeof( ENTRY_INDEX_HEADER );
+
+			// The database must not have changed since the index was saved, and the records and names must fill the rest of the index.
+			if ( memcmp( eih, key, ( same_database ? offsetof( ENTRY_INDEX_HEADER, record_count ) : offsetof( ENTRY_INDEX_HEADER, database_size ) ) ) == 0 &&
+				 eih->record_count <= ( records_size / sizeof( ENTRY_INDEX_RECORD ) ) &&
+				 eih->name_size == records_size - ( eih->record_count * sizeof( ENTRY_INDEX_RECORD ) ) )
+			{
+				index = ( ENTRY_INDEX * )malloc( sizeof( ENTRY_INDEX ) );
+				if ( index != NULL )
+				{
+					index->buffer = buffer;
+					index->header = eih;
+					index->records = ( ENTRY_INDEX_RECORD * )( buffer + sizeof( ENTRY_INDEX_HEADER ) );
+					index->names = buffer + sizeof( ENTRY_INDEX_HEADER ) + ( eih->record_count * sizeof( ENTRY_INDEX_RECORD ) );
+				}
+			}
+		}
+
+		if ( index == NULL )
+		{
+			free( buffer );
+		}
+	}
+
+	CloseHandle( hFile );
+
+	return index;
+}
+
+// The record count and name size are taken from eih. A partially written index is deleted.
+bool SaveEntryIndex( const wchar_t *database_path, const ENTRY_INDEX_HEADER *eih, const ENTRY_INDEX_RECORD *records, const void *names )
+{
+	bool ret = false;
+	DWORD written = 0;
+
+	wchar_t *index_path = GetEntryIndexPath( database_path );
+	if ( index_path == NULL )
+	{
+		return false;
+	}
+
+	// This will fail if the database is on read-only media. We'll simply parse it each time.
+	HANDLE hFile = CreateFile( index_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile != INVALID_HANDLE_VALUE )
+	{
+		unsigned int records_size = eih->record_count * sizeof( ENTRY_INDEX_RECORD );
+
+		ret = ( WriteFile( hFile, eih, sizeof( ENTRY_INDEX_HEADER ), &written, NULL ) != FALSE && written == sizeof( ENTRY_INDEX_HEADER ) &&
+				( records_size == 0 || ( WriteFile( hFile, records, records_size, &written, NULL ) != FALSE && written == records_size ) ) &&
+				( eih->name_size == 0 || ( WriteFile( hFile, names, eih->name_size, &written, NULL ) != FALSE && written == eih->name_size ) ) );
+
+		CloseHandle( hFile );
+
+		if ( !ret )
+		{
+			DeleteFile( index_path );
+		}
+	}
+
+	free( index_path );
+
+	return ret;
+}
+
+void FreeEntryIndex( ENTRY_INDEX *index )
+{
+	if ( index != NULL )
+	{
+		free( index->buffer );
+		free( index );
+	}
+}
@@ -0,0 +1,162 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "find_signature.h"
+
+#include <string.h>
+#include <intrin.h>
+#include <emmintrin.h>
+
+// AVX2 intrinsics are available in Visual Studio 2012 and newer.
+#if defined( _MSC_VER ) && ( _MSC_VER >= 1700 )
+	#define USE_AVX2
+	#include <immintrin.h>
+#endif
+
+// The magic identifier "CMMM" as a little-endian integer.
+#define SIGNATURE	0x4D4D4D43
+
+typedef size_t ( *pfind_signature )( const unsigned char *buf, size_t length );
+
+pfind_signature g_find_signature = NULL;
+
+size_t find_signature_scalar( const unsigned char *buf, size_t length )
+{
+	for ( size_t i = 0; length >= 4 && i <= length - 4; ++i )
+	{
+		// Compare all 4 bytes at once. The buffer may not be aligned.
+		unsigned int value;
+		memcpy( &value, buf + i, sizeof( unsigned int ) );
+		if ( value == SIGNATURE )
+		{
+			return i;
+		}
+	}
+
+	return length;
+}
+
+size_t find_signature_sse2( const unsigned char *buf, size_t length )
+{
+	size_t i = 0;
+
+	const __m128i c = _mm_set1_epi8( 'C' );
+	const __m128i m = _mm_set1_epi8( 'M' );
+
+	// Test 16 positions at a time. Each position needs the 3 bytes that follow it.
+	for ( ; length >= 19 && i <= length - 19; i += 16 )
+	{
+		__m128i match = _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * )( buf + i ) ), c );
+		match = _mm_and_si128( match, _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * )( buf + i + 1 ) ), m ) );
+		match = _mm_and_si128( match, _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * )( buf + i + 2 ) ), m ) );
+		match = _mm_and_si128( match, _mm_cmpeq_epi8( _mm_loadu_si128( ( const __m128i * )( buf + i + 3 ) ), m ) );
+
+		unsigned long mask = ( unsigned long )_mm_movemask_epi8( match );
+		if ( mask != 0 )
+		{
+			unsigned long index;
+			_BitScanForward( &index, mask );
+
+			return i + index;
+		}
+	}
+
+	// Finish whatever is left.
+	return i + find_signature_scalar( buf + i, length - i );
+}
+
+#ifdef USE_AVX2
+
+size_t find_signature_avx2( const unsigned char *buf, size_t length )
+{
+	size_t i = 0;
+
+	const __m256i c = _mm256_set1_epi8( 'C' );
+	const __m256i m = _mm256_set1_epi8( 'M' );
+
+	// Test 32 positions at a time. Each position needs the 3 bytes that follow it.
+	for ( ; length >= 35 && i <= length - 35; i += 32 )
+	{
+		__m256i match = _mm256_cmpeq_epi8( _mm256_loadu_si256( ( const __m256i * )( buf + i ) ), c );
+		match = _mm256_and_si256( match, _mm256_cmpeq_epi8( _mm256_loadu_si256( ( const __m256i * )( buf + i + 1 ) ), m ) );
+		match = _mm256_and_si256( match, _mm256_cmpeq_epi8( _mm256_loadu_si256( ( const __m256i * )( buf + i + 2 ) ), m ) );
+		match = _mm256_and_si256( match, _mm256_cmpeq_epi8( _mm256_loadu_si256( ( const __m256i * )( buf + i + 3 ) ), m ) );
+
+		unsigned long mask = ( unsigned long )_mm256_movemask_epi8( match );
+		if ( mask != 0 )
+		{
+			_mm256_zeroupper();
+
+			unsigned long index;
+			_BitScanForward( &index, mask );
+
+			return i + index;
+		}
+	}
+
+	// Avoid the transition penalty when returning to SSE code.
+	_mm256_zeroupper();
+
+	// Finish whatever is left.
+	return i + find_signature_sse2( buf + i, length - i );
+}
+
+#endif
+
+pfind_signature select_find_signature()
+{
+	int cpu_info[ 4 ];
+	__cpuid( cpu_info, 0 );
+	int max_function_id = cpu_info[ 0 ];
+
+	__cpuid( cpu_info, 1 );
+
+#ifdef USE_AVX2
+	// The OS must support saving the YMM registers (OSXSAVE is set and XCR0 has the XMM and YMM state bits).
+	if ( max_function_id >= 7 && ( cpu_info[ 2 ] & ( 1 << 27 ) ) != 0 && ( _xgetbv( 0 ) & 0x06 ) == 0x06 )
+	{
+		int extended_info[ 4 ];
+		__cpuidex( extended_info, 7, 0 );
+		if ( ( extended_info[ 1 ] & ( 1 << 5 ) ) != 0 )
+		{
+			return find_signature_avx2;
+		}
+	}
+#endif
+
+#ifndef _WIN64
+	// SSE2 is always available on 64-bit processors.
+	if ( ( cpu_info[ 3 ] & ( 1 << 26 ) ) == 0 )
+	{
+		return find_signature_scalar;
+	}
+#endif
+
+	return find_signature_sse2;
+}
+
+size_t find_signature( const unsigned char *buf, size_t length )
+{
+	// Every thread would select the same function so there's no harm in racing here.
+	if ( g_find_signature == NULL )
+	{
+		g_find_signature = select_find_signature();
+	}
+
+	return g_find_signature( buf, length );
+}
@@ -58,6 +58,7 @@
 #define WM_DESTROY_ALT		WM_APP + 1	// Allows non-window threads to call DestroyWindow.
 #define WM_CHANGE_CURSOR	WM_APP + 2	// Updates the window cursor.
 #define WM_ALERT			WM_APP + 3	// Called from threads to display a message box.
+#define WM_GET_ENTRIES		WM_APP + 4	// Called from threads to collect the entries of the listview.
 
 // file info flags.
 #define FIF_TYPE_BMP		1
@@ -102,11 +103,12 @@ struct FILE_INFO
 	unsigned long long mapped_hash;		// Entry hash or Vista's filename integer representation.
 	wchar_t *filename;					// Name of the database entry.
 	SHARED_INFO *si;					// Shared information between items in a database.
-	EXTENDED_INFO *ei;					// Information retrieved from Windows.edb
+	unsigned int row_reference;			// The Windows.edb row that the entry was mapped to. Its values are retrieved when they're viewed. 0 if it wasn't mapped.
 	unsigned int header_offset;			// Offset of header.
 	unsigned int data_offset;			// Offset of data.
 	unsigned int size;					// Size of file.
 	unsigned char flag;					// 1 = bmp, 2 = jpg, 4 = png, 8 = in tree, 16 = verified headers, 32 = bad header, 64 = bad data.
+	bool shared_filename;				// The filename is a SHARED_FILENAME that's referenced by the entry's duplicates.
 };
 
 // Holds duplicate and blank entries.
@@ -186,6 +188,7 @@ extern float scale;					// Scale of the image.
 
 // List variables
 extern bool hide_blank_entries;		// Hide blank entries.
+extern bool use_index_files;		// Load each database's entries from its index, or save them to it.
 
 extern bool is_kbytes_c_offset;		// Toggle the cache entry offset text.
 extern bool is_kbytes_c_size;		// Toggle the cache entry size text.
@@ -0,0 +1,169 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_table.h"
+
+#define MINIMUM_CAPACITY	16
+
+// The keys can be small sequential IDs, so their bits are mixed before they're masked to a slot.
+static unsigned int get_slot( hash_table *table, unsigned long long key )
+{
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+
+	return ( unsigned int )key & ( table->capacity - 1 );
+}
+
+// Allocates the slots so that they're never more than half full.
+static bool allocate_slots( hash_table *table, unsigned int count )
+{
+	unsigned int capacity = MINIMUM_CAPACITY;
+	while ( capacity < 0x80000000 && capacity < count * 2 )
+	{
+		capacity <<= 1;
+	}
+
+	slot_type *slots = ( slot_type * )malloc( sizeof( slot_type ) * capacity );
+	if ( slots == NULL )
+	{
+		return false;
+	}
+
+	memset( slots, 0, sizeof( slot_type ) * capacity );
+
+	slot_type *old_slots = table->slots;
+	unsigned int old_capacity = table->capacity;
+
+	table->slots = slots;
+	table->capacity = capacity;
+
+	// Move the keys into the new slots.
+	for ( unsigned int i = 0; i < old_capacity; ++i )
+	{
+		if ( old_slots[ i ].used )
+		{
+			unsigned int index = get_slot( table, old_slots[ i ].key );
+			while ( slots[ index ].used )
+			{
+				index = ( index + 1 ) & ( capacity - 1 );
+			}
+
+			slots[ index ] = old_slots[ i ];
+		}
+	}
+
+	free( old_slots );
+
+	return true;
+}
+
+hash_table *hash_table_create( unsigned int expected_count )
+{
+	hash_table *table = ( hash_table * )malloc( sizeof( hash_table ) );
+	if ( table == NULL )
+	{
+		return NULL;
+	}
+
+	table->slots = NULL;
+	table->capacity = 0;
+	table->count = 0;
+
+	if ( !allocate_slots( table, expected_count ) )
+	{
+		free( table );
+		return NULL;
+	}
+
+	return table;
+}
+
+hash_table_status hash_table_insert( hash_table *table, unsigned long long key, unsigned int value )
+{
+	if ( table == NULL )
+	{
+		return HASH_TABLE_STATUS_TABLE_NOT_FOUND;
+	}
+
+	// Grow the table before it's more than half full.
+	if ( ( table->count + 1 ) * 2 > table->capacity )
+	{
+		if ( table->capacity == 0x80000000 || !allocate_slots( table, table->count + 1 ) )
+		{
+			return HASH_TABLE_STATUS_MEM_EXHAUSTED;
+		}
+	}
+
+	unsigned int index = get_slot( table, key );
+	while ( table->slots[ index ].used )
+	{
+		if ( table->slots[ index ].key == key )
+		{
+			return HASH_TABLE_STATUS_DUPLICATE_KEY;
+		}
+
+		index = ( index + 1 ) & ( table->capacity - 1 );
+	}
+
+	table->slots[ index ].key = key;
+	table->slots[ index ].value = value;
+	table->slots[ index ].used = true;
+
+	++table->count;
+
+	return HASH_TABLE_STATUS_OK;
+}
+
+bool hash_table_find( hash_table *table, unsigned long long key, unsigned int *value )
+{
+	if ( table == NULL )
+	{
+		return false;
+	}
+
+	unsigned int index = get_slot( table, key );
+	while ( table->slots[ index ].used )
+	{
+		if ( table->slots[ index ].key == key )
+		{
+			*value = table->slots[ index ].value;
+			return true;
+		}
+
+		index = ( index + 1 ) & ( table->capacity - 1 );
+	}
+
+	return false;
+}
+
+void hash_table_delete( hash_table *table )
+{
+	if ( table == NULL )
+	{
+		return;
+	}
+
+	free( table->slots );
+	free( table );
+}
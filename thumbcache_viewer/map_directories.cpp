@@ -0,0 +1,607 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "map_directories.h"
+#include "map_entries.h"
+#include "utilities.h"
+
+#include <stddef.h>
+
+// Size of the buffer that each thread reads its directory listings into.
+#define DIRECTORY_BUFFER_SIZE	65536
+
+// FileIdBothDirectoryInfo of FILE_INFO_BY_HANDLE_CLASS
+#define FILE_ID_BOTH_DIRECTORY_INFO_CLASS	10
+
+// FILE_ID_BOTH_DIR_INFO
+struct DIRECTORY_ENTRY
+{
+	DWORD NextEntryOffset;
+	DWORD FileIndex;
+	LARGE_INTEGER CreationTime;
+	LARGE_INTEGER LastAccessTime;
+	LARGE_INTEGER LastWriteTime;
+	LARGE_INTEGER ChangeTime;
+	LARGE_INTEGER EndOfFile;
+	LARGE_INTEGER AllocationSize;
+	DWORD FileAttributes;
+	DWORD FileNameLength;		// In bytes.
+	DWORD EaSize;
+	CCHAR ShortNameLength;		// In bytes.
+	WCHAR ShortName[ 12 ];
+	LARGE_INTEGER FileId;
+	WCHAR FileName[ 1 ];		// Not NULL terminated.
+};
+
+// Windows Vista and newer.
+typedef BOOL ( WINAPI *pGetFileInformationByHandleEx )( HANDLE hFile, int FileInformationClass, LPVOID lpFileInformation, DWORD dwBufferSize );
+
+pGetFileInformationByHandleEx _GetFileInformationByHandleEx = NULL;
+
+bool is_win_7_or_higher = true;						// Windows Vista uses a different file hashing algorithm.
+bool is_win_8_1_or_higher = true;					// Windows 8.1 uses a different file hashing algorithm.
+
+#define _WIN32_WINNT_WIN7		0x0601
+//#define _WIN32_WINNT_WIN8		0x0602
+#define _WIN32_WINNT_WINBLUE	0x0603
+
+BOOL IsWindowsVersionOrGreater( WORD wMajorVersion, WORD wMinorVersion, WORD wServicePackMajor )
+{
+	OSVERSIONINFOEXW osvi = { sizeof( osvi ), 0, 0, 0, 0, { 0 }, 0, 0 };
+	DWORDLONG const dwlConditionMask = VerSetConditionMask(
+		VerSetConditionMask(
+		VerSetConditionMask(
+		0, VER_MAJORVERSION, VER_GREATER_EQUAL ),
+		   VER_MINORVERSION, VER_GREATER_EQUAL ),
+		   VER_SERVICEPACKMAJOR, VER_GREATER_EQUAL );
+
+	osvi.dwMajorVersion = wMajorVersion;
+	osvi.dwMinorVersion = wMinorVersion;
+	osvi.wServicePackMajor = wServicePackMajor;
+
+	return VerifyVersionInfoW( &osvi, VER_MAJORVERSION | VER_MINORVERSION | VER_SERVICEPACKMAJOR, dwlConditionMask ) != FALSE;
+}
+
+BOOL IsWindows7OrGreater()
+{
+    return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WIN7 ), LOBYTE( _WIN32_WINNT_WIN7 ), 0 );
+}
+
+/*BOOL IsWindows8OrGreater()
+{
+	return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WIN8 ), LOBYTE( _WIN32_WINNT_WIN8 ), 0 );
+}*/
+
+BOOL IsWindows8Point1OrGreater()
+{
+	return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WINBLUE ), LOBYTE( _WIN32_WINNT_WINBLUE ), 0 );
+}
+
+unsigned long long HashData( char *data, unsigned long long hash, short length )
+{
+	while ( length-- > 0 )
+	{
+		hash ^= ( ( ( hash * 0x820 ) + ( *data++ & 0x00000000000000FF ) ) + ( hash >> 2 ) );
+	}
+
+	return hash;
+}
+
+// Continues the volume's hash with the file's information.
+unsigned long long HashFileInfo( unsigned long long hash, unsigned long long file_id, wchar_t *extension, FILETIME *last_write_time )
+{
+	// Hash File ID - found in the Master File Table.
+	hash = HashData( ( char * )&file_id, hash, sizeof( unsigned long long ) );
+
+	// Windows Vista doesn't hash the file extension or modified DOS time.
+	if ( is_win_7_or_higher )
+	{
+		// Hash Wide Character File Extension
+		hash = HashData( ( char * )extension, hash, ( short )( wcslen( extension ) * sizeof( wchar_t ) ) );
+
+		// Hash Last Modified DOS Time
+		unsigned short fat_date;
+		unsigned short fat_time;
+		FileTimeToDosDateTime( last_write_time, &fat_date, &fat_time );
+		unsigned int dos_time = fat_date;
+		dos_time = ( dos_time << 16 ) | fat_time;
+
+		hash = HashData( ( char * )&dos_time, hash, sizeof( unsigned int ) );
+
+		// Windows 8.1 calculates the precision loss between the converted write time and original write time.
+		if ( is_win_8_1_or_higher )
+		{
+			// Convert the DOS time back into a FILETIME.
+			FILETIME converted_write_time;
+			DosDateTimeToFileTime( fat_date, fat_time, &converted_write_time );
+
+			// We only need to hash the low order int.
+			unsigned int precision_loss = converted_write_time.dwLowDateTime - last_write_time->dwLowDateTime;
+
+			// Hash if there's any precision loss.
+			if ( precision_loss != 0 )
+			{
+				hash = HashData( ( char * )&precision_loss, hash, sizeof( unsigned int ) );
+			}
+		}
+	}
+
+	return hash;
+}
+
+void MapFile( SCAN_INFO *si, unsigned long long hash, wchar_t *filepath )
+{
+	EnterCriticalSection( &si->map_cs );
+
+	UpdateFileinfo( hash, filepath, false );
+	UpdateWindowInfo( hash, filepath );
+
+	LeaveCriticalSection( &si->map_cs );
+}
+
+// Opens the file to get its File ID and last write time.
+void HashFile( SCAN_INFO *si, SCAN_VOLUME *sv, wchar_t *filepath, wchar_t *extension )
+{
+	HANDLE hFile = CreateFile( filepath, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL );
+	if ( hFile != INVALID_HANDLE_VALUE )
+	{
+		BY_HANDLE_FILE_INFORMATION bhfi;
+		BOOL ret = GetFileInformationByHandle( hFile, &bhfi );
+		CloseHandle( hFile );
+
+		if ( ret != FALSE )
+		{
+			unsigned long long file_id = bhfi.nFileIndexHigh;
+			file_id = ( file_id << 32 ) | bhfi.nFileIndexLow;
+
+			MapFile( si, HashFileInfo( sv->volume_hash, file_id, extension, &bhfi.ftLastWriteTime ), filepath );
+		}
+	}
+}
+
+// Returns the length of "path\name", or 0 if it's not shorter than MAX_PATH.
+unsigned int BuildPath( wchar_t *filepath, SCAN_DIRECTORY *sd, const wchar_t *name, unsigned int name_length )
+{
+	unsigned int length = sd->path_length + 1 + name_length;
+	if ( length >= MAX_PATH )
+	{
+		return 0;
+	}
+
+	wmemcpy_s( filepath, MAX_PATH, sd->path, sd->path_length );
+	filepath[ sd->path_length ] = L'\\';
+	wmemcpy_s( filepath + sd->path_length + 1, MAX_PATH - ( sd->path_length + 1 ), name, name_length );
+	filepath[ length ] = L'\0';
+
+	return length;
+}
+
+// Adds a directory for any of the threads to list.
+bool PushDirectory( SCAN_INFO *si, SCAN_VOLUME *sv, wchar_t *path, unsigned int path_length )
+{
+	SCAN_DIRECTORY *sd = ( SCAN_DIRECTORY * )malloc( offsetof( SCAN_DIRECTORY, path ) + ( sizeof( wchar_t ) * ( path_length + 1 ) ) );
+	if ( sd == NULL )
+	{
+		return false;
+	}
+
+	sd->sv = sv;
+	sd->path_length = path_length;
+	wmemcpy_s( sd->path, path_length + 1, path, path_length );
+	sd->path[ path_length ] = L'\0';
+
+	EnterCriticalSection( &si->pending_cs );
+
+	sd->next = si->pending;
+	si->pending = sd;
+
+	LeaveCriticalSection( &si->pending_cs );
+
+	ReleaseSemaphore( si->pending_semaphore, 1, NULL );
+
+	return true;
+}
+
+// Lists the directory using FileIdBothDirectoryInfo. Each file is opened to get its last write time unless g_use_listed_write_times is set.
+// The listed time can be stale: NTFS updates an entry when its file is closed, but only for the name that the file was opened with, so hard links can have an older time.
+// Returns false if the file system can't list the directory this way.
+bool ListDirectory( SCAN_INFO *si, SCAN_DIRECTORY *sd, unsigned char *buffer )
+{
+	if ( _GetFileInformationByHandleEx == NULL )
+	{
+		return false;
+	}
+
+	wchar_t filepath[ MAX_PATH + 1 ];
+	wchar_t filename[ MAX_PATH ];
+
+	// A drive without the "\" would be its current directory.
+	wmemcpy_s( filepath, MAX_PATH + 1, sd->path, sd->path_length );
+	filepath[ sd->path_length ] = L'\\';
+	filepath[ sd->path_length + 1 ] = L'\0';
+
+	HANDLE hDirectory = CreateFile( filepath, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL );
+	if ( hDirectory == INVALID_HANDLE_VALUE )
+	{
+		return true;	// There's nothing we can list.
+	}
+
+	bool listed = false;
+
+	while ( !g_kill_scan && _GetFileInformationByHandleEx( hDirectory, FILE_ID_BOTH_DIRECTORY_INFO_CLASS, buffer, DIRECTORY_BUFFER_SIZE ) != FALSE )
+	{
+		listed = true;
+
+		DIRECTORY_ENTRY *de = ( DIRECTORY_ENTRY * )buffer;
+		while ( !g_kill_scan )
+		{
+			unsigned int name_length = de->FileNameLength / sizeof( wchar_t );
+
+			// See if the file is a directory.
+			if ( ( de->FileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 )
+			{
+				// Go through all directories except "." and ".." (current and parent)
+				if ( !( de->FileName[ 0 ] == L'.' && ( name_length == 1 || ( name_length == 2 && de->FileName[ 1 ] == L'.' ) ) ) )
+				{
+					// Limit the path length to MAX_PATH.
+					unsigned int length = BuildPath( filepath, sd, de->FileName, name_length );
+					if ( length > 0 )
+					{
+						PushDirectory( si, sd->sv, filepath, length );
+
+						// Only hash folders if enabled. A folder's entry isn't always updated when its contents change, so it's opened instead.
+						if ( g_include_folders )
+						{
+							HashFile( si, sd->sv, filepath, L"" );
+						}
+					}
+				}
+			}
+			else if ( name_length < MAX_PATH )
+			{
+				// The extension needs to be NULL terminated.
+				wmemcpy_s( filename, MAX_PATH, de->FileName, name_length );
+				filename[ name_length ] = L'\0';
+
+				// See if the file's extension is in our filter. Go to the next file if it's not.
+				wchar_t *ext = GetExtensionFromFilename( filename, name_length );
+				if ( MatchExtensionFilter( ext ) )
+				{
+					unsigned int length = BuildPath( filepath, sd, filename, name_length );
+					if ( length == 0 && de->ShortNameLength > 0 )
+					{
+						// See if the 8.3 filename can fit.
+						length = BuildPath( filepath, sd, de->ShortName, de->ShortNameLength / sizeof( wchar_t ) );
+					}
+
+					if ( length > 0 )
+					{
+						// File systems without File IDs set them to 0.
+						if ( g_use_listed_write_times && de->FileId.QuadPart != 0 )
+						{
+							MapFile( si, HashFileInfo( sd->sv->volume_hash, de->FileId.QuadPart, ext, ( FILETIME * )&de->LastWriteTime ), filepath );
+						}
+						else
+						{
+							HashFile( si, sd->sv, filepath, ext );
+						}
+					}
+				}
+			}
+
+			if ( de->NextEntryOffset == 0 )
+			{
+				break;
+			}
+
+			de = ( DIRECTORY_ENTRY * )( ( unsigned char * )de + de->NextEntryOffset );
+		}
+	}
+
+	DWORD error = GetLastError();
+
+	CloseHandle( hDirectory );
+
+	// The file system doesn't support FileIdBothDirectoryInfo.
+	if ( !listed && !g_kill_scan && error != ERROR_NO_MORE_FILES )
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Lists the directory by name and opens each file.
+void ListDirectoryByName( SCAN_INFO *si, SCAN_DIRECTORY *sd )
+{
+	// Set the file path to search for all files/folders in the current directory.
+	wchar_t filepath[ ( MAX_PATH * 2 ) + 2 ];
+	swprintf_s( filepath, ( MAX_PATH * 2 ) + 2, L"%.259s\\*", sd->path );
+
+	WIN32_FIND_DATA FindFileData;
+	HANDLE hFind = FindFirstFileEx( ( LPCWSTR )filepath, FindExInfoStandard, &FindFileData, FindExSearchNameMatch, NULL, 0 );
+	if ( hFind != INVALID_HANDLE_VALUE ) 
+	{
+		do
+		{
+			if ( g_kill_scan )
+			{
+				break;	// We need to close the find file handle.
+			}
+
+			unsigned int name_length = ( unsigned int )wcslen( FindFileData.cFileName );
+
+			// See if the file is a directory.
+			if ( ( FindFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 )
+			{
+				// Go through all directories except "." and ".." (current and parent)
+				if ( ( wcscmp( FindFileData.cFileName, L"." ) != 0 ) && ( wcscmp( FindFileData.cFileName, L".." ) != 0 ) )
+				{
+					// Limit the path length to MAX_PATH.
+					unsigned int length = BuildPath( filepath, sd, FindFileData.cFileName, name_length );
+					if ( length > 0 )
+					{
+						PushDirectory( si, sd->sv, filepath, length );
+
+						// Only hash folders if enabled.
+						if ( g_include_folders )
+						{
+							HashFile( si, sd->sv, filepath, L"" );
+						}
+					}
+				}
+			}
+			else
+			{
+				// See if the file's extension is in our filter. Go to the next file if it's not.
+				wchar_t *ext = GetExtensionFromFilename( FindFileData.cFileName, name_length );
+				if ( !MatchExtensionFilter( ext ) )
+				{
+					continue;
+				}
+
+				unsigned int length = BuildPath( filepath, sd, FindFileData.cFileName, name_length );
+				if ( length == 0 && FindFileData.cAlternateFileName[ 0 ] != 0 )
+				{
+					// See if the 8.3 filename can fit.
+					length = BuildPath( filepath, sd, FindFileData.cAlternateFileName, ( unsigned int )wcslen( FindFileData.cAlternateFileName ) );
+				}
+
+				if ( length > 0 )
+				{
+					HashFile( si, sd->sv, filepath, ext );
+				}
+			}
+		}
+		while ( FindNextFile( hFind, &FindFileData ) != 0 );	// Go to the next file.
+
+		FindClose( hFind );	// Close the find file handle.
+	}
+}
+
+// Lists pending directories until there are none left and no other thread is listing one.
+void ListDirectories( SCAN_INFO *si )
+{
+	// Reused for every directory. We can still list them by name without it.
+	unsigned char *buffer = ( unsigned char * )malloc( sizeof( unsigned char ) * DIRECTORY_BUFFER_SIZE );
+
+	while ( true )
+	{
+		WaitForSingleObject( si->pending_semaphore, INFINITE );
+
+		EnterCriticalSection( &si->pending_cs );
+
+		SCAN_DIRECTORY *sd = si->pending;
+		if ( sd != NULL )
+		{
+			si->pending = sd->next;
+			++si->active;
+		}
+
+		LeaveCriticalSection( &si->pending_cs );
+
+		if ( sd == NULL )
+		{
+			break;
+		}
+
+		// Directories that are still pending after the scan is cancelled are only freed.
+		if ( !g_kill_scan )
+		{
+			if ( buffer == NULL || !ListDirectory( si, sd, buffer ) )
+			{
+				ListDirectoryByName( si, sd );
+			}
+		}
+
+		free( sd );
+
+		EnterCriticalSection( &si->pending_cs );
+
+		bool finished = ( --si->active == 0 && si->pending == NULL );
+
+		LeaveCriticalSection( &si->pending_cs );
+
+		// Only a thread that's listing a directory can add more, so wake every thread to let them know we're done.
+		if ( finished )
+		{
+			ReleaseSemaphore( si->pending_semaphore, si->thread_count, NULL );
+		}
+	}
+
+	free( buffer );
+}
+
+unsigned __stdcall list_directories( void *pArguments )
+{
+	ListDirectories( ( SCAN_INFO * )pArguments );
+
+	_endthreadex( 0 );
+	return 0;
+}
+
+// Hashes the Volume GUID of the volume that the directory is on.
+bool GetVolumeHash( wchar_t *directory, unsigned long long *volume_hash )
+{
+	wchar_t volume_path[ MAX_PATH ];
+	wchar_t volume_guid[ 50 ] = { 0 };
+
+	// The directory can be a folder that a volume is mounted to.
+	if ( GetVolumePathName( directory, volume_path, MAX_PATH ) == FALSE || GetVolumeNameForVolumeMountPoint( volume_path, volume_guid, 50 ) == FALSE )
+	{
+		return false;
+	}
+
+	CLSID clsid;
+	volume_guid[ 48 ] = L'\0';
+	if ( CLSIDFromString( ( LPOLESTR )( volume_guid + 10 ), &clsid ) != NOERROR )
+	{
+		return false;
+	}
+
+	// Initial hash value. This value was found in shell32.dll.
+	*volume_hash = HashData( ( char * )&clsid, 0x95E729BA2C37FD21, sizeof( CLSID ) );
+
+	return true;
+}
+
+// Maps the files in each of the "|" separated directories. The directories can be on different volumes.
+void MapDirectories( wchar_t *paths )
+{
+	// Assume anything below Windows 7 is running on Windows Vista.
+	is_win_7_or_higher = ( IsWindows7OrGreater() != FALSE ? true : false );
+	is_win_8_1_or_higher = ( IsWindows8Point1OrGreater() != FALSE ? true : false );
+
+	if ( _GetFileInformationByHandleEx == NULL )
+	{
+		_GetFileInformationByHandleEx = ( pGetFileInformationByHandleEx )GetProcAddress( GetModuleHandle( L"kernel32.dll" ), "GetFileInformationByHandleEx" );
+	}
+
+	unsigned int directory_count = 1;
+	for ( wchar_t *path = paths; *path != L'\0'; ++path )
+	{
+		if ( *path == SCAN_PATH_DELIMITER )
+		{
+			++directory_count;
+		}
+	}
+
+	SCAN_VOLUME *volumes = ( SCAN_VOLUME * )malloc( sizeof( SCAN_VOLUME ) * directory_count );
+	if ( volumes == NULL )
+	{
+		return;
+	}
+
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo( &sysinfo );
+
+	// We're one of the workers.
+	unsigned int thread_count = min( sysinfo.dwNumberOfProcessors, MAXIMUM_WAIT_OBJECTS );
+	thread_count = ( thread_count > 0 ? thread_count - 1 : 0 );
+
+	SCAN_INFO si;
+	memset( &si, 0, sizeof( SCAN_INFO ) );
+	InitializeCriticalSection( &si.pending_cs );
+	InitializeCriticalSection( &si.map_cs );
+	si.pending_semaphore = CreateSemaphore( NULL, 0, LONG_MAX, NULL );
+	si.thread_count = thread_count + 1;	// Any thread that fails to start only gets an extra signal.
+
+	bool volume_not_found = false;
+	unsigned int volume_count = 0;
+
+	wchar_t *directory = paths;
+	while ( si.pending_semaphore != NULL && directory != NULL )
+	{
+		wchar_t *next_directory = wcschr( directory, SCAN_PATH_DELIMITER );
+		unsigned int directory_length = ( unsigned int )( next_directory != NULL ? next_directory - directory : wcslen( directory ) );
+
+		// Remove any trailing "\" from the path.
+		while ( directory_length > 0 && directory[ directory_length - 1 ] == L'\\' )
+		{
+			--directory_length;
+		}
+
+		// We need to have at least the drive path. Example: "C:\"
+		if ( directory_length >= 2 && directory_length < MAX_PATH - 1 && directory[ 1 ] == L':' && ( directory_length == 2 || directory[ 2 ] == L'\\' ) )
+		{
+			wchar_t root[ MAX_PATH ];
+			wmemcpy_s( root, MAX_PATH, directory, directory_length );
+			root[ directory_length ] = L'\\';
+			root[ directory_length + 1 ] = L'\0';
+
+			if ( GetVolumeHash( root, &volumes[ volume_count ].volume_hash ) )
+			{
+				if ( PushDirectory( &si, &volumes[ volume_count ], root, directory_length ) )
+				{
+					++volume_count;
+				}
+			}
+			else
+			{
+				volume_not_found = true;
+			}
+		}
+		else if ( directory_length > 0 )
+		{
+			volume_not_found = true;
+		}
+
+		directory = ( next_directory != NULL ? next_directory + 1 : NULL );
+	}
+
+	if ( volume_not_found )
+	{
+		SendNotifyMessageA( g_hWnd_scan, WM_ALERT, 0, ( LPARAM )"Volume name could not be found." );
+	}
+
+	if ( volume_count > 0 )
+	{
+		HANDLE threads[ MAXIMUM_WAIT_OBJECTS ];
+		unsigned int threads_started = 0;
+		for ( ; threads_started < thread_count; ++threads_started )
+		{
+			threads[ threads_started ] = ( HANDLE )_beginthreadex( NULL, 0, &list_directories, ( void * )&si, 0, NULL );
+			if ( threads[ threads_started ] == NULL )
+			{
+				break;
+			}
+		}
+
+		ListDirectories( &si );
+
+		if ( threads_started > 0 )
+		{
+			WaitForMultipleObjects( threads_started, threads, TRUE, INFINITE );
+
+			for ( unsigned int i = 0; i < threads_started; ++i )
+			{
+				CloseHandle( threads[ i ] );
+			}
+		}
+	}
+
+	if ( si.pending_semaphore != NULL )
+	{
+		CloseHandle( si.pending_semaphore );
+	}
+
+	DeleteCriticalSection( &si.map_cs );
+	DeleteCriticalSection( &si.pending_cs );
+
+	free( volumes );
+}
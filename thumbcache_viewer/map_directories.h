@@ -0,0 +1,55 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAP_DIRECTORIES_H
+#define MAP_DIRECTORIES_H
+
+#include "globals.h"
+
+// Separates the initial scan directories.
+#define SCAN_PATH_DELIMITER		L'|'
+
+// The volume that an initial scan directory is on.
+struct SCAN_VOLUME
+{
+	unsigned long long volume_hash;		// The initial hash value with the Volume GUID already hashed.
+};
+
+// A directory that's waiting to be listed.
+struct SCAN_DIRECTORY
+{
+	SCAN_DIRECTORY *next;
+	SCAN_VOLUME *sv;
+	unsigned int path_length;
+	wchar_t path[ 1 ];					// Doesn't end with "\".
+};
+
+// Shared by the threads that list the directories.
+struct SCAN_INFO
+{
+	CRITICAL_SECTION pending_cs;		// Guards pending and active.
+	CRITICAL_SECTION map_cs;			// Guards the fileinfo table and the scan window.
+	HANDLE pending_semaphore;			// Signaled once for each pending directory, and once for each thread when there are none left.
+	SCAN_DIRECTORY *pending;
+	unsigned int active;				// Number of directories that are being listed.
+	unsigned int thread_count;			// Includes the calling thread.
+};
+
+void MapDirectories( wchar_t *paths );
+
+#endif
@@ -27,59 +27,39 @@
 #include "read_esedb.h"
 #include "read_sqlitedb.h"
 
+#include "map_directories.h"
+
 #include <stdio.h>
 
-wchar_t g_filepath[ MAX_PATH ] = { 0 };				// Path to the files and folders to scan.
+wchar_t g_filepath[ SCAN_PATHS_LENGTH ] = { 0 };		// Path to the files and folders to scan.
 wchar_t g_extension_filter[ MAX_PATH + 2 ] = { 0 };	// A list of extensions to filter from a file scan.
 
+EXTENSION_FILTER g_extensions;						// The extensions in g_extension_filter.
+
 bool g_include_folders = false;						// Include folders in a file scan.
+bool g_use_listed_write_times = false;				// Hash the write times in the directory listings instead of opening each file.
 bool g_retrieve_extended_information = false;		// Retrieve additional columns from Windows.edb
 bool g_show_details = false;						// Show details in the scan window.
 
 bool g_kill_scan = true;							// Stop a file scan.
 
-bool is_win_7_or_higher = true;						// Windows Vista uses a different file hashing algorithm.
-bool is_win_8_1_or_higher = true;					// Windows 8.1 uses a different file hashing algorithm.
-
-CLSID clsid;										// Holds a drive's Volume GUID.
 unsigned int g_file_count = 0;						// Number of files scanned.
 unsigned int g_match_count = 0;						// Number of files that match an entry hash.
 
-#define _WIN32_WINNT_WIN7		0x0601
-//#define _WIN32_WINNT_WIN8		0x0602
-#define _WIN32_WINNT_WINBLUE	0x0603
+CRITICAL_SECTION row_cs;							// Guards the row references and the database they refer to.
 
-BOOL IsWindowsVersionOrGreater( WORD wMajorVersion, WORD wMinorVersion, WORD wServicePackMajor )
-{
-	OSVERSIONINFOEXW osvi = { sizeof( osvi ), 0, 0, 0, 0, { 0 }, 0, 0 };
-	DWORDLONG const dwlConditionMask = VerSetConditionMask(
-		VerSetConditionMask(
-		VerSetConditionMask(
-		0, VER_MAJORVERSION, VER_GREATER_EQUAL ),
-		   VER_MINORVERSION, VER_GREATER_EQUAL ),
-		   VER_SERVICEPACKMAJOR, VER_GREATER_EQUAL );
-
-	osvi.dwMajorVersion = wMajorVersion;
-	osvi.dwMinorVersion = wMinorVersion;
-	osvi.wServicePackMajor = wServicePackMajor;
-
-	return VerifyVersionInfoW( &osvi, VER_MAJORVERSION | VER_MINORVERSION | VER_SERVICEPACKMAJOR, dwlConditionMask ) != FALSE;
-}
+ROW_REFERENCE *g_row_references = NULL;				// Rows that entries were mapped to. FILE_INFO's row_reference is a 1-based index into this.
+unsigned int g_row_reference_count = 0;
+unsigned int g_row_reference_size = 0;
 
-BOOL IsWindows7OrGreater()
-{
-    return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WIN7 ), LOBYTE( _WIN32_WINNT_WIN7 ), 0 );
-}
+unsigned char *g_bookmarks = NULL;					// ESE bookmarks of the row references, stored back to back.
+unsigned int g_bookmarks_length = 0;
+unsigned int g_bookmarks_size = 0;
 
-/*BOOL IsWindows8OrGreater()
-{
-	return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WIN8 ), LOBYTE( _WIN32_WINNT_WIN8 ), 0 );
-}*/
+unsigned char g_row_database = ROW_DATABASE_NONE;	// Set once a database has been mapped. It stays open until the row references are released.
 
-BOOL IsWindows8Point1OrGreater()
-{
-	return IsWindowsVersionOrGreater( HIBYTE( _WIN32_WINNT_WINBLUE ), LOBYTE( _WIN32_WINNT_WINBLUE ), 0 );
-}
+EXTENDED_INFO_CACHE g_ei_cache[ EXTENDED_INFO_CACHE_SIZE ];	// Converted values of the most recently viewed rows.
+unsigned int g_ei_cache_next = 0;					// The cache entry to replace next.
 
 void UpdateWindowInfo( unsigned long long hash, wchar_t *filepath )
 {
@@ -97,236 +77,277 @@ void UpdateWindowInfo( unsigned long long hash, wchar_t *filepath )
 	}
 }
 
-void UpdateFileinfo( unsigned long long hash, wchar_t *filepath )
+// Returns the 1-based index of the new row reference, or 0 if it couldn't be added.
+unsigned int AddRowReference( unsigned long long work_id, unsigned char *bookmark, unsigned long bookmark_length )
 {
-	// Now that we have a hash value to compare, search our file info tree for the same value.
-	LINKED_LIST *ll = ( LINKED_LIST * )dllrbt_find( g_file_info_tree, ( void * )hash, true );
-
-	// Retrieve the column information once so we don't have to call this for duplicate entries in the loop below.
-	bool got_columns = false;
-	EXTENDED_INFO *ei = NULL;
-	if ( g_retrieve_extended_information )
+	if ( g_row_reference_count == g_row_reference_size )
 	{
-		if ( ll != NULL && ll->fi != NULL )
+		unsigned int size = ( g_row_reference_size > 0 ? g_row_reference_size * 2 : 1024 );
+		ROW_REFERENCE *realloc_references = ( ROW_REFERENCE * )realloc( g_row_references, sizeof( ROW_REFERENCE ) * size );
+		if ( realloc_references == NULL )
 		{
-			if ( ll->fi->ei == NULL )
-			{
-				// Retrieve all the records associated with the matching System_ThumbnailCacheId.
-				if ( ( g_err = JetRetrieveColumns( g_sesid, g_tableid_0A, g_rc_array, g_column_count ) ) == JET_errSuccess )
-				{
-					got_columns = true;
-				}
-			}
-			else
-			{
-				// Save this to copy to any linked list nodes that have NULL extended info.
-				ei = ll->fi->ei;
-			}
+			return 0;
 		}
+
+		g_row_references = realloc_references;
+		g_row_reference_size = size;
 	}
 
-	while ( ll != NULL )
+	if ( bookmark_length > 0 && g_bookmarks_length + bookmark_length > g_bookmarks_size )
 	{
-		if ( ll->fi != NULL )
+		// A bookmark is never larger than JET_cbBookmarkMost, so doubling the buffer will always fit it.
+		unsigned int size = ( g_bookmarks_size > 0 ? g_bookmarks_size * 2 : 65536 );
+		unsigned char *realloc_bookmarks = ( unsigned char * )realloc( g_bookmarks, sizeof( unsigned char ) * size );
+		if ( realloc_bookmarks == NULL )
 		{
-			++g_match_count;
+			return 0;
+		}
 
-			// Replace the hash filename with the local filename.
-			wchar_t *del_filename = ll->fi->filename;
-			ll->fi->filename = _wcsdup( filepath );
-			free( del_filename );
+		g_bookmarks = realloc_bookmarks;
+		g_bookmarks_size = size;
+	}
 
-			if ( got_columns )
-			{
-				// Convert the record values to strings so we can print them out.
-				ConvertValues( &( ll->fi->ei ) );
-			}
-			else if ( ll->fi->ei == NULL )
-			{
-				// If we have extended information, but didn't retrieve any columns, then copy it to our file info linked list nodes.
-				EXTENDED_INFO *l_ei = NULL;
-				EXTENDED_INFO *t_ei = ei;
-				while ( t_ei != NULL )
-				{
-					if ( t_ei->sei != NULL )
-					{
-						++( t_ei->sei->count );
-
-						EXTENDED_INFO *c_ei = ( EXTENDED_INFO * )malloc( sizeof( EXTENDED_INFO ) );
-						c_ei->sei = t_ei->sei;
-						c_ei->property_value = _wcsdup( t_ei->property_value );
-						c_ei->next = NULL;
-
-						if ( l_ei != NULL )
-						{
-							l_ei->next = c_ei;
-						}
-						else
-						{
-							ll->fi->ei = c_ei;
-						}
-
-						l_ei = c_ei;
-					}
-
-					t_ei = t_ei->next;
-				}
-			}
-		}
+	ROW_REFERENCE *rr = &g_row_references[ g_row_reference_count ];
+	rr->work_id = work_id;
+	rr->bookmark_offset = g_bookmarks_length;
+	rr->bookmark_length = bookmark_length;
 
-		ll = ll->next;
+	if ( bookmark_length > 0 )
+	{
+		memcpy_s( g_bookmarks + g_bookmarks_length, g_bookmarks_size - g_bookmarks_length, bookmark, bookmark_length );
+		g_bookmarks_length += bookmark_length;
+	}
+
+	return ++g_row_reference_count;
+}
+
+// Entries no longer refer to a row once the row references have been released.
+void ResetEntryRowReferences()
+{
+	LVITEM lvi = { NULL };
+	lvi.mask = LVIF_PARAM;
+
+	int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );
+
+	for ( lvi.iItem = 0; lvi.iItem < item_count; ++lvi.iItem )
+	{
+		SendMessage( g_hWnd_list, LVM_GETITEM, 0, ( LPARAM )&lvi );
+
+		FILE_INFO *fi = ( FILE_INFO * )lvi.lParam;
+		if ( fi != NULL )
+		{
+			fi->row_reference = 0;
+		}
 	}
 }
 
-unsigned long long HashData( char *data, unsigned long long hash, short length )
+void ReleaseRowReferences()
 {
-	while ( length-- > 0 )
+	EnterCriticalSection( &row_cs );
+
+	for ( unsigned int i = 0; i < EXTENDED_INFO_CACHE_SIZE; ++i )
+	{
+		CleanupExtendedInfo( g_ei_cache[ i ].ei );
+		g_ei_cache[ i ].ei = NULL;
+		g_ei_cache[ i ].row_reference = 0;
+	}
+	g_ei_cache_next = 0;
+
+	// The database was left open so that the values could be converted when they're viewed.
+	if ( g_row_database == ROW_DATABASE_ESE )
 	{
-		hash ^= ( ( ( hash * 0x820 ) + ( *data++ & 0x00000000000000FF ) ) + ( hash >> 2 ) );
+		CleanupESEDBInfo();
 	}
+	else if ( g_row_database == ROW_DATABASE_SQLITE )
+	{
+		CleanupSQLiteInfo();
+	}
+	g_row_database = ROW_DATABASE_NONE;
+
+	free( g_row_references );
+	g_row_references = NULL;
+	g_row_reference_count = 0;
+	g_row_reference_size = 0;
 
-	return hash;
+	free( g_bookmarks );
+	g_bookmarks = NULL;
+	g_bookmarks_length = 0;
+	g_bookmarks_size = 0;
+
+	LeaveCriticalSection( &row_cs );
 }
 
-void HashFile( wchar_t *filepath, wchar_t *extension )
+// Converts the values of the row that the entry was mapped to.
+// The list belongs to the cache and remains valid until it's replaced in the cache or the row references are released.
+EXTENDED_INFO *GetExtendedInfo( FILE_INFO *fi )
 {
-	// Initial hash value. This value was found in shell32.dll.
-	unsigned long long hash = 0x95E729BA2C37FD21;
+	EXTENDED_INFO *ei = NULL;
 
-	HANDLE hFile = CreateFile( filepath, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL );
-	if ( hFile != INVALID_HANDLE_VALUE )
+	if ( fi == NULL || fi->row_reference == 0 )
 	{
-		// Hash Volume GUID
-		hash = HashData( ( char * )&clsid, hash, sizeof( CLSID ) );
+		return NULL;
+	}
 
-		// Hash File ID - found in the Master File Table.
-		BY_HANDLE_FILE_INFORMATION bhfi;
-		GetFileInformationByHandle( hFile, &bhfi );
-		CloseHandle( hFile );
-		unsigned long long file_id = bhfi.nFileIndexHigh;
-		file_id = ( file_id << 32 ) | bhfi.nFileIndexLow;
+	EnterCriticalSection( &row_cs );
 
-		hash = HashData( ( char * )&file_id, hash, sizeof( unsigned long long ) );
+	// The row references aren't usable until the mapping is complete.
+	if ( g_row_database != ROW_DATABASE_NONE && fi->row_reference <= g_row_reference_count )
+	{
+		unsigned int i = 0;
 
-		// Windows Vista doesn't hash the file extension or modified DOS time.
-		if ( is_win_7_or_higher )
+		// See if the row has already been converted.
+		for ( ; i < EXTENDED_INFO_CACHE_SIZE; ++i )
 		{
-			// Hash Wide Character File Extension
-			hash = HashData( ( char * )extension, hash, ( short )( wcslen( extension ) * sizeof( wchar_t ) ) );
+			if ( g_ei_cache[ i ].row_reference == fi->row_reference )
+			{
+				ei = g_ei_cache[ i ].ei;
 
-			// Hash Last Modified DOS Time
-			unsigned short fat_date;
-			unsigned short fat_time;
-			FileTimeToDosDateTime( &bhfi.ftLastWriteTime, &fat_date, &fat_time );
-			unsigned int dos_time = fat_date;
-			dos_time = ( dos_time << 16 ) | fat_time;
+				break;
+			}
+		}
 
-			hash = HashData( ( char * )&dos_time, hash, sizeof( unsigned int ) );
+		if ( i == EXTENDED_INFO_CACHE_SIZE )
+		{
+			ROW_REFERENCE *rr = &g_row_references[ fi->row_reference - 1 ];
 
-			// Windows 8.1 calculates the precision loss between the converted write time and original write time.
-			if ( is_win_8_1_or_higher )
+			if ( g_row_database == ROW_DATABASE_ESE )
 			{
-				// Convert the DOS time back into a FILETIME.
-				FILETIME converted_write_time;
-				DosDateTimeToFileTime( fat_date, fat_time, &converted_write_time );
-
-				// We only need to hash the low order int.
-				unsigned int precision_loss = converted_write_time.dwLowDateTime - bhfi.ftLastWriteTime.dwLowDateTime;
-
-				// Hash if there's any precision loss.
-				if ( precision_loss != 0 )
+				// Retrieve all the records of the row and convert them to strings.
+				if ( JetGotoBookmark( g_sesid, g_tableid_0A, ( void * )( g_bookmarks + rr->bookmark_offset ), rr->bookmark_length ) == JET_errSuccess &&
+					 JetRetrieveColumns( g_sesid, g_tableid_0A, g_rc_array, g_column_count ) == JET_errSuccess )
 				{
-					hash = HashData( ( char * )&precision_loss, hash, sizeof( unsigned int ) );
+					ConvertValues( &ei );
 				}
 			}
-		}
+			else
+			{
+				char query[ 512 ];
+				sprintf_s( query, 512,
+					"SELECT WorkId, Id, UniqueKey, Value, VariantType FROM SystemIndex_1_PropertyStore " \
+					"JOIN SystemIndex_1_PropertyStore_Metadata ON SystemIndex_1_PropertyStore_Metadata.Id = SystemIndex_1_PropertyStore.ColumnId " \
+					"WHERE WorkId = %llu", rr->work_id );
+
+				// Get all the values associated with the WorkId. ei is filled out in the callback.
+				sqlite3_exec( g_sql_db, query, CreatePropertyInfoCallback, ( void * )&ei, NULL );
+			}
 
-		UpdateFileinfo( hash, filepath );
-		UpdateWindowInfo( hash, filepath );
+			// Replace the oldest entry in the cache.
+			EXTENDED_INFO_CACHE *eic = &g_ei_cache[ g_ei_cache_next ];
+			CleanupExtendedInfo( eic->ei );
+			eic->ei = ei;
+			eic->row_reference = fi->row_reference;
+
+			g_ei_cache_next = ( g_ei_cache_next + 1 ) % EXTENDED_INFO_CACHE_SIZE;
+		}
 	}
+
+	LeaveCriticalSection( &row_cs );
+
+	return ei;
 }
 
-void TraverseDirectory( wchar_t *path )
+void UpdateFileinfo( unsigned long long hash, wchar_t *filepath, bool database_row )
 {
-	// We don't want to continue scanning if the user cancels the scan.
-	if ( g_kill_scan )
+	// Now that we have a hash value to compare, search our file info table for the same value.
+	LINKED_LIST *ll = NULL;
+	unsigned int head = 0;
+	if ( hash_table_find( g_file_info_table, hash, &head ) )
+	{
+		ll = &g_file_info_list[ head ];
+	}
+
+	// Reference the current row once so we don't have to do this for duplicate entries in the loop below.
+	// The values of the row are retrieved and converted when the entry's information is viewed.
+	unsigned int row_reference = ( ll != NULL && ll->fi != NULL ? ll->fi->row_reference : 0 );
+	if ( row_reference == 0 && database_row && g_retrieve_extended_information && ll != NULL )
 	{
-		return;
+		unsigned char bookmark[ JET_cbBookmarkMost ];
+		unsigned long bookmark_length = 0;
+		if ( ( g_err = JetGetBookmark( g_sesid, g_tableid_0A, bookmark, JET_cbBookmarkMost, &bookmark_length ) ) == JET_errSuccess )
+		{
+			row_reference = AddRowReference( 0, bookmark, bookmark_length );
+		}
 	}
 
-	// Set the file path to search for all files/folders in the current directory.
-	wchar_t filepath[ ( MAX_PATH * 2 ) + 2 ];
-	swprintf_s( filepath, ( MAX_PATH * 2 ) + 2, L"%.259s\\*", path );
+	// Duplicate entries share a single copy of the local filename.
+	wchar_t *shared_filename = NULL;
 
-	WIN32_FIND_DATA FindFileData;
-	HANDLE hFind = FindFirstFileEx( ( LPCWSTR )filepath, FindExInfoStandard, &FindFileData, FindExSearchNameMatch, NULL, 0 );
-	if ( hFind != INVALID_HANDLE_VALUE ) 
+	while ( ll != NULL )
 	{
-		do
+		if ( ll->fi != NULL )
 		{
-			if ( g_kill_scan )
+			++g_match_count;
+
+			if ( shared_filename == NULL )
 			{
-				break;	// We need to close the find file handle.
+				shared_filename = CreateSharedFilename( filepath );
 			}
 
-			// See if the file is a directory.
-			if ( ( FindFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0 )
+			// Replace the hash filename with the local filename.
+			if ( shared_filename != NULL )
 			{
-				// Go through all directories except "." and ".." (current and parent)
-				if ( ( wcscmp( FindFileData.cFileName, L"." ) != 0 ) && ( wcscmp( FindFileData.cFileName, L".." ) != 0 ) )
-				{
-					// Move to the next directory. Limit the path length to MAX_PATH.
-					if ( swprintf_s( filepath, ( MAX_PATH * 2 ) + 2, L"%.259s\\%.259s", path, FindFileData.cFileName ) < MAX_PATH )
-					{
-						TraverseDirectory( filepath );
-
-						// Only hash folders if enabled.
-						if ( g_include_folders )
-						{
-							HashFile( filepath, L"" );
-						}
-					}
-				}
+				SetSharedFilename( ll->fi, shared_filename );
 			}
-			else
+
+			// Duplicate entries refer to the same row.
+			if ( ll->fi->row_reference == 0 )
 			{
-				// See if the file's extension is in our filter. Go to the next file if it's not.
-				wchar_t *ext = GetExtensionFromFilename( FindFileData.cFileName, ( unsigned long )wcslen( FindFileData.cFileName ) );
-				if ( g_extension_filter[ 0 ] != 0 )
-				{
-					// Do a case-insensitive substring search for the extension.
-					int ext_length = ( int )wcslen( ext );
-					wchar_t *temp_ext = ( wchar_t * )malloc( sizeof( wchar_t ) * ( ext_length + 3 ) );
-					for ( int i = 0; i < ext_length; ++i )
-					{
-						temp_ext[ i + 1 ] = towlower( ext[ i ] );
-					}
-					temp_ext[ 0 ] = L'|';				// Append the delimiter to the beginning of the string.
-					temp_ext[ ext_length + 1 ] = L'|';	// Append the delimiter to the end of the string.
-					temp_ext[ ext_length + 2 ] = L'\0';
-
-					if ( wcsstr( g_extension_filter, temp_ext ) == NULL )
-					{
-						free( temp_ext );
-						continue;
-					}
-
-					free( temp_ext );
-				}
+				ll->fi->row_reference = row_reference;
+			}
+		}
 
-				if ( swprintf_s( filepath, ( MAX_PATH * 2 ) + 2, L"%.259s\\%.259s", path, FindFileData.cFileName ) >= MAX_PATH && FindFileData.cAlternateFileName[ 0 ] != 0 )
-				{
-					// See if the 8.3 filename can fit.
-					swprintf_s( filepath, ( MAX_PATH * 2 ) + 2, L"%.259s\\%.259s", path, FindFileData.cAlternateFileName );
-				}
+		ll = ll->next;
+	}
+}
 
-				HashFile( filepath, ext );
-			}
+// Splits g_extension_filter so that each extension can be compared without building a delimited copy of it.
+void CompileExtensionFilter()
+{
+	g_extensions.count = 0;
+	g_extensions.enabled = ( g_extension_filter[ 0 ] != 0 );
+
+	wchar_t *extension = g_extension_filter;
+	while ( *extension != L'\0' && g_extensions.count < MAX_FILTER_EXTENSIONS )
+	{
+		// Skip the delimiter.
+		++extension;
+
+		wchar_t *end = extension;
+		while ( *end != L'\0' && *end != L'|' )
+		{
+			++end;
 		}
-		while ( FindNextFile( hFind, &FindFileData ) != 0 );	// Go to the next file.
 
-		FindClose( hFind );	// Close the find file handle.
+		if ( end > extension )
+		{
+			g_extensions.extensions[ g_extensions.count ] = extension;
+			g_extensions.lengths[ g_extensions.count ] = ( unsigned int )( end - extension );
+			++g_extensions.count;
+		}
+
+		extension = end;
+	}
+}
+
+// Returns true if there's no filter or if the extension is in it.
+bool MatchExtensionFilter( const wchar_t *extension )
+{
+	if ( !g_extensions.enabled )
+	{
+		return true;
+	}
+
+	// The filter is already lowercase.
+	unsigned int extension_length = ( unsigned int )wcslen( extension );
+	for ( unsigned int i = 0; i < g_extensions.count; ++i )
+	{
+		if ( g_extensions.lengths[ i ] == extension_length && _wcsnicmp( g_extensions.extensions[ i ], extension, extension_length ) == 0 )
+		{
+			return true;
+		}
 	}
+
+	return false;
 }
 
 void TraverseSQLiteDatabase( wchar_t *database_filepath )
@@ -388,6 +409,7 @@ void TraverseSQLiteDatabase( wchar_t *database_filepath )
 			sprintf_s( query + 288, 512 - 288, "%016llx\') ) AND (Id = 438 OR Id = 434 OR Id = 33)", hash );
 
 			PROPERTY_INFO_STATUS pis;
+			pis.work_id = 0;
 			pis.file_attributes = 0;
 			pis.file_extension = NULL;
 			pis.item_path_display = NULL;
@@ -415,29 +437,12 @@ void TraverseSQLiteDatabase( wchar_t *database_filepath )
 			else
 			{
 				// See if the file's extension is in our filter. Go to the next entry if it's not.
-				if ( pis.file_extension != NULL && g_extension_filter[ 0 ] != 0 )
+				if ( pis.file_extension != NULL && !MatchExtensionFilter( pis.file_extension ) )
 				{
-					// Do a case-insensitive substring search for the extension.
-					int ext_length = ( int )wcslen( pis.file_extension );
-					wchar_t *temp_ext = ( wchar_t * )malloc( sizeof( wchar_t ) * ( ext_length + 3 ) );
-					for ( int i = 0; i < ext_length; ++i )
-					{
-						temp_ext[ i + 1 ] = towlower( pis.file_extension[ i ] );
-					}
-					temp_ext[ 0 ] = L'|';				// Append the delimiter to the beginning of the string.
-					temp_ext[ ext_length + 1 ] = L'|';	// Append the delimiter to the end of the string.
-					temp_ext[ ext_length + 2 ] = L'\0';
-
-					if ( wcsstr( g_extension_filter, temp_ext ) == NULL )
-					{
-						free( temp_ext );
-						free( pis.file_extension );
-						free( pis.item_path_display );
-
-						continue;
-					}
-
-					free( temp_ext );
+					free( pis.file_extension );
+					free( pis.item_path_display );
+
+					continue;
 				}
 			}
 
@@ -448,22 +453,15 @@ void TraverseSQLiteDatabase( wchar_t *database_filepath )
 				++g_match_count;
 
 				// Replace the hash filename with the local filename.
-				wchar_t *del_filename = fi->filename;
+				FreeFilename( fi );
 				fi->filename = pis.item_path_display;
-				free( del_filename );
 
 				pis.item_path_display = NULL;
 
-				if ( g_retrieve_extended_information && fi->ei == NULL )
+				// The values of the WorkId are retrieved and converted when the entry's information is viewed.
+				if ( g_retrieve_extended_information && fi->row_reference == 0 )
 				{
-					query[ 308 ] = 0; // Preform the same query, but without the last AND statement.
-
-					// Get all the values associated with the hash. fi->ei is filled out in the callback.
-					sql_rc = sqlite3_exec( g_sql_db, query, CreatePropertyInfoCallback, ( void * )fi, &sql_err_msg );
-					if ( sql_rc != SQLITE_OK )
-					{
-						break;
-					}
+					fi->row_reference = AddRowReference( pis.work_id, NULL, 0 );
 				}
 			}
 
@@ -484,7 +482,17 @@ CLEANUP:
 		sqlite3_free( sql_err_msg );
 	}
 
-	CleanupSQLiteInfo();
+	// Keep the database open if entries refer to its rows.
+	if ( g_row_reference_count > 0 )
+	{
+		EnterCriticalSection( &row_cs );
+		g_row_database = ROW_DATABASE_SQLITE;
+		LeaveCriticalSection( &row_cs );
+	}
+	else
+	{
+		CleanupSQLiteInfo();
+	}
 }
 
 // The Microsoft Jet Database Engine seems to have a lot of annoying quirks/compatibility issues.
@@ -602,29 +610,12 @@ void TraverseESEDatabase( wchar_t *database_filepath, unsigned long revision, un
 
 			// See if the file's extension is in our filter. Go to the next entry if it's not.
 			wchar_t *ext = ( uc_file_extension == NULL ? ( wchar_t * )file_extension : uc_file_extension );
-			if ( g_extension_filter[ 0 ] != 0 )
+			if ( !MatchExtensionFilter( ext ) )
 			{
-				// Do a case-insensitive substring search for the extension.
-				int ext_length = ( int )wcslen( ext );
-				wchar_t *temp_ext = ( wchar_t * )malloc( sizeof( wchar_t ) * ( ext_length + 3 ) );
-				for ( int i = 0; i < ext_length; ++i )
-				{
-					temp_ext[ i + 1 ] = towlower( ext[ i ] );
-				}
-				temp_ext[ 0 ] = L'|';				// Append the delimiter to the beginning of the string.
-				temp_ext[ ext_length + 1 ] = L'|';	// Append the delimiter to the end of the string.
-				temp_ext[ ext_length + 2 ] = L'\0';
-
-				if ( wcsstr( g_extension_filter, temp_ext ) == NULL )
-				{
-					free( temp_ext );
-					free( uc_file_extension );
-
-					set_file_info = false;
-					goto NEXT_ITEM;
-				}
+				free( uc_file_extension );
 
-				free( temp_ext );
+				set_file_info = false;
+				goto NEXT_ITEM;
 			}
 
 			free( uc_file_extension );
@@ -652,7 +643,7 @@ NEXT_ITEM:
 
 		if ( set_file_info )
 		{
-			UpdateFileinfo( thumbnail_cache_id, filepath );
+			UpdateFileinfo( thumbnail_cache_id, filepath, true );
 		}
 		UpdateWindowInfo( thumbnail_cache_id, filepath );
 
@@ -673,13 +664,32 @@ CLEANUP:
 	// Process any error that occurred.
 	HandleESEDBError();
 
-	// Cleanup and reset all values associated with processing the database.
-	CleanupESEDBInfo();
+	// Keep the database open if entries refer to its rows. Otherwise, cleanup and reset all values associated with processing the database.
+	if ( g_row_reference_count > 0 && g_rc_array != NULL )
+	{
+		EnterCriticalSection( &row_cs );
+		g_row_database = ROW_DATABASE_ESE;
+		LeaveCriticalSection( &row_cs );
+	}
+	else
+	{
+		CleanupESEDBInfo();
+	}
 }
 
 // Tests the file's header to figure out whether it's an ESE or SQLite database.
 void TraverseDatabase( wchar_t *database_filepath )
 {
+	// The info window may be showing values from the previously mapped database.
+	if ( g_current_fi != NULL && g_current_fi->row_reference != 0 )
+	{
+		SendMessage( g_hWnd_info, WM_CLOSE, 0, 0 );
+	}
+
+	// Close the previously mapped database before opening a new one.
+	ReleaseRowReferences();
+	ResetEntryRowReferences();
+
 	HANDLE hFile = CreateFile( database_filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
 	if ( hFile != INVALID_HANDLE_VALUE )
 	{
@@ -742,44 +752,23 @@ unsigned __stdcall MapEntries( void *pArguments )
 	// Disable scan button, enable cancel button.
 	SendMessage( g_hWnd_scan, WM_PROPAGATE, 1, 0 );
 
-	CreateFileinfoTree();
+	CreateFileinfoTable();
 
 	g_file_count = 0;	// Reset the file count.
 	g_match_count = 0;	// Reset the match count.
 
+	CompileExtensionFilter();
+
 	if ( scan_type == 0 )
 	{
-		// File path will be at least 2 characters. Copy our drive to get the volume GUID.
-		wchar_t drive[ 4 ] = { 0 };
-		wchar_t volume_guid[ 50 ] = { 0 };
-
-		wmemcpy_s( drive, 4, g_filepath, 2 );
-		drive[ 2 ] = L'\\';	// Ensure the drive ends with "\".
-		drive[ 3 ] = L'\0';
-
-		// Get the volume GUID first.
-		if ( GetVolumeNameForVolumeMountPoint( drive, volume_guid, 50 ) == TRUE )
-		{
-			volume_guid[ 48 ] = L'\0';
-			CLSIDFromString( ( LPOLESTR )( volume_guid + 10 ), &clsid );
-
-			// Assume anything below Windows 7 is running on Windows Vista.
-			is_win_7_or_higher = ( IsWindows7OrGreater() != FALSE ? true : false );
-			is_win_8_1_or_higher = ( IsWindows8Point1OrGreater() != FALSE ? true : false );
-
-			TraverseDirectory( g_filepath );
-		}
-		else
-		{
-			SendNotifyMessageA( g_hWnd_scan, WM_ALERT, 0, ( LPARAM )"Volume name could not be found." );
-		}
+		MapDirectories( g_filepath );
 	}
 	else
 	{
 		TraverseDatabase( g_filepath );
 	}
 
-	CleanupFileinfoTree();
+	CleanupFileinfoTable();
 
 	InvalidateRect( g_hWnd_list, NULL, TRUE );
 
@@ -19,13 +19,63 @@
 #ifndef MAP_ENTRIES_H
 #define MAP_ENTRIES_H
 
+#include "globals.h"
+
+// The database that the row references refer to.
+#define ROW_DATABASE_NONE	0
+#define ROW_DATABASE_ESE	1
+#define ROW_DATABASE_SQLITE	2
+
+// Length of g_filepath. It can hold several "|" separated directories.
+#define SCAN_PATHS_LENGTH	( MAX_PATH * 8 )
+
+// An extension filter of MAX_PATH characters can't have more than this many extensions.
+#define MAX_FILTER_EXTENSIONS	( MAX_PATH / 2 )
+
+// Number of entries whose extended information is kept after it's been converted.
+#define EXTENDED_INFO_CACHE_SIZE	16
+
+// A row of Windows.edb (or Windows.db) that an entry was mapped to.
+struct ROW_REFERENCE
+{
+	unsigned long long work_id;		// The WorkId of a SQLite row.
+	unsigned int bookmark_offset;	// The bookmark of an ESE row in g_bookmarks.
+	unsigned int bookmark_length;
+};
+
+// Extended information that was converted for a row reference.
+struct EXTENDED_INFO_CACHE
+{
+	EXTENDED_INFO *ei;
+	unsigned int row_reference;
+};
+
+// The extensions in g_extension_filter. Each one points into it and isn't NULL terminated.
+struct EXTENSION_FILTER
+{
+	wchar_t *extensions[ MAX_FILTER_EXTENSIONS ];
+	unsigned int lengths[ MAX_FILTER_EXTENSIONS ];
+	unsigned int count;
+	bool enabled;
+};
+
 unsigned __stdcall MapEntries( void *pArguments );
 
+void UpdateFileinfo( unsigned long long hash, wchar_t *filepath, bool database_row );
+void UpdateWindowInfo( unsigned long long hash, wchar_t *filepath );
+bool MatchExtensionFilter( const wchar_t *extension );
+
+EXTENDED_INFO *GetExtendedInfo( FILE_INFO *fi );
+void ReleaseRowReferences();
+
 extern wchar_t g_filepath[];					// Path to the files and folders to scan.
 extern wchar_t g_extension_filter[];			// A list of extensions to filter from a file scan.
 
 extern bool g_include_folders;					// Include folders in a file scan.
+extern bool g_use_listed_write_times;			// Hash the write times in the directory listings instead of opening each file.
 extern bool g_retrieve_extended_information;	// Retrieve additional columns from Windows.edb
 extern bool g_show_details;						// Show details in the scan window.
 
+extern CRITICAL_SECTION row_cs;					// Guards the row references and the database they refer to.
+
 #endif
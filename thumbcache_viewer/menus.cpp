@@ -136,6 +136,16 @@ void CreateMenus()
 	mii.wID = MENU_SCAN;
 	InsertMenuItemA( hMenuSub_tools, 1, TRUE, &mii );
 
+	mii.fType = MFT_SEPARATOR;
+	InsertMenuItemA( hMenuSub_tools, 2, TRUE, &mii );
+
+	mii.fType = MFT_STRING;
+	mii.dwTypeData = "Use Index Files";
+	mii.cch = 15;
+	mii.wID = MENU_USE_INDEX;
+	mii.fState = MFS_ENABLED;
+	InsertMenuItemA( hMenuSub_tools, 3, TRUE, &mii );
+
 	// HELP MENU
 	mii.dwTypeData = "Thumbcache Viewer &Home Page";
 	mii.cch = 28;
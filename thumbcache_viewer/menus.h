@@ -39,6 +39,7 @@
 #define MENU_PROP_VALUE	1013
 #define MENU_COPY_SEL	1014
 #define MENU_HOME_PAGE	1015
+#define MENU_USE_INDEX	1016
 
 #define UM_DISABLE			0
 #define UM_ENABLE			1
@@ -78,21 +78,16 @@ void ConvertValues( EXTENDED_INFO **ei )
 
 	wchar_t *format = NULL;
 
+	// The values are converted when an entry's information is viewed, so we don't check g_kill_scan here.
 	for ( unsigned long i = 0; i < g_column_count; ++i )
 	{
-		// Stop processing and exit the thread.
-		if ( g_kill_scan )
-		{
-			break;
-		}
-
 		if ( t_ci != NULL )
 		{
 			// Create a shared extended info structure to share the Windows Property names across entries.
 			if ( t_ci->sei == NULL )
 			{
 				t_ci->sei = ( SHARED_EXTENDED_INFO * )malloc( sizeof( SHARED_EXTENDED_INFO ) );
-				t_ci->sei->count = 0;
+				t_ci->sei->count = 1;	// The column holds a reference until the database is closed.
 
 				t_ci->sei->windows_property = ( wchar_t * )malloc( sizeof( char ) * ( t_ci->Name_byte_length + sizeof( wchar_t ) ) );
 				memcpy_s( t_ci->sei->windows_property, sizeof( char ) * ( t_ci->Name_byte_length + sizeof( wchar_t ) ), t_ci->Name, t_ci->Name_byte_length );
@@ -486,7 +481,18 @@ void CleanupESEDBInfo()
 		d_ci = t_ci;
 		t_ci = t_ci->next;
 
-		// d_ci->sei will be freed with the FILE_INFO structure in wnd_proc_main.
+		// Release the column's reference. Any converted values that still use the shared info will free it.
+		if ( d_ci->sei != NULL )
+		{
+			--( d_ci->sei->count );
+
+			if ( d_ci->sei->count == 0 )
+			{
+				free( d_ci->sei->windows_property );
+				free( d_ci->sei );
+			}
+		}
+
 		free( d_ci->data );
 		free( d_ci->Name );
 		free( d_ci );
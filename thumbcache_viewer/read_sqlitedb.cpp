@@ -26,54 +26,40 @@
 #include <stdio.h>
 
 void *g_sql_db = NULL;
-dllrbt_tree *g_property_tree = NULL;
-
-int dllrbt_property_compare( void *a, void *b )
-{
-	unsigned long id1 = ( unsigned long )a;
-	unsigned long id2 = ( unsigned long )b;
-
-	if ( id1 > id2 )
-	{
-		return 1;
-	}
-
-	if ( id1 < id2 )
-	{
-		return -1;
-	}
-
-	return 0;
-}
+hash_table *g_property_table = NULL;	// Maps each property Id to its index in g_property_info.
+PROPERTY_INFO *g_property_info = NULL;
+unsigned int g_property_count = 0;
+unsigned int g_property_size = 0;
 
 void CleanupSQLiteInfo()
 {
 	sqlite3_close( g_sql_db );
 	g_sql_db = NULL;
 
-	// Free the values of the property tree.
-	node_type *node = dllrbt_get_head( g_property_tree );
-	while ( node != NULL )
+	// Free the values of the property table.
+	for ( unsigned int i = 0; i < g_property_count; ++i )
 	{
-		// Free the linked list if there is one.
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )node->val;
-
-		node = node->next;
-
-		if ( pi != NULL )
+		PROPERTY_INFO *pi = &g_property_info[ i ];
+		if ( pi->sei != NULL )	// Release the property's reference. Any converted values that still use the shared info will free it.
 		{
-			if ( pi->sei != NULL && pi->sei->count == 0 )	// Shared info is cleaned up when the main list is cleaned.
+			--( pi->sei->count );
+
+			if ( pi->sei->count == 0 )
 			{
 				free( pi->sei->windows_property );
 				free( pi->sei );
 			}
-			free( pi );
 		}
 	}
 
-	// Clean up our property tree.
-	dllrbt_delete_recursively( g_property_tree );
-	g_property_tree = NULL;
+	free( g_property_info );
+	g_property_info = NULL;
+	g_property_count = 0;
+	g_property_size = 0;
+
+	// Clean up our property table.
+	hash_table_delete( g_property_table );
+	g_property_table = NULL;
 }
 
 int GetLengthCallback( void *arg, int argc, char **argv, char ** /*azColName*/ )
@@ -108,28 +94,48 @@ int BuildPropertyTreeCallback( void * /*arg*/, int argc, char **argv, char ** /*
 		}
 
 		SHARED_EXTENDED_INFO *sei = ( SHARED_EXTENDED_INFO * )malloc( sizeof( SHARED_EXTENDED_INFO ) );
-		sei->count = 0;
+		sei->count = 1;	// The property holds a reference until the database is closed.
 
 		int property_name_length = MultiByteToWideChar( CP_UTF8, 0, prop_name, -1, NULL, 0 );	// Include the NULL terminator.
 		sei->windows_property = ( wchar_t * )malloc( sizeof( wchar_t ) * property_name_length );
 		property_name_length = MultiByteToWideChar( CP_UTF8, 0, prop_name, -1, sei->windows_property, property_name_length ) - 1;
 
-		// Create the file info tree if it doesn't exist.
-		if ( g_property_tree == NULL )
+		// Create the property table if it doesn't exist.
+		if ( g_property_table == NULL )
 		{
-			g_property_tree = dllrbt_create( dllrbt_property_compare );
+			g_property_table = hash_table_create( 0 );
 		}
 
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )malloc( sizeof( PROPERTY_INFO ) );
+		// The properties are stored together and the table refers to them by index.
+		if ( g_property_count == g_property_size )
+		{
+			unsigned int size = ( g_property_size > 0 ? g_property_size * 2 : 256 );
+			PROPERTY_INFO *realloc_info = ( PROPERTY_INFO * )realloc( g_property_info, sizeof( PROPERTY_INFO ) * size );
+			if ( realloc_info == NULL )
+			{
+				free( sei->windows_property );
+				free( sei );
+
+				return 0;
+			}
+
+			g_property_info = realloc_info;
+			g_property_size = size;
+		}
+
+		PROPERTY_INFO *pi = &g_property_info[ g_property_count ];
 		pi->sei = sei;
 		pi->id = ( argv[ 0 ] != NULL ? strtoul( argv[ 0 ], NULL, 10 ) : 0 );
 		pi->property_name_length = property_name_length;
 
-		if ( dllrbt_insert( g_property_tree, ( void * )pi->id, pi ) != DLLRBT_STATUS_OK )
+		if ( hash_table_insert( g_property_table, pi->id, g_property_count ) == HASH_TABLE_STATUS_OK )
+		{
+			++g_property_count;
+		}
+		else
 		{
 			free( pi->sei->windows_property );
 			free( pi->sei );
-			free( pi );
 		}
 	}
 
@@ -150,6 +156,11 @@ int CheckPropertyInfoCallback( void *arg, int argc, char **argv, char ** /*azCol
 	PROPERTY_INFO_STATUS *pis = ( PROPERTY_INFO_STATUS * )arg;
 	if ( pis != NULL && argc == 5 )
 	{
+		if ( argv[ 0 ] != NULL )
+		{
+			pis->work_id = _strtoui64( argv[ 0 ], NULL, 10 );
+		}
+
 		unsigned long Id_num = ( argv[ 1 ] != NULL ? strtoul( argv[ 1 ], NULL, 10 ) : 0 );
 		char *val = argv[ 3 ];
 
@@ -193,13 +204,19 @@ argv[ 4 ] = VariantType
 */
 int CreatePropertyInfoCallback( void *arg, int argc, char **argv, char ** /*azColName*/ )
 {
-	FILE_INFO *fi = ( FILE_INFO * )arg;
-	if ( fi != NULL && argc == 5 )
+	EXTENDED_INFO **ei_list = ( EXTENDED_INFO ** )arg;
+	if ( ei_list != NULL && argc == 5 )
 	{
 		SHARED_EXTENDED_INFO *sei = NULL;
 
 		unsigned long Id_num = ( argv[ 1 ] != NULL ? strtoul( argv[ 1 ], NULL, 10 ) : 0 );
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )dllrbt_find( g_property_tree, ( void * )Id_num, true );
+		PROPERTY_INFO *pi = NULL;
+		unsigned int index = 0;
+		if ( hash_table_find( g_property_table, Id_num, &index ) )
+		{
+			pi = &g_property_info[ index ];
+		}
+
 		if ( pi != NULL && pi->sei != NULL )
 		{
 			++pi->sei->count;
@@ -437,12 +454,12 @@ int CreatePropertyInfoCallback( void *arg, int argc, char **argv, char ** /*azCo
 			break;
 		}
 
-		if ( fi->ei != NULL )
+		if ( *ei_list != NULL )
 		{
-			ei->next = fi->ei;
+			ei->next = *ei_list;
 		}
 
-		fi->ei = ei;
+		*ei_list = ei;
 	}
 	return 0;
 }
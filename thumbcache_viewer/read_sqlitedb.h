@@ -30,6 +30,7 @@ struct PROPERTY_INFO_STATUS
 {
 	wchar_t *file_extension;
 	wchar_t *item_path_display;
+	unsigned long long work_id;
 	unsigned long file_attributes;
 };
 
@@ -19,47 +19,470 @@
 #include "read_thumbcache.h"
 #include "globals.h"
 #include "utilities.h"
+#include "find_signature.h"
+#include "entry_index.h"
 
 #include <stdio.h>
 
 bool scan_memory( HANDLE hFile, unsigned int &offset )
 {
-	// Allocate a 32 kilobyte chunk of memory to scan. This value is arbitrary.
-	char *buf = ( char * )malloc( sizeof( char ) * 32768 );
-	char *scan = NULL;
+	// Allocate a 64 kilobyte chunk of memory to scan, plus room for the bytes we carry over from the previous chunk. This value is arbitrary.
+	unsigned char *buf = ( unsigned char * )malloc( sizeof( unsigned char ) * ( 65536 + 3 ) );
+	unsigned int carry = 0;
 	DWORD read = 0;
+	bool found = false;
 
 	for ( ;; )
 	{
-		// Begin reading through the database.
-		ReadFile( hFile, buf, sizeof( char ) * 32768, &read, NULL );
-		if ( read <= 4 )
+		// Begin reading through the database. offset is the position of the first byte in buf.
+		ReadFile( hFile, buf + carry, sizeof( unsigned char ) * 65536, &read, NULL );
+		if ( read == 0 )
 		{
-			free( buf );
-			return false;
+			break;
+		}
+
+		unsigned int length = carry + read;
+
+		// Look for the magic identifier.
+		size_t index = find_signature( buf, length );
+		if ( index < length )
+		{
+			offset += ( unsigned int )index;
+			found = true;
+			break;
 		}
 
-		// Binary string search. Look for the magic identifier.
-		scan = buf;
-		while ( read-- > 4 && memcmp( scan++, "CMMM", 4 ) != 0 )
+		// Carry the last 3 bytes over to the next chunk in case we truncated the magic identifier. There's no need to read them again.
+		carry = min( 3, length );
+		memmove( buf, buf + ( length - carry ), carry );
+		offset += ( length - carry );
+	}
+
+	free( buf );
+	return found;
+}
+
+// Adds an entry to the listview, or to the blank entries if they're hidden.
+void add_entry( FILE_INFO *fi, SHARED_INFO *&si, const database_header &dh, const wchar_t *filepath, int &item_count )
+{
+	// Do this only once for each database, and only if we have an entry to add to the listview.
+	if ( si == NULL )
+	{
+		// This information is shared between entries within the database.
+		si = ( SHARED_INFO * )malloc( sizeof( SHARED_INFO ) );
+		si->count = 0;
+		si->system = dh.version;
+		wcscpy_s( si->dbpath, MAX_PATH, filepath );
+	}
+
+	// Increase the number of items for our shared information.
+	++( si->count );
+
+	// The operating system and database location is shared among each entry for the database. This will reduce the amount of memory used.
+	fi->si = si;
+
+	// Add blank entries to our blank entries linked list.
+	if ( hide_blank_entries && fi->size == 0 )
+	{
+		LINKED_LIST *be = ( LINKED_LIST * )malloc( sizeof( LINKED_LIST ) );
+		be->fi = fi;
+		be->next = g_be;
+
+		g_be = be;
+	}
+	else
+	{
+		// Insert a row into our listview.
+		LVITEM lvi = { NULL };
+		lvi.mask = LVIF_PARAM; // Our listview items will display the text contained the lParam value.
+		lvi.iItem = item_count++;
+		lvi.iSubItem = 0;
+		lvi.lParam = ( LPARAM )fi;
+		SendMessage( g_hWnd_list, LVM_INSERTITEM, 0, ( LPARAM )&lvi );
+	}
+}
+
+// Adds the entries of a database's index to the listview without reading the database.
+void load_entries( const ENTRY_INDEX *index, const database_header &dh, const wchar_t *filepath )
+{
+	SHARED_INFO *si = NULL;
+	int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );	// We don't need to call this for each item.
+
+	for ( unsigned int i = 0; i < index->header->record_count; ++i )
+	{
+		// Stop processing and exit the thread.
+		if ( g_kill_thread )
 		{
-			++offset;
+			break;
 		}
 
-		// If it's not found, then we'll keep scanning.
-		if ( read < 4 )
+		const ENTRY_INDEX_RECORD *record = &index->records[ i ];
+
+		// We only save entries, but make sure the identifier string is within the index.
+		if ( record->type != STEP_ENTRY || record->name_offset > index->header->name_size || record->name_length > ( index->header->name_size - record->name_offset ) )
 		{
-			// Adjust the offset back 4 characters (in case we truncated the magic identifier when reading).
-			SetFilePointer( hFile, offset, NULL, FILE_BEGIN );
-			// Keep scanning.
 			continue;
 		}
 
-		break;
+		wchar_t *filename = ( wchar_t * )malloc( record->name_length + sizeof( wchar_t ) );
+		memcpy( filename, index->names + record->name_offset, record->name_length );
+		filename[ record->name_length / sizeof( wchar_t ) ] = 0;	// Sanity.
+
+		FILE_INFO *fi = ( FILE_INFO * )malloc( sizeof( FILE_INFO ) );
+		fi->flag = record->file_type;
+		fi->row_reference = 0;
+		fi->shared_filename = false;
+		fi->header_offset = ( unsigned int )record->offset;
+		fi->data_offset = ( unsigned int )record->data_offset;
+		fi->size = record->data_size;
+
+		fi->entry_hash = fi->mapped_hash = record->entry_hash;
+		fi->data_checksum = fi->v_data_checksum = record->data_checksum;
+		fi->header_checksum = fi->v_header_checksum = record->header_checksum;
+
+		fi->filename = filename;	// Gets deleted during shutdown.
+
+		add_entry( fi, si, dh, filepath, item_count );
 	}
+}
 
-	free( buf );
-	return true;
+// Parses each cache entry in the database and adds it to the listview.
+// The entry loop is instantiated once for each entry layout so that the database version only needs to be checked once.
+template < typename T >
+void read_entries( HANDLE hFile, const database_header &dh, const wchar_t *filepath )
+{
+	SHARED_INFO *si = NULL;
+	DWORD read = 0;
+	int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );	// We don't need to call this for each item.
+
+	ENTRY_INDEX_HEADER eih;
+	bool save_index = false;
+
+	// An index is only valid for the exact database that it was saved for.
+	if ( use_index_files && GetEntryIndexKey( hFile, ENTRY_INDEX_CREATOR_GUI, &eih ) )
+	{
+		ENTRY_INDEX *index = LoadEntryIndex( filepath, &eih, true );
+		if ( index != NULL )
+		{
+			load_entries( index, dh, filepath );
+			FreeEntryIndex( index );
+
+			return;
+		}
+
+		save_index = true;
+	}
+
+	// The records and identifier strings of the index we'll save. Databases that couldn't be read without errors aren't saved.
+	ENTRY_INDEX_RECORD *records = NULL;
+	unsigned int record_size = 0;
+	unsigned char *names = NULL;
+	unsigned int name_buffer_size = 0;
+
+	// Set the file pointer to the first possible cache entry. (Should be at an offset equal to the size of the header)
+	// current_position will keep track our our file pointer position before setting the file pointer. (ReadFile sets it as well)
+	unsigned int current_position = ( dh.version != WINDOWS_8v2 ? 24 : 28 );
+
+	unsigned int header_offset = 0;
+
+	T dce;
+
+	// Go through our database and attempt to extract each cache entry.
+	for ( ;; )
+	{
+		// Stop processing and exit the thread.
+		if ( g_kill_thread )
+		{
+			save_index = false;
+
+			break;
+		}
+
+		// Set the file pointer to the end of the last cache entry.
+		current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
+		if ( current_position == INVALID_SET_FILE_POINTER )
+		{
+			if ( cmd_line != 2 ){ MessageBoxA( g_hWnd_main, "Invalid cache entry.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING ); }
+
+			save_index = false;
+
+			break;
+		}
+
+		ReadFile( hFile, &dce, sizeof( T ), &read, NULL );
+
+		// Make sure it's a thumbcache database and the stucture was filled correctly.
+		if ( read != sizeof( T ) )
+		{
+			// EOF reached.
+			break;
+		}
+		else if ( memcmp( dce.magic_identifier, "CMMM", 4 ) != 0 )
+		{
+			// Walk back to the end of the last cache entry.
+			current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
+
+			// If we found the beginning of the entry, attempt to read it again.
+			if ( scan_memory( hFile, current_position ) )
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		// I think this signifies the end of a valid database and everything beyond this is data that's been overwritten.
+		if ( dce.entry_hash == 0 )
+		{
+			// Skip the header of this entry. If the next position is invalid (which it probably will be), we'll end up scanning.
+			current_position += read;
+
+			continue;
+		}
+
+		header_offset = current_position;
+
+		// Size of the cache entry.
+		unsigned int cache_entry_size = dce.cache_entry_size;
+
+		current_position += cache_entry_size;
+
+		// Filename length should be the total number of bytes (excluding the NULL character) that the UTF-16 filename takes up. A realistic limit should be twice the size of MAX_PATH.
+		unsigned int filename_length = dce.filename_length;
+
+		// Since the database can store CLSIDs that extend beyond MAX_PATH, we'll have to set a larger truncation length. A length of 32767 would probably never be seen. 
+		unsigned int filename_truncate_length = min( filename_length, ( sizeof( wchar_t ) * SHRT_MAX ) );
+		
+		// UTF-16 filename. Allocate the filename length, any extra extension, 4 for the unicode extension (.xxx), and 1 for the null character. This will get deleted before MainWndProc is destroyed. See WM_DESTROY in MainWndProc.
+		unsigned int filename_end = filename_truncate_length / sizeof( wchar_t );
+		unsigned char extra_extension = 0;
+		const wchar_t *extension = entry_extension( dce );
+		if ( extension != NULL )
+		{
+			// The Vista file extension can be up to 4 characters long and unterminated.
+			extra_extension = ( unsigned char )wcsnlen( extension, 4 );
+
+			// Include '.'
+			if ( extra_extension > 0 )
+			{
+				++extra_extension;
+			}
+		}
+		wchar_t *filename = ( wchar_t * )malloc( filename_truncate_length + ( sizeof( wchar_t ) * ( extra_extension + 4 + 1 ) ) );
+		memset( filename, 0, filename_truncate_length + ( sizeof( wchar_t ) * ( extra_extension + 4 + 1 ) ) );
+		ReadFile( hFile, filename, filename_truncate_length, &read, NULL );
+		if ( read == 0 )
+		{
+			free( filename );
+			
+			if ( cmd_line != 2 )
+			{
+				char msg[ 49 ] = { 0 };
+				sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
+				MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
+			}
+
+			save_index = false;
+
+			break;
+		}
+
+		// Add the Windows Vista file extension.
+		if ( extra_extension > 0 )
+		{
+			wmemcpy_s( filename + filename_end, 1, L".", 1 );
+			wmemcpy_s( filename + filename_end + 1, 4, extension, 4 );
+			filename_end += extra_extension;
+		}
+
+		unsigned int file_position = 0;
+
+		// Adjust our file pointer if we truncated the filename. This really shouldn't happen unless someone tampered with the database, or it became corrupt.
+		if ( filename_length > filename_truncate_length )
+		{
+			// Offset the file pointer and see if we've moved beyond the EOF.
+			file_position = SetFilePointer( hFile, filename_length - filename_truncate_length, 0, FILE_CURRENT );
+			if ( file_position == INVALID_SET_FILE_POINTER )
+			{
+				free( filename );
+
+				if ( cmd_line != 2 )
+				{
+					char msg[ 49 ] = { 0 };
+					sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
+					MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
+				}
+				
+				save_index = false;
+
+				break;
+			}
+		}
+
+		// Padding before the data entry.
+		unsigned int padding_size = dce.padding_size;
+
+		// This will set our file pointer to the beginning of the data entry.
+		file_position = SetFilePointer( hFile, padding_size, 0, FILE_CURRENT );
+		if ( file_position == INVALID_SET_FILE_POINTER )
+		{
+			free( filename );
+
+			if ( cmd_line != 2 )
+			{
+				char msg[ 49 ] = { 0 };
+				sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
+				MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
+			}
+
+			save_index = false;
+
+			break;
+		}
+
+		// Size of our image.
+		unsigned int data_size = dce.data_size;
+
+		// Create a new info structure to send to the listview item's lParam value.
+		FILE_INFO *fi = ( FILE_INFO * )malloc( sizeof( FILE_INFO ) );
+		fi->flag = 0;
+		fi->row_reference = 0;
+		fi->shared_filename = false;
+		fi->header_offset = header_offset;
+		fi->data_offset = file_position;
+		fi->size = data_size;
+
+		fi->entry_hash = fi->mapped_hash = dce.entry_hash;
+		fi->data_checksum = fi->v_data_checksum = dce.data_checksum;
+		fi->header_checksum = fi->v_header_checksum = dce.header_checksum;
+
+		// Read any data that exists and get its file extension.
+		if ( data_size != 0 )
+		{
+			// Retrieve the data content header. Our longest identifier is 8 bytes.
+			char *buf = ( char * )malloc( sizeof( char ) * 8 );
+			ReadFile( hFile, buf, 8, &read, NULL );
+			if ( read == 0 )
+			{
+				free( buf );
+				free( fi );
+				free( filename );
+
+				if ( cmd_line != 2 )
+				{
+					char msg[ 49 ] = { 0 };
+					sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
+					MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
+				}
+
+				save_index = false;
+
+				break;
+			}
+
+			// Detect the file type and copy its file extension into the filename string.
+			if ( memcmp( buf, FILE_TYPE_BMP, 2 ) == 0 )			// First 3 bytes
+			{
+				fi->flag = FIF_TYPE_BMP;
+
+				if ( extension == NULL || _wcsnicmp( extension, L"bmp", 4 ) != 0 )
+				{
+					wmemcpy_s( filename + filename_end, 4, L".bmp", 4 );
+				}
+			}
+			else if ( memcmp( buf, FILE_TYPE_JPEG, 4 ) == 0 )	// First 4 bytes
+			{
+				fi->flag = FIF_TYPE_JPG;
+
+				if ( extension == NULL || _wcsnicmp( extension, L"jpg", 4 ) != 0 )
+				{
+					wmemcpy_s( filename + filename_end, 4, L".jpg", 4 );
+				}
+			}
+			else if ( memcmp( buf, FILE_TYPE_PNG, 8 ) == 0 )	// First 8 bytes
+			{
+				fi->flag = FIF_TYPE_PNG;
+
+				if ( extension == NULL || _wcsnicmp( extension, L"png", 4 ) != 0 )
+				{
+					wmemcpy_s( filename + filename_end, 4, L".png", 4 );
+				}
+			}
+
+			// Free our data buffer.
+			free( buf );
+
+			// This will set our file pointer to the end of the data entry.
+			SetFilePointer( hFile, data_size - 8, 0, FILE_CURRENT );
+		}
+
+		fi->filename = filename;	// Gets deleted during shutdown.
+
+		if ( save_index )
+		{
+			unsigned int name_length = ( unsigned int )( wcslen( filename ) * sizeof( wchar_t ) );
+
+			if ( eih.record_count == record_size )
+			{
+				record_size = ( record_size > 0 ? record_size * 2 : 1024 );
+				ENTRY_INDEX_RECORD *realloc_buffer = ( ENTRY_INDEX_RECORD * )realloc( records, sizeof( ENTRY_INDEX_RECORD ) * record_size );
+				if ( realloc_buffer == NULL )
+				{
+					save_index = false;
+				}
+				else
+				{
+					records = realloc_buffer;
+				}
+			}
+
+			if ( save_index && eih.name_size + name_length > name_buffer_size )
+			{
+				name_buffer_size = max( name_buffer_size * 2, eih.name_size + name_length );
+				unsigned char *realloc_buffer = ( unsigned char * )realloc( names, sizeof( unsigned char ) * name_buffer_size );
+				if ( realloc_buffer == NULL )
+				{
+					save_index = false;
+				}
+				else
+				{
+					names = realloc_buffer;
+				}
+			}
+
+			if ( save_index )
+			{
+				ENTRY_INDEX_RECORD *record = &records[ eih.record_count++ ];
+				memset( record, 0, sizeof( ENTRY_INDEX_RECORD ) );
+				record->offset = fi->header_offset;
+				record->data_offset = fi->data_offset;
+				record->entry_hash = fi->entry_hash;
+				record->data_checksum = fi->data_checksum;
+				record->header_checksum = fi->header_checksum;
+				record->number = eih.record_count;
+				record->data_size = fi->size;
+				record->name_offset = eih.name_size;
+				record->name_length = name_length;
+				record->type = STEP_ENTRY;
+				record->file_type = fi->flag;
+
+				memcpy( names + eih.name_size, filename, name_length );
+				eih.name_size += name_length;
+			}
+		}
+
+		add_entry( fi, si, dh, filepath, item_count );
+	}
+
+	if ( save_index )
+	{
+		eih.entry_count = eih.record_count;
+
+		SaveEntryIndex( filepath, &eih, records, names );
+	}
+
+	free( names );
+	free( records );
 }
 
 unsigned __stdcall read_thumbcache( void *pArguments )
@@ -122,9 +545,7 @@ unsigned __stdcall read_thumbcache( void *pArguments )
 			HANDLE hFile = CreateFile( filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
 			if ( hFile != INVALID_HANDLE_VALUE )
 			{
-				SHARED_INFO *si = NULL;
 				DWORD read = 0;
-				int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );	// We don't need to call this for each item.
 
 				database_header dh = { 0 };
 				ReadFile( hFile, &dh, sizeof( database_header ), &read, NULL );
@@ -132,398 +553,27 @@ unsigned __stdcall read_thumbcache( void *pArguments )
 				// Make sure it's a thumbcache database and the stucture was filled correctly.
 				if ( memcmp( dh.magic_identifier, "CMMM", 4 ) != 0 || read != sizeof( database_header ) )
 				{
-					CloseHandle( hFile );
-					free( filepath );
-
 					if ( cmd_line != 2 ){ MessageBoxA( g_hWnd_main, "The file is not a thumbcache database.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING ); }
-
-					continue;
 				}
-
-				// Set the file pointer to the first possible cache entry. (Should be at an offset equal to the size of the header)
-				// current_position will keep track our our file pointer position before setting the file pointer. (ReadFile sets it as well)
-				unsigned int current_position = ( dh.version != WINDOWS_8v2 ? 24 : 28 );
-
-				bool next_file = false;	// Go to the next database file.
-				unsigned int header_offset = 0;
-
-				// Go through our database and attempt to extract each cache entry.
-				for ( ;; )
+				else if ( dh.version == WINDOWS_VISTA )
 				{
-					// Stop processing and exit the thread.
-					if ( g_kill_thread )
-					{
-						free( filepath );
-
-						next_file = true;
-						break;
-					}
-
-					// Set the file pointer to the end of the last cache entry.
-					current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
-					if ( current_position == INVALID_SET_FILE_POINTER )
-					{
-						free( filepath );
-
-						if ( cmd_line != 2 ){ MessageBoxA( g_hWnd_main, "Invalid cache entry.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING ); }
-
-						next_file = true;
-						break;
-					}
-
-					void *database_cache_entry = NULL;
-					// Determine the type of database we're working with and store its content in the correct structure.
-					if ( dh.version == WINDOWS_7 )
-					{
-						database_cache_entry = ( database_cache_entry_7 * )malloc( sizeof( database_cache_entry_7 ) );
-						ReadFile( hFile, database_cache_entry, sizeof( database_cache_entry_7 ), &read, NULL );
-						
-						// Make sure it's a thumbcache database and the stucture was filled correctly.
-						if ( read != sizeof( database_cache_entry_7 ) )
-						{
-							// EOF reached.
-							free( database_cache_entry );
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-						else if ( memcmp( ( ( database_cache_entry_7 * )database_cache_entry )->magic_identifier, "CMMM", 4 ) != 0 )
-						{
-							free( database_cache_entry );
-
-							// Walk back to the end of the last cache entry.
-							current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
-
-							// If we found the beginning of the entry, attempt to read it again.
-							if ( scan_memory( hFile, current_position ) )
-							{
-								continue;
-							}
-
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-					}
-					else if ( dh.version == WINDOWS_VISTA )
-					{
-						database_cache_entry = ( database_cache_entry_vista * )malloc( sizeof( database_cache_entry_vista ) );
-						ReadFile( hFile, database_cache_entry, sizeof( database_cache_entry_vista ), &read, NULL );
-						// Make sure it's a thumbcache database and the stucture was filled correctly.
-						if ( read != sizeof( database_cache_entry_vista ) )
-						{
-							// EOF reached.
-							free( database_cache_entry );
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-						else if ( memcmp( ( ( database_cache_entry_vista * )database_cache_entry )->magic_identifier, "CMMM", 4 ) != 0 )
-						{
-							free( database_cache_entry );
-
-							// Walk back to the end of the last cache entry.
-							current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
-
-							// If we found the beginning of the entry, attempt to read it again.
-							if ( scan_memory( hFile, current_position ) )
-							{
-								continue;
-							}
-
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-					}
-					else if ( dh.version == WINDOWS_8 || dh.version == WINDOWS_8v2 || dh.version == WINDOWS_8v3 || dh.version == WINDOWS_8_1 || dh.version == WINDOWS_10 )
-					{
-						database_cache_entry = ( database_cache_entry_8 * )malloc( sizeof( database_cache_entry_8 ) );
-						ReadFile( hFile, database_cache_entry, sizeof( database_cache_entry_8 ), &read, NULL );
-						
-						// Make sure it's a thumbcache database and the stucture was filled correctly.
-						if ( read != sizeof( database_cache_entry_8 ) )
-						{
-							// EOF reached.
-							free( database_cache_entry );
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-						else if ( memcmp( ( ( database_cache_entry_8 * )database_cache_entry )->magic_identifier, "CMMM", 4 ) != 0 )
-						{
-							free( database_cache_entry );
-
-							// Walk back to the end of the last cache entry.
-							current_position = SetFilePointer( hFile, current_position, NULL, FILE_BEGIN );
-
-							// If we found the beginning of the entry, attempt to read it again.
-							if ( scan_memory( hFile, current_position ) )
-							{
-								continue;
-							}
-
-							free( filepath );
-
-							next_file = true;
-							break;
-						}
-					}
-					else	// If this is true, then the file isn't from Vista, 7, 8, or 10 and not supported by this program.
-					{
-						free( filepath );
-
-						if ( cmd_line != 2 ){ MessageBoxA( g_hWnd_main, "The file is not supported by this program.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING ); }
-
-						next_file = true;
-						break;
-					}
-
-					// I think this signifies the end of a valid database and everything beyond this is data that's been overwritten.
-					if ( ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->entry_hash : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->entry_hash : ( ( database_cache_entry_8 * )database_cache_entry )->entry_hash ) ) == 0 )
-					{
-						// Skip the header of this entry. If the next position is invalid (which it probably will be), we'll end up scanning.
-						current_position += read;
-						// Free each database entry that we've skipped over.
-						free( database_cache_entry );
-
-						continue;
-					}
-
-					header_offset = current_position;
-
-					// Size of the cache entry.
-					unsigned int cache_entry_size = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->cache_entry_size : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->cache_entry_size : ( ( database_cache_entry_8 * )database_cache_entry )->cache_entry_size ) );
-
-					current_position += cache_entry_size;
-
-					// Filename length should be the total number of bytes (excluding the NULL character) that the UTF-16 filename takes up. A realistic limit should be twice the size of MAX_PATH.
-					unsigned int filename_length = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->filename_length : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->filename_length : ( ( database_cache_entry_8 * )database_cache_entry )->filename_length ) );
-
-					// Since the database can store CLSIDs that extend beyond MAX_PATH, we'll have to set a larger truncation length. A length of 32767 would probably never be seen. 
-					unsigned int filename_truncate_length = min( filename_length, ( sizeof( wchar_t ) * SHRT_MAX ) );
-					
-					// UTF-16 filename. Allocate the filename length, any extra extension, 4 for the unicode extension (.xxx), and 1 for the null character. This will get deleted before MainWndProc is destroyed. See WM_DESTROY in MainWndProc.
-					unsigned int filename_end = filename_truncate_length / sizeof( wchar_t );
-					unsigned char extra_extension = 0;
-					if ( dh.version == WINDOWS_VISTA )
-					{
-						// The Vista file extension can be up to 4 characters long and unterminated.
-						extra_extension = ( unsigned char )wcsnlen( ( ( database_cache_entry_vista * )database_cache_entry )->extension, 4 );
-
-						// Include '.'
-						if ( extra_extension > 0 )
-						{
-							++extra_extension;
-						}
-					}
-					wchar_t *filename = ( wchar_t * )malloc( filename_truncate_length + ( sizeof( wchar_t ) * ( extra_extension + 4 + 1 ) ) );
-					memset( filename, 0, filename_truncate_length + ( sizeof( wchar_t ) * ( extra_extension + 4 + 1 ) ) );
-					ReadFile( hFile, filename, filename_truncate_length, &read, NULL );
-					if ( read == 0 )
-					{
-						free( filename );
-						free( database_cache_entry );
-						free( filepath );
-						
-						if ( cmd_line != 2 )
-						{
-							char msg[ 49 ] = { 0 };
-							sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
-							MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
-						}
-
-						next_file = true;
-						break;
-					}
-
-					// Add the Windows Vista file extension.
-					if ( extra_extension > 0 )
-					{
-						wmemcpy_s( filename + filename_end, 1, L".", 1 );
-						wmemcpy_s( filename + filename_end + 1, 4, ( ( database_cache_entry_vista * )database_cache_entry )->extension, 4 );
-						filename_end += extra_extension;
-					}
-
-					unsigned int file_position = 0;
-
-					// Adjust our file pointer if we truncated the filename. This really shouldn't happen unless someone tampered with the database, or it became corrupt.
-					if ( filename_length > filename_truncate_length )
-					{
-						// Offset the file pointer and see if we've moved beyond the EOF.
-						file_position = SetFilePointer( hFile, filename_length - filename_truncate_length, 0, FILE_CURRENT );
-						if ( file_position == INVALID_SET_FILE_POINTER )
-						{
-							free( filename );
-							free( database_cache_entry );
-							free( filepath );
-
-							if ( cmd_line != 2 )
-							{
-								char msg[ 49 ] = { 0 };
-								sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
-								MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
-							}
-							
-							next_file = true;
-							break;
-						}
-					}
-
-					// Padding before the data entry.
-					unsigned int padding_size = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->padding_size : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->padding_size : ( ( database_cache_entry_8 * )database_cache_entry )->padding_size ) );
-
-					// This will set our file pointer to the beginning of the data entry.
-					file_position = SetFilePointer( hFile, padding_size, 0, FILE_CURRENT );
-					if ( file_position == INVALID_SET_FILE_POINTER )
-					{
-						free( filename );
-						free( database_cache_entry );
-						free( filepath );
-
-						if ( cmd_line != 2 )
-						{
-							char msg[ 49 ] = { 0 };
-							sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
-							MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
-						}
-
-						next_file = true;
-						break;
-					}
-
-					// Size of our image.
-					unsigned int data_size = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->data_size : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->data_size : ( ( database_cache_entry_8 * )database_cache_entry )->data_size ) );
-
-					// Create a new info structure to send to the listview item's lParam value.
-					FILE_INFO *fi = ( FILE_INFO * )malloc( sizeof( FILE_INFO ) );
-					fi->flag = 0;
-					fi->ei = NULL;
-					fi->header_offset = header_offset;
-					fi->data_offset = file_position;
-					fi->size = data_size;
-
-					fi->entry_hash = fi->mapped_hash = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->entry_hash : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->entry_hash : ( ( database_cache_entry_8 * )database_cache_entry )->entry_hash ) );
-					fi->data_checksum = fi->v_data_checksum = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->data_checksum : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->data_checksum : ( ( database_cache_entry_8 * )database_cache_entry )->data_checksum ) );
-					fi->header_checksum = fi->v_header_checksum = ( ( dh.version == WINDOWS_7 ) ? ( ( database_cache_entry_7 * )database_cache_entry )->header_checksum : ( ( dh.version == WINDOWS_VISTA ) ? ( ( database_cache_entry_vista * )database_cache_entry )->header_checksum : ( ( database_cache_entry_8 * )database_cache_entry )->header_checksum ) );
-
-					// Read any data that exists and get its file extension.
-					if ( data_size != 0 )
-					{
-						// Retrieve the data content header. Our longest identifier is 8 bytes.
-						char *buf = ( char * )malloc( sizeof( char ) * 8 );
-						ReadFile( hFile, buf, 8, &read, NULL );
-						if ( read == 0 )
-						{
-							free( buf );
-							free( fi );
-							free( filename );
-							free( database_cache_entry );
-							free( filepath );
-
-							if ( cmd_line != 2 )
-							{
-								char msg[ 49 ] = { 0 };
-								sprintf_s( msg, 49, "Invalid cache entry located at %lu bytes.", current_position );
-								MessageBoxA( g_hWnd_main, msg, PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
-							}
-
-							next_file = true;
-							break;
-						}
-
-						// Detect the file type and copy its file extension into the filename string.
-						if ( memcmp( buf, FILE_TYPE_BMP, 2 ) == 0 )			// First 3 bytes
-						{
-							fi->flag = FIF_TYPE_BMP;
-
-							if ( dh.version != WINDOWS_VISTA ||
-							   ( dh.version == WINDOWS_VISTA && _wcsnicmp( ( ( database_cache_entry_vista * )database_cache_entry )->extension, L"bmp", 4 ) != 0 ) )
-							{
-								wmemcpy_s( filename + filename_end, 4, L".bmp", 4 );
-							}
-						}
-						else if ( memcmp( buf, FILE_TYPE_JPEG, 4 ) == 0 )	// First 4 bytes
-						{
-							fi->flag = FIF_TYPE_JPG;
-
-							if ( dh.version != WINDOWS_VISTA ||
-							   ( dh.version == WINDOWS_VISTA && _wcsnicmp( ( ( database_cache_entry_vista * )database_cache_entry )->extension, L"jpg", 4 ) != 0 ) )
-							{
-								wmemcpy_s( filename + filename_end, 4, L".jpg", 4 );
-							}
-						}
-						else if ( memcmp( buf, FILE_TYPE_PNG, 8 ) == 0 )	// First 8 bytes
-						{
-							fi->flag = FIF_TYPE_PNG;
-
-							if ( dh.version != WINDOWS_VISTA ||
-							   ( dh.version == WINDOWS_VISTA && _wcsnicmp( ( ( database_cache_entry_vista * )database_cache_entry )->extension, L"png", 4 ) != 0 ) )
-							{
-								wmemcpy_s( filename + filename_end, 4, L".png", 4 );
-							}
-						}
-
-						// Free our data buffer.
-						free( buf );
-
-						// This will set our file pointer to the end of the data entry.
-						SetFilePointer( hFile, data_size - 8, 0, FILE_CURRENT );
-					}
-
-					fi->filename = filename;	// Gets deleted during shutdown.
-
-					// Do this only once for each database, and only if we have an entry to add to the listview.
-					if ( si == NULL )
-					{
-						// This information is shared between entries within the database.
-						si = ( SHARED_INFO * )malloc( sizeof( SHARED_INFO ) );
-						si->count = 0;
-						si->system = dh.version;
-						wcscpy_s( si->dbpath, MAX_PATH, filepath );
-					}
-
-					// Increase the number of items for our shared information.
-					++( si->count );
-
-					// The operating system and database location is shared among each entry for the database. This will reduce the amount of memory used.
-					fi->si = si;
-
-					// Add blank entries to our blank entries linked list.
-					if ( hide_blank_entries && fi->size == 0 )
-					{
-						LINKED_LIST *be = ( LINKED_LIST * )malloc( sizeof( LINKED_LIST ) );
-						be->fi = fi;
-						be->next = g_be;
-
-						g_be = be;
-					}
-					else
-					{
-						// Insert a row into our listview.
-						LVITEM lvi = { NULL };
-						lvi.mask = LVIF_PARAM; // Our listview items will display the text contained the lParam value.
-						lvi.iItem = item_count++;
-						lvi.iSubItem = 0;
-						lvi.lParam = ( LPARAM )fi;
-						SendMessage( g_hWnd_list, LVM_INSERTITEM, 0, ( LPARAM )&lvi );
-					}
-
-					// Free our database cache entry.
-					free( database_cache_entry );
+					read_entries< database_cache_entry_vista >( hFile, dh, filepath );
 				}
-				// Close the input file.
-				CloseHandle( hFile );
-
-				if ( next_file )
+				else if ( dh.version == WINDOWS_7 )
+				{
+					read_entries< database_cache_entry_7 >( hFile, dh, filepath );
+				}
+				else if ( dh.version == WINDOWS_8 || dh.version == WINDOWS_8v2 || dh.version == WINDOWS_8v3 || dh.version == WINDOWS_8_1 || dh.version == WINDOWS_10 )
 				{
-					continue;
+					read_entries< database_cache_entry_8 >( hFile, dh, filepath );
 				}
+				else	// If this is true, then the file isn't from Vista, 7, 8, or 10 and not supported by this program.
+				{
+					if ( cmd_line != 2 ){ MessageBoxA( g_hWnd_main, "The file is not supported by this program.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING ); }
+				}
+
+				// Close the input file.
+				CloseHandle( hFile );
 			}
 			else
 			{
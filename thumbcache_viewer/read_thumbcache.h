@@ -19,6 +19,8 @@
 #ifndef READ_THUMBCACHE_H
 #define READ_THUMBCACHE_H
 
+#include "globals.h"
+
 #define WINDOWS_VISTA	0x14
 #define WINDOWS_7		0x15
 #define WINDOWS_8		0x1A
@@ -111,6 +113,10 @@ struct database_cache_entry_vista
 	unsigned long long header_checksum;
 };
 
+// Windows Vista is the only layout that stores the file extension in the entry.
+inline const wchar_t *entry_extension( const database_cache_entry_vista &dce ) { return dce.extension; }
+template < typename T > inline const wchar_t *entry_extension( const T & ) { return NULL; }
+
 unsigned __stdcall read_thumbcache( void *pArguments );
 
 #endif
@@ -19,6 +19,7 @@
 #include "globals.h"
 #include "menus.h"
 #include "read_thumbcache.h"
+#include "map_entries.h"
 
 #include "lite_user32.h"
 #include "lite_mssrch.h"
@@ -57,6 +58,7 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR lpCm
 
 	// Blocks our reading thread and various GUI operations.
 	InitializeCriticalSection( &pe_cs );
+	InitializeCriticalSection( &row_cs );
 
 	// Get the system icon for each of the three file types.
 	SHFILEINFOA shfi = { NULL }; 
@@ -244,6 +246,13 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE /*hPrevInstance*/, LPSTR lpCm
 						// Put a check next to the menu item. g_hMenu is created in g_hWnd_main.
 						CheckMenuItem( g_hMenu, MENU_HIDE_BLANK, MF_CHECKED );
 					}
+					else if ( filepath_length > 1 && szArgList[ i ][ 0 ] == L'-' && ( szArgList[ i ][ 1 ] == L'i' || szArgList[ i ][ 1 ] == L'I' ) )
+					{
+						use_index_files = true;
+
+						// Put a check next to the menu item. g_hMenu is created in g_hWnd_main.
+						CheckMenuItem( g_hMenu, MENU_USE_INDEX, MF_CHECKED );
+					}
 					else	// Copy the paths into the NULL separated filepath.
 					{
 						// If the user typed a relative path, get the full path.
@@ -311,8 +320,12 @@ CLEANUP:
 	DestroyIcon( hIcon_png );
 	DestroyIcon( hIcon_bmp );
 
-	// Delete our critical section.
+	// Close any database that we mapped entries to.
+	ReleaseRowReferences();
+
+	// Delete our critical sections.
 	DeleteCriticalSection( &pe_cs );
+	DeleteCriticalSection( &row_cs );
 
 	// Shutdown GDI+
 	Gdiplus::GdiplusShutdown( gdiplusToken );
@@ -21,11 +21,12 @@
 #include "read_thumbcache.h"
 #include "menus.h"
 #include "map_entries.h"
-#include "crc64.h"
+#include "verify_entries.h"
 
 #include "lite_user32.h"
 
 #include <stdio.h>
+#include <stddef.h>
 
 HANDLE g_shutdown_semaphore = NULL;		// Blocks shutdown while a worker thread is active.
 bool g_kill_thread = false;				// Allow for a clean shutdown.
@@ -36,7 +37,8 @@ bool skip_draw = false;					// Prevents WM_DRAWITEM from accessing listview item
 
 LINKED_LIST *g_be = NULL;				// A list to hold all of the blank entries.
 
-dllrbt_tree *g_file_info_tree = NULL;	// Red-black tree of FILE_INFO structures.
+hash_table *g_file_info_table = NULL;	// Maps each hash to the first node of its list in g_file_info_list.
+LINKED_LIST *g_file_info_list = NULL;	// Nodes of FILE_INFO structures that share a hash.
 
 void Processing_Window( bool enable )
 {
@@ -57,21 +59,6 @@ void Processing_Window( bool enable )
 	}
 }
 
-int dllrbt_compare( void *a, void *b )
-{
-	if ( a > b )
-	{
-		return 1;
-	}
-
-	if ( a < b )
-	{
-		return -1;
-	}
-
-	return 0;
-}
-
 wchar_t *GetExtensionFromFilename( wchar_t *filename, unsigned long length )
 {
 	while ( length != 0 && filename[ --length ] != L'.' );
@@ -232,6 +219,58 @@ wchar_t *GetFileAttributesStr( unsigned long fa_flags )
 	return ret;
 }
 
+// The filename isn't referenced until it's set with SetSharedFilename.
+wchar_t *CreateSharedFilename( const wchar_t *filename )
+{
+	unsigned int length = ( unsigned int )wcslen( filename ) + 1;	// Include the NULL character.
+
+	SHARED_FILENAME *sf = ( SHARED_FILENAME * )malloc( offsetof( SHARED_FILENAME, filename ) + ( sizeof( wchar_t ) * length ) );
+	if ( sf == NULL )
+	{
+		return NULL;
+	}
+
+	sf->count = 0;
+	wmemcpy_s( sf->filename, length, filename, length );
+
+	return sf->filename;
+}
+
+void SetSharedFilename( FILE_INFO *fi, wchar_t *shared_filename )
+{
+	// The entry might already reference the filename.
+	++( ( ( SHARED_FILENAME * )( ( char * )shared_filename - offsetof( SHARED_FILENAME, filename ) ) )->count );
+
+	FreeFilename( fi );
+
+	fi->filename = shared_filename;
+	fi->shared_filename = true;
+}
+
+void FreeFilename( FILE_INFO *fi )
+{
+	if ( fi->shared_filename )
+	{
+		SHARED_FILENAME *sf = ( SHARED_FILENAME * )( ( char * )fi->filename - offsetof( SHARED_FILENAME, filename ) );
+
+		--( sf->count );
+
+		// Free the filename if there's no more entries that reference it.
+		if ( sf->count == 0 )
+		{
+			free( sf );
+		}
+
+		fi->shared_filename = false;
+	}
+	else
+	{
+		free( fi->filename );
+	}
+
+	fi->filename = NULL;
+}
+
 void CleanupExtendedInfo( EXTENDED_INFO *ei )
 {
 	EXTENDED_INFO *d_ei = NULL;
@@ -279,9 +318,7 @@ void CleanupBlankEntries()
 				}
 			}
 
-			CleanupExtendedInfo( del_be->fi->ei );
-
-			free( del_be->fi->filename );
+			FreeFilename( del_be->fi );
 			free( del_be->fi );
 		}
 
@@ -289,32 +326,18 @@ void CleanupBlankEntries()
 	}
 }
 
-void CleanupFileinfoTree()
+void CleanupFileinfoTable()
 {
-	// Free the values of the file info tree.
-	node_type *node = dllrbt_get_head( g_file_info_tree );
-	while ( node != NULL )
-	{
-		// Free the linked list if there is one.
-		LINKED_LIST *fi_node = ( LINKED_LIST * )node->val;
-		while ( fi_node != NULL )
-		{
-			LINKED_LIST *del_fi_node = fi_node;
-
-			fi_node = fi_node->next;
-
-			free( del_fi_node );
-		}
+	// The nodes were allocated together.
+	free( g_file_info_list );
+	g_file_info_list = NULL;
 
-		node = node->next;
-	}
-
-	// Clean up our file info tree.
-	dllrbt_delete_recursively( g_file_info_tree );
-	g_file_info_tree = NULL;
+	// Clean up our file info table.
+	hash_table_delete( g_file_info_table );
+	g_file_info_table = NULL;
 }
 
-void CreateFileinfoTree()
+void CreateFileinfoTable()
 {
 	LVITEM lvi = { NULL };
 	lvi.mask = LVIF_PARAM;
@@ -323,13 +346,21 @@ void CreateFileinfoTree()
 
 	int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );
 
-	// Create the file info tree if it doesn't exist.
-	if ( g_file_info_tree == NULL )
+	CleanupFileinfoTable();
+
+	// Every item gets a node, so the table and nodes are allocated once for all of them.
+	g_file_info_table = hash_table_create( item_count );
+	g_file_info_list = ( LINKED_LIST * )malloc( sizeof( LINKED_LIST ) * ( item_count > 0 ? item_count : 1 ) );
+	if ( g_file_info_table == NULL || g_file_info_list == NULL )
 	{
-		g_file_info_tree = dllrbt_create( dllrbt_compare );
+		CleanupFileinfoTable();
+
+		return;
 	}
 
-	// Go through each item and add them to our tree.
+	unsigned int node_count = 0;
+
+	// Go through each item and add them to our table.
 	for ( lvi.iItem = 0; lvi.iItem < item_count; ++lvi.iItem )
 	{
 		// We don't want to continue scanning if the user cancels the scan.
@@ -342,11 +373,10 @@ void CreateFileinfoTree()
 
 		fi = ( FILE_INFO * )lvi.lParam;
 
-		// Don't attempt to insert the FILE_INFO if it's already in the tree.
 		if ( fi != NULL )
 		{
-			// Create the node to insert into a linked list.
-			LINKED_LIST *fi_node = ( LINKED_LIST * )malloc( sizeof( LINKED_LIST ) );
+			// Set up the node to insert into a linked list.
+			LINKED_LIST *fi_node = &g_file_info_list[ node_count ];
 			fi_node->fi = fi;
 			fi_node->next = NULL;
 
@@ -383,20 +413,23 @@ void CreateFileinfoTree()
 				}
 			}
 
-			// See if our tree has the hash to add the node to.
-			LINKED_LIST *ll = ( LINKED_LIST * )dllrbt_find( g_file_info_tree, ( void * )fi->mapped_hash, true );
-			if ( ll == NULL )
+			// See if our table has the hash to add the node to.
+			unsigned int head = 0;
+			if ( !hash_table_find( g_file_info_table, fi->mapped_hash, &head ) )
 			{
-				if ( dllrbt_insert( g_file_info_tree, ( void * )fi->mapped_hash, fi_node ) != DLLRBT_STATUS_OK )
+				if ( hash_table_insert( g_file_info_table, fi->mapped_hash, node_count ) == HASH_TABLE_STATUS_OK )
 				{
-					free( fi_node );
+					++node_count;
 				}
 			}
 			else	// If a hash exits, insert the node into the linked list.
 			{
+				LINKED_LIST *ll = &g_file_info_list[ head ];
 				LINKED_LIST *next = ll->next;	// We'll insert the node after the head.
 				fi_node->next = next;
 				ll->next = fi_node;
+
+				++node_count;
 			}
 		}
 	}
@@ -803,10 +836,9 @@ unsigned __stdcall remove_items( void * /*pArguments*/ )
 				{
 					SendMessage( g_hWnd_info, WM_CLOSE, 0, 0 );
 				}
-				CleanupExtendedInfo( fi->ei );
 
 				// Free our filename, then FILE_INFO structure.
-				free( fi->filename );
+				FreeFilename( fi );
 				free( fi );
 			}
 		}
@@ -861,10 +893,9 @@ unsigned __stdcall remove_items( void * /*pArguments*/ )
 				{
 					SendMessage( g_hWnd_info, WM_CLOSE, 0, 0 );
 				}
-				CleanupExtendedInfo( fi->ei );
-				
+
 				// Free our filename, then FILE_INFO structure.
-				free( fi->filename );
+				FreeFilename( fi );
 				free( fi );
 			}
 
@@ -994,145 +1025,68 @@ unsigned __stdcall verify_checksums( void * /*pArguments*/ )
 
 	Processing_Window( true );
 
-	// Create our buffers to hash.
-	char *header_buffer = NULL;
-	char *data_buffer = NULL;
-	char *tmp_data = NULL;	// Used to offset the data buffer.
-
 	unsigned int bad_header = 0;
 	unsigned int bad_data = 0;
 
-	unsigned int header_size = 0;
-
-	LVITEM lvi = { NULL };
-	lvi.mask = LVIF_PARAM;
-
-	FILE_INFO *fi = NULL;
+	bool verified = false;
 
 	int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );
 
-	// Go through each item to compare values.
-	for ( lvi.iItem = 0; lvi.iItem < item_count; ++lvi.iItem )
+	// The entries that haven't been verified. They're verified together so that each database is only opened once.
+	FILE_INFO **entries = ( FILE_INFO ** )malloc( sizeof( FILE_INFO * ) * ( item_count > 0 ? item_count : 1 ) );
+	if ( entries != NULL )
 	{
-		// Stop processing and exit the thread.
-		if ( g_kill_thread )
-		{
-			break;
-		}
-
-		SendMessage( g_hWnd_list, LVM_GETITEM, 0, ( LPARAM )&lvi );
-
-		fi = ( FILE_INFO * )lvi.lParam;
-		if ( fi == NULL || ( fi != NULL && fi->si == NULL ) )
-		{
-			continue;
-		}
+		// The window thread collects every item so that each one isn't a separate round trip to it.
+		item_count = ( int )SendMessage( g_hWnd_main, WM_GET_ENTRIES, ( WPARAM )item_count, ( LPARAM )entries );
 
-		// Skip entries that we've already verified, but count bad checksums.
-		if ( fi->flag >= FIF_VERIFIED_HEADER )
-		{
-			if ( fi->flag & FIF_BAD_HEADER )
-			{
-				++bad_header;
-			}
+		unsigned int entry_count = 0;
 
-			if ( fi->flag & FIF_BAD_DATA )
-			{
-				++bad_data;
-			}
-
-			continue;
-		}
-
-		// Get the header size of the current entry.
-		header_size = ( fi->si->system == WINDOWS_7 ? sizeof( database_cache_entry_7 ) : ( fi->si->system == WINDOWS_VISTA ? sizeof( database_cache_entry_vista ) : sizeof( database_cache_entry_8 ) ) ) - sizeof( unsigned long long );
-
-		// Attempt to open a file for reading.
-		HANDLE hFile = CreateFile( fi->si->dbpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
-		if ( hFile != INVALID_HANDLE_VALUE )
+		// Go through each item to compare values.
+		for ( int i = 0; i < item_count; ++i )
 		{
-			fi->flag |= FIF_VERIFIED_HEADER;	// Entry has been verified
-
-			header_buffer = ( char * )malloc( sizeof( char ) * header_size );
-
-			DWORD read = 0;
-			// Set our file pointer to the beginning of the database file.
-			SetFilePointer( hFile, fi->header_offset, 0, FILE_BEGIN );
-			// Read the header into memory.
-			ReadFile( hFile, header_buffer, header_size, &read, NULL );
-
-			data_buffer = ( char * )malloc( sizeof( char ) * fi->size );
-			tmp_data = data_buffer;
-
-			// Set our file pointer to the beginning of the database file.
-			SetFilePointer( hFile, fi->data_offset, 0, FILE_BEGIN );
-			// Read the entire image into memory.
-			ReadFile( hFile, data_buffer, fi->size, &read, NULL );
-			CloseHandle( hFile );
-
-			// The header checksum uses an initial CRC of -1
-			fi->v_header_checksum = crc64( header_buffer, header_size, 0xFFFFFFFFFFFFFFFF );
-			if ( fi->v_header_checksum != fi->header_checksum )
+			FILE_INFO *fi = entries[ i ];
+			if ( fi == NULL || fi->si == NULL )
 			{
-				fi->flag |= FIF_BAD_HEADER;	// Header checksum is invalid.
-				++bad_header;
+				continue;
 			}
 
-			free( header_buffer );
-
-			// If the data is larger than 1024 bytes, then we're going to generate two CRCs and xor them together.
-			if ( read > 1024 )
+			// Skip entries that we've already verified, but count bad checksums.
+			if ( fi->flag >= FIF_VERIFIED_HEADER )
 			{
-				// The first checksum uses an initial CRC of 0. We read the first 1024 bytes.
-				unsigned long long first_crc = crc64( tmp_data, 1024, 0x0000000000000000 );
-				tmp_data += 1024;
-
-				// Break the remaining data into 400 byte chunks.
-				read -= 1024;
-				int chunks = read / 400;
-
-				// The second CRC also uses an initial CRC of 0.
-				unsigned long long second_crc = 0x0000000000000000;
-
-				// For each of these chunks, we hash the first 4 bytes.
-				for ( int i = 0; i < chunks; ++i )
+				if ( fi->flag & FIF_BAD_HEADER )
 				{
-					second_crc = crc64( tmp_data, 4, second_crc );
-					tmp_data += 400;	// Move to the next chunk.
+					++bad_header;
 				}
 
-				// See how many bytes we have left.
-				int remaining = read % 400;
-				if ( remaining > 0 )
+				if ( fi->flag & FIF_BAD_DATA )
 				{
-					// If we have more than 4 bytes left to hash, then set it to 4.
-					if ( remaining > 4 )
-					{
-						remaining = 4;
-					}
-					second_crc = crc64( tmp_data, remaining, second_crc );
+					++bad_data;
 				}
 
-				// xor the two CRCs to generate the final data checksum.
-				fi->v_data_checksum = ( first_crc ^ second_crc );
-			}
-			else	// Data is less than or equal to 1024 bytes
-			{
-				// The header checksum uses an initial CRC of 0
-				fi->v_data_checksum = crc64( tmp_data, read, 0x0000000000000000 );
+				continue;
 			}
 
-			if ( fi->v_data_checksum != fi->data_checksum )
-			{
-				fi->flag |= FIF_BAD_DATA;	// Data checksum is invalid.
-				++bad_data;
-			}
+			entries[ entry_count++ ] = fi;
+		}
 
-			free( data_buffer );
+		// Stop processing and exit the thread.
+		if ( !g_kill_thread )
+		{
+			verified = VerifyEntries( entries, entry_count, &bad_header, &bad_data );
 		}
+
+		free( entries );
 	}
 
-	if ( bad_header == 0 && bad_data == 0 )
+	if ( g_kill_thread )
+	{
+		// Nothing is reported if the program is closing.
+	}
+	else if ( !verified )
+	{
+		MessageBoxA( g_hWnd_main, "The checksums could not be verified.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONWARNING );
+	}
+	else if ( bad_header == 0 && bad_data == 0 )
 	{
 		MessageBoxA( g_hWnd_main, "All checksums are valid.", PROGRAM_CAPTION_A, MB_APPLMODAL | MB_ICONINFORMATION );
 	}
@@ -20,7 +20,7 @@
 #define UTILITIES_H
 
 #include "globals.h"
-#include "dllrbt.h"
+#include "hash_table.h"
 
 #define SNAP_WIDTH		10		// The minimum distance at which our windows will attach together.
 
@@ -33,6 +33,13 @@
 
 #define ntohll( i ) ( ( ( __int64 )ntohl( i & 0xFFFFFFFFU ) << 32 ) | ntohl( ( __int64 )( i >> 32 ) ) )
 
+// A filename that's referenced by duplicate entries. FILE_INFO's filename points to filename.
+struct SHARED_FILENAME
+{
+	unsigned long count;				// Number of entries that reference the filename.
+	wchar_t filename[ 1 ];
+};
+
 unsigned __stdcall cleanup( void *pArguments );
 unsigned __stdcall remove_items( void *pArguments );
 unsigned __stdcall show_hide_items( void *pArguments );
@@ -47,10 +54,14 @@ wchar_t *GetFileAttributesStr( unsigned long fa_flags );
 wchar_t *GetSFGAOStr( unsigned long sfgao_flags );
 
 void CleanupBlankEntries();
-void CreateFileinfoTree();
-void CleanupFileinfoTree();
+void CreateFileinfoTable();
+void CleanupFileinfoTable();
 void CleanupExtendedInfo( EXTENDED_INFO *ei );
 
+wchar_t *CreateSharedFilename( const wchar_t *filename );
+void SetSharedFilename( FILE_INFO *fi, wchar_t *shared_filename );
+void FreeFilename( FILE_INFO *fi );
+
 void Processing_Window( bool enable );
 
 BOOL CALLBACK EnumChildProc( HWND hWnd, LPARAM lParam );
@@ -58,7 +69,8 @@ HFONT UpdateFontsAndMetrics( UINT current_dpi_update, /*UINT last_dpi_update,*/
 
 extern HANDLE g_shutdown_semaphore;		// Blocks shutdown while a worker thread is active.
 extern LINKED_LIST *g_be;				// A list to hold all of the blank entries.
-extern dllrbt_tree *g_file_info_tree;	// Red-black tree of FILE_INFO structures.
+extern hash_table *g_file_info_table;	// Maps each hash to the first node of its list in g_file_info_list.
+extern LINKED_LIST *g_file_info_list;	// Nodes of FILE_INFO structures that share a hash.
 
 extern FILE_INFO *g_current_fi;			// If we removed an entry and the info window is showing, then close the info window.
 
@@ -0,0 +1,251 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "verify_entries.h"
+#include "read_thumbcache.h"
+#include "entry_checksums.h"
+
+// Orders the entries by database and then by offset so that each database is read from beginning to end.
+int compare_entries( const void *a, const void *b )
+{
+	FILE_INFO *fi1 = *( FILE_INFO ** )a;
+	FILE_INFO *fi2 = *( FILE_INFO ** )b;
+
+	if ( fi1->si != fi2->si )
+	{
+		return ( fi1->si < fi2->si ? -1 : 1 );
+	}
+
+	return ( fi1->header_offset < fi2->header_offset ? -1 : ( fi1->header_offset > fi2->header_offset ? 1 : 0 ) );
+}
+
+// Claims and verifies batches of entries until none are left.
+void VerifyBatches( VERIFY_INFO *vi )
+{
+	// Reused for every entry.
+	unsigned char *buffer = NULL;
+	unsigned int buffer_size = 0;
+
+	LONG bad_header = 0;
+	LONG bad_data = 0;
+
+	HANDLE hEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+	for ( ;; )
+	{
+		unsigned int index = ( unsigned int )( InterlockedIncrement( &vi->next_batch ) - 1 );
+		if ( index >= vi->batch_count || hEvent == NULL )
+		{
+			break;
+		}
+
+		VERIFY_BATCH *vb = &vi->batches[ index ];
+
+		for ( unsigned int i = vb->first; i < vb->last; ++i )
+		{
+			// Stop processing and exit the thread.
+			if ( g_kill_thread )
+			{
+				break;
+			}
+
+			FILE_INFO *fi = vi->entries[ i ];
+
+			// The header, identifier string, and data are read at once. The data beyond the first 1024 bytes is only sampled every 400 bytes,
+			// but that still touches every page of it, so one read is cheaper than a read for each sample.
+			unsigned int data_start = fi->data_offset - fi->header_offset;
+			unsigned int length = data_start + fi->size;
+
+			if ( length > buffer_size )
+			{
+				unsigned char *realloc_buffer = ( unsigned char * )realloc( buffer, sizeof( unsigned char ) * length );
+				if ( realloc_buffer == NULL )
+				{
+					continue;
+				}
+
+				buffer = realloc_buffer;
+				buffer_size = length;
+			}
+
+			OVERLAPPED ol = { 0 };
+			ol.Offset = fi->header_offset;
+			ol.hEvent = hEvent;
+
+			// A read that begins beyond the end of the database fails, and we'll checksum nothing just as if it had read nothing.
+			DWORD read = 0;
+			if ( ReadFile( vb->vd->hFile, buffer, length, NULL, &ol ) != FALSE || GetLastError() == ERROR_IO_PENDING )
+			{
+				if ( GetOverlappedResult( vb->vd->hFile, &ol, &read, TRUE ) == FALSE )
+				{
+					read = 0;
+				}
+			}
+
+			fi->flag |= FIF_VERIFIED_HEADER;	// Entry has been verified
+
+			ENTRY_CHECKSUMS verified;
+			unsigned char result = VerifyEntryChecksums( buffer, read, vb->vd->header_size, data_start, fi->header_checksum, fi->data_checksum, &verified );
+
+			fi->v_header_checksum = verified.header_checksum;
+			fi->v_data_checksum = verified.data_checksum;
+
+			if ( result & ENTRY_BAD_HEADER )
+			{
+				fi->flag |= FIF_BAD_HEADER;	// Header checksum is invalid.
+				++bad_header;
+			}
+
+			if ( result & ENTRY_BAD_DATA )
+			{
+				fi->flag |= FIF_BAD_DATA;	// Data checksum is invalid.
+				++bad_data;
+			}
+		}
+	}
+
+	InterlockedExchangeAdd( &vi->bad_header, bad_header );
+	InterlockedExchangeAdd( &vi->bad_data, bad_data );
+
+	if ( hEvent != NULL )
+	{
+		CloseHandle( hEvent );
+	}
+
+	free( buffer );
+}
+
+unsigned __stdcall verify_batches( void *pArguments )
+{
+	VerifyBatches( ( VERIFY_INFO * )pArguments );
+
+	_endthreadex( 0 );
+	return 0;
+}
+
+// Verifies the header and data checksum of each entry and flags the ones that don't match. The entries are sorted.
+// Each database is opened once and its entries are split into batches that a worker on each processor claims.
+// Entries in a database that can't be opened are left unverified. Returns false if the batches couldn't be allocated.
+bool VerifyEntries( FILE_INFO **entries, unsigned int entry_count, unsigned int *bad_header, unsigned int *bad_data )
+{
+	if ( entry_count == 0 )
+	{
+		return true;
+	}
+
+	qsort( entries, entry_count, sizeof( FILE_INFO * ), compare_entries );
+
+	// Count the databases and the batches they're split into.
+	unsigned int database_count = 0;
+	unsigned int batch_count = 0;
+	for ( unsigned int first = 0, last = 0; first < entry_count; first = last )
+	{
+		for ( last = first + 1; last < entry_count && entries[ last ]->si == entries[ first ]->si; ++last );
+
+		++database_count;
+		batch_count += ( last - first + VERIFY_BATCH_SIZE - 1 ) / VERIFY_BATCH_SIZE;
+	}
+
+	VERIFY_DATABASE *databases = ( VERIFY_DATABASE * )malloc( sizeof( VERIFY_DATABASE ) * database_count );
+	VERIFY_BATCH *batches = ( VERIFY_BATCH * )malloc( sizeof( VERIFY_BATCH ) * batch_count );
+	if ( databases == NULL || batches == NULL )
+	{
+		free( batches );
+		free( databases );
+
+		return false;
+	}
+
+	VERIFY_INFO vi;
+	memset( &vi, 0, sizeof( VERIFY_INFO ) );
+	vi.entries = entries;
+	vi.batches = batches;
+
+	database_count = 0;
+	for ( unsigned int first = 0, last = 0; first < entry_count; first = last )
+	{
+		SHARED_INFO *si = entries[ first ]->si;
+
+		for ( last = first + 1; last < entry_count && entries[ last ]->si == si; ++last );
+
+		VERIFY_DATABASE *vd = &databases[ database_count++ ];
+
+		// The header checksum covers everything before it.
+		vd->header_size = ( si->system == WINDOWS_7 ? sizeof( database_cache_entry_7 ) : ( si->system == WINDOWS_VISTA ? sizeof( database_cache_entry_vista ) : sizeof( database_cache_entry_8 ) ) ) - sizeof( unsigned long long );
+
+		vd->hFile = CreateFile( si->dbpath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL );
+		if ( vd->hFile == INVALID_HANDLE_VALUE )
+		{
+			continue;
+		}
+
+		for ( unsigned int i = first; i < last; i += VERIFY_BATCH_SIZE )
+		{
+			VERIFY_BATCH *vb = &batches[ vi.batch_count++ ];
+			vb->vd = vd;
+			vb->first = i;
+			vb->last = min( i + VERIFY_BATCH_SIZE, last );
+		}
+	}
+
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo( &sysinfo );
+
+	// We're one of the workers.
+	unsigned int thread_count = min( sysinfo.dwNumberOfProcessors, MAXIMUM_WAIT_OBJECTS );
+	thread_count = ( thread_count > 0 ? min( thread_count - 1, vi.batch_count ) : 0 );
+
+	HANDLE threads[ MAXIMUM_WAIT_OBJECTS ];
+	unsigned int threads_started = 0;
+	for ( ; threads_started < thread_count; ++threads_started )
+	{
+		threads[ threads_started ] = ( HANDLE )_beginthreadex( NULL, 0, &verify_batches, ( void * )&vi, 0, NULL );
+		if ( threads[ threads_started ] == NULL )
+		{
+			break;
+		}
+	}
+
+	VerifyBatches( &vi );
+
+	if ( threads_started > 0 )
+	{
+		WaitForMultipleObjects( threads_started, threads, TRUE, INFINITE );
+
+		for ( unsigned int i = 0; i < threads_started; ++i )
+		{
+			CloseHandle( threads[ i ] );
+		}
+	}
+
+	for ( unsigned int i = 0; i < database_count; ++i )
+	{
+		if ( databases[ i ].hFile != INVALID_HANDLE_VALUE )
+		{
+			CloseHandle( databases[ i ].hFile );
+		}
+	}
+
+	free( batches );
+	free( databases );
+
+	*bad_header += vi.bad_header;
+	*bad_data += vi.bad_data;
+
+	return true;
+}
@@ -0,0 +1,55 @@
+/*
+	thumbcache_viewer will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VERIFY_ENTRIES_H
+#define VERIFY_ENTRIES_H
+
+#include "globals.h"
+
+// Number of entries that a worker claims at a time.
+#define VERIFY_BATCH_SIZE	64
+
+// A database whose entries are being verified. It's opened once for overlapped reads so that every worker can read from it at the same time.
+struct VERIFY_DATABASE
+{
+	HANDLE hFile;
+	unsigned int header_size;	// Number of header bytes that the header checksum covers.
+};
+
+// A range of entries that all belong to the same database.
+struct VERIFY_BATCH
+{
+	VERIFY_DATABASE *vd;
+	unsigned int first;
+	unsigned int last;
+};
+
+// Shared between the workers that verify the entries.
+struct VERIFY_INFO
+{
+	FILE_INFO **entries;		// Sorted by database and then by offset.
+	VERIFY_BATCH *batches;
+	unsigned int batch_count;
+	volatile LONG next_batch;	// The next batch to be claimed by a worker.
+	volatile LONG bad_header;
+	volatile LONG bad_data;
+};
+
+bool VerifyEntries( FILE_INFO **entries, unsigned int entry_count, unsigned int *bad_header, unsigned int *bad_data );
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "globals.h"
 #include "utilities.h"
+#include "map_entries.h"
 #include "menus.h"
 
 #include "lite_user32.h"
@@ -631,7 +632,8 @@ LRESULT CALLBACK InfoWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 					lvi.mask = LVIF_PARAM;
 					lvi.iSubItem = 0;
 
-					EXTENDED_INFO *t_ei = fi->ei;
+					// The values are converted now that they're being viewed.
+					EXTENDED_INFO *t_ei = GetExtendedInfo( fi );
 					while ( t_ei != NULL )
 					{
 						lvi.iItem = ( int )SendMessage( g_hWnd_list_info, LVM_GETITEMCOUNT, 0, 0 );
@@ -45,6 +45,7 @@ RECT last_pos = { 0 };				// The last position of the image window.
 RECT current_edit_pos = { 0 };		// Current position of the listview edit control.
 
 bool hide_blank_entries = false;	// Toggled from the main menu. Hides the blank (0 byte) entries.
+bool use_index_files = false;		// Toggled from the main menu. Loads and saves the .tcidx index of each database.
 
 bool is_kbytes_c_offset = true;		// Toggle the cache entry offset text.
 bool is_kbytes_c_size = true;		// Toggle the cache entry size text.
@@ -503,6 +504,30 @@ LRESULT CALLBACK MainWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 		}
 		break;
 
+		case WM_GET_ENTRIES:
+		{
+			// wParam is the number of entries that lParam can hold. Returns the number that were collected.
+			FILE_INFO **entries = ( FILE_INFO ** )lParam;
+
+			LVITEM lvi = { NULL };
+			lvi.mask = LVIF_PARAM;
+
+			int item_count = ( int )SendMessage( g_hWnd_list, LVM_GETITEMCOUNT, 0, 0 );
+			if ( item_count > ( int )wParam )
+			{
+				item_count = ( int )wParam;
+			}
+
+			for ( lvi.iItem = 0; lvi.iItem < item_count; ++lvi.iItem )
+			{
+				SendMessage( g_hWnd_list, LVM_GETITEM, 0, ( LPARAM )&lvi );
+				entries[ lvi.iItem ] = ( FILE_INFO * )lvi.lParam;
+			}
+
+			return item_count;
+		}
+		break;
+
 		case WM_SETCURSOR:
 		{
 			if ( wait_cursor != NULL )
@@ -665,6 +690,15 @@ LRESULT CALLBACK MainWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 					}
 					break;
 
+					case MENU_USE_INDEX:
+					{
+						use_index_files = !use_index_files;
+
+						// Put a check next to the menu item if we choose to use index files. Remove it if we don't.
+						CheckMenuItem( g_hMenu, MENU_USE_INDEX, ( use_index_files ? MF_CHECKED : MF_UNCHECKED ) );
+					}
+					break;
+
 					case MENU_CHECKSUMS:
 					{
 						// Go through each item in the list and verify the header and data checksums.
@@ -1198,8 +1232,8 @@ LRESULT CALLBACK MainWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 						return FALSE;
 					}
 
-					// Free the old filename.
-					free( current_file_info->filename );
+					// Free the old filename. Its duplicates keep the shared filename.
+					FreeFilename( current_file_info );
 					// Create a new filename based on the editbox's text.
 					wchar_t *filename = ( wchar_t * )malloc( sizeof( wchar_t ) * ( length + 1 ) );
 					wmemset( filename, 0, length + 1 );
@@ -1493,7 +1527,7 @@ LRESULT CALLBACK MainWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 
 						// Show red text if our checksums don't match, green text for entries with extended info, and black text for everything else.
 						COLORREF text_color = RGB( 0x00, 0x00, 0x00 );
-						if ( i == 1 && fi->ei != NULL )
+						if ( i == 1 && fi->row_reference != 0 )
 						{
 							text_color = RGB( 0x00, 0x80, 0x00 );
 						}
@@ -1582,10 +1616,8 @@ LRESULT CALLBACK MainWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 						}
 					}
 
-					CleanupExtendedInfo( fi->ei );
-
 					// First free the filename pointer.
-					free( fi->filename );
+					FreeFilename( fi );
 					// Then free the FILE_INFO structure.
 					free( fi );
 				}
@@ -36,6 +36,7 @@ HWND g_hWnd_extensions[ 2 ] = { NULL };
 HWND g_hWnd_chk_folders[ 2 ] = { NULL };
 HWND g_hWnd_hashing[ 2 ] = { NULL };
 HWND g_hWnd_extended_information = NULL;
+HWND g_hWnd_listed_write_times = NULL;
 HWND g_hWnd_btn_scan = NULL;
 HWND g_hWnd_btn_cancel = NULL;
 HWND g_hWnd_load = NULL;
@@ -66,10 +67,10 @@ LRESULT CALLBACK ScanTabWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 			wchar_t current_directory[ MAX_PATH ] = { 0 };
 			GetCurrentDirectory( MAX_PATH, current_directory );
 
-			g_hWnd_static1 = CreateWindowA( WC_STATICA, "Initial scan directory:", WS_CHILD | WS_VISIBLE, 0, 0, rc.right, _SCALE_( 15, dpi_scan ), hWnd, NULL, NULL, NULL );
-			g_hWnd_path[ 0 ] = CreateWindowEx( WS_EX_CLIENTEDGE, WC_EDIT, current_directory, ES_AUTOHSCROLL | ES_READONLY | WS_CHILD | WS_VISIBLE, 0, 0, 0, 0, hWnd, ( HMENU )EDIT_PATH, NULL, NULL );
+			g_hWnd_static1 = CreateWindowA( WC_STATICA, "Initial scan directories (separated by |):", WS_CHILD | WS_VISIBLE, 0, 0, rc.right, _SCALE_( 15, dpi_scan ), hWnd, NULL, NULL, NULL );
+			g_hWnd_path[ 0 ] = CreateWindowEx( WS_EX_CLIENTEDGE, WC_EDIT, current_directory, ES_AUTOHSCROLL | WS_CHILD | WS_VISIBLE, 0, 0, 0, 0, hWnd, ( HMENU )EDIT_PATH, NULL, NULL );
 			g_hWnd_path[ 1 ] = CreateWindowEx( WS_EX_CLIENTEDGE, WC_EDIT, NULL, ES_AUTOHSCROLL | ES_READONLY | WS_CHILD, 0, 0, 0, 0, hWnd, ( HMENU )EDIT_PATH, NULL, NULL );
-			SendMessage( g_hWnd_path[ 0 ], EM_LIMITTEXT, MAX_PATH - 1, 0 );
+			SendMessage( g_hWnd_path[ 0 ], EM_LIMITTEXT, SCAN_PATHS_LENGTH - 1, 0 );
 			SendMessage( g_hWnd_path[ 1 ], EM_LIMITTEXT, MAX_PATH - 1, 0 );
 
 			g_hWnd_load = CreateWindowA( WC_BUTTONA, "...", WS_CHILD | WS_TABSTOP | WS_VISIBLE, 0, 0, 0, 0, hWnd, ( HMENU )BTN_LOAD, NULL, NULL );
@@ -83,6 +84,8 @@ LRESULT CALLBACK ScanTabWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 			g_hWnd_chk_folders[ 0 ] = CreateWindowA( WC_BUTTONA, "Include Folders", BS_AUTOCHECKBOX | WS_CHILD | WS_TABSTOP | WS_VISIBLE, 0, 0, 0, 0, hWnd, NULL, NULL, NULL );
 			g_hWnd_chk_folders[ 1 ] = CreateWindowA( WC_BUTTONA, "Include Folders", BS_AUTOCHECKBOX | WS_CHILD | WS_TABSTOP, 0, 0, 0, 0, hWnd, NULL, NULL, NULL );
 
+			g_hWnd_listed_write_times = CreateWindowA( WC_BUTTONA, "Use Listed Write Times", BS_AUTOCHECKBOX | WS_CHILD | WS_TABSTOP | WS_VISIBLE, 0, 0, 0, 0, hWnd, NULL, NULL, NULL );
+
 			g_hWnd_extended_information = CreateWindowA( WC_BUTTONA, "Retrieve Extended Information", BS_AUTOCHECKBOX | WS_CHILD | WS_TABSTOP, 0, 0, 0, 0, hWnd, NULL, NULL, NULL );
 
 			g_hWnd_static3 = CreateWindowA( WC_STATICA, "Current file/folder:", WS_CHILD, 0, _SCALE_( 96, dpi_scan ), rc.right, _SCALE_( 15, dpi_scan ), hWnd, NULL, NULL, NULL );
@@ -110,6 +113,7 @@ LRESULT CALLBACK ScanTabWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 			SendMessage( g_hWnd_extensions[ 1 ], WM_SETFONT, ( WPARAM )hFont_scan, 0 );
 			SendMessage( g_hWnd_chk_folders[ 0 ], WM_SETFONT, ( WPARAM )hFont_scan, 0 );
 			SendMessage( g_hWnd_chk_folders[ 1 ], WM_SETFONT, ( WPARAM )hFont_scan, 0 );
+			SendMessage( g_hWnd_listed_write_times, WM_SETFONT, ( WPARAM )hFont_scan, 0 );
 			SendMessage( g_hWnd_extended_information, WM_SETFONT, ( WPARAM )hFont_scan, 0 );
 			SendMessage( g_hWnd_hashing[ 0 ], WM_SETFONT, ( WPARAM )hFont_scan, 0 );
 			SendMessage( g_hWnd_hashing[ 1 ], WM_SETFONT, ( WPARAM )hFont_scan, 0 );
@@ -199,7 +203,7 @@ LRESULT CALLBACK ScanTabWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 			GetClientRect( hWnd, &rc );
 
 			// Allow our controls to move in relation to the parent window.
-			HDWP hdwp = BeginDeferWindowPos( 15 );
+			HDWP hdwp = BeginDeferWindowPos( 16 );
 			DeferWindowPos( hdwp, g_hWnd_static1, HWND_TOP, 0, 0, rc.right, _SCALE_( 15, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_static2, HWND_TOP, 0, _SCALE_( 48, dpi_scan ), rc.right, _SCALE_( 15, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_static3, HWND_TOP, 0, _SCALE_( 96, dpi_scan ), rc.right, _SCALE_( 15, dpi_scan ), SWP_NOZORDER );
@@ -210,9 +214,10 @@ LRESULT CALLBACK ScanTabWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lPar
 			DeferWindowPos( hdwp, g_hWnd_path[ 0 ], HWND_TOP, 0, _SCALE_( 18, dpi_scan ), rc.right - _SCALE_( 35, dpi_scan ), _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_load, HWND_TOP, rc.right - _SCALE_( 30, dpi_scan ), _SCALE_( 18, dpi_scan ), _SCALE_( 30, dpi_scan ), _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_extensions[ 1 ], HWND_TOP, 0, _SCALE_( 66, dpi_scan ), rc.right - _SCALE_( 295, dpi_scan ), _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
-			DeferWindowPos( hdwp, g_hWnd_extensions[ 0 ], HWND_TOP, 0, _SCALE_( 66, dpi_scan ), rc.right - _SCALE_( 105, dpi_scan ), _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
+			DeferWindowPos( hdwp, g_hWnd_extensions[ 0 ], HWND_TOP, 0, _SCALE_( 66, dpi_scan ), rc.right - _SCALE_( 295, dpi_scan ), _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_chk_folders[ 1 ], HWND_TOP, rc.right - _SCALE_( 290, dpi_scan ), _SCALE_( 68, dpi_scan ), _SCALE_( 100, dpi_scan ), _SCALE_( 20, dpi_scan ), SWP_NOZORDER );
-			DeferWindowPos( hdwp, g_hWnd_chk_folders[ 0 ], HWND_TOP, rc.right - _SCALE_( 100, dpi_scan ), _SCALE_( 68, dpi_scan ), _SCALE_( 100, dpi_scan ), _SCALE_( 20, dpi_scan ), SWP_NOZORDER );
+			DeferWindowPos( hdwp, g_hWnd_chk_folders[ 0 ], HWND_TOP, rc.right - _SCALE_( 290, dpi_scan ), _SCALE_( 68, dpi_scan ), _SCALE_( 100, dpi_scan ), _SCALE_( 20, dpi_scan ), SWP_NOZORDER );
+			DeferWindowPos( hdwp, g_hWnd_listed_write_times, HWND_TOP, rc.right - _SCALE_( 180, dpi_scan ), _SCALE_( 68, dpi_scan ), _SCALE_( 180, dpi_scan ), _SCALE_( 20, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_extended_information, HWND_TOP, rc.right - _SCALE_( 180, dpi_scan ), _SCALE_( 68, dpi_scan ), _SCALE_( 180, dpi_scan ), _SCALE_( 20, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_hashing[ 1 ], HWND_TOP, 0, _SCALE_( 114, dpi_scan ), rc.right, _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
 			DeferWindowPos( hdwp, g_hWnd_hashing[ 0 ], HWND_TOP, 0, _SCALE_( 114, dpi_scan ), rc.right, _SCALE_( 23, dpi_scan ), SWP_NOZORDER );
@@ -322,7 +327,8 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 						break;
 					}
 
-					int length = ( int )SendMessage( g_hWnd_path[ tab_index ], WM_GETTEXT, MAX_PATH, ( LPARAM )g_filepath );
+					// The directories are separated by "|". Only the first one is checked here.
+					int length = ( int )SendMessage( g_hWnd_path[ tab_index ], WM_GETTEXT, ( tab_index == 0 ? SCAN_PATHS_LENGTH : MAX_PATH ), ( LPARAM )g_filepath );
 					if ( length >= 3 )
 					{
 						// We need to have at least the drive path. Example: "C:\"
@@ -350,6 +356,8 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 
 							g_include_folders = SendMessage( g_hWnd_chk_folders[ tab_index ], BM_GETCHECK, 0, 0 ) ? true : false;
 
+							g_use_listed_write_times = SendMessage( g_hWnd_listed_write_times, BM_GETCHECK, 0, 0 ) ? true : false;
+
 							g_retrieve_extended_information = SendMessage( g_hWnd_extended_information, BM_GETCHECK, 0, 0 ) ? true : false;
 
 							scan_type = tab_index;	// scan_type will allow the correct windows to update regardless of the selected tab.
@@ -431,7 +439,11 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 						ShowWindow( g_hWnd_static_hash[ index ], SW_HIDE );
 						ShowWindow( g_hWnd_static_count[ index ], SW_HIDE );
 
-						if ( index == 1 )
+						if ( index == 0 )
+						{
+							ShowWindow( g_hWnd_listed_write_times, SW_HIDE );
+						}
+						else if ( index == 1 )
 						{
 							ShowWindow( g_hWnd_extended_information, SW_HIDE );
 						}
@@ -448,7 +460,7 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 					int index = ( int )SendMessage( nmhdr->hwndFrom, TCM_GETCURSEL, 0, 0 );		// Get the selected tab
 					if ( index == 0 || index == 1 )
 					{
-						SendMessageA( g_hWnd_static1, WM_SETTEXT, 0, ( LPARAM )( index == 0 ? "Initial scan directory:" : "Windows Search database file:" ) );
+						SendMessageA( g_hWnd_static1, WM_SETTEXT, 0, ( LPARAM )( index == 0 ? "Initial scan directories (separated by |):" : "Windows Search database file:" ) );
 
 						ShowWindow( g_hWnd_path[ index ], SW_SHOW );
 						ShowWindow( g_hWnd_extensions[ index ], SW_SHOW );
@@ -461,7 +473,11 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 							ShowWindow( g_hWnd_static_count[ index ], SW_SHOW );
 						}
 
-						if ( index == 1 )
+						if ( index == 0 )
+						{
+							ShowWindow( g_hWnd_listed_write_times, SW_SHOW );
+						}
+						else if ( index == 1 )
 						{
 							ShowWindow( g_hWnd_extended_information, SW_SHOW );
 						}
@@ -590,6 +606,7 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 				EnableWindow( g_hWnd_extensions[ 1 ], FALSE );
 				EnableWindow( g_hWnd_chk_folders[ 0 ], FALSE );
 				EnableWindow( g_hWnd_chk_folders[ 1 ], FALSE );
+				EnableWindow( g_hWnd_listed_write_times, FALSE );
 				EnableWindow( g_hWnd_extended_information, FALSE );
 
 				// We're scanning. Set the button's text to "Stop".
@@ -613,6 +630,7 @@ LRESULT CALLBACK ScanWndProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam
 				EnableWindow( g_hWnd_extensions[ 1 ], TRUE );
 				EnableWindow( g_hWnd_chk_folders[ 0 ], TRUE );
 				EnableWindow( g_hWnd_chk_folders[ 1 ], TRUE );
+				EnableWindow( g_hWnd_listed_write_times, TRUE );
 				EnableWindow( g_hWnd_extended_information, TRUE );
 
 				// We've stopped/finished scanning. Set the button's text to "Scan".
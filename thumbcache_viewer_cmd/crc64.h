@@ -0,0 +1,28 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRC64_H
+#define CRC64_H
+
+// Uses the fastest kernel that the processor supports. They all produce the same CRC.
+unsigned long long crc64( char *buf, unsigned int length, unsigned long long init_crc );
+
+// The data checksum that's stored in a cache entry.
+unsigned long long GetDataChecksum( const unsigned char *data, unsigned int data_size );
+
+#endif
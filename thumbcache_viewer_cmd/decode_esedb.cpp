@@ -0,0 +1,595 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Decodes the pages, records, and compressed values of an ESE database from memory.
+// Nothing here reads the database or depends on Windows, so that it can be tested on its own with a page image.
+
+#include "decode_esedb.h"
+
+// Sets the layout of a database's pages. Returns false if the page size isn't one that ESE uses.
+bool SetESEFormat( ESE_FORMAT *format, unsigned long revision, unsigned long page_size )
+{
+	if ( page_size != 2048 && page_size != 4096 && page_size != 8192 && page_size != 16384 && page_size != 32768 )
+	{
+		return false;
+	}
+
+	format->page_size = page_size;
+	format->large_pages = ( revision >= 0x11 && page_size >= 16384 );
+	format->page_header_size = ( format->large_pages ? 80 : 40 );
+
+	return true;
+}
+
+// Reads the header of a page. data holds the page_size bytes of the page.
+bool ParsePage( const ESE_FORMAT *format, unsigned char *data, unsigned int page_number, ESE_PAGE *page )
+{
+	unsigned short tag_count = GetUShort( data + ESE_PAGE_TAG_COUNT );
+
+	// The tags are stored at the end of the page and can't overlap its header.
+	if ( ( unsigned int )tag_count * 4 > format->page_size - format->page_header_size )
+	{
+		return false;
+	}
+
+	page->format = format;
+	page->data = data;
+	page->page_number = page_number;
+	page->next_page = GetUInt( data + ESE_PAGE_NEXT_PAGE );
+	page->objid = GetUInt( data + ESE_PAGE_OBJID );
+	page->flags = GetUInt( data + ESE_PAGE_FLAGS );
+	page->tag_count = tag_count;
+
+	return true;
+}
+
+// The tags are stored in reverse order at the end of the page. Each has the size and offset of its value.
+bool GetPageValue( ESE_PAGE *page, unsigned short tag, unsigned char **value, unsigned int *value_length, unsigned char *flags )
+{
+	if ( tag >= page->tag_count )
+	{
+		return false;
+	}
+
+	unsigned char *tag_data = page->data + page->format->page_size - ( ( tag + 1 ) * 4 );
+	unsigned int size = GetUShort( tag_data );
+	unsigned int offset = GetUShort( tag_data + 2 );
+
+	if ( page->format->large_pages )
+	{
+		size &= 0x7FFF;
+		offset &= 0x7FFF;
+	}
+	else
+	{
+		*flags = ( unsigned char )( offset >> 13 );
+		size &= 0x1FFF;
+		offset &= 0x1FFF;
+	}
+
+	if ( offset + size > page->format->page_size - page->format->page_header_size )
+	{
+		return false;
+	}
+
+	*value = page->data + page->format->page_header_size + offset;
+	*value_length = size;
+
+	// Large pages store the flags in the upper 3 bits of the value's first 2 bytes.
+	if ( page->format->large_pages )
+	{
+		*flags = ( size >= 2 ? ( *value )[ 1 ] >> 5 : 0 );
+	}
+
+	return true;
+}
+
+// Splits a node into its key and data. The first tag of a page is its header, not a node.
+bool GetPageNode( ESE_PAGE *page, unsigned short tag, ESE_NODE *node )
+{
+	unsigned char *value = NULL;
+	unsigned int value_length = 0;
+	unsigned char flags = 0;
+
+	if ( tag == 0 || !GetPageValue( page, tag, &value, &value_length, &flags ) )
+	{
+		return false;
+	}
+
+	unsigned int offset = 0;
+
+	node->flags = flags;
+	node->prefix = NULL;
+	node->prefix_length = 0;
+
+	// The key sizes are masked since large pages store the flags in the first one.
+	if ( flags & ESE_TAG_FLAG_COMMON_KEY )
+	{
+		if ( value_length < 2 )
+		{
+			return false;
+		}
+
+		node->prefix_length = GetUShort( value ) & 0x1FFF;
+		offset = 2;
+	}
+
+	if ( value_length < offset + 2 )
+	{
+		return false;
+	}
+
+	node->key_length = GetUShort( value + offset ) & 0x1FFF;
+	offset += 2;
+
+	if ( node->key_length > value_length - offset )
+	{
+		return false;
+	}
+
+	node->key = value + offset;
+	node->data = value + offset + node->key_length;
+	node->data_length = value_length - offset - node->key_length;
+
+	// The common key prefix is the page's header.
+	if ( node->prefix_length > 0 )
+	{
+		unsigned char *prefix = NULL;
+		unsigned int prefix_length = 0;
+		unsigned char prefix_flags = 0;
+
+		if ( !GetPageValue( page, 0, &prefix, &prefix_length, &prefix_flags ) || node->prefix_length > prefix_length )
+		{
+			return false;
+		}
+
+		node->prefix = prefix;
+	}
+
+	return true;
+}
+
+// Returns less than, equal to, or greater than 0 if the node's key is less than, equal to, or greater than key.
+int CompareNodeKey( ESE_NODE *node, const unsigned char *key, unsigned int key_length )
+{
+	unsigned int node_key_length = node->prefix_length + node->key_length;
+	unsigned int length = ( node_key_length < key_length ? node_key_length : key_length );
+
+	for ( unsigned int i = 0; i < length; ++i )
+	{
+		unsigned char c = GetNodeKeyByte( node, i );
+		if ( c != key[ i ] )
+		{
+			return ( c < key[ i ] ? -1 : 1 );
+		}
+	}
+
+	return ( node_key_length < key_length ? -1 : ( node_key_length > key_length ? 1 : 0 ) );
+}
+
+// Plain LZ77 (MS-XCA 2.3/2.4). Returns false unless the data decompresses to exactly output_length bytes.
+bool DecompressXpress( const unsigned char *input, unsigned int input_length, unsigned char *output, unsigned int output_length )
+{
+	unsigned int input_position = 0;
+	unsigned int output_position = 0;
+
+	unsigned int flags = 0;
+	unsigned int flag_count = 0;
+
+	unsigned int last_length_half_byte = 0;	// The flags are read first, so no half byte can be at 0.
+
+	while ( output_position < output_length )
+	{
+		if ( flag_count == 0 )
+		{
+			if ( input_length - input_position < sizeof( unsigned int ) )
+			{
+				return false;
+			}
+
+			flags = GetUInt( input + input_position );
+			input_position += sizeof( unsigned int );
+			flag_count = 32;
+		}
+
+		--flag_count;
+
+		if ( ( flags & ( 1U << flag_count ) ) == 0 )
+		{
+			// A literal.
+			if ( input_position >= input_length )
+			{
+				return false;
+			}
+
+			output[ output_position++ ] = input[ input_position++ ];
+		}
+		else
+		{
+			if ( input_length - input_position < sizeof( unsigned short ) )
+			{
+				return false;
+			}
+
+			unsigned int match = GetUShort( input + input_position );
+			input_position += sizeof( unsigned short );
+
+			unsigned int match_length = match & 0x07;
+			unsigned int match_offset = ( match >> 3 ) + 1;
+
+			// Longer lengths continue into a half byte that's shared with the next long match, then a byte, then 2 or 4 bytes.
+			if ( match_length == 7 )
+			{
+				if ( last_length_half_byte == 0 )
+				{
+					if ( input_position >= input_length )
+					{
+						return false;
+					}
+
+					match_length = input[ input_position ] & 0x0F;
+					last_length_half_byte = input_position++;
+				}
+				else
+				{
+					match_length = input[ last_length_half_byte ] >> 4;
+					last_length_half_byte = 0;
+				}
+
+				if ( match_length == 15 )
+				{
+					if ( input_position >= input_length )
+					{
+						return false;
+					}
+
+					match_length = input[ input_position++ ];
+
+					if ( match_length == 255 )
+					{
+						if ( input_length - input_position < sizeof( unsigned short ) )
+						{
+							return false;
+						}
+
+						match_length = GetUShort( input + input_position );
+						input_position += sizeof( unsigned short );
+
+						if ( match_length == 0 )
+						{
+							if ( input_length - input_position < sizeof( unsigned int ) )
+							{
+								return false;
+							}
+
+							match_length = GetUInt( input + input_position );
+							input_position += sizeof( unsigned int );
+						}
+
+						if ( match_length < 15 + 7 )
+						{
+							return false;
+						}
+
+						match_length -= ( 15 + 7 );
+					}
+
+					match_length += 15;
+				}
+
+				match_length += 7;
+			}
+
+			match_length += 3;
+
+			if ( match_offset > output_position || match_length > output_length - output_position )
+			{
+				return false;
+			}
+
+			// The match can overlap the bytes that it produces.
+			for ( ; match_length > 0; --match_length, ++output_position )
+			{
+				output[ output_position ] = output[ output_position - match_offset ];
+			}
+		}
+	}
+
+	return true;
+}
+
+// The upper 5 bits of the first byte are the compression scheme. Returns the length of the value once it's decompressed, or 0 if the scheme isn't supported.
+unsigned int GetDecompressedLength( const unsigned char *data, unsigned int data_length )
+{
+	if ( data_length < 2 )
+	{
+		return 0;
+	}
+
+	unsigned char scheme = data[ 0 ] >> 3;
+
+	if ( scheme == ESE_COMPRESSION_7BIT_ASCII || scheme == ESE_COMPRESSION_7BIT_UNICODE )
+	{
+		// The lower 3 bits of the first byte are the number of bits that are used in the last byte, minus 1.
+		unsigned int bit_count = ( ( data_length - 2 ) * 8 ) + ( data[ 0 ] & 0x07 ) + 1;
+
+		return ( bit_count / 7 ) * ( scheme == ESE_COMPRESSION_7BIT_UNICODE ? 2 : 1 );
+	}
+	else if ( scheme == ESE_COMPRESSION_XPRESS )
+	{
+		// The uncompressed size follows the first byte.
+		return ( data_length >= 3 ? GetUShort( data + 1 ) : 0 );
+	}
+
+	// Any other scheme isn't supported.
+	return 0;
+}
+
+// Decompresses a value into output. output_length must be the length that GetDecompressedLength() returns.
+bool DecompressData( const unsigned char *data, unsigned int data_length, unsigned char *output, unsigned int output_length )
+{
+	if ( output_length == 0 || GetDecompressedLength( data, data_length ) != output_length )
+	{
+		return false;
+	}
+
+	unsigned char scheme = data[ 0 ] >> 3;
+
+	if ( scheme == ESE_COMPRESSION_7BIT_ASCII || scheme == ESE_COMPRESSION_7BIT_UNICODE )
+	{
+		unsigned int char_size = ( scheme == ESE_COMPRESSION_7BIT_UNICODE ? 2 : 1 );
+		unsigned int char_count = output_length / char_size;
+
+		unsigned int bit_offset = 0;
+		for ( unsigned int i = 0; i < char_count; ++i, bit_offset += 7 )
+		{
+			// A character can span 2 bytes.
+			unsigned int byte_offset = 1 + ( bit_offset / 8 );
+			unsigned int bits = data[ byte_offset ];
+			if ( byte_offset + 1 < data_length )
+			{
+				bits |= ( data[ byte_offset + 1 ] << 8 );
+			}
+
+			unsigned char c = ( unsigned char )( ( bits >> ( bit_offset % 8 ) ) & 0x7F );
+
+			if ( char_size == 2 )
+			{
+				output[ i * 2 ] = c;
+				output[ ( i * 2 ) + 1 ] = 0;
+			}
+			else
+			{
+				output[ i ] = c;
+			}
+		}
+
+		return true;
+	}
+
+	return DecompressXpress( data + 3, data_length - 3, output, output_length );
+}
+
+// Sets output to the output_length bytes of a chunk of a compressed long value.
+// A chunk is only stored compressed if that makes it smaller, so one that's already output_length bytes is copied.
+bool ExpandLongValueChunk( const unsigned char *data, unsigned int data_length, unsigned char *output, unsigned int output_length )
+{
+	if ( data_length == output_length )
+	{
+		memcpy( output, data, data_length );
+		return true;
+	}
+
+	return DecompressData( data, data_length, output, output_length );
+}
+
+// Fixed columns are stored in the order of their ids.
+void SetFixedColumnOffsets( ESE_TABLE *table )
+{
+	unsigned short offset = 4;
+
+	for ( unsigned int i = 1; i <= ESE_MAX_FIXED_COLUMN; ++i )
+	{
+		table->fixed_offset[ i ] = offset;
+		offset += table->fixed_size[ i ];
+	}
+}
+
+// Sets value to the value of a column in a record. Returns false if the column is NULL or isn't in the record.
+// flags is set to the flags of a tagged column's value, or 0 for fixed and variable columns.
+bool GetRecordValue( const ESE_FORMAT *format, ESE_TABLE *table, unsigned char *record, unsigned int record_length, unsigned int column_id, unsigned char **value, unsigned int *value_length, unsigned char *flags )
+{
+	*flags = 0;
+
+	// The record begins with the last fixed and variable column ids that it holds and the offset of the variable column offsets.
+	if ( record_length < 4 )
+	{
+		return false;
+	}
+
+	unsigned int last_fixed = record[ 0 ];
+	unsigned int last_variable = record[ 1 ];
+	unsigned int variable_offset = GetUShort( record + 2 );
+	unsigned int variable_count = ( last_variable > ESE_MAX_FIXED_COLUMN ? last_variable - ESE_MAX_FIXED_COLUMN : 0 );
+	unsigned int variable_data = variable_offset + ( variable_count * 2 );
+
+	if ( variable_offset < 4 || variable_data > record_length )
+	{
+		return false;
+	}
+
+	if ( column_id <= ESE_MAX_FIXED_COLUMN )
+	{
+		if ( column_id == 0 || column_id > last_fixed || table->fixed_size[ column_id ] == 0 )
+		{
+			return false;
+		}
+
+		// A bitmap of the fixed columns that are NULL is between the fixed values and the variable column offsets.
+		unsigned int bitmap_size = ( last_fixed + 7 ) / 8;
+		if ( bitmap_size > variable_offset - 4 )
+		{
+			return false;
+		}
+
+		unsigned int bitmap_offset = variable_offset - bitmap_size;
+		if ( record[ bitmap_offset + ( ( column_id - 1 ) / 8 ) ] & ( 1 << ( ( column_id - 1 ) % 8 ) ) )
+		{
+			return false;
+		}
+
+		unsigned int offset = table->fixed_offset[ column_id ];
+		if ( offset + table->fixed_size[ column_id ] > bitmap_offset )
+		{
+			return false;
+		}
+
+		*value = record + offset;
+		*value_length = table->fixed_size[ column_id ];
+	}
+	else if ( column_id <= ESE_MAX_VARIABLE_COLUMN )
+	{
+		if ( column_id > last_variable )
+		{
+			return false;
+		}
+
+		// Each offset is the end of its value. The high bit is set if the value is NULL.
+		unsigned int index = column_id - ( ESE_MAX_FIXED_COLUMN + 1 );
+		unsigned int end = GetUShort( record + variable_offset + ( index * 2 ) );
+		if ( end & 0x8000 )
+		{
+			return false;
+		}
+
+		unsigned int start = ( index > 0 ? GetUShort( record + variable_offset + ( ( index - 1 ) * 2 ) ) & 0x7FFF : 0 );
+		if ( start > end || end > record_length - variable_data )
+		{
+			return false;
+		}
+
+		*value = record + variable_data + start;
+		*value_length = end - start;
+	}
+	else
+	{
+		// The tagged columns follow the variable values. They begin with an array of their ids and offsets that's sorted by id.
+		unsigned int tagged_offset = variable_data + ( variable_count > 0 ? GetUShort( record + variable_offset + ( ( variable_count - 1 ) * 2 ) ) & 0x7FFF : 0 );
+		if ( tagged_offset > record_length || record_length - tagged_offset < 4 )
+		{
+			return false;
+		}
+
+		unsigned char *tagged = record + tagged_offset;
+		unsigned int tagged_length = record_length - tagged_offset;
+		unsigned int offset_mask = ( format->large_pages ? 0x7FFF : 0x1FFF );
+
+		// The first value begins after the array.
+		unsigned int tag_count = ( GetUShort( tagged + 2 ) & offset_mask ) / 4;
+		if ( tag_count == 0 || tag_count > tagged_length / 4 )
+		{
+			return false;
+		}
+
+		unsigned int low = 0, high = tag_count;
+		while ( low < high )
+		{
+			unsigned int middle = ( low + high ) / 2;
+			if ( GetUShort( tagged + ( middle * 4 ) ) < column_id )
+			{
+				low = middle + 1;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+
+		if ( low >= tag_count || GetUShort( tagged + ( low * 4 ) ) != column_id )
+		{
+			return false;
+		}
+
+		unsigned int tag_offset = GetUShort( tagged + ( low * 4 ) + 2 );
+		unsigned int start = tag_offset & offset_mask;
+		unsigned int end = ( low + 1 < tag_count ? GetUShort( tagged + ( ( low + 1 ) * 4 ) + 2 ) & offset_mask : tagged_length );
+		if ( start > end || end > tagged_length )
+		{
+			return false;
+		}
+
+		*value = tagged + start;
+		*value_length = end - start;
+
+		// Small pages flag a NULL value, and a value that begins with a flags byte, in its offset. Values in large pages always begin with a flags byte.
+		bool has_flags = format->large_pages;
+		if ( !format->large_pages )
+		{
+			if ( tag_offset & 0x2000 )
+			{
+				return false;
+			}
+
+			has_flags = ( tag_offset & 0x4000 ? true : false );
+		}
+
+		if ( has_flags )
+		{
+			if ( *value_length == 0 )
+			{
+				return false;
+			}
+
+			*flags = **value;
+			++( *value );
+			--( *value_length );
+
+			if ( *flags & ESE_VALUE_FLAG_NULL )
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+unsigned int GetRecordUInt( const ESE_FORMAT *format, ESE_TABLE *table, unsigned char *record, unsigned int record_length, unsigned int column_id )
+{
+	unsigned char *value = NULL;
+	unsigned int value_length = 0;
+	unsigned char flags = 0;
+
+	if ( GetRecordValue( format, table, record, record_length, column_id, &value, &value_length, &flags ) )
+	{
+		if ( value_length == sizeof( unsigned int ) )
+		{
+			return GetUInt( value );
+		}
+		else if ( value_length == sizeof( unsigned short ) )
+		{
+			return GetUShort( value );
+		}
+		else if ( value_length == sizeof( unsigned char ) )
+		{
+			return value[ 0 ];
+		}
+	}
+
+	return 0;
+}
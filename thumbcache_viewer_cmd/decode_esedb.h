@@ -0,0 +1,138 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DECODE_ESEDB_H
+#define DECODE_ESEDB_H
+
+#include <string.h>
+
+// Page flags.
+#define ESE_PAGE_FLAG_ROOT			0x0001
+#define ESE_PAGE_FLAG_LEAF			0x0002
+#define ESE_PAGE_FLAG_PARENT		0x0004
+#define ESE_PAGE_FLAG_EMPTY			0x0008
+#define ESE_PAGE_FLAG_SPACE_TREE	0x0020
+#define ESE_PAGE_FLAG_INDEX			0x0040
+#define ESE_PAGE_FLAG_LONG_VALUE	0x0080
+
+// Page tag flags.
+#define ESE_TAG_FLAG_VERSION		0x01
+#define ESE_TAG_FLAG_DELETED		0x02
+#define ESE_TAG_FLAG_COMMON_KEY		0x04
+
+// Flags of a tagged column's value.
+#define ESE_VALUE_FLAG_LONG_VALUE	0x01
+#define ESE_VALUE_FLAG_COMPRESSED	0x02
+#define ESE_VALUE_FLAG_SEPARATED	0x04	// The value is a long value id. The data is stored in the table's long value tree.
+#define ESE_VALUE_FLAG_MULTI_VALUES	0x08
+#define ESE_VALUE_FLAG_TWO_VALUES	0x10
+#define ESE_VALUE_FLAG_NULL			0x20
+
+#define ESE_MAX_FIXED_COLUMN		127
+#define ESE_MAX_VARIABLE_COLUMN		255
+
+// Compression schemes of a value. The scheme is stored in the upper 5 bits of the value's first byte.
+#define ESE_COMPRESSION_7BIT_ASCII		1
+#define ESE_COMPRESSION_7BIT_UNICODE	2
+#define ESE_COMPRESSION_XPRESS			3
+
+// The offsets of the page header's fields.
+#define ESE_PAGE_NEXT_PAGE			20
+#define ESE_PAGE_OBJID				24
+#define ESE_PAGE_TAG_COUNT			34
+#define ESE_PAGE_FLAGS				36
+
+// How the pages of a database are laid out.
+struct ESE_FORMAT
+{
+	unsigned int page_size;
+	unsigned int page_header_size;
+	bool large_pages;				// 16 and 32 kilobyte pages have an extended header and larger tag offsets.
+};
+
+// A page that was read from the database. data is only valid until the next view of the map it was read from.
+struct ESE_PAGE
+{
+	const ESE_FORMAT *format;
+	unsigned char *data;
+	unsigned int page_number;
+	unsigned int objid;				// The father data page (FDP) object id of the tree that the page belongs to.
+	unsigned int flags;
+	unsigned int next_page;
+	unsigned short tag_count;
+};
+
+// A node of a B+ tree page. Its key is the common key prefix followed by the local key.
+struct ESE_NODE
+{
+	unsigned char *prefix;
+	unsigned char *key;
+	unsigned char *data;
+	unsigned int prefix_length;
+	unsigned int key_length;
+	unsigned int data_length;
+	unsigned char flags;
+};
+
+// The layout of a table's records.
+struct ESE_TABLE
+{
+	unsigned int objid;
+	unsigned int root_page;
+	unsigned int lv_objid;
+	unsigned int lv_root_page;		// 0 if the table doesn't have a long value tree.
+	unsigned short fixed_offset[ ESE_MAX_FIXED_COLUMN + 1 ];	// Offset of each fixed column in a record, by column id.
+	unsigned short fixed_size[ ESE_MAX_FIXED_COLUMN + 1 ];		// 0 if the column doesn't exist.
+};
+
+inline unsigned short GetUShort( const unsigned char *data )
+{
+	unsigned short val = 0;
+	memcpy( &val, data, sizeof( unsigned short ) );
+	return val;
+}
+
+inline unsigned int GetUInt( const unsigned char *data )
+{
+	unsigned int val = 0;
+	memcpy( &val, data, sizeof( unsigned int ) );
+	return val;
+}
+
+inline unsigned char GetNodeKeyByte( ESE_NODE *node, unsigned int index )
+{
+	return ( index < node->prefix_length ? node->prefix[ index ] : node->key[ index - node->prefix_length ] );
+}
+
+bool SetESEFormat( ESE_FORMAT *format, unsigned long revision, unsigned long page_size );
+
+bool ParsePage( const ESE_FORMAT *format, unsigned char *data, unsigned int page_number, ESE_PAGE *page );
+bool GetPageValue( ESE_PAGE *page, unsigned short tag, unsigned char **value, unsigned int *value_length, unsigned char *flags );
+bool GetPageNode( ESE_PAGE *page, unsigned short tag, ESE_NODE *node );
+int CompareNodeKey( ESE_NODE *node, const unsigned char *key, unsigned int key_length );
+
+bool DecompressXpress( const unsigned char *input, unsigned int input_length, unsigned char *output, unsigned int output_length );
+unsigned int GetDecompressedLength( const unsigned char *data, unsigned int data_length );
+bool DecompressData( const unsigned char *data, unsigned int data_length, unsigned char *output, unsigned int output_length );
+bool ExpandLongValueChunk( const unsigned char *data, unsigned int data_length, unsigned char *output, unsigned int output_length );
+
+void SetFixedColumnOffsets( ESE_TABLE *table );
+bool GetRecordValue( const ESE_FORMAT *format, ESE_TABLE *table, unsigned char *record, unsigned int record_length, unsigned int column_id, unsigned char **value, unsigned int *value_length, unsigned char *flags );
+unsigned int GetRecordUInt( const ESE_FORMAT *format, ESE_TABLE *table, unsigned char *record, unsigned int record_length, unsigned int column_id );
+
+#endif
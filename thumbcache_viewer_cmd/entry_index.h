@@ -0,0 +1,91 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENTRY_INDEX_H
+#define ENTRY_INDEX_H
+
+#include "globals.h"
+
+// The index of a database is saved next to it with this extension appended to its name.
+#define ENTRY_INDEX_EXTENSION	L".tcidx"
+
+#define ENTRY_INDEX_VERSION		1
+
+// The program that saved the index. Each program only loads its own since they stop at different points in a damaged database.
+#define ENTRY_INDEX_CREATOR_CMD	1
+#define ENTRY_INDEX_CREATOR_GUI	2
+
+// What was found at each position of the walk through a database's entries.
+#define STEP_ENTRY			0
+#define STEP_EMPTY			1	// The entry hash is 0.
+#define STEP_SCAN_FOUND		2	// An invalid entry. The next step is the entry that was found by scanning.
+#define STEP_SCAN_FAILED	3	// An invalid entry and no more entries could be found.
+#define STEP_END_OF_FILE	4
+
+// File type detected from the beginning of the data.
+#define ENTRY_FILE_TYPE_BMP	1
+#define ENTRY_FILE_TYPE_JPG	2
+#define ENTRY_FILE_TYPE_PNG	4
+
+// Everything up to record_count identifies the database that the index was saved for.
+struct ENTRY_INDEX_HEADER
+{
+	char magic_identifier[ 4 ];				// "TCIX"
+	unsigned short version;
+	unsigned short creator;
+	unsigned long long database_size;
+	unsigned long long database_write_time;	// FILETIME of the last write.
+	unsigned long long header_hash;			// FNV-1a hash of the database header. It holds the offset of the next available entry.
+	unsigned int record_count;
+	unsigned int entry_count;				// Number of entries that were processed.
+	unsigned int name_size;					// Size of the identifier strings that follow the records.
+	unsigned int reserved;
+};
+
+struct ENTRY_INDEX_RECORD
+{
+	unsigned long long offset;				// Offset of the entry header.
+	unsigned long long data_offset;
+	unsigned long long entry_hash;
+	unsigned long long data_checksum;
+	unsigned long long header_checksum;
+	unsigned int number;					// Entry number that's reported.
+	unsigned int data_size;
+	unsigned int name_offset;				// Offset of the identifier string from the beginning of the names.
+	unsigned int name_length;				// In bytes. 0 if the identifier string isn't saved.
+	unsigned char type;						// STEP_*
+	unsigned char file_type;				// ENTRY_FILE_TYPE_*
+	unsigned char layout;					// Database version whose entry layout was matched. Only set for entries carved from a disk image.
+	unsigned char reserved[ 5 ];
+};
+
+// An index that was loaded with a single read. Everything points into buffer.
+struct ENTRY_INDEX
+{
+	ENTRY_INDEX_HEADER *header;
+	ENTRY_INDEX_RECORD *records;
+	unsigned char *names;
+	unsigned char *buffer;
+};
+
+bool GetEntryIndexKey( HANDLE hFile, unsigned short creator, ENTRY_INDEX_HEADER *eih );
+ENTRY_INDEX *LoadEntryIndex( const wchar_t *database_path, const ENTRY_INDEX_HEADER *key, bool same_database );
+bool SaveEntryIndex( const wchar_t *database_path, const ENTRY_INDEX_HEADER *eih, const ENTRY_INDEX_RECORD *records, const void *names );
+void FreeEntryIndex( ENTRY_INDEX *index );
+
+#endif
@@ -0,0 +1,28 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FIND_SIGNATURE_H
+#define FIND_SIGNATURE_H
+
+#include <stddef.h>
+
+// Returns the offset of the first "CMMM" magic identifier in buf, or length if there isn't one.
+// A magic identifier that's truncated by the end of buf is not a match. Callers scanning in chunks should overlap them by 3 bytes.
+size_t find_signature( const unsigned char *buf, size_t length );
+
+#endif
@@ -31,8 +31,9 @@
 struct EXTENDED_INFO
 {
 	void *si;					// Shared information between items. (Cast this to SHARED_EXTENDED_INFO for SQLite or COLUMN_INFO for ESE)
-	wchar_t *property_value;	// Converted data value.
+	wchar_t *property_value;	// Converted data value. It's allocated with the node.
 	EXTENDED_INFO *next;
+	bool block;					// The node begins an allocation that holds its value and the nodes and values that follow it, up to the next node that begins one.
 };
 
 // This structure holds information obtained as we read the database.
@@ -43,10 +44,12 @@ struct FILE_INFO
 	unsigned long index;	// Row index in ESE database.
 };
 
-struct LINKED_LIST
+// Holds output until it can be written in order with the output of other threads.
+struct OUTPUT_BUFFER
 {
-	FILE_INFO fi;
-	LINKED_LIST *next;
+	char *buffer;
+	unsigned int length;	// Number of bytes used.
+	unsigned int size;		// Number of bytes allocated.
 };
 
 #endif
@@ -0,0 +1,59 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+
+// An open-addressing hash table that's keyed by a 64-bit value.
+// Each value is an index into an array that's owned by the caller. Values that share a key are chained in that array.
+
+typedef enum
+{
+	HASH_TABLE_STATUS_OK,
+	HASH_TABLE_STATUS_MEM_EXHAUSTED,
+	HASH_TABLE_STATUS_DUPLICATE_KEY,
+	HASH_TABLE_STATUS_TABLE_NOT_FOUND
+} hash_table_status;
+
+typedef struct slot
+{
+	unsigned long long key;
+	unsigned int value;
+	bool used;
+} slot_type;
+
+typedef struct hash_table
+{
+	slot_type *slots;
+	unsigned int capacity;	// Always a power of 2.
+	unsigned int count;		// Number of used slots.
+} hash_table;
+
+// Create a hash table that can hold expected_count keys before it needs to grow.
+hash_table *hash_table_create( unsigned int expected_count );
+
+// Insert a key/value pair.
+hash_table_status hash_table_insert( hash_table *table, unsigned long long key, unsigned int value );
+
+// Returns true and sets value if the key exists.
+bool hash_table_find( hash_table *table, unsigned long long key, unsigned int *value );
+
+// Destroy the hash table. Does not free what the values refer to.
+void hash_table_delete( hash_table *table );
+
+#endif
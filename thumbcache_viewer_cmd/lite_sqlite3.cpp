@@ -25,6 +25,15 @@ c_psqlite3_exec		c_sqlite3_exec;
 //c_psqlite3_errmsg16		c_sqlite3_errmsg16;
 c_psqlite3_free		c_sqlite3_free;
 c_psqlite3_close		c_sqlite3_close;
+c_psqlite3_prepare_v2		c_sqlite3_prepare_v2;
+c_psqlite3_bind_blob		c_sqlite3_bind_blob;
+c_psqlite3_step		c_sqlite3_step;
+c_psqlite3_reset		c_sqlite3_reset;
+c_psqlite3_finalize		c_sqlite3_finalize;
+c_psqlite3_column_int64		c_sqlite3_column_int64;
+c_psqlite3_column_blob		c_sqlite3_column_blob;
+c_psqlite3_column_text		c_sqlite3_column_text;
+c_psqlite3_column_bytes		c_sqlite3_column_bytes;
 
 //s_psqlite3_open16		s_sqlite3_open16;
 s_psqlite3_open_v2		s_sqlite3_open_v2;
@@ -33,6 +42,15 @@ s_psqlite3_exec		s_sqlite3_exec;
 //s_psqlite3_errmsg16		s_sqlite3_errmsg16;
 s_psqlite3_free		s_sqlite3_free;
 s_psqlite3_close		s_sqlite3_close;
+s_psqlite3_prepare_v2		s_sqlite3_prepare_v2;
+s_psqlite3_bind_blob		s_sqlite3_bind_blob;
+s_psqlite3_step		s_sqlite3_step;
+s_psqlite3_reset		s_sqlite3_reset;
+s_psqlite3_finalize		s_sqlite3_finalize;
+s_psqlite3_column_int64		s_sqlite3_column_int64;
+s_psqlite3_column_blob		s_sqlite3_column_blob;
+s_psqlite3_column_text		s_sqlite3_column_text;
+s_psqlite3_column_bytes		s_sqlite3_column_bytes;
 
 HMODULE hModule_sqlite3 = NULL;
 
@@ -85,6 +103,24 @@ bool InitializeSQLite3()
 		if ( s_sqlite3_free == NULL ) { goto CLEANUP; }
 		s_sqlite3_close = ( s_psqlite3_close )GetProcAddress( hModule_sqlite3, "sqlite3_close" );
 		if ( s_sqlite3_close == NULL ) { goto CLEANUP; }
+		s_sqlite3_prepare_v2 = ( s_psqlite3_prepare_v2 )GetProcAddress( hModule_sqlite3, "sqlite3_prepare_v2" );
+		if ( s_sqlite3_prepare_v2 == NULL ) { goto CLEANUP; }
+		s_sqlite3_bind_blob = ( s_psqlite3_bind_blob )GetProcAddress( hModule_sqlite3, "sqlite3_bind_blob" );
+		if ( s_sqlite3_bind_blob == NULL ) { goto CLEANUP; }
+		s_sqlite3_step = ( s_psqlite3_step )GetProcAddress( hModule_sqlite3, "sqlite3_step" );
+		if ( s_sqlite3_step == NULL ) { goto CLEANUP; }
+		s_sqlite3_reset = ( s_psqlite3_reset )GetProcAddress( hModule_sqlite3, "sqlite3_reset" );
+		if ( s_sqlite3_reset == NULL ) { goto CLEANUP; }
+		s_sqlite3_finalize = ( s_psqlite3_finalize )GetProcAddress( hModule_sqlite3, "sqlite3_finalize" );
+		if ( s_sqlite3_finalize == NULL ) { goto CLEANUP; }
+		s_sqlite3_column_int64 = ( s_psqlite3_column_int64 )GetProcAddress( hModule_sqlite3, "sqlite3_column_int64" );
+		if ( s_sqlite3_column_int64 == NULL ) { goto CLEANUP; }
+		s_sqlite3_column_blob = ( s_psqlite3_column_blob )GetProcAddress( hModule_sqlite3, "sqlite3_column_blob" );
+		if ( s_sqlite3_column_blob == NULL ) { goto CLEANUP; }
+		s_sqlite3_column_text = ( s_psqlite3_column_text )GetProcAddress( hModule_sqlite3, "sqlite3_column_text" );
+		if ( s_sqlite3_column_text == NULL ) { goto CLEANUP; }
+		s_sqlite3_column_bytes = ( s_psqlite3_column_bytes )GetProcAddress( hModule_sqlite3, "sqlite3_column_bytes" );
+		if ( s_sqlite3_column_bytes == NULL ) { goto CLEANUP; }
 	}
 	else
 	{
@@ -102,6 +138,24 @@ bool InitializeSQLite3()
 		if ( c_sqlite3_free == NULL ) { goto CLEANUP; }
 		c_sqlite3_close = ( c_psqlite3_close )GetProcAddress( hModule_sqlite3, "sqlite3_close" );
 		if ( c_sqlite3_close == NULL ) { goto CLEANUP; }
+		c_sqlite3_prepare_v2 = ( c_psqlite3_prepare_v2 )GetProcAddress( hModule_sqlite3, "sqlite3_prepare_v2" );
+		if ( c_sqlite3_prepare_v2 == NULL ) { goto CLEANUP; }
+		c_sqlite3_bind_blob = ( c_psqlite3_bind_blob )GetProcAddress( hModule_sqlite3, "sqlite3_bind_blob" );
+		if ( c_sqlite3_bind_blob == NULL ) { goto CLEANUP; }
+		c_sqlite3_step = ( c_psqlite3_step )GetProcAddress( hModule_sqlite3, "sqlite3_step" );
+		if ( c_sqlite3_step == NULL ) { goto CLEANUP; }
+		c_sqlite3_reset = ( c_psqlite3_reset )GetProcAddress( hModule_sqlite3, "sqlite3_reset" );
+		if ( c_sqlite3_reset == NULL ) { goto CLEANUP; }
+		c_sqlite3_finalize = ( c_psqlite3_finalize )GetProcAddress( hModule_sqlite3, "sqlite3_finalize" );
+		if ( c_sqlite3_finalize == NULL ) { goto CLEANUP; }
+		c_sqlite3_column_int64 = ( c_psqlite3_column_int64 )GetProcAddress( hModule_sqlite3, "sqlite3_column_int64" );
+		if ( c_sqlite3_column_int64 == NULL ) { goto CLEANUP; }
+		c_sqlite3_column_blob = ( c_psqlite3_column_blob )GetProcAddress( hModule_sqlite3, "sqlite3_column_blob" );
+		if ( c_sqlite3_column_blob == NULL ) { goto CLEANUP; }
+		c_sqlite3_column_text = ( c_psqlite3_column_text )GetProcAddress( hModule_sqlite3, "sqlite3_column_text" );
+		if ( c_sqlite3_column_text == NULL ) { goto CLEANUP; }
+		c_sqlite3_column_bytes = ( c_psqlite3_column_bytes )GetProcAddress( hModule_sqlite3, "sqlite3_column_bytes" );
+		if ( c_sqlite3_column_bytes == NULL ) { goto CLEANUP; }
 	}
 
 	sqlite3_state = SQLITE3_STATE_RUNNING;
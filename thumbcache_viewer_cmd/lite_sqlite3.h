@@ -30,7 +30,12 @@
 #define SQLITE3_STATE_RUNNING	1
 
 #define SQLITE_OK				0
+#define SQLITE_ROW				100
+#define SQLITE_DONE				101
 #define SQLITE_OPEN_READONLY	0x00000001
+#define SQLITE_OPEN_URI			0x00000040
+
+#define SQLITE_STATIC			( ( void ( * )( void * ) )0 )
 
 //typedef int ( WINAPIV *c_psqlite3_open16 )( const void *filename, void /*sqlite3*/ **ppDb );
 typedef int ( WINAPIV *c_psqlite3_open_v2 )( const void *filename, void /*sqlite3*/ **ppDb, int flags, const char *zVfs );
@@ -39,6 +44,15 @@ typedef int ( WINAPIV *c_psqlite3_exec )( void /*sqlite3*/ *pDb, const char *sql
 //typedef const void * ( WINAPIV *c_psqlite3_errmsg16 )( void /*sqlite3*/ *pDb );
 typedef void ( WINAPIV *c_psqlite3_free )( void *val );
 typedef int ( WINAPIV *c_psqlite3_close )( void /*sqlite3*/ *pDb );
+typedef int ( WINAPIV *c_psqlite3_prepare_v2 )( void /*sqlite3*/ *pDb, const char *sql, int nByte, void /*sqlite3_stmt*/ **ppStmt, const char **pzTail );
+typedef int ( WINAPIV *c_psqlite3_bind_blob )( void /*sqlite3_stmt*/ *pStmt, int i, const void *val, int n, void ( *destructor )( void * ) );
+typedef int ( WINAPIV *c_psqlite3_step )( void /*sqlite3_stmt*/ *pStmt );
+typedef int ( WINAPIV *c_psqlite3_reset )( void /*sqlite3_stmt*/ *pStmt );
+typedef int ( WINAPIV *c_psqlite3_finalize )( void /*sqlite3_stmt*/ *pStmt );
+typedef long long ( WINAPIV *c_psqlite3_column_int64 )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef const void * ( WINAPIV *c_psqlite3_column_blob )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef const unsigned char * ( WINAPIV *c_psqlite3_column_text )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef int ( WINAPIV *c_psqlite3_column_bytes )( void /*sqlite3_stmt*/ *pStmt, int iCol );
 
 //typedef int ( WINAPI *s_psqlite3_open16 )( const void *filename, void /*sqlite3*/ **ppDb );
 typedef int ( WINAPI *s_psqlite3_open_v2 )( const void *filename, void /*sqlite3*/ **ppDb, int flags, const char *zVfs );
@@ -47,6 +61,15 @@ typedef int ( WINAPI *s_psqlite3_exec )( void /*sqlite3*/ *pDb, const char *sql,
 //typedef const void * ( WINAPI *s_psqlite3_errmsg16 )( void /*sqlite3*/ *pDb );
 typedef void ( WINAPI *s_psqlite3_free )( void *val );
 typedef int ( WINAPI *s_psqlite3_close )( void /*sqlite3*/ *pDb );
+typedef int ( WINAPI *s_psqlite3_prepare_v2 )( void /*sqlite3*/ *pDb, const char *sql, int nByte, void /*sqlite3_stmt*/ **ppStmt, const char **pzTail );
+typedef int ( WINAPI *s_psqlite3_bind_blob )( void /*sqlite3_stmt*/ *pStmt, int i, const void *val, int n, void ( *destructor )( void * ) );
+typedef int ( WINAPI *s_psqlite3_step )( void /*sqlite3_stmt*/ *pStmt );
+typedef int ( WINAPI *s_psqlite3_reset )( void /*sqlite3_stmt*/ *pStmt );
+typedef int ( WINAPI *s_psqlite3_finalize )( void /*sqlite3_stmt*/ *pStmt );
+typedef long long ( WINAPI *s_psqlite3_column_int64 )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef const void * ( WINAPI *s_psqlite3_column_blob )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef const unsigned char * ( WINAPI *s_psqlite3_column_text )( void /*sqlite3_stmt*/ *pStmt, int iCol );
+typedef int ( WINAPI *s_psqlite3_column_bytes )( void /*sqlite3_stmt*/ *pStmt, int iCol );
 
 //extern c_psqlite3_open16		c_sqlite3_open16;
 extern c_psqlite3_open_v2		c_sqlite3_open_v2;
@@ -55,6 +78,15 @@ extern c_psqlite3_exec		c_sqlite3_exec;
 //extern c_psqlite3_errmsg16		c_sqlite3_errmsg16;
 extern c_psqlite3_free		c_sqlite3_free;
 extern c_psqlite3_close		c_sqlite3_close;
+extern c_psqlite3_prepare_v2		c_sqlite3_prepare_v2;
+extern c_psqlite3_bind_blob		c_sqlite3_bind_blob;
+extern c_psqlite3_step		c_sqlite3_step;
+extern c_psqlite3_reset		c_sqlite3_reset;
+extern c_psqlite3_finalize		c_sqlite3_finalize;
+extern c_psqlite3_column_int64		c_sqlite3_column_int64;
+extern c_psqlite3_column_blob		c_sqlite3_column_blob;
+extern c_psqlite3_column_text		c_sqlite3_column_text;
+extern c_psqlite3_column_bytes		c_sqlite3_column_bytes;
 
 //extern s_psqlite3_open16		s_sqlite3_open16;
 extern s_psqlite3_open_v2		s_sqlite3_open_v2;
@@ -63,6 +95,15 @@ extern s_psqlite3_exec		s_sqlite3_exec;
 //extern s_psqlite3_errmsg16		s_sqlite3_errmsg16;
 extern s_psqlite3_free		s_sqlite3_free;
 extern s_psqlite3_close		s_sqlite3_close;
+extern s_psqlite3_prepare_v2		s_sqlite3_prepare_v2;
+extern s_psqlite3_bind_blob		s_sqlite3_bind_blob;
+extern s_psqlite3_step		s_sqlite3_step;
+extern s_psqlite3_reset		s_sqlite3_reset;
+extern s_psqlite3_finalize		s_sqlite3_finalize;
+extern s_psqlite3_column_int64		s_sqlite3_column_int64;
+extern s_psqlite3_column_blob		s_sqlite3_column_blob;
+extern s_psqlite3_column_text		s_sqlite3_column_text;
+extern s_psqlite3_column_bytes		s_sqlite3_column_bytes;
 
 extern unsigned char sqlite3_state;
 
@@ -72,6 +113,15 @@ extern unsigned char sqlite3_calling_convention;
 #define sqlite3_exec( pDb, sql, fp, arg, errmsg ) ( sqlite3_calling_convention == 1 ? s_sqlite3_exec( pDb, sql, s_##fp, arg, errmsg ) : c_sqlite3_exec( pDb, sql, c_##fp, arg, errmsg ) )
 #define sqlite3_free( val ) ( sqlite3_calling_convention == 1 ? s_sqlite3_free( val ) : c_sqlite3_free( val ) )
 #define sqlite3_close( pDb ) ( sqlite3_calling_convention == 1 ? s_sqlite3_close( pDb ) : c_sqlite3_close( pDb ) )
+#define sqlite3_prepare_v2( pDb, sql, nByte, ppStmt, pzTail ) ( sqlite3_calling_convention == 1 ? s_sqlite3_prepare_v2( pDb, sql, nByte, ppStmt, pzTail ) : c_sqlite3_prepare_v2( pDb, sql, nByte, ppStmt, pzTail ) )
+#define sqlite3_bind_blob( pStmt, i, val, n, destructor ) ( sqlite3_calling_convention == 1 ? s_sqlite3_bind_blob( pStmt, i, val, n, destructor ) : c_sqlite3_bind_blob( pStmt, i, val, n, destructor ) )
+#define sqlite3_step( pStmt ) ( sqlite3_calling_convention == 1 ? s_sqlite3_step( pStmt ) : c_sqlite3_step( pStmt ) )
+#define sqlite3_reset( pStmt ) ( sqlite3_calling_convention == 1 ? s_sqlite3_reset( pStmt ) : c_sqlite3_reset( pStmt ) )
+#define sqlite3_finalize( pStmt ) ( sqlite3_calling_convention == 1 ? s_sqlite3_finalize( pStmt ) : c_sqlite3_finalize( pStmt ) )
+#define sqlite3_column_int64( pStmt, iCol ) ( sqlite3_calling_convention == 1 ? s_sqlite3_column_int64( pStmt, iCol ) : c_sqlite3_column_int64( pStmt, iCol ) )
+#define sqlite3_column_blob( pStmt, iCol ) ( sqlite3_calling_convention == 1 ? s_sqlite3_column_blob( pStmt, iCol ) : c_sqlite3_column_blob( pStmt, iCol ) )
+#define sqlite3_column_text( pStmt, iCol ) ( sqlite3_calling_convention == 1 ? s_sqlite3_column_text( pStmt, iCol ) : c_sqlite3_column_text( pStmt, iCol ) )
+#define sqlite3_column_bytes( pStmt, iCol ) ( sqlite3_calling_convention == 1 ? s_sqlite3_column_bytes( pStmt, iCol ) : c_sqlite3_column_bytes( pStmt, iCol ) )
 
 bool InitializeSQLite3();
 bool UnInitializeSQLite3();
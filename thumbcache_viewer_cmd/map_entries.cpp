@@ -23,89 +23,541 @@
 #include "utilities.h"
 #include "map_entries.h"
 #include "read_esedb.h"
+#include "parse_esedb.h"
 #include "read_sqlitedb.h"
 
-#include <io.h>
-#include <fcntl.h>
+// The ColumnId of System_ThumbnailCacheId. Windows 8+ prefixes the property name with a hex number and a '-'.
+#define THUMBNAIL_CACHE_ID_COLUMNS	"( SELECT Id FROM SystemIndex_1_PropertyStore_Metadata WHERE UniqueKey LIKE '%System_ThumbnailCacheId' )"
 
-#include "dllrbt.h"
+unsigned char g_database_type = 0;	// The type of the open database. 0 = None, 1 = ESE, 2 = SQLite
 
-char g_query[ 512 ];
-unsigned char g_database_type = 0;	// 0 = None, 1 = ESE, 2 = SQLite
+MAPPED_SOURCE *g_sources = NULL;	// Every Windows Search database that entry hashes are looked up in.
+unsigned int g_source_count = 0;
+unsigned int g_source = 0;			// The index of the open database in g_sources.
+bool g_use_index = false;			// Load or save the index of an ESE database each time it's opened.
 
-int dllrbt_compare( void *a, void *b )
+CRITICAL_SECTION g_map_cs;			// Serializes lookups in the Windows Search database.
+
+hash_table *g_entry_hashes = NULL;	// Hashes of the entries that are joined to every Windows Search database while it's traversed.
+MAPPED_LIST g_mapped = { NULL };	// The joined entry hashes. It's read without a lock once the databases have been traversed.
+
+wchar_t *g_projection = NULL;		// The Windows Properties to retrieve, each NULL terminated and followed by an empty one. NULL to retrieve every property.
+unsigned int g_projection_length = 0;
+
+void FreeExtendedInfo( EXTENDED_INFO *ei )
+{
+	// The nodes of a block are freed once we've moved past them.
+	EXTENDED_INFO *del_block = NULL;
+
+	while ( ei != NULL )
+	{
+		if ( ei->block )
+		{
+			free( del_block );
+			del_block = ei;
+		}
+
+		ei = ei->next;
+	}
+
+	free( del_block );
+}
+
+void CleanupMappedList( MAPPED_LIST *ml )
+{
+	for ( unsigned int i = 0; i < ml->count; ++i )
+	{
+		FreeExtendedInfo( ml->info[ i ].ei );
+	}
+
+	free( ml->info );
+	ml->info = NULL;
+	ml->count = 0;
+	ml->size = 0;
+
+	hash_table_delete( ml->table );
+	ml->table = NULL;
+}
+
+void CleanupMappedInfo()
+{
+	CleanupMappedList( &g_mapped );
+
+	// The open database's properties are freed when it's cleaned up.
+	for ( unsigned int i = 0; i < g_source_count; ++i )
+	{
+		free( g_sources[ i ].database_filepath );
+		free( g_sources[ i ].utf8_filepath );
+		FreeColumnInfo( ( COLUMN_INFO * )g_sources[ i ].columns );
+		FreePropertyInfo( g_sources[ i ].properties, g_sources[ i ].property_count );
+	}
+
+	free( g_sources );
+	g_sources = NULL;
+	g_source_count = 0;
+	g_source = 0;
+
+	hash_table_delete( g_entry_hashes );
+	g_entry_hashes = NULL;
+
+	free( g_projection );
+	g_projection = NULL;
+	g_projection_length = 0;
+}
+
+// Adds a comma-separated list of Windows Properties to the projection. Can be called more than once.
+bool SetPropertyProjection( const wchar_t *property_list )
+{
+	if ( property_list == NULL )
+	{
+		return false;
+	}
+
+	int length = ( int )wcslen( property_list );
+
+	// Include a NULL character for each property and the empty property at the end.
+	wchar_t *realloc_projection = ( wchar_t * )realloc( g_projection, sizeof( wchar_t ) * ( g_projection_length + length + 1 + 1 ) );
+	if ( realloc_projection == NULL )
+	{
+		return false;
+	}
+
+	g_projection = realloc_projection;
+
+	const wchar_t *property = property_list;
+	while ( *property != L'\0' )
+	{
+		const wchar_t *end = property;
+		while ( *end != L'\0' && *end != L',' )
+		{
+			++end;
+		}
+
+		// Trim any spaces around the name.
+		const wchar_t *start = property;
+		const wchar_t *last = end;
+		while ( start < last && *start == L' ' )
+		{
+			++start;
+		}
+		while ( last > start && *( last - 1 ) == L' ' )
+		{
+			--last;
+		}
+
+		if ( last > start )
+		{
+			wmemcpy_s( g_projection + g_projection_length, length + 1, start, last - start );
+			g_projection_length += ( unsigned int )( last - start );
+			g_projection[ g_projection_length++ ] = 0;
+		}
+
+		property = ( *end == L',' ? end + 1 : end );
+	}
+
+	g_projection[ g_projection_length ] = 0;	// Sanity.
+
+	return true;
+}
+
+// Returns true if there's no projection or if the Windows Property is in it. '.' and '_' are treated the same, and case is ignored.
+bool IsPropertyProjected( const wchar_t *name, unsigned long name_length )
+{
+	if ( g_projection == NULL )
+	{
+		return true;
+	}
+
+	for ( const wchar_t *property = g_projection; *property != L'\0'; property += ( wcslen( property ) + 1 ) )
+	{
+		unsigned long i = 0;
+		for ( ; i < name_length && property[ i ] != L'\0'; ++i )
+		{
+			wchar_t a = towlower( name[ i ] );
+			wchar_t b = towlower( property[ i ] );
+
+			if ( ( a != b ) && !( ( a == L'.' || a == L'_' ) && ( b == L'.' || b == L'_' ) ) )
+			{
+				break;
+			}
+		}
+
+		if ( i == name_length && property[ i ] == L'\0' )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Returns a copy of sql that only selects the projected properties of the PropertyStore aliased as p. The caller frees it.
+char *ProjectStatement( const char *sql )
+{
+	int sql_length = ( int )strlen( sql );
+
+	// Each property id needs at most 10 digits and a separator.
+	int projection_size = 32 + ( g_projection != NULL ? g_property_count * 12 : 0 );
+	char *projected_sql = ( char * )malloc( sizeof( char ) * ( sql_length + projection_size ) );
+	if ( projected_sql == NULL )
+	{
+		return NULL;
+	}
+
+	int offset = sprintf_s( projected_sql, sql_length + projection_size, "%s", sql );
+
+	if ( g_projection != NULL )
+	{
+		if ( g_property_count > 0 )
+		{
+			offset += sprintf_s( projected_sql + offset, sql_length + projection_size - offset, " AND p.ColumnId IN ( " );
+
+			for ( unsigned int i = 0; i < g_property_count; ++i )
+			{
+				offset += sprintf_s( projected_sql + offset, sql_length + projection_size - offset, ( i > 0 ? ", %lu" : "%lu" ), g_property_info[ i ].id );
+			}
+
+			sprintf_s( projected_sql + offset, sql_length + projection_size - offset, " )" );
+		}
+		else	// None of the properties exist.
+		{
+			sprintf_s( projected_sql + offset, sql_length + projection_size - offset, " AND 0" );
+		}
+	}
+
+	return projected_sql;
+}
+
+// Sets index to the mapping of an entry hash from a database. An empty mapping is added if the hash doesn't have one from that database.
+// The mappings of a hash from each database are linked in the order that they were added.
+bool AddMappedInfo( MAPPED_LIST *ml, unsigned long long hash, unsigned int source, unsigned int *index )
 {
-	unsigned long long hash1 = ( unsigned long long )a;
-	unsigned long long hash2 = ( unsigned long long )b;
+	unsigned int last = 0;
+	bool found = hash_table_find( ml->table, hash, &last );
+	if ( found )
+	{
+		for ( ;; )
+		{
+			if ( ml->info[ last ].source == source )
+			{
+				*index = last;
+
+				return true;
+			}
+
+			if ( ml->info[ last ].next == 0 )
+			{
+				break;
+			}
+
+			last = ml->info[ last ].next - 1;
+		}
+	}
+
+	if ( ml->count == ml->size )
+	{
+		unsigned int size = ( ml->size > 0 ? ml->size * 2 : 1024 );
+		MAPPED_INFO *realloc_info = ( MAPPED_INFO * )realloc( ml->info, sizeof( MAPPED_INFO ) * size );
+		if ( realloc_info == NULL )
+		{
+			return false;
+		}
+
+		ml->info = realloc_info;
+		ml->size = size;
+	}
+
+	if ( found )
+	{
+		ml->info[ last ].next = ml->count + 1;
+	}
+	else if ( hash_table_insert( ml->table, hash, ml->count ) != HASH_TABLE_STATUS_OK )
+	{
+		return false;
+	}
+
+	ml->info[ ml->count ].hash = hash;
+	ml->info[ ml->count ].ei = NULL;
+	ml->info[ ml->count ].source = source;
+	ml->info[ ml->count ].next = 0;
+
+	*index = ml->count++;
+
+	return true;
+}
+
+// Runs a statement and ignores any rows that it returns.
+int ExecStatement( const char *sql )
+{
+	void *stmt = NULL;
+
+	int sql_rc = sqlite3_prepare_v2( g_sql_db, sql, -1, &stmt, NULL );
+	if ( sql_rc == SQLITE_OK )
+	{
+		while ( ( sql_rc = sqlite3_step( stmt ) ) == SQLITE_ROW );
+
+		sqlite3_finalize( stmt );
+	}
+
+	return ( sql_rc == SQLITE_DONE ? SQLITE_OK : sql_rc );
+}
+
+// Joins the properties of every file whose System_ThumbnailCacheId is one of the hashes.
+// The hashes are loaded into a temporary table so that a single statement can join them to the property store.
+// Each hash is first resolved to the WorkIds of its files. The properties are then read in WorkId order, which is the order that the property store is kept in.
+// The properties are added to the mappings from the database at source.
+void JoinSQLiteDatabase( hash_table *hashes, MAPPED_LIST *ml, unsigned int source )
+{
+	if ( ExecStatement( "CREATE TEMP TABLE EntryHash ( Value BLOB PRIMARY KEY )" ) != SQLITE_OK )
+	{
+		return;
+	}
 
-	if ( hash1 > hash2 )
+	if ( ExecStatement( "CREATE TEMP TABLE EntryWork ( WorkId INTEGER, Value BLOB, PRIMARY KEY ( WorkId, Value ) ) WITHOUT ROWID" ) != SQLITE_OK )
 	{
-		return 1;
+		ExecStatement( "DROP TABLE temp.EntryHash" );
+
+		return;
 	}
 
-	if ( hash1 < hash2 )
+	void *stmt = NULL;
+
+	ExecStatement( "BEGIN" );
+
+	if ( sqlite3_prepare_v2( g_sql_db, "INSERT OR IGNORE INTO temp.EntryHash VALUES ( ?1 )", -1, &stmt, NULL ) == SQLITE_OK )
 	{
-		return -1;
+		for ( unsigned int i = 0; i < hashes->capacity; ++i )
+		{
+			if ( hashes->slots[ i ].used )
+			{
+				// The hash is stored in big-endian order.
+				unsigned long long value = hashes->slots[ i ].key;
+				value = ntohll( value );
+
+				sqlite3_bind_blob( stmt, 1, &value, sizeof( unsigned long long ), SQLITE_STATIC );
+				sqlite3_step( stmt );
+				sqlite3_reset( stmt );
+			}
+		}
+
+		sqlite3_finalize( stmt );
 	}
 
-	return 0;
+	ExecStatement( "INSERT OR IGNORE INTO temp.EntryWork SELECT h.WorkId, e.Value FROM temp.EntryHash AS e " \
+				   "JOIN SystemIndex_1_PropertyStore AS h ON h.Value = e.Value AND h.ColumnId IN " THUMBNAIL_CACHE_ID_COLUMNS );
+
+	ExecStatement( "COMMIT" );
+
+	// CROSS JOIN keeps temp.EntryWork as the outer loop so that its WorkIds are visited in order.
+	char *sql = ProjectStatement(
+		"SELECT w.Value, p.ColumnId, p.Value, p.VariantType FROM temp.EntryWork AS w " \
+		"CROSS JOIN SystemIndex_1_PropertyStore AS p ON p.WorkId = w.WorkId" );
+
+	if ( sql != NULL && sqlite3_prepare_v2( g_sql_db, sql, -1, &stmt, NULL ) == SQLITE_OK )
+	{
+		while ( sqlite3_step( stmt ) == SQLITE_ROW )
+		{
+			const void *value = sqlite3_column_blob( stmt, 0 );
+			if ( value == NULL || sqlite3_column_bytes( stmt, 0 ) != sizeof( unsigned long long ) )
+			{
+				continue;
+			}
+
+			unsigned long long hash = 0;
+			memcpy( &hash, value, sizeof( unsigned long long ) );
+			hash = ntohll( hash );
+
+			// More than one file can share a thumbnail. Each of their properties are added to the same mapping.
+			unsigned int index = 0;
+			if ( AddMappedInfo( ml, hash, source, &index ) )
+			{
+				AddPropertyInfo( &ml->info[ index ].ei, stmt, 1 );
+			}
+		}
+
+		sqlite3_finalize( stmt );
+	}
+
+	free( sql );
+
+	ExecStatement( "DROP TABLE temp.EntryWork" );
+	ExecStatement( "DROP TABLE temp.EntryHash" );
+}
+
+// Builds a URI that opens the database as read-only and immutable. SQLite won't lock the database or check whether it has changed.
+char *BuildDatabaseUri( wchar_t *database_filepath )
+{
+	int utf8_length = WideCharToMultiByte( CP_UTF8, 0, database_filepath, -1, NULL, 0, NULL, NULL );
+	char *utf8_filepath = ( char * )malloc( sizeof( char ) * utf8_length ); // Size includes the null character.
+	WideCharToMultiByte( CP_UTF8, 0, database_filepath, -1, utf8_filepath, utf8_length, NULL, NULL );
+
+	// Drive paths get an empty authority and UNC paths keep their leading slashes.
+	const char *scheme = ( utf8_filepath[ 0 ] != '\0' && utf8_filepath[ 1 ] == ':' ? "file:///" : ( utf8_filepath[ 0 ] == '\\' && utf8_filepath[ 1 ] == '\\' ? "file://" : "file:" ) );
+
+	// Each character might need to be escaped.
+	int uri_size = 8 + ( utf8_length * 3 ) + 12;
+	char *uri = ( char * )malloc( sizeof( char ) * uri_size );
+	int uri_length = sprintf_s( uri, uri_size, "%s", scheme );
+
+	for ( char *c = utf8_filepath; *c != '\0'; ++c )
+	{
+		if ( *c == '\\' )
+		{
+			uri[ uri_length++ ] = '/';
+		}
+		else if ( *c == '%' || *c == '?' || *c == '#' )
+		{
+			uri_length += sprintf_s( uri + uri_length, uri_size - uri_length, "%%%02x", ( unsigned char )*c );
+		}
+		else
+		{
+			uri[ uri_length++ ] = *c;
+		}
+	}
+
+	memcpy_s( uri + uri_length, uri_size - uri_length, "?immutable=1", 13 );
+
+	free( utf8_filepath );
+
+	return uri;
 }
 
-void TraverseSQLiteDatabase( wchar_t *database_filepath )
+// If join_hashes is not NULL, then the information of those hashes is joined to g_mapped.
+void TraverseSQLiteDatabase( wchar_t *database_filepath, hash_table *join_hashes )
 {
 	char *sql_err_msg = NULL;
+	char *sql = NULL;
 
-	int filepath_length = WideCharToMultiByte( CP_ACP, 0, database_filepath, -1, NULL, 0, NULL, NULL );
-	char *ascii_filepath = ( char * )malloc( sizeof( char ) * filepath_length ); // Size includes the null character.
-	WideCharToMultiByte( CP_ACP, 0, database_filepath, -1, ascii_filepath, filepath_length, NULL, NULL );
+	char *uri = BuildDatabaseUri( database_filepath );
 
-	int sql_rc = sqlite3_open_v2( ascii_filepath, &g_sql_db, SQLITE_OPEN_READONLY, NULL );
+	int sql_rc = sqlite3_open_v2( uri, &g_sql_db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, NULL );
 	if ( sql_rc )
 	{
 		// sqlite3_errmsg16( g_sql_db );
-		printf( "The SQLite database could not be opened.\n" );
+		wprintf( L"The SQLite database could not be opened.\n" );
 
 		goto CLEANUP;
 	}
 
+	// The database is only read, so let SQLite map it and cache more of it. The temporary table is kept in memory.
+	ExecStatement( "PRAGMA mmap_size = 268435456" );
+	ExecStatement( "PRAGMA cache_size = -65536" );
+	ExecStatement( "PRAGMA temp_store = MEMORY" );
+
 	sql_rc = sqlite3_exec( g_sql_db, "SELECT Id, UniqueKey FROM SystemIndex_1_PropertyStore_Metadata", BuildPropertyTreeCallback, NULL, &sql_err_msg );
 	if ( sql_rc != SQLITE_OK )
 	{
 		goto CLEANUP;
 	}
 
-	memcpy_s( g_query, 512,
-		"SELECT WorkId, Id, UniqueKey, Value, VariantType FROM SystemIndex_1_PropertyStore " \
-		"JOIN SystemIndex_1_PropertyStore_Metadata ON SystemIndex_1_PropertyStore_Metadata.Id = SystemIndex_1_PropertyStore.ColumnId " \
-		"WHERE WorkId IN ( SELECT WorkId FROM SystemIndex_1_PropertyStore WHERE Value = (X\'", 288 );
+	// Entries that weren't joined are looked up with this statement.
+	sql = ProjectStatement(
+		"SELECT p.ColumnId, p.Value, p.VariantType FROM SystemIndex_1_PropertyStore AS h " \
+		"JOIN SystemIndex_1_PropertyStore AS p ON p.WorkId = h.WorkId " \
+		"WHERE h.Value = ?1 AND h.ColumnId IN " THUMBNAIL_CACHE_ID_COLUMNS );
+
+	if ( sql != NULL )
+	{
+		sqlite3_prepare_v2( g_sql_db, sql, -1, &g_hash_stmt, NULL );
+
+		free( sql );
+	}
+
+	if ( join_hashes != NULL )
+	{
+		JoinSQLiteDatabase( join_hashes, &g_mapped, g_source );
+	}
 
 CLEANUP:
 
-	free( ascii_filepath );
+	free( uri );
 
 	if ( sql_err_msg != NULL )
 	{
-		printf( "SQLite: %s\n", sql_err_msg );
+		wprintf( L"SQLite: %hs\n", sql_err_msg );
 
 		sqlite3_free( sql_err_msg );
 	}
 }
 
+// Reads the database without the Microsoft Jet Database Engine. The rows are decoded in parallel.
+// Returns false if the database couldn't be parsed so that the engine can be used instead.
+// If use_index is true, then the schema and rows are loaded from the database's index (.tcsidx) instead of being parsed, or saved to it.
+// If join_hashes is not NULL, then the information of those hashes is joined to g_mapped.
+bool TraverseNativeESEDatabase( wchar_t *database_filepath, unsigned long revision, unsigned long page_size, bool use_index, hash_table *join_hashes )
+{
+	if ( !OpenNativeESEDatabase( database_filepath, revision, page_size, use_index ) )
+	{
+		return false;
+	}
+
+	if ( !ScanNativeESEDatabase( join_hashes ) )
+	{
+		CleanupESEDBInfo();
+		return false;
+	}
+
+	// Create the file info table if it doesn't exist.
+	if ( g_file_info_table == NULL )
+	{
+		g_file_info_table = hash_table_create( g_ese_row_count );
+	}
+
+	for ( unsigned int index = 0; index < g_ese_row_count; ++index )
+	{
+		ESE_ROW *row = &g_ese_rows[ index ];
+
+		// Only the first row with a given hash is mapped. The rows of entry hashes were converted when they were decoded.
+		if ( hash_table_insert( g_file_info_table, row->hash, index ) == HASH_TABLE_STATUS_OK && row->ei != NULL )
+		{
+			unsigned int mapped_index = 0;
+			if ( AddMappedInfo( &g_mapped, row->hash, g_source, &mapped_index ) )
+			{
+				g_mapped.info[ mapped_index ].ei = row->ei;
+				row->ei = NULL;
+			}
+		}
+
+		FreeExtendedInfo( row->ei );
+		row->ei = NULL;
+	}
+
+	return true;
+}
+
 // The Microsoft Jet Database Engine seems to have a lot of annoying quirks/compatibility issues.
 // The directory scanner is a nice compliment should this function not work 100%.
 // Ideally, the database being scanned should be done with the same esent.dll that was used to create it.
 // If there are issues with the database, make a copy and use esentutl.exe to fix it.
-void TraverseESEDatabase( wchar_t *database_filepath, unsigned long revision, unsigned long page_size )
+void TraverseESEDatabase( wchar_t *database_filepath, unsigned long revision, unsigned long page_size, bool use_index, hash_table *join_hashes )
 {
 	JET_RETRIEVECOLUMN rc = { 0 };
 
 	unsigned long long thumbnail_cache_id = 0;
 
+	// Windows 8+ (database revision >= 0x14) doesn't use compression.
+	// Compressed text is decoded by UncompressText(). mssrch.dll (Windows 7) or msscb.dll (Windows Vista) is only a fallback for values that it can't decode.
+	if ( revision < 0x14 && mssrch_state == MSSRCH_STATE_SHUTDOWN && msscb_state == MSSRCH_STATE_SHUTDOWN )
+	{
+		// We only need one to load successfully.
+		if ( !InitializeMsSrch() )
+		{
+			InitializeMsSCB();
+		}
+	}
+
+	if ( TraverseNativeESEDatabase( database_filepath, revision, page_size, use_index, join_hashes ) )
+	{
+		return;
+	}
+
+	wprintf( L"The database could not be parsed. Using the Microsoft Jet Database Engine instead.\n" );
+
 	// Initialize the Jet database session and get column information for later retrieval. SystemIndex_0A and SystemIndex_0P will be opened on success.
 	if ( ( g_err = InitESEDBInfo( database_filepath, revision, page_size ) ) != JET_errSuccess || ( g_err = ( g_revision < 0x14 ? GetColumnInfo() : GetColumnInfoWin8() ) ) != JET_errSuccess ) { goto CLEANUP; }
 
 	// These are set in get_column_info. Make sure they exist.
-	if ( g_thumbnail_cache_id == NULL ) { if ( g_err == JET_errColumnNotFound ) { printf( "The System_ThumbnailCacheId column was not found.\n" ); } goto CLEANUP; }
+	if ( g_thumbnail_cache_id == NULL ) { if ( g_err == JET_errColumnNotFound ) { wprintf( L"The System_ThumbnailCacheId column was not found.\n" ); } goto CLEANUP; }
 
 	// Ensure that the values we retrieve are of the correct size.
 	if ( g_thumbnail_cache_id->max_size != sizeof( unsigned long long ) ) { g_err = JET_errInvalidColumnType; goto CLEANUP; }
@@ -118,25 +570,14 @@ void TraverseESEDatabase( wchar_t *database_filepath, unsigned long revision, un
 
 	if ( ( g_err = JetMove( g_sesid, g_tableid_0A, JET_MoveFirst, JET_bitNil ) ) != JET_errSuccess ) { goto CLEANUP; }
 
-	// Windows 8+ (database revision >= 0x14) doesn't use compression.
-	// mssrch.dll is for Windows 7. msscb.dll is for Windows Vista. Load whichever one we can.
-	// These dlls will allow us to uncompress certain column's data/text.
-	if ( g_revision < 0x14 && mssrch_state == MSSRCH_STATE_SHUTDOWN && msscb_state == MSSRCH_STATE_SHUTDOWN )
-	{
-		// We only need one to load successfully.
-		if ( !InitializeMsSrch() && !InitializeMsSCB() )
-		{
-			printf( "The modules mssrch.dll and msscb.dll failed to load.\nCompressed data will not be read.\n" );
-		}
-	}
-
-	// Initialize g_rc_array to hold all of the record information we'll retrieve.
+	// Initialize g_rc_array to hold all of the record information we'll retrieve. Only the projected properties are retrieved.
+	ProjectColumns();
 	BuildRetrieveColumnArray();
 
-	// Create the file info tree if it doesn't exist.
-	if ( g_file_info_tree == NULL )
+	// Create the file info table if it doesn't exist.
+	if ( g_file_info_table == NULL )
 	{
-		g_file_info_tree = dllrbt_create( dllrbt_compare );
+		g_file_info_table = hash_table_create( 0 );
 	}
 
 	for ( unsigned int index = 0; ; ++index )
@@ -153,16 +594,17 @@ void TraverseESEDatabase( wchar_t *database_filepath, unsigned long revision, un
 			thumbnail_cache_id = ntohll( thumbnail_cache_id );
 		}
 
-		// Create the node to insert into a linked list.
-		LINKED_LIST *fi_node = ( LINKED_LIST * )malloc( sizeof( LINKED_LIST ) );
-		fi_node->fi.entry_hash = thumbnail_cache_id;
-		fi_node->fi.index = index;	// Row index.
-		fi_node->fi.ei = NULL;
-		fi_node->next = NULL;
-
-		if ( dllrbt_insert( g_file_info_tree, ( void * )fi_node->fi.entry_hash, fi_node ) != DLLRBT_STATUS_OK )
+		// Only the first row with a given hash is mapped.
+		if ( hash_table_insert( g_file_info_table, thumbnail_cache_id, index ) == HASH_TABLE_STATUS_OK && join_hashes != NULL )
 		{
-			free( fi_node );
+			// Join the row to the entry while we're positioned on it.
+			unsigned int mapped_index = 0;
+			if ( hash_table_find( join_hashes, thumbnail_cache_id, &mapped_index ) &&
+				 JetRetrieveColumns( g_sesid, g_tableid_0A, g_rc_array, g_column_count ) == JET_errSuccess &&
+				 AddMappedInfo( &g_mapped, thumbnail_cache_id, g_source, &mapped_index ) )
+			{
+				ConvertValues( &g_mapped.info[ mapped_index ].ei );
+			}
 		}
 
 		// Move to the next record (column row).
@@ -178,9 +620,14 @@ CLEANUP:
 	HandleESEDBError();
 }
 
-// Tests the file's header to figure out whether it's an ESE or SQLite database.
-void TraverseDatabase( wchar_t *database_filepath )
+// Tests the header of a database in g_sources to figure out whether it's an ESE or SQLite database, and opens it.
+// If join_hashes is not NULL, then the information of those hashes is joined to g_mapped while the database is traversed.
+void OpenSource( unsigned int source, hash_table *join_hashes )
 {
+	wchar_t *database_filepath = g_sources[ source ].database_filepath;
+
+	g_source = source;
+
 	HANDLE hFile = CreateFile( database_filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
 	if ( hFile != INVALID_HANDLE_VALUE )
 	{
@@ -199,11 +646,11 @@ void TraverseDatabase( wchar_t *database_filepath )
 				{
 					g_database_type = 2;
 
-					TraverseSQLiteDatabase( database_filepath );
+					TraverseSQLiteDatabase( database_filepath, join_hashes );
 				}
 				else
 				{
-					printf( "The module sqlite3.dll failed to load.\nThe DLL can be downloaded from: www.sqlite.org\n" );
+					wprintf( L"The module sqlite3.dll failed to load.\nThe DLL can be downloaded from: www.sqlite.org\n" );
 				}
 			}
 			else if ( memcmp( partial_header + 4, "\xEF\xCD\xAB\x89", sizeof( unsigned long ) ) == 0 )	// Make sure we got enough of the header and it has the magic identifier (0x89ABCDEF) for an ESE database.
@@ -215,108 +662,183 @@ void TraverseDatabase( wchar_t *database_filepath )
 
 				g_database_type = 1;
 
-				TraverseESEDatabase( database_filepath, revision, page_size );
+				TraverseESEDatabase( database_filepath, revision, page_size, g_use_index, join_hashes );
 			}
 			else
 			{
-				printf( "The selected file is not an ESE or SQLite database.\n" );
+				wprintf( L"The selected file is not an ESE or SQLite database.\n" );
 			}
 		}
 		else
 		{
-			printf( "The selected file could not be read or is an invalid database.\n" );
+			wprintf( L"The selected file could not be read or is an invalid database.\n" );
 		}
 	}
 	else
 	{
-		printf( "The selected file could not be opened.\n" );
+		wprintf( L"The selected file could not be opened.\n" );
 	}
+
+	g_sources[ source ].database_type = g_database_type;
 }
 
-void MapHash( unsigned long long hash, bool output_html, HANDLE hFile_html )
+// Closes the open database. Its properties are kept since the information that was mapped from it refers to them.
+void CloseSource()
 {
-	FILE_INFO fi;
-	EXTENDED_INFO *ei = NULL;
+	MAPPED_SOURCE *ms = &g_sources[ g_source ];
 
 	if ( g_database_type == 1 )	// ESE Database
 	{
-		LINKED_LIST *ll = ( LINKED_LIST * )dllrbt_find( g_file_info_tree, ( void * )hash, true );
-		if ( ll != NULL )
+		COLUMN_INFO *ci = DetachColumnInfo();
+		if ( ci != NULL )
 		{
-			if ( ( g_err = JetMove( g_sesid, g_tableid_0A, JET_MoveFirst, JET_bitNil ) ) == JET_errSuccess )
+			// Keep the columns from the previous times that the database was opened after these.
+			COLUMN_INFO *last_ci = ci;
+			while ( last_ci->next != NULL )
 			{
-				if ( ( g_err = JetMove( g_sesid, g_tableid_0A, ll->fi.index, JET_bitNil ) ) == JET_errSuccess )
-				{
-					// Retrieve all the records associated with the matching System_ThumbnailCacheId.
-					if ( ( g_err = JetRetrieveColumns( g_sesid, g_tableid_0A, g_rc_array, g_column_count ) ) == JET_errSuccess )
-					{
-						ConvertValues( &ei );
-					}
-				}
+				last_ci = last_ci->next;
 			}
+
+			last_ci->next = ( COLUMN_INFO * )ms->columns;
+			ms->columns = ci;
 		}
+
+		CleanupESEDBInfo();
 	}
 	else if ( g_database_type == 2 )	// SQLite Database
 	{
-		// Hex value must be padded.
-		sprintf_s( g_query + 288, 512 - 288, "%016llx\') )", ntohll( hash ) );
+		DetachPropertyInfo( &ms->properties, &ms->property_count );
 
-		fi.ei = NULL;
-		fi.entry_hash = hash;
-		//fi.index = 0;	// Not used.
+		CleanupSQLiteInfo();
+	}
 
-		// Get all the values associated with the hash.
-		int sql_rc = sqlite3_exec( g_sql_db, g_query, CreatePropertyInfoCallback, ( void * )&fi, NULL/*&sql_err_msg*/ );
-		if ( sql_rc != SQLITE_OK )
+	g_database_type = 0;
+}
+
+// Traverses each Windows Search database in the list. The paths are separated by a NULL character and the list ends with an empty path.
+// If entry_hashes is not NULL, then the information of those hashes is joined from every database while it's traversed. We take ownership of it.
+// If use_index is true, then an ESE database's index is loaded or saved. See TraverseNativeESEDatabase().
+// Only the last database is left open. It's searched for any hash that wasn't collected.
+void TraverseDatabases( wchar_t *database_filepath_list, hash_table *entry_hashes, bool use_index )
+{
+	g_use_index = use_index;
+
+	unsigned int source_count = 0;
+	for ( wchar_t *database_filepath = database_filepath_list; database_filepath != NULL && *database_filepath != NULL; database_filepath += ( wcslen( database_filepath ) + 1 ) )
+	{
+		++source_count;
+	}
+
+	g_sources = ( MAPPED_SOURCE * )calloc( ( source_count > 0 ? source_count : 1 ), sizeof( MAPPED_SOURCE ) );
+	if ( g_sources == NULL || source_count == 0 )
+	{
+		hash_table_delete( entry_hashes );
+
+		return;
+	}
+
+	for ( wchar_t *database_filepath = database_filepath_list; g_source_count < source_count; database_filepath += ( wcslen( database_filepath ) + 1 ) )
+	{
+		MAPPED_SOURCE *ms = &g_sources[ g_source_count++ ];
+
+		// The current directory is changed to the output path before the databases are reopened, so we need the full path.
+		DWORD filepath_length = GetFullPathNameW( database_filepath, 0, NULL, NULL );
+		if ( filepath_length == 0 )
 		{
-			if ( fi.ei != NULL )
-			{
-				free( fi.ei->property_value );
-				free( fi.ei );
-				fi.ei = NULL;
-			}
+			continue;
+		}
+
+		ms->database_filepath = ( wchar_t * )malloc( sizeof( wchar_t ) * filepath_length );
+		if ( ms->database_filepath == NULL )
+		{
+			continue;
+		}
+
+		GetFullPathNameW( database_filepath, filepath_length, ms->database_filepath, NULL );
+
+		int utf8_length = WideCharToMultiByte( CP_UTF8, 0, ms->database_filepath, -1, NULL, 0, NULL, NULL );
+		ms->utf8_filepath = ( char * )malloc( sizeof( char ) * utf8_length ); // Size includes the null character.
+		if ( ms->utf8_filepath != NULL )
+		{
+			WideCharToMultiByte( CP_UTF8, 0, ms->database_filepath, -1, ms->utf8_filepath, utf8_length, NULL, NULL );
 		}
+	}
 
-		ei = fi.ei;
+	if ( entry_hashes != NULL )
+	{
+		g_mapped.table = hash_table_create( entry_hashes->count );
+		if ( g_mapped.table != NULL )
+		{
+			g_entry_hashes = entry_hashes;
+		}
+		else
+		{
+			hash_table_delete( entry_hashes );
+		}
 	}
 
-	if ( ei != NULL )
+	for ( unsigned int source = 0; source < g_source_count; ++source )
 	{
-		char buf[ 128 ];
-		int write_size = 0;
-		DWORD written = 0;
+		if ( g_sources[ source ].database_filepath == NULL )
+		{
+			continue;
+		}
+
+		CloseSource();
+
+		wprintf( L"Attempting to open the Windows Search database: %s\n", g_sources[ source ].database_filepath );
 
-		printf( "---------------------------------------------\n" );
-		printf( "Mapped Windows Search Information\n" );
-		printf( "---------------------------------------------\n" );
+		OpenSource( source, g_entry_hashes );
+
+		wprintf( L"\n" );
+	}
+}
 
-		if ( output_html )
+// Writes the Windows Search information of an entry hash from the database at source. html may be NULL.
+// The database is named if more than one was loaded.
+void WriteMappedInfo( unsigned long long hash, EXTENDED_INFO *ei, unsigned int source, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html )
+{
+	if ( ei != NULL )
+	{
+		bool named = ( g_source_count > 1 );
+
+		BufferPrintfW( console, L"---------------------------------------------\n" );
+		BufferPrintfW( console, L"Mapped Windows Search Information\n" );
+		if ( named )
 		{
-			write_size = sprintf_s( buf, 128, "<tr><td></td><td colspan=\"9\">Mapped Windows Search information for: %016llx</td></tr>", hash );
-			WriteFile( hFile_html, buf, write_size, &written, NULL );
+			BufferPrintfW( console, L"Source: %s\n", g_sources[ source ].database_filepath );
 		}
+		BufferPrintfW( console, L"---------------------------------------------\n" );
 
-		int mode = _setmode( _fileno( stdout ), _O_U16TEXT );	// For Unicode output.
+		if ( html != NULL )
+		{
+			if ( named && g_sources[ source ].utf8_filepath != NULL )
+			{
+				BufferPrintf( html, "<tr><td></td><td colspan=\"9\">Mapped Windows Search information for: %016llx from %s</td></tr>", hash, g_sources[ source ].utf8_filepath );
+			}
+			else
+			{
+				BufferPrintf( html, "<tr><td></td><td colspan=\"9\">Mapped Windows Search information for: %016llx</td></tr>", hash );
+			}
+		}
 
 		while ( ei != NULL )
 		{
-			EXTENDED_INFO *del_ei = ei;
-
 			if ( ei->property_value != NULL && ei->si != NULL )
 			{
 				wchar_t *property_name;
-				if ( g_database_type == 1 )
+				if ( g_sources[ source ].database_type == 1 )
 				{
 					property_name = ( ( COLUMN_INFO * )ei->si )->Name;
-					wprintf( L"%.*s: %s\n", ( ( COLUMN_INFO * )ei->si )->Name_byte_length, property_name, ei->property_value );
+					BufferPrintfW( console, L"%.*s: %s\n", ( ( COLUMN_INFO * )ei->si )->Name_byte_length, property_name, ei->property_value );
 				}
-				else// ( g_database_type == 2 )
+				else// ( g_sources[ source ].database_type == 2 )
 				{
 					property_name = ( ( SHARED_EXTENDED_INFO * )ei->si )->windows_property;
-					wprintf( L"%s: %s\n", property_name, ei->property_value );
+					BufferPrintfW( console, L"%s: %s\n", property_name, ei->property_value );
 				}
 
-				if ( output_html )
+				if ( html != NULL )
 				{
 					int nlength = WideCharToMultiByte( CP_UTF8, 0, property_name, -1, NULL, 0, NULL, NULL );
 					char *name = ( char * )malloc( sizeof( char ) * nlength ); // Size includes the null character.
@@ -326,11 +848,11 @@ void MapHash( unsigned long long hash, bool output_html, HANDLE hFile_html )
 					char *val = ( char * )malloc( sizeof( char ) * vlength ); // Size includes the null character.
 					vlength = WideCharToMultiByte( CP_UTF8, 0, ei->property_value, -1, val, vlength, NULL, NULL ) - 1;
 
-					WriteFile( hFile_html, "<tr><td></td><td>", 17, &written, NULL );
-					WriteFile( hFile_html, name, nlength, &written, NULL );
-					WriteFile( hFile_html, "</td><td colspan=\"8\"><pre>", 26, &written, NULL );
-					WriteFile( hFile_html, val, vlength, &written, NULL );
-					WriteFile( hFile_html, "</pre></td></tr>", 16, &written, NULL );
+					BufferWrite( html, "<tr><td></td><td>", 17 );
+					BufferWrite( html, name, nlength );
+					BufferWrite( html, "</td><td colspan=\"8\"><pre>", 26 );
+					BufferWrite( html, val, vlength );
+					BufferWrite( html, "</pre></td></tr>", 16 );
 
 					free( name );
 					free( val );
@@ -338,11 +860,101 @@ void MapHash( unsigned long long hash, bool output_html, HANDLE hFile_html )
 			}
 
 			ei = ei->next;
+		}
+	}
+}
+
+// Writes the information of the mapping at index and of every mapping that's linked to it.
+void WriteMappedList( MAPPED_LIST *ml, unsigned int index, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html )
+{
+	for ( ;; )
+	{
+		MAPPED_INFO *mi = &ml->info[ index ];
+
+		WriteMappedInfo( mi->hash, mi->ei, mi->source, console, html );
+
+		if ( mi->next == 0 )
+		{
+			break;
+		}
+
+		index = mi->next - 1;
+	}
+}
 
-			free( del_ei->property_value );
-			free( del_ei );
+// Writes any mapped Windows Search information to the console buffer, and to the HTML report buffer if html is not NULL.
+void MapHash( unsigned long long hash, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html )
+{
+	EXTENDED_INFO *ei = NULL;
+
+	// The collected hashes, including those of carved entries, were joined when each database was traversed.
+	if ( g_entry_hashes != NULL )
+	{
+		unsigned int index = 0;
+		if ( hash_table_find( g_mapped.table, hash, &index ) )
+		{
+			WriteMappedList( &g_mapped, index, console, html );
+
+			return;
 		}
 
-		_setmode( _fileno( stdout ), mode );	// Reset.
+		if ( hash_table_find( g_entry_hashes, hash, &index ) )
+		{
+			return;
+		}
 	}
+
+	// The database cursors and query buffer are shared by every thread.
+	EnterCriticalSection( &g_map_cs );
+
+	// Only the open database is searched.
+	unsigned int source = g_source;
+
+	if ( g_database_type == 1 )	// ESE Database
+	{
+		unsigned int index = 0;
+		if ( g_native_esedb )
+		{
+			if ( hash_table_find( g_file_info_table, hash, &index ) )
+			{
+				RetrieveNativeRow( index, &ei );
+			}
+		}
+		else if ( hash_table_find( g_file_info_table, hash, &index ) )
+		{
+			if ( ( g_err = JetMove( g_sesid, g_tableid_0A, JET_MoveFirst, JET_bitNil ) ) == JET_errSuccess )
+			{
+				if ( ( g_err = JetMove( g_sesid, g_tableid_0A, index, JET_bitNil ) ) == JET_errSuccess )
+				{
+					// Retrieve all the records associated with the matching System_ThumbnailCacheId.
+					if ( ( g_err = JetRetrieveColumns( g_sesid, g_tableid_0A, g_rc_array, g_column_count ) ) == JET_errSuccess )
+					{
+						ConvertValues( &ei );
+					}
+				}
+			}
+		}
+	}
+	else if ( g_database_type == 2 )	// SQLite Database
+	{
+		// The hash is stored in big-endian order.
+		unsigned long long value = ntohll( hash );
+
+		// Get all the values associated with the hash.
+		if ( g_hash_stmt != NULL && sqlite3_bind_blob( g_hash_stmt, 1, &value, sizeof( unsigned long long ), SQLITE_STATIC ) == SQLITE_OK )
+		{
+			while ( sqlite3_step( g_hash_stmt ) == SQLITE_ROW )
+			{
+				AddPropertyInfo( &ei, g_hash_stmt, 0 );
+			}
+
+			sqlite3_reset( g_hash_stmt );
+		}
+	}
+
+	LeaveCriticalSection( &g_map_cs );
+
+	WriteMappedInfo( hash, ei, source, console, html );
+
+	FreeExtendedInfo( ei );
 }
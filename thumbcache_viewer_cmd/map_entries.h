@@ -19,7 +19,47 @@
 #ifndef MAP_ENTRIES_H
 #define MAP_ENTRIES_H
 
-void TraverseDatabase( wchar_t *database_filepath );
-void MapHash( unsigned long long hash, bool output_html, HANDLE hFile_html );
+#include "globals.h"
+#include "hash_table.h"
+#include "read_sqlitedb.h"
+
+// Windows Search information that was joined to an entry hash.
+struct MAPPED_INFO
+{
+	unsigned long long hash;
+	EXTENDED_INFO *ei;
+	unsigned int source;	// The index of the database in g_sources that the information came from.
+	unsigned int next;		// One more than the index of the hash's information from another database. 0 if there's none.
+};
+
+// The Windows Search information of a set of entry hashes.
+struct MAPPED_LIST
+{
+	hash_table *table;		// Maps each entry hash to its index in info.
+	MAPPED_INFO *info;
+	unsigned int count;
+	unsigned int size;
+};
+
+// A Windows Search database that entry hashes are looked up in. Only one database is open at a time.
+struct MAPPED_SOURCE
+{
+	wchar_t *database_filepath;
+	char *utf8_filepath;					// For the HTML report.
+	void *columns;							// The columns (COLUMN_INFO) of an ESE database each time it was closed. The mapped information refers to them.
+	SHARED_EXTENDED_INFO **properties;		// The properties of a SQLite database each time it was closed. The mapped information refers to them.
+	unsigned int property_count;
+	unsigned char database_type;			// 0 = None, 1 = ESE, 2 = SQLite
+};
+
+extern CRITICAL_SECTION g_map_cs;
+
+void TraverseDatabases( wchar_t *database_filepath_list, hash_table *entry_hashes, bool use_index );
+void MapHash( unsigned long long hash, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html );
+void FreeExtendedInfo( EXTENDED_INFO *ei );
+void CleanupMappedInfo();
+
+bool SetPropertyProjection( const wchar_t *property_list );
+bool IsPropertyProjected( const wchar_t *name, unsigned long name_length );
 
 #endif
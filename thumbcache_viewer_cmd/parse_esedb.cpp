@@ -0,0 +1,1461 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parse_esedb.h"
+#include "search_index.h"
+#include "read_esedb.h"
+#include "map_entries.h"
+#include "utilities.h"
+
+#include <process.h>
+
+// The catalog's fixed columns in the order of their ids: ObjidTable, Type, Id, ColtypOrPgnoFDP, SpaceUsage, Flags, PagesOrLocale, RootFlag, RecordOffset, LCMapFlags, KeyMost, LVChunkMax
+static const unsigned short catalog_fixed_sizes[] = { 4, 2, 4, 4, 4, 4, 4, 1, 2, 4, 2, 4 };
+
+bool g_native_esedb = false;
+
+ESE_ROW *g_ese_rows = NULL;
+unsigned int g_ese_row_count = 0;
+
+HANDLE g_ese_hFile = INVALID_HANDLE_VALUE;
+DATABASE_MAP g_ese_map;			// Every reader shares this mapping.
+ESE_READER g_ese_lookup;		// Reads the rows of entries that weren't joined while the table was scanned. Guarded by g_map_cs.
+ESE_TABLE g_ese_table;			// SystemIndex_0A or SystemIndex_PropertyStore.
+
+ESE_FORMAT g_ese_format;
+
+SEARCH_INDEX *g_ese_index = NULL;					// The schema and rows that were loaded from the database's index. NULL if the catalog was read.
+SEARCH_INDEX_HEADER g_ese_index_header;				// Identifies the database that the index is saved for.
+SEARCH_INDEX_COLUMN *g_ese_index_columns = NULL;	// Every property of the database, including those that aren't projected.
+unsigned char *g_ese_index_names = NULL;
+wchar_t *g_ese_index_path = NULL;					// Set if the index is saved once the table has been scanned.
+
+// Makes sure that buffer can hold length bytes.
+bool ReserveBuffer( unsigned char **buffer, unsigned int *buffer_size, unsigned int length )
+{
+	if ( *buffer == NULL || length > *buffer_size )
+	{
+		unsigned int size = max( length, 256 );
+		unsigned char *realloc_buffer = ( unsigned char * )realloc( *buffer, sizeof( unsigned char ) * size );
+		if ( realloc_buffer == NULL )
+		{
+			return false;
+		}
+
+		*buffer = realloc_buffer;
+		*buffer_size = size;
+	}
+
+	return true;
+}
+
+bool AddPage( ESE_PAGE_LIST *list, unsigned int page_number )
+{
+	if ( list->count == list->size )
+	{
+		unsigned int size = ( list->size > 0 ? list->size * 2 : 256 );
+		unsigned int *realloc_pages = ( unsigned int * )realloc( list->pages, sizeof( unsigned int ) * size );
+		if ( realloc_pages == NULL )
+		{
+			return false;
+		}
+
+		list->pages = realloc_pages;
+		list->size = size;
+	}
+
+	list->pages[ list->count++ ] = page_number;
+
+	return true;
+}
+
+// Page numbers begin after the database header and its shadow copy.
+bool ReadPage( DATABASE_MAP *dm, unsigned int page_number, ESE_PAGE *page )
+{
+	unsigned char *data = GetMapView( dm, ( ( unsigned long long )page_number + 1 ) * g_ese_format.page_size, g_ese_format.page_size );
+
+	return ( data != NULL && ParsePage( &g_ese_format, data, page_number, page ) );
+}
+
+// Appends the leaf pages of the tree below page_number to leaves in the order of their keys.
+bool CollectLeafPages( DATABASE_MAP *dm, unsigned int page_number, unsigned int objid, unsigned int depth, ESE_PAGE_LIST *leaves )
+{
+	ESE_PAGE page;
+
+	// A corrupt tree could point back to one of its parents.
+	if ( depth > ESE_MAX_TREE_DEPTH || !ReadPage( dm, page_number, &page ) || page.objid != objid )
+	{
+		return false;
+	}
+
+	if ( page.flags & ESE_PAGE_FLAG_LEAF )
+	{
+		return AddPage( leaves, page_number );
+	}
+
+	if ( !( page.flags & ESE_PAGE_FLAG_PARENT ) )
+	{
+		return false;
+	}
+
+	// The page's view is replaced when its children are read. Get all of their page numbers first.
+	ESE_PAGE_LIST children;
+	memset( &children, 0, sizeof( ESE_PAGE_LIST ) );
+
+	bool ret = true;
+
+	for ( unsigned short tag = 1; tag < page.tag_count && ret; ++tag )
+	{
+		ESE_NODE node;
+		if ( GetPageNode( &page, tag, &node ) && !( node.flags & ESE_TAG_FLAG_DELETED ) && node.data_length >= sizeof( unsigned int ) )
+		{
+			ret = AddPage( &children, GetUInt( node.data ) );
+		}
+	}
+
+	for ( unsigned int i = 0; i < children.count && ret; ++i )
+	{
+		ret = CollectLeafPages( dm, children.pages[ i ], objid, depth + 1, leaves );
+	}
+
+	free( children.pages );
+
+	return ret;
+}
+
+// Moves to the next node of the leaf level, following the links between its pages.
+bool NextTreeNode( DATABASE_MAP *dm, ESE_PAGE *page, unsigned short *tag, ESE_NODE *node )
+{
+	for ( ;; )
+	{
+		while ( ++( *tag ) < page->tag_count )
+		{
+			if ( GetPageNode( page, *tag, node ) && !( node->flags & ESE_TAG_FLAG_DELETED ) )
+			{
+				return true;
+			}
+		}
+
+		unsigned int objid = page->objid;
+
+		if ( page->next_page == 0 || page->next_page == page->page_number ||
+			 !ReadPage( dm, page->next_page, page ) || page->objid != objid || !( page->flags & ESE_PAGE_FLAG_LEAF ) )
+		{
+			return false;
+		}
+
+		*tag = 0;
+	}
+}
+
+// Positions page and tag so that the next call to NextTreeNode returns the first node whose key is greater than or equal to key.
+bool SeekTree( DATABASE_MAP *dm, unsigned int root_page, unsigned int objid, const unsigned char *key, unsigned int key_length, ESE_PAGE *page, unsigned short *tag )
+{
+	unsigned int page_number = root_page;
+
+	for ( unsigned int depth = 0; depth <= ESE_MAX_TREE_DEPTH; ++depth )
+	{
+		if ( !ReadPage( dm, page_number, page ) || page->objid != objid )
+		{
+			return false;
+		}
+
+		ESE_NODE node;
+
+		if ( page->flags & ESE_PAGE_FLAG_LEAF )
+		{
+			for ( unsigned short i = 1; i < page->tag_count; ++i )
+			{
+				if ( GetPageNode( page, i, &node ) && !( node.flags & ESE_TAG_FLAG_DELETED ) && CompareNodeKey( &node, key, key_length ) >= 0 )
+				{
+					*tag = i - 1;
+
+					return true;
+				}
+			}
+
+			// Every key in the page is less than key. The node is at the beginning of the next page.
+			*tag = ( page->tag_count > 0 ? page->tag_count - 1 : 0 );
+
+			return true;
+		}
+
+		if ( !( page->flags & ESE_PAGE_FLAG_PARENT ) )
+		{
+			return false;
+		}
+
+		// Each node's key separates its child from the next. The last node's key is empty and it holds everything else.
+		// If a separator equals key, then key may be at the beginning of the next child, but NextTreeNode will move there.
+		page_number = 0;
+
+		for ( unsigned short i = 1; i < page->tag_count; ++i )
+		{
+			if ( GetPageNode( page, i, &node ) && !( node.flags & ESE_TAG_FLAG_DELETED ) && node.data_length >= sizeof( unsigned int ) )
+			{
+				page_number = GetUInt( node.data );
+
+				if ( ( node.prefix_length + node.key_length ) == 0 || CompareNodeKey( &node, key, key_length ) >= 0 )
+				{
+					break;
+				}
+			}
+		}
+
+		if ( page_number == 0 )
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+// Decompresses a value into buffer.
+bool DecompressValue( const unsigned char *data, unsigned int data_length, unsigned char **buffer, unsigned int *buffer_size, unsigned char **value, unsigned int *value_length )
+{
+	unsigned int length = GetDecompressedLength( data, data_length );
+
+	if ( length == 0 || !ReserveBuffer( buffer, buffer_size, length ) || !DecompressData( data, data_length, *buffer, length ) )
+	{
+		return false;
+	}
+
+	*value = *buffer;
+	*value_length = length;
+
+	return true;
+}
+
+// Reads a separated long value into buffer. lid is the long value id as it's stored in the record.
+// The chunks of a compressed long value are decompressed one at a time. The value's size and the chunks' offsets are of the uncompressed data.
+bool ReadLongValue( ESE_READER *r, ESE_TABLE *table, const unsigned char *lid, unsigned int lid_length, bool compressed, unsigned char **buffer, unsigned int *buffer_size, unsigned char **value, unsigned int *value_length )
+{
+	if ( table->lv_root_page == 0 || ( lid_length != 4 && lid_length != 8 ) )
+	{
+		return false;
+	}
+
+	// The keys of the long value tree have the id in big-endian order. The first node of a long value is followed by its chunks, whose keys end with their offset.
+	unsigned char key[ 8 ];
+	for ( unsigned int i = 0; i < lid_length; ++i )
+	{
+		key[ i ] = lid[ lid_length - 1 - i ];
+	}
+
+	ESE_PAGE page;
+	ESE_NODE node;
+	unsigned short tag = 0;
+
+	// The first node has the reference count and the size of the value.
+	if ( !SeekTree( &r->lv_dm, table->lv_root_page, table->lv_objid, key, lid_length, &page, &tag ) ||
+		 !NextTreeNode( &r->lv_dm, &page, &tag, &node ) ||
+		 CompareNodeKey( &node, key, lid_length ) != 0 ||
+		 node.data_length < 8 )
+	{
+		return false;
+	}
+
+	unsigned int size = GetUInt( node.data + 4 );
+	if ( size == 0 || size > ESE_MAX_LONG_VALUE_SIZE || !ReserveBuffer( buffer, buffer_size, size ) )
+	{
+		return false;
+	}
+
+	unsigned int length = 0;
+
+	// A compressed chunk's length is the difference between its offset and the next chunk's, so it's held until the next chunk is found.
+	unsigned int held_length = 0;
+	bool held = false;
+
+	while ( length < size && NextTreeNode( &r->lv_dm, &page, &tag, &node ) )
+	{
+		if ( ( node.prefix_length + node.key_length ) != lid_length + 4 || CompareNodeKey( &node, key, lid_length ) <= 0 )
+		{
+			break;
+		}
+
+		// Make sure the chunk belongs to the value and that it's the next one.
+		unsigned int offset = 0;
+		bool same_lid = true;
+
+		for ( unsigned int i = 0; i < lid_length; ++i )
+		{
+			if ( GetNodeKeyByte( &node, i ) != key[ i ] )
+			{
+				same_lid = false;
+				break;
+			}
+		}
+
+		for ( unsigned int i = lid_length; i < lid_length + 4; ++i )
+		{
+			offset = ( offset << 8 ) | GetNodeKeyByte( &node, i );
+		}
+
+		if ( !same_lid )
+		{
+			break;
+		}
+
+		if ( compressed )
+		{
+			if ( held )
+			{
+				held = false;
+
+				if ( offset <= length || offset > size || !ExpandLongValueChunk( r->chunk, held_length, *buffer + length, offset - length ) )
+				{
+					break;
+				}
+
+				length = offset;
+			}
+			else if ( offset != length )
+			{
+				break;
+			}
+
+			// The chunk's page can be replaced when the next chunk is read.
+			if ( !ReserveBuffer( &r->chunk, &r->chunk_size, node.data_length ) )
+			{
+				break;
+			}
+
+			memcpy_s( r->chunk, r->chunk_size, node.data, node.data_length );
+			held_length = node.data_length;
+			held = true;
+		}
+		else
+		{
+			if ( offset != length )
+			{
+				break;
+			}
+
+			unsigned int chunk_length = min( node.data_length, size - length );
+			memcpy_s( *buffer + length, *buffer_size - length, node.data, chunk_length );
+			length += chunk_length;
+		}
+	}
+
+	// The last chunk ends with the value.
+	if ( held && ExpandLongValueChunk( r->chunk, held_length, *buffer + length, size - length ) )
+	{
+		length = size;
+	}
+
+	if ( length != size )
+	{
+		return false;
+	}
+
+	*value = *buffer;
+	*value_length = length;
+
+	return true;
+}
+
+// Gets the value of a column in a record. Values that are compressed or stored in the long value tree are read into buffer.
+// Only the first value of a multi-valued column is retrieved, as JetRetrieveColumns does with an itagSequence of 1.
+bool ReadColumnValue( ESE_READER *r, ESE_TABLE *table, unsigned char *record, unsigned int record_length, unsigned int column_id, unsigned char **buffer, unsigned int *buffer_size, unsigned char **value, unsigned int *value_length )
+{
+	unsigned char *data = NULL;
+	unsigned int data_length = 0;
+	unsigned char flags = 0;
+
+	if ( !GetRecordValue( &g_ese_format, table, record, record_length, column_id, &data, &data_length, &flags ) )
+	{
+		return false;
+	}
+
+	bool separated = ( flags & ESE_VALUE_FLAG_SEPARATED ? true : false );
+
+	if ( flags & ESE_VALUE_FLAG_TWO_VALUES )
+	{
+		// The first byte is the length of the first value.
+		if ( data_length < 1 || data[ 0 ] > data_length - 1 )
+		{
+			return false;
+		}
+
+		data_length = data[ 0 ];
+		++data;
+	}
+	else if ( flags & ESE_VALUE_FLAG_MULTI_VALUES )
+	{
+		// The values begin with an array of their offsets. The high bit of an offset is set if its value is separated.
+		if ( data_length < 2 )
+		{
+			return false;
+		}
+
+		unsigned int first = GetUShort( data );
+		unsigned int start = first & 0x7FFF;
+		unsigned int end = ( start >= 4 ? GetUShort( data + 2 ) & 0x7FFF : data_length );
+		if ( start < 2 || start > end || end > data_length )
+		{
+			return false;
+		}
+
+		separated = ( first & 0x8000 ? true : false );
+		data += start;
+		data_length = end - start;
+	}
+
+	if ( separated )
+	{
+		return ReadLongValue( r, table, data, data_length, ( flags & ESE_VALUE_FLAG_COMPRESSED ? true : false ), buffer, buffer_size, value, value_length );
+	}
+	else if ( flags & ESE_VALUE_FLAG_COMPRESSED )
+	{
+		return DecompressValue( data, data_length, buffer, buffer_size, value, value_length );
+	}
+
+	*value = data;
+	*value_length = data_length;
+
+	return true;
+}
+
+// Sets the values of the reader's columns to those in the record. The values are only valid until the reader's next record.
+void DecodeRecord( ESE_READER *r, unsigned char *record, unsigned int record_length )
+{
+	COLUMN_INFO *t_ci = g_ci;
+
+	for ( unsigned long i = 0; i < g_column_count && t_ci != NULL; ++i, t_ci = t_ci->next )
+	{
+		unsigned char *value = NULL;
+		unsigned int value_length = 0;
+
+		// A column that wasn't found in the table has an id of 0.
+		if ( t_ci->column_id == 0 || !ReadColumnValue( r, &g_ese_table, record, record_length, t_ci->column_id, &r->buffers[ i ], &r->buffer_sizes[ i ], &value, &value_length ) )
+		{
+			value = NULL;
+			value_length = 0;
+		}
+
+		r->column_data[ i ] = value;
+		r->column_length[ i ] = value_length;
+	}
+}
+
+bool InitializeReader( ESE_READER *r )
+{
+	memset( r, 0, sizeof( ESE_READER ) );
+
+	ShareDatabaseMap( &g_ese_map, &r->dm );
+	ShareDatabaseMap( &g_ese_map, &r->lv_dm );
+
+	if ( g_column_count > 0 )
+	{
+		r->column_data = ( unsigned char ** )calloc( g_column_count, sizeof( unsigned char * ) );
+		r->column_length = ( unsigned long * )calloc( g_column_count, sizeof( unsigned long ) );
+		r->buffers = ( unsigned char ** )calloc( g_column_count, sizeof( unsigned char * ) );
+		r->buffer_sizes = ( unsigned int * )calloc( g_column_count, sizeof( unsigned int ) );
+
+		if ( r->column_data == NULL || r->column_length == NULL || r->buffers == NULL || r->buffer_sizes == NULL )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CleanupReader( ESE_READER *r )
+{
+	// The readers don't own the mapping.
+	CloseDatabaseView( &r->dm );
+	CloseDatabaseView( &r->lv_dm );
+
+	if ( r->buffers != NULL )
+	{
+		for ( unsigned long i = 0; i < g_column_count; ++i )
+		{
+			free( r->buffers[ i ] );
+		}
+	}
+
+	free( r->column_data );
+	free( r->column_length );
+	free( r->buffers );
+	free( r->buffer_sizes );
+	free( r->buffer );
+	free( r->chunk );
+
+	FreeBuffer( &r->values );
+
+	memset( r, 0, sizeof( ESE_READER ) );
+}
+
+unsigned short GetFixedColumnSize( unsigned int column_type, unsigned int space_usage )
+{
+	unsigned short size = ( unsigned short )space_usage;
+
+	switch ( column_type )
+	{
+		case JET_coltypBit:
+		case JET_coltypUnsignedByte:
+		{
+			size = 1;
+		}
+		break;
+
+		case JET_coltypShort:
+		case JET_coltypUnsignedShort:
+		{
+			size = 2;
+		}
+		break;
+
+		case JET_coltypLong:
+		case JET_coltypUnsignedLong:
+		case JET_coltypIEEESingle:
+		{
+			size = 4;
+		}
+		break;
+
+		case JET_coltypCurrency:
+		case JET_coltypIEEEDouble:
+		case JET_coltypDateTime:
+		case JET_coltypLongLong:
+		{
+			size = 8;
+		}
+		break;
+
+		case JET_coltypGUID:
+		{
+			size = 16;
+		}
+		break;
+	}
+
+	return size;
+}
+
+// The catalog (MSysObjects) has a record for every table, column, index, and long value tree.
+// entries is freed with FreeCatalog().
+bool LoadCatalog( ESE_READER *r, ESE_CATALOG_ENTRY **entries, unsigned int *entry_count )
+{
+	ESE_TABLE catalog;
+	memset( &catalog, 0, sizeof( ESE_TABLE ) );
+	catalog.objid = ESE_CATALOG_OBJID;
+	catalog.root_page = ESE_CATALOG_ROOT_PAGE;
+
+	for ( unsigned int i = 0; i < sizeof( catalog_fixed_sizes ) / sizeof( catalog_fixed_sizes[ 0 ] ); ++i )
+	{
+		catalog.fixed_size[ i + 1 ] = catalog_fixed_sizes[ i ];
+	}
+
+	SetFixedColumnOffsets( &catalog );
+
+	ESE_PAGE_LIST leaves;
+	memset( &leaves, 0, sizeof( ESE_PAGE_LIST ) );
+
+	*entries = NULL;
+	*entry_count = 0;
+	unsigned int entry_size = 0;
+
+	bool ret = CollectLeafPages( &r->dm, catalog.root_page, catalog.objid, 0, &leaves );
+
+	for ( unsigned int i = 0; i < leaves.count && ret; ++i )
+	{
+		ESE_PAGE page;
+		if ( !ReadPage( &r->dm, leaves.pages[ i ], &page ) )
+		{
+			ret = false;
+			break;
+		}
+
+		for ( unsigned short tag = 1; tag < page.tag_count; ++tag )
+		{
+			ESE_NODE node;
+			if ( !GetPageNode( &page, tag, &node ) || ( node.flags & ESE_TAG_FLAG_DELETED ) )
+			{
+				continue;
+			}
+
+			unsigned char *name = NULL;
+			unsigned int name_length = 0;
+			unsigned char flags = 0;
+
+			if ( !GetRecordValue( &g_ese_format, &catalog, node.data, node.data_length, ESE_CATALOG_COLUMN_NAME, &name, &name_length, &flags ) )
+			{
+				continue;
+			}
+
+			if ( *entry_count == entry_size )
+			{
+				unsigned int size = ( entry_size > 0 ? entry_size * 2 : 1024 );
+				ESE_CATALOG_ENTRY *realloc_entries = ( ESE_CATALOG_ENTRY * )realloc( *entries, sizeof( ESE_CATALOG_ENTRY ) * size );
+				if ( realloc_entries == NULL )
+				{
+					ret = false;
+					break;
+				}
+
+				*entries = realloc_entries;
+				entry_size = size;
+			}
+
+			ESE_CATALOG_ENTRY *entry = &( *entries )[ *entry_count ];
+
+			entry->name = ( char * )malloc( sizeof( char ) * ( name_length + 1 ) );
+			if ( entry->name == NULL )
+			{
+				ret = false;
+				break;
+			}
+
+			memcpy_s( entry->name, name_length + 1, name, name_length );
+			entry->name[ name_length ] = 0;	// Sanity.
+
+			entry->objid_table = GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 1 );
+			entry->type = ( unsigned short )GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 2 );
+			entry->id = GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 3 );
+			entry->coltyp_or_pgno = GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 4 );
+			entry->space_usage = GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 5 );
+			entry->codepage = GetRecordUInt( &g_ese_format, &catalog, node.data, node.data_length, 7 );
+
+			++( *entry_count );
+		}
+	}
+
+	free( leaves.pages );
+
+	return ret;
+}
+
+void FreeCatalog( ESE_CATALOG_ENTRY *entries, unsigned int entry_count )
+{
+	for ( unsigned int i = 0; i < entry_count; ++i )
+	{
+		free( entries[ i ].name );
+	}
+
+	free( entries );
+}
+
+ESE_CATALOG_ENTRY *FindColumn( ESE_CATALOG_ENTRY *entries, unsigned int entry_count, unsigned int objid, const char *name )
+{
+	for ( unsigned int i = 0; i < entry_count; ++i )
+	{
+		if ( entries[ i ].type == ESE_CATALOG_TYPE_COLUMN && entries[ i ].objid_table == objid && _stricmp( entries[ i ].name, name ) == 0 )
+		{
+			return &entries[ i ];
+		}
+	}
+
+	return NULL;
+}
+
+// Sets the location of a table and the layout of its records.
+bool LoadTable( ESE_CATALOG_ENTRY *entries, unsigned int entry_count, const char *name, ESE_TABLE *table )
+{
+	memset( table, 0, sizeof( ESE_TABLE ) );
+
+	for ( unsigned int i = 0; i < entry_count; ++i )
+	{
+		if ( entries[ i ].type == ESE_CATALOG_TYPE_TABLE && _stricmp( entries[ i ].name, name ) == 0 )
+		{
+			table->objid = entries[ i ].id;
+			table->root_page = entries[ i ].coltyp_or_pgno;
+			break;
+		}
+	}
+
+	if ( table->root_page == 0 )
+	{
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < entry_count; ++i )
+	{
+		if ( entries[ i ].objid_table != table->objid )
+		{
+			continue;
+		}
+
+		if ( entries[ i ].type == ESE_CATALOG_TYPE_LONG_VALUE )
+		{
+			table->lv_objid = entries[ i ].id;
+			table->lv_root_page = entries[ i ].coltyp_or_pgno;
+		}
+		else if ( entries[ i ].type == ESE_CATALOG_TYPE_COLUMN && entries[ i ].id > 0 && entries[ i ].id <= ESE_MAX_FIXED_COLUMN )
+		{
+			table->fixed_size[ entries[ i ].id ] = GetFixedColumnSize( entries[ i ].coltyp_or_pgno, entries[ i ].space_usage );
+		}
+	}
+
+	SetFixedColumnOffsets( table );
+
+	return true;
+}
+
+// Adds a Windows Property to the end of g_ci. column is NULL if the property's column wasn't found.
+COLUMN_INFO *AddColumnInfo( COLUMN_INFO **last_ci, wchar_t *name, unsigned long name_byte_length, ESE_CATALOG_ENTRY *column, VARENUM type, bool jet_compress )
+{
+	COLUMN_INFO *ci = ( COLUMN_INFO * )malloc( sizeof( COLUMN_INFO ) );
+	if ( ci == NULL )
+	{
+		free( name );
+		return NULL;
+	}
+
+	ci->Name = name;
+	ci->Name_byte_length = name_byte_length;
+	ci->Type = type;
+	ci->JetCompress = jet_compress;
+	ci->data = NULL;
+	ci->next = NULL;
+
+	if ( column != NULL )
+	{
+		ci->column_type = column->coltyp_or_pgno;
+		ci->column_id = column->id;
+		ci->max_size = ( column->id <= ESE_MAX_FIXED_COLUMN ? GetFixedColumnSize( column->coltyp_or_pgno, column->space_usage ) : column->space_usage );
+	}
+	else
+	{
+		ci->column_type = 0;
+		ci->column_id = 0;
+		ci->max_size = 0;
+	}
+
+	if ( *last_ci != NULL )
+	{
+		( *last_ci )->next = ci;
+	}
+	else
+	{
+		g_ci = ci;
+	}
+
+	*last_ci = ci;
+
+	++g_column_count;
+
+	return ci;
+}
+
+// Handles Windows Vista and Windows 7 databases. See GetColumnInfo().
+bool LoadColumnInfo( ESE_READER *r, ESE_CATALOG_ENTRY *entries, unsigned int entry_count )
+{
+	ESE_TABLE property_list;	// SystemIndex_0P
+
+	if ( !LoadTable( entries, entry_count, "SystemIndex_0P", &property_list ) ||
+		 !LoadTable( entries, entry_count, "SystemIndex_0A", &g_ese_table ) )
+	{
+		return false;
+	}
+
+	ESE_CATALOG_ENTRY *name_column = FindColumn( entries, entry_count, property_list.objid, "Name" );
+	ESE_CATALOG_ENTRY *type_column = FindColumn( entries, entry_count, property_list.objid, "Type" );
+	ESE_CATALOG_ENTRY *jet_compress_column = FindColumn( entries, entry_count, property_list.objid, "JetCompress" );
+
+	if ( name_column == NULL || type_column == NULL || jet_compress_column == NULL )
+	{
+		return false;
+	}
+
+	COLUMN_INFO *last_ci = NULL;
+
+	// The DocID column isn't listed in SystemIndex_0P.
+	ESE_CATALOG_ENTRY *doc_id_column = FindColumn( entries, entry_count, g_ese_table.objid, "DocID" );
+	if ( doc_id_column != NULL )
+	{
+		AddColumnInfo( &last_ci, _wcsdup( L"DocID" ), 10, doc_id_column, VT_I4, false );
+	}
+
+	ESE_PAGE_LIST leaves;
+	memset( &leaves, 0, sizeof( ESE_PAGE_LIST ) );
+
+	bool ret = CollectLeafPages( &r->dm, property_list.root_page, property_list.objid, 0, &leaves );
+
+	for ( unsigned int i = 0; i < leaves.count && ret; ++i )
+	{
+		ESE_PAGE page;
+		if ( !ReadPage( &r->dm, leaves.pages[ i ], &page ) )
+		{
+			ret = false;
+			break;
+		}
+
+		for ( unsigned short tag = 1; tag < page.tag_count; ++tag )
+		{
+			ESE_NODE node;
+			if ( !GetPageNode( &page, tag, &node ) || ( node.flags & ESE_TAG_FLAG_DELETED ) )
+			{
+				continue;
+			}
+
+			unsigned char *value = NULL;
+			unsigned int value_length = 0;
+
+			if ( !ReadColumnValue( r, &property_list, node.data, node.data_length, name_column->id, &r->buffer, &r->buffer_size, &value, &value_length ) )
+			{
+				continue;
+			}
+
+			// The name should be an unterminated Unicode string. Add L"\0" to the end.
+			unsigned char *name = ( unsigned char * )malloc( sizeof( char ) * ( value_length + 2 ) );
+			if ( name == NULL )
+			{
+				ret = false;
+				break;
+			}
+
+			memcpy_s( name, value_length + 2, value, value_length );
+			name[ value_length ] = 0;
+			name[ value_length + 1 ] = 0;
+
+			VARENUM type = ( VARENUM )GetRecordUInt( &g_ese_format, &property_list, node.data, node.data_length, type_column->id );
+			bool jet_compress = ( GetRecordUInt( &g_ese_format, &property_list, node.data, node.data_length, jet_compress_column->id ) != 0 ? true : false );
+
+			char *column_name = GetColumnName( ( wchar_t * )name, value_length );	// Converts the column name into a char string and replaces all '.' with '_'.
+			ESE_CATALOG_ENTRY *column = FindColumn( entries, entry_count, g_ese_table.objid, column_name );
+			free( column_name );
+
+			COLUMN_INFO *ci = AddColumnInfo( &last_ci, ( wchar_t * )name, value_length, column, type, jet_compress );
+			if ( ci == NULL )
+			{
+				ret = false;
+				break;
+			}
+
+			if ( ci->Name_byte_length == 46 && wcscmp( ci->Name, L"System_ThumbnailCacheId" ) == 0 )
+			{
+				g_thumbnail_cache_id = ci;
+			}
+		}
+	}
+
+	free( leaves.pages );
+
+	return ret;
+}
+
+// Handles Windows 8+ databases. See GetColumnInfoWin8().
+bool LoadColumnInfoWin8( ESE_CATALOG_ENTRY *entries, unsigned int entry_count )
+{
+	if ( !LoadTable( entries, entry_count, "SystemIndex_PropertyStore", &g_ese_table ) )
+	{
+		return false;
+	}
+
+	COLUMN_INFO *last_ci = NULL;
+
+	for ( unsigned int i = 0; i < entry_count; ++i )
+	{
+		if ( entries[ i ].type != ESE_CATALOG_TYPE_COLUMN || entries[ i ].objid_table != g_ese_table.objid )
+		{
+			continue;
+		}
+
+		// Windows 8+ columns have a hex number followed by a '-' separating the Windows Property.
+		char *prop_name = strchr( entries[ i ].name, '-' );
+		if ( prop_name == NULL )
+		{
+			prop_name = entries[ i ].name;
+		}
+		else
+		{
+			++prop_name;
+		}
+
+		// Convert the ASCII name to a wide char string.
+		int val_length = MultiByteToWideChar( CP_UTF8, 0, prop_name, -1, NULL, 0 );	// Include the NULL terminator.
+		wchar_t *val = ( wchar_t * )malloc( sizeof( wchar_t ) * val_length );
+		if ( val == NULL )
+		{
+			return false;
+		}
+
+		MultiByteToWideChar( CP_UTF8, 0, prop_name, -1, val, val_length );
+
+		COLUMN_INFO *ci = AddColumnInfo( &last_ci, val, ( val_length - 1 ) * sizeof( wchar_t ), &entries[ i ], VT_EMPTY, false );
+		if ( ci == NULL )
+		{
+			return false;
+		}
+
+		// There's no data type information in Windows 8+ databases, so we'll make a guess based on the column type and data size.
+		if ( ci->column_type == JET_coltypBinary && ci->max_size == sizeof( unsigned long long ) )
+		{
+			ci->Type = VT_FILETIME;
+		}
+		else if ( ci->column_type == JET_coltypBit && ci->max_size == sizeof( unsigned char ) )
+		{
+			ci->Type = VT_BOOL;
+		}
+
+		if ( ci->Name_byte_length == 46 && wcscmp( ci->Name, L"System_ThumbnailCacheId" ) == 0 )
+		{
+			ci->Type = VT_EMPTY;	// Reset the data type.
+			g_thumbnail_cache_id = ci;
+		}
+		else if ( ( ci->Name_byte_length == 22 && wcscmp( ci->Name, L"System_Size" ) == 0 ) ||
+				  ( ci->Name_byte_length == 42 && wcscmp( ci->Name, L"System_Media_Duration" ) == 0 ) ||
+				  ( ci->Name_byte_length == 64 && wcscmp( ci->Name, L"System_Document_TotalEditingTime" ) == 0 ) ||
+				  ( ci->Name_byte_length == 28 && wcscmp( ci->Name, L"System_FileFRN" ) == 0 ) )
+		{
+			ci->Type = VT_EMPTY;	// Reset the data type.
+		}
+	}
+
+	return true;
+}
+
+// Builds g_ci and the layout of the property table from the database's index instead of its catalog.
+bool LoadIndexColumnInfo( SEARCH_INDEX *index )
+{
+	g_ese_table = index->header->table;
+
+	COLUMN_INFO *last_ci = NULL;
+
+	for ( unsigned int i = 0; i < index->header->column_count; ++i )
+	{
+		SEARCH_INDEX_COLUMN *column = &index->columns[ i ];
+
+		wchar_t *name = ( wchar_t * )malloc( column->name_length + sizeof( wchar_t ) );
+		if ( name == NULL )
+		{
+			return false;
+		}
+
+		memcpy_s( name, column->name_length + sizeof( wchar_t ), index->names + column->name_offset, column->name_length );
+		name[ column->name_length / sizeof( wchar_t ) ] = 0;	// Sanity.
+
+		COLUMN_INFO *ci = AddColumnInfo( &last_ci, name, column->name_length, NULL, ( VARENUM )column->type, ( column->jet_compress != 0 ? true : false ) );
+		if ( ci == NULL )
+		{
+			return false;
+		}
+
+		ci->column_type = column->column_type;
+		ci->column_id = column->column_id;
+		ci->max_size = column->max_size;
+
+		if ( ci->Name_byte_length == 46 && wcscmp( ci->Name, L"System_ThumbnailCacheId" ) == 0 )
+		{
+			g_thumbnail_cache_id = ci;
+		}
+	}
+
+	return true;
+}
+
+// Copies every property in g_ci so that they can be saved to the database's index. Must be called before ProjectColumns().
+bool CopyIndexColumns()
+{
+	unsigned int name_size = 0;
+	for ( COLUMN_INFO *ci = g_ci; ci != NULL; ci = ci->next )
+	{
+		name_size += ci->Name_byte_length;
+	}
+
+	g_ese_index_columns = ( SEARCH_INDEX_COLUMN * )malloc( sizeof( SEARCH_INDEX_COLUMN ) * ( g_column_count > 0 ? g_column_count : 1 ) );
+	g_ese_index_names = ( unsigned char * )malloc( sizeof( unsigned char ) * ( name_size > 0 ? name_size : 1 ) );
+	if ( g_ese_index_columns == NULL || g_ese_index_names == NULL )
+	{
+		return false;
+	}
+
+	unsigned int column_count = 0;
+	unsigned int name_offset = 0;
+
+	for ( COLUMN_INFO *ci = g_ci; ci != NULL && column_count < g_column_count; ci = ci->next )
+	{
+		SEARCH_INDEX_COLUMN *column = &g_ese_index_columns[ column_count++ ];
+
+		memset( column, 0, sizeof( SEARCH_INDEX_COLUMN ) );
+		column->name_offset = name_offset;
+		column->name_length = ci->Name_byte_length;
+		column->column_type = ci->column_type;
+		column->column_id = ci->column_id;
+		column->max_size = ci->max_size;
+		column->type = ( unsigned short )ci->Type;
+		column->jet_compress = ( ci->JetCompress ? 1 : 0 );
+
+		memcpy_s( g_ese_index_names + name_offset, name_size - name_offset, ci->Name, ci->Name_byte_length );
+		name_offset += ci->Name_byte_length;
+	}
+
+	g_ese_index_header.column_count = column_count;
+	g_ese_index_header.name_size = name_offset;
+
+	return true;
+}
+
+// Saves the schema and the rows of g_ese_rows to the database's index. The rows are kept in the order of the table.
+void SaveNativeIndex()
+{
+	SEARCH_INDEX_ROW *rows = ( SEARCH_INDEX_ROW * )malloc( sizeof( SEARCH_INDEX_ROW ) * ( g_ese_row_count > 0 ? g_ese_row_count : 1 ) );
+	if ( rows != NULL )
+	{
+		for ( unsigned int i = 0; i < g_ese_row_count; ++i )
+		{
+			rows[ i ].hash = g_ese_rows[ i ].hash;
+			rows[ i ].page_number = g_ese_rows[ i ].page_number;
+			rows[ i ].tag = g_ese_rows[ i ].tag;
+			rows[ i ].reserved = 0;
+		}
+
+		g_ese_index_header.row_count = g_ese_row_count;
+		g_ese_index_header.table = g_ese_table;
+
+		SaveSearchIndex( g_ese_index_path, &g_ese_index_header, g_ese_index_columns, rows, g_ese_index_names );
+
+		free( rows );
+	}
+}
+
+// Frees everything that was kept to load or save the database's index.
+void FreeNativeIndex()
+{
+	FreeSearchIndex( g_ese_index );
+	g_ese_index = NULL;
+
+	free( g_ese_index_columns );
+	g_ese_index_columns = NULL;
+
+	free( g_ese_index_names );
+	g_ese_index_names = NULL;
+
+	free( g_ese_index_path );
+	g_ese_index_path = NULL;
+}
+
+// Reads the catalog and builds g_ci without the Microsoft Jet Database Engine.
+// If use_index is true, then the schema is loaded from the database's index if it hasn't changed since the index was saved. Otherwise, the index is saved after the table is scanned.
+// Returns false if the database isn't one that we can read. Everything is freed in CleanupNativeESEDatabase().
+bool OpenNativeESEDatabase( wchar_t *database_filepath, unsigned long revision, unsigned long page_size, bool use_index )
+{
+	if ( !SetESEFormat( &g_ese_format, revision, page_size ) )
+	{
+		return false;
+	}
+
+	g_revision = revision;
+
+	// Vista and 8+ use little-endian
+	g_use_big_endian = ( g_revision == 0x0C || g_revision >= 0x14 ? false : true );
+
+
+	g_ese_hFile = CreateFile( database_filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( g_ese_hFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	if ( !OpenDatabaseMap( g_ese_hFile, &g_ese_map, false ) || g_ese_map.hMapping == NULL )
+	{
+		CleanupNativeESEDatabase();
+		return false;
+	}
+
+	bool ret = false;
+
+	if ( use_index && GetSearchIndexKey( g_ese_hFile, revision, page_size, &g_ese_index_header ) )
+	{
+		g_ese_index = LoadSearchIndex( database_filepath, &g_ese_index_header );
+		if ( g_ese_index != NULL )
+		{
+			ret = LoadIndexColumnInfo( g_ese_index );
+		}
+		else
+		{
+			g_ese_index_path = _wcsdup( database_filepath );
+		}
+	}
+
+	if ( g_ese_index == NULL )
+	{
+		ESE_CATALOG_ENTRY *entries = NULL;
+		unsigned int entry_count = 0;
+
+		// g_ci is empty, so this reader only reads the catalog and the list of properties.
+		ESE_READER r;
+		ret = InitializeReader( &r ) && LoadCatalog( &r, &entries, &entry_count );
+
+		if ( ret )
+		{
+			ret = ( g_revision < 0x14 ? LoadColumnInfo( &r, entries, entry_count ) : LoadColumnInfoWin8( entries, entry_count ) );
+		}
+
+		CleanupReader( &r );
+		FreeCatalog( entries, entry_count );
+
+		// The index is only saved if every property could be copied.
+		if ( ret && g_ese_index_path != NULL && !CopyIndexColumns() )
+		{
+			FreeNativeIndex();
+		}
+	}
+
+	// Only the projected properties are read.
+	if ( ret )
+	{
+		ProjectColumns();
+	}
+
+	// Ensure that the values we retrieve are of the correct size.
+	if ( !ret || g_thumbnail_cache_id == NULL || g_thumbnail_cache_id->max_size != sizeof( unsigned long long ) || !InitializeReader( &g_ese_lookup ) )
+	{
+		// Frees g_ci so that the Microsoft Jet Database Engine can build it.
+		CleanupESEDBInfo();
+		return false;
+	}
+
+	g_native_esedb = true;
+
+	return true;
+}
+
+// Decodes the rows of a leaf page. The rows of entry hashes are converted.
+void ScanLeaf( ESE_READER *r, ESE_SCAN_INFO *si, unsigned int index )
+{
+	ESE_LEAF_ROWS *leaf_rows = &si->leaf_rows[ index ];
+
+	ESE_PAGE page;
+	if ( !ReadPage( &r->dm, si->leaves[ index ], &page ) || page.objid != g_ese_table.objid || !( page.flags & ESE_PAGE_FLAG_LEAF ) )
+	{
+		leaf_rows->failed = true;
+		return;
+	}
+
+	if ( page.tag_count <= 1 )
+	{
+		return;
+	}
+
+	leaf_rows->rows = ( ESE_ROW * )malloc( sizeof( ESE_ROW ) * ( page.tag_count - 1 ) );
+	if ( leaf_rows->rows == NULL )
+	{
+		leaf_rows->failed = true;
+		return;
+	}
+
+	for ( unsigned short tag = 1; tag < page.tag_count; ++tag )
+	{
+		ESE_NODE node;
+		if ( !GetPageNode( &page, tag, &node ) || ( node.flags & ESE_TAG_FLAG_DELETED ) )
+		{
+			continue;
+		}
+
+		unsigned char *value = NULL;
+		unsigned int value_length = 0;
+
+		if ( !ReadColumnValue( r, &g_ese_table, node.data, node.data_length, g_thumbnail_cache_id->column_id, &r->buffer, &r->buffer_size, &value, &value_length ) ||
+			 value_length != sizeof( unsigned long long ) )
+		{
+			continue;
+		}
+
+		ESE_ROW *row = &leaf_rows->rows[ leaf_rows->row_count++ ];
+
+		memcpy_s( &row->hash, sizeof( unsigned long long ), value, sizeof( unsigned long long ) );
+
+		// Swap the byte order of the hash. For XP and 7
+		if ( g_use_big_endian )
+		{
+			row->hash = ntohll( row->hash );
+		}
+
+		row->ei = NULL;
+		row->page_number = page.page_number;
+		row->tag = tag;
+
+		unsigned int mapped_index = 0;
+		if ( si->entry_hashes != NULL && hash_table_find( si->entry_hashes, row->hash, &mapped_index ) )
+		{
+			DecodeRecord( r, node.data, node.data_length );
+			ConvertRecord( &row->ei, r->column_data, r->column_length, &r->values );
+		}
+	}
+}
+
+void ScanLeaves( ESE_SCAN_INFO *si )
+{
+	ESE_READER r;
+	bool initialized = InitializeReader( &r );
+
+	for ( ;; )
+	{
+		unsigned int first = ( unsigned int )( InterlockedIncrement( &si->next_chunk ) - 1 ) * ESE_LEAF_CHUNK_SIZE;
+		if ( first >= si->leaf_count )
+		{
+			break;
+		}
+
+		unsigned int last = min( first + ESE_LEAF_CHUNK_SIZE, si->leaf_count );
+
+		for ( unsigned int i = first; i < last; ++i )
+		{
+			if ( initialized )
+			{
+				ScanLeaf( &r, si, i );
+			}
+			else
+			{
+				si->leaf_rows[ i ].failed = true;
+			}
+		}
+	}
+
+	CleanupReader( &r );
+}
+
+unsigned __stdcall scan_leaves( void *pArguments )
+{
+	ScanLeaves( ( ESE_SCAN_INFO * )pArguments );
+
+	_endthreadex( 0 );
+	return 0;
+}
+
+// Gathers the rows from the database's index into g_ese_rows. Only the rows whose hash is in entry_hashes are read, in the order of the table.
+bool LoadIndexedRows( hash_table *entry_hashes )
+{
+	unsigned int row_count = g_ese_index->header->row_count;
+
+	g_ese_rows = ( ESE_ROW * )malloc( sizeof( ESE_ROW ) * ( row_count > 0 ? row_count : 1 ) );
+	if ( g_ese_rows == NULL )
+	{
+		return false;
+	}
+
+	unsigned int failed_count = 0;
+
+	for ( unsigned int i = 0; i < row_count; ++i )
+	{
+		ESE_ROW *row = &g_ese_rows[ i ];
+
+		row->hash = g_ese_index->rows[ i ].hash;
+		row->ei = NULL;
+		row->page_number = g_ese_index->rows[ i ].page_number;
+		row->tag = g_ese_index->rows[ i ].tag;
+
+		unsigned int mapped_index = 0;
+		if ( entry_hashes != NULL && hash_table_find( entry_hashes, row->hash, &mapped_index ) )
+		{
+			ESE_PAGE page;
+			ESE_NODE node;
+
+			if ( ReadPage( &g_ese_lookup.dm, row->page_number, &page ) && page.objid == g_ese_table.objid && ( page.flags & ESE_PAGE_FLAG_LEAF ) &&
+				 GetPageNode( &page, row->tag, &node ) )
+			{
+				DecodeRecord( &g_ese_lookup, node.data, node.data_length );
+				ConvertRecord( &row->ei, g_ese_lookup.column_data, g_ese_lookup.column_length, &g_ese_lookup.values );
+			}
+			else
+			{
+				++failed_count;
+			}
+		}
+	}
+
+	g_ese_row_count = row_count;
+
+	FreeNativeIndex();
+
+	if ( failed_count > 0 )
+	{
+		wprintf( L"%lu rows of the Windows Search database could not be read.\n", failed_count );
+	}
+
+	return true;
+}
+
+// Decodes every leaf page of the property table in parallel and gathers their rows into g_ese_rows in the order of the table.
+// The rows whose hash is in entry_hashes are converted while they're decoded.
+// If the schema was loaded from the database's index, then so are the rows and the table isn't scanned.
+bool ScanNativeESEDatabase( hash_table *entry_hashes )
+{
+	if ( g_ese_index != NULL )
+	{
+		return LoadIndexedRows( entry_hashes );
+	}
+
+	ESE_PAGE_LIST leaves;
+	memset( &leaves, 0, sizeof( ESE_PAGE_LIST ) );
+
+	// Only the parent pages are read to find the leaves.
+	if ( !CollectLeafPages( &g_ese_lookup.dm, g_ese_table.root_page, g_ese_table.objid, 0, &leaves ) )
+	{
+		free( leaves.pages );
+		return false;
+	}
+
+	ESE_SCAN_INFO si;
+	memset( &si, 0, sizeof( ESE_SCAN_INFO ) );
+	si.leaves = leaves.pages;
+	si.leaf_count = leaves.count;
+	si.entry_hashes = entry_hashes;
+	si.leaf_rows = ( ESE_LEAF_ROWS * )calloc( ( leaves.count > 0 ? leaves.count : 1 ), sizeof( ESE_LEAF_ROWS ) );
+	if ( si.leaf_rows == NULL )
+	{
+		free( leaves.pages );
+		return false;
+	}
+
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo( &systemInfo );
+
+	unsigned int chunk_count = ( leaves.count + ESE_LEAF_CHUNK_SIZE - 1 ) / ESE_LEAF_CHUNK_SIZE;
+	unsigned int worker_count = min( systemInfo.dwNumberOfProcessors, MAXIMUM_WAIT_OBJECTS );
+
+	// Every worker decodes chunks of leaves. We're one of them.
+	HANDLE threads[ MAXIMUM_WAIT_OBJECTS ];
+	unsigned int thread_count = 0;
+
+	for ( ; ( thread_count + 1 ) < worker_count && ( thread_count + 1 ) < chunk_count; ++thread_count )
+	{
+		threads[ thread_count ] = ( HANDLE )_beginthreadex( NULL, 0, &scan_leaves, ( void * )&si, 0, NULL );
+		if ( threads[ thread_count ] == NULL )
+		{
+			break;
+		}
+	}
+
+	ScanLeaves( &si );
+
+	if ( thread_count > 0 )
+	{
+		WaitForMultipleObjects( thread_count, threads, TRUE, INFINITE );
+
+		for ( unsigned int i = 0; i < thread_count; ++i )
+		{
+			CloseHandle( threads[ i ] );
+		}
+	}
+
+	// Gather the rows of every leaf in the order of the table.
+	unsigned int row_count = 0;
+	unsigned int failed_count = 0;
+	for ( unsigned int i = 0; i < si.leaf_count; ++i )
+	{
+		row_count += si.leaf_rows[ i ].row_count;
+
+		if ( si.leaf_rows[ i ].failed )
+		{
+			++failed_count;
+		}
+	}
+
+	g_ese_rows = ( ESE_ROW * )malloc( sizeof( ESE_ROW ) * ( row_count > 0 ? row_count : 1 ) );
+	g_ese_row_count = 0;
+
+	for ( unsigned int i = 0; i < si.leaf_count; ++i )
+	{
+		ESE_LEAF_ROWS *leaf_rows = &si.leaf_rows[ i ];
+
+		for ( unsigned int j = 0; j < leaf_rows->row_count; ++j )
+		{
+			if ( g_ese_rows != NULL )
+			{
+				g_ese_rows[ g_ese_row_count++ ] = leaf_rows->rows[ j ];
+			}
+			else
+			{
+				FreeExtendedInfo( leaf_rows->rows[ j ].ei );
+			}
+		}
+
+		free( leaf_rows->rows );
+	}
+
+	free( si.leaf_rows );
+	free( leaves.pages );
+
+	if ( failed_count > 0 )
+	{
+		wprintf( L"%lu pages of the Windows Search database could not be read.\n", failed_count );
+	}
+
+	// An index of a partial scan would hide the rows that couldn't be read.
+	if ( g_ese_index_path != NULL && g_ese_rows != NULL && failed_count == 0 )
+	{
+		SaveNativeIndex();
+	}
+
+	FreeNativeIndex();
+
+	return ( g_ese_rows != NULL );
+}
+
+// Converts the values of a row in g_ese_rows. The caller must hold g_map_cs.
+bool RetrieveNativeRow( unsigned int index, EXTENDED_INFO **ei )
+{
+	if ( !g_native_esedb || index >= g_ese_row_count )
+	{
+		return false;
+	}
+
+	ESE_PAGE page;
+	ESE_NODE node;
+
+	if ( !ReadPage( &g_ese_lookup.dm, g_ese_rows[ index ].page_number, &page ) || !GetPageNode( &page, g_ese_rows[ index ].tag, &node ) )
+	{
+		return false;
+	}
+
+	DecodeRecord( &g_ese_lookup, node.data, node.data_length );
+	ConvertRecord( ei, g_ese_lookup.column_data, g_ese_lookup.column_length, &g_ese_lookup.values );
+
+	return true;
+}
+
+void CleanupNativeESEDatabase()
+{
+	CleanupReader( &g_ese_lookup );
+
+	CloseDatabaseMap( &g_ese_map );
+	memset( &g_ese_map, 0, sizeof( DATABASE_MAP ) );
+
+	if ( g_ese_hFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( g_ese_hFile );
+		g_ese_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	if ( g_ese_rows != NULL )
+	{
+		for ( unsigned int i = 0; i < g_ese_row_count; ++i )
+		{
+			FreeExtendedInfo( g_ese_rows[ i ].ei );
+		}
+
+		free( g_ese_rows );
+		g_ese_rows = NULL;
+	}
+
+	g_ese_row_count = 0;
+
+	memset( &g_ese_table, 0, sizeof( ESE_TABLE ) );
+
+	FreeNativeIndex();
+
+	memset( &g_ese_format, 0, sizeof( ESE_FORMAT ) );
+
+	g_native_esedb = false;
+}
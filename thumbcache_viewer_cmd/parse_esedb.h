@@ -0,0 +1,118 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PARSE_ESEDB_H
+#define PARSE_ESEDB_H
+
+#include "globals.h"
+#include "hash_table.h"
+#include "read_thumbcache.h"
+#include "decode_esedb.h"
+
+// Catalog (MSysObjects) record types.
+#define ESE_CATALOG_TYPE_TABLE		1
+#define ESE_CATALOG_TYPE_COLUMN		2
+#define ESE_CATALOG_TYPE_INDEX		3
+#define ESE_CATALOG_TYPE_LONG_VALUE	4
+
+#define ESE_CATALOG_ROOT_PAGE		4
+#define ESE_CATALOG_OBJID			2
+
+#define ESE_CATALOG_COLUMN_NAME		128
+
+// A corrupt database shouldn't send us through an endless number of pages.
+#define ESE_MAX_TREE_DEPTH			16
+#define ESE_MAX_LONG_VALUE_SIZE		67108864	// 64 megabytes.
+
+// Number of leaf pages that a worker claims at a time.
+#define ESE_LEAF_CHUNK_SIZE			64
+
+// A record from the catalog.
+struct ESE_CATALOG_ENTRY
+{
+	char *name;
+	unsigned int objid_table;
+	unsigned int id;				// The object id of a table or long value tree, or the column id of a column.
+	unsigned int coltyp_or_pgno;	// The root page of a table or long value tree, or the data type of a column.
+	unsigned int space_usage;		// The maximum size of a column.
+	unsigned int codepage;
+	unsigned short type;
+};
+
+// Each worker reads the database through its own views.
+struct ESE_READER
+{
+	DATABASE_MAP dm;				// Views of the data pages.
+	DATABASE_MAP lv_dm;				// Views of the long value pages. A record stays valid while its long values are read.
+	unsigned char **column_data;	// Values of the current record, in the order of g_ci.
+	unsigned long *column_length;
+	unsigned char **buffers;		// Values that were decompressed or read from the long value tree, in the order of g_ci.
+	unsigned int *buffer_sizes;
+	unsigned char *buffer;			// Holds a single value, such as the System_ThumbnailCacheId of the current record.
+	unsigned int buffer_size;
+	OUTPUT_BUFFER values;			// Reused to format the values of a record before they're copied into a single allocation.
+	unsigned char *chunk;			// Holds a compressed chunk of a long value until its length is known.
+	unsigned int chunk_size;
+};
+
+// A row of the property table that has a System_ThumbnailCacheId.
+struct ESE_ROW
+{
+	unsigned long long hash;
+	EXTENDED_INFO *ei;				// The converted values if the hash is one of the entry hashes. NULL otherwise.
+	unsigned int page_number;
+	unsigned short tag;
+};
+
+// The rows of a leaf page.
+struct ESE_LEAF_ROWS
+{
+	ESE_ROW *rows;
+	unsigned int row_count;
+	bool failed;					// The page couldn't be read.
+};
+
+// A growable list of page numbers.
+struct ESE_PAGE_LIST
+{
+	unsigned int *pages;
+	unsigned int count;
+	unsigned int size;
+};
+
+// Shared between the workers that decode the leaf pages of the property table.
+struct ESE_SCAN_INFO
+{
+	unsigned int *leaves;
+	unsigned int leaf_count;
+	ESE_LEAF_ROWS *leaf_rows;
+	hash_table *entry_hashes;
+	volatile LONG next_chunk;		// The next chunk of leaves to be claimed by a worker.
+};
+
+bool OpenNativeESEDatabase( wchar_t *database_filepath, unsigned long revision, unsigned long page_size, bool use_index );
+bool ScanNativeESEDatabase( hash_table *entry_hashes );
+bool RetrieveNativeRow( unsigned int index, EXTENDED_INFO **ei );
+void CleanupNativeESEDatabase();
+
+extern bool g_native_esedb;		// The database was opened by our reader rather than esent.dll.
+
+extern ESE_ROW *g_ese_rows;		// Rows of the property table in the order of the table.
+extern unsigned int g_ese_row_count;
+
+#endif
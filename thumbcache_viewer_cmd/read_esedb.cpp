@@ -20,6 +20,9 @@
 #include "lite_msscb.h"
 
 #include "read_esedb.h"
+#include "parse_esedb.h"
+#include "map_entries.h"
+#include "uncompress_text.h"
 
 #include "utilities.h"
 
@@ -30,12 +33,16 @@ JET_SESID g_sesid = JET_sesidNil;
 JET_DBID g_dbid = JET_bitNil;
 JET_TABLEID g_tableid_0P = JET_tableidNil, g_tableid_0A = JET_tableidNil;
 JET_RETRIEVECOLUMN *g_rc_array = NULL;
+unsigned char **g_column_data = NULL;
+unsigned long *g_column_length = NULL;
 unsigned long g_column_count = 0;
 char *g_ascii_filepath = NULL;
 COLUMN_INFO *g_ci = NULL;
 
 COLUMN_INFO *g_thumbnail_cache_id = NULL;
 
+OUTPUT_BUFFER g_values = { NULL };	// Reused to format the values that were retrieved into g_rc_array.
+
 bool g_use_big_endian = true;
 unsigned long g_revision = 0;
 
@@ -44,362 +51,320 @@ int g_error_offset = 0;
 char g_error[ ERROR_BUFFER_SIZE ] = { 0 };
 unsigned char g_error_state = 0;
 
-dllrbt_tree *g_file_info_tree = NULL;
+hash_table *g_file_info_table = NULL;
 
-wchar_t *UncompressValue( unsigned char *value, unsigned long value_length )
+// Appends the uncompressed value to values. Returns false if it couldn't be uncompressed.
+bool UncompressValue( unsigned char *value, unsigned long value_length, OUTPUT_BUFFER *values )
 {
-	wchar_t *ret_value = NULL;
+	bool ret = false;
+
+	if ( value == NULL )
+	{
+		return false;
+	}
 
-	if ( ( mssrch_state != MSSRCH_STATE_SHUTDOWN || msscb_state != MSSRCH_STATE_SHUTDOWN ) && value != NULL )
+	// Get the length first. The value isn't modified, so it can be decoded twice.
+	int uncompressed_byte_length = UncompressText( value, value_length, NULL, 0 );
+	if ( uncompressed_byte_length > 0 )
 	{
-		int uncompressed_byte_length = MSSUncompressText( value, value_length, NULL, 0 );
-		if ( uncompressed_byte_length > 0 )
+		if ( BufferReserve( values, uncompressed_byte_length ) )
 		{
-			ret_value = ( wchar_t * )malloc( sizeof( char ) * ( uncompressed_byte_length + sizeof( wchar_t ) ) );	// Include the NULL terminator.
-			memset( ret_value, 0, sizeof( char ) * ( uncompressed_byte_length + sizeof( wchar_t ) ) );
+			UncompressText( value, value_length, ( wchar_t * )( values->buffer + values->length ), uncompressed_byte_length );
+			values->length += ( uncompressed_byte_length & ~( sizeof( wchar_t ) - 1 ) );	// Whole characters only.
 
-			MSSUncompressText( value, value_length, ret_value, uncompressed_byte_length );
-			ret_value[ uncompressed_byte_length / sizeof( wchar_t ) ] = 0;	// Sanity.
+			ret = true;
 		}
 	}
+	else if ( uncompressed_byte_length < 0 && ( mssrch_state != MSSRCH_STATE_SHUTDOWN || msscb_state != MSSRCH_STATE_SHUTDOWN ) )
+	{
+		// Let mssrch.dll or msscb.dll try the values that we couldn't decode.
+		// They unobfuscate the value in-place, so they get a copy. They aren't known to be thread-safe.
+		unsigned char *value_copy = ( unsigned char * )malloc( sizeof( unsigned char ) * value_length );
+		if ( value_copy != NULL )
+		{
+			EnterCriticalSection( &g_map_cs );
+
+			memcpy_s( value_copy, sizeof( unsigned char ) * value_length, value, value_length );
+			uncompressed_byte_length = MSSUncompressText( value_copy, value_length, NULL, 0 );
+			if ( uncompressed_byte_length > 0 && BufferReserve( values, uncompressed_byte_length ) )
+			{
+				memset( values->buffer + values->length, 0, sizeof( char ) * uncompressed_byte_length );
+
+				MSSUncompressText( value_copy, value_length, ( wchar_t * )( values->buffer + values->length ), uncompressed_byte_length );
+				values->length += ( uncompressed_byte_length & ~( sizeof( wchar_t ) - 1 ) );	// Whole characters only.
+
+				ret = true;
+			}
+
+			LeaveCriticalSection( &g_map_cs );
 
-	return ret_value;
+			free( value_copy );
+		}
+	}
+
+	return ret;
 }
 
-void ConvertValues( EXTENDED_INFO **ei )
+// Appends the converted value of a column to values. Returns false if there's no value.
+bool ConvertColumnValue( COLUMN_INFO *ci, unsigned char *data, unsigned long data_length, OUTPUT_BUFFER *values )
 {
-	EXTENDED_INFO *l_ei = *ei;
-	COLUMN_INFO *t_ci = g_ci;
+	switch ( ci->column_type )
+	{
+		case JET_coltypBit:
+		{
+			// Handles Type(s): VT_BOOL
 
-	int buf_count = 0;
+			if ( ci->Type == VT_BOOL )	// bool (true == -1, false == 0)
+			{
+				return ( data[ 0 ] != 0 ? BufferWriteW( values, L"true", 4 ) : BufferWriteW( values, L"false", 5 ) );
+			}
 
-	wchar_t *format = NULL;
+			// For anything else, fall through to JET_coltypUnsignedByte
+		}
 
-	for ( unsigned long i = 0; i < g_column_count; ++i )
-	{
-		if ( t_ci != NULL )
+		case JET_coltypUnsignedByte:
+		{
+			// Handles Type(s): VT_I1, VT_UI1, anything else from JET_coltypBit
+
+			return BufferWriteUnsignedW( values, data[ 0 ] );
+		}
+
+		case JET_coltypShort:
+		case JET_coltypUnsignedShort:
+		{
+			// Handles Type(s): VT_UI2
+
+			unsigned short val = 0;
+			memcpy_s( &val, sizeof( unsigned short ), data, sizeof( unsigned short ) );
+
+			return BufferWriteUnsignedW( values, val );
+		}
+
+		case JET_coltypLong:
+		case JET_coltypUnsignedLong:
 		{
-			EXTENDED_INFO *t_ei = ( EXTENDED_INFO * )malloc( sizeof( EXTENDED_INFO ) );
-			t_ei->si = ( void * )t_ci;
-			t_ei->property_value = NULL;
-			t_ei->next = NULL;
+			// Handles Type(s): VT_I4, VT_UI4
 
-			// See if the property value was retrieved.
-			if ( g_rc_array[ i ].cbActual != 0 && g_rc_array[ i ].cbActual <= t_ci->max_size )
+			unsigned long val = 0;
+			memcpy_s( &val, sizeof( unsigned long ), data, sizeof( unsigned long ) );
+
+			if ( ci->format == PROPERTY_FORMAT_FILE_ATTRIBUTES )
+			{
+				return BufferWriteFileAttributesW( values, val );
+			}
+			else if ( ci->format == PROPERTY_FORMAT_SFGAO )
 			{
-				switch ( t_ci->column_type )
+				return BufferWriteSFGAOW( values, val );
+			}
+			else if ( ci->column_type == JET_coltypLong )
+			{
+				return BufferWriteSignedW( values, ( long )val );
+			}
+			else
+			{
+				return BufferWriteUnsignedW( values, val );
+			}
+		}
+
+		case JET_coltypIEEEDouble:
+		{
+			// Handles Type(s): VT_R8
+
+			double val = 0.0f;
+			memcpy_s( &val, sizeof( double ), data, sizeof( double ) );
+
+			// _CVTBUFSIZE holds any double that's formatted with %f.
+			if ( !BufferReserve( values, sizeof( wchar_t ) * _CVTBUFSIZE ) )
+			{
+				return false;
+			}
+
+			int buf_count = swprintf_s( ( wchar_t * )( values->buffer + values->length ), _CVTBUFSIZE, L"%f", val );
+			if ( buf_count <= 0 )
+			{
+				return false;
+			}
+
+			values->length += ( sizeof( wchar_t ) * buf_count );
+
+			return true;
+		}
+
+		case JET_coltypCurrency:
+		case JET_coltypBinary:		// May be compressed. We'll fall through to JET_coltypLongBinary to handle uncompressing it.
+		case JET_coltypLongLong:
+		{
+			// Handles Type(s): VT_FILETIME, VT_UI8, VT_LPWSTR
+
+			unsigned long long val = 0;
+			memcpy_s( &val, sizeof( unsigned long long ), data, min( data_length, sizeof( unsigned long long ) ) );
+
+			if ( g_use_big_endian )
+			{
+				val = ntohll( val );
+			}
+
+			if ( ci->Type == VT_FILETIME )	// FILETIME
+			{
+				return BufferWriteFileTimeW( values, val );
+			}
+			else if ( ci->format == PROPERTY_FORMAT_SIZE )
+			{
+				return ( BufferWriteUnsignedW( values, val ) && BufferWriteW( values, L" bytes", 6 ) );
+			}
+			else if ( ci->format == PROPERTY_FORMAT_CACHE_ID )
+			{
+				return BufferWriteHexW( values, val, 16 );
+			}
+			else if ( ci->format == PROPERTY_FORMAT_INVERTED_MD5 )
+			{
+				// Output hex values.
+				return BufferWriteHexBytesW( values, data, data_length );
+			}
+			else if ( !ci->JetCompress && data_length == sizeof( unsigned long long ) )
+			{
+				// Handle 8 byte values. For everything else, fall through.
+				return ( ci->column_type == JET_coltypLongLong ? BufferWriteSignedW( values, ( long long )val ) : BufferWriteUnsignedW( values, val ) );
+			}
+
+			// Fall through to JET_coltypLongBinary.
+		}
+
+		case JET_coltypText:
+		case JET_coltypLongBinary:
+		case JET_coltypLongText:
+		case JET_coltypGUID:
+		{
+			// Handles Type(s): VT_NULL, VT_LPWSTR, ( VT_VECTOR | VT_LPWSTR ), VT_BLOB, anything else from JET_coltypBinary
+
+			if ( ci->column_type == JET_coltypGUID )
+			{
+				if ( data_length == 16 )
 				{
-					case JET_coltypBit:
-					{
-						// Handles Type(s): VT_BOOL
-
-						if ( t_ci->Type == VT_BOOL )	// bool (true == -1, false == 0)
-						{
-							buf_count = ( t_ci->data[ 0 ] != 0 ? 4 : 5 );	// "true" or "false"
-							t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-							wcscpy_s( t_ei->property_value, buf_count + 1, ( t_ci->data[ 0 ] != 0 ? L"true" : L"false" ) );
-
-							break;
-						}
-
-						// For anything else, fall through to JET_coltypUnsignedByte
-					}
-
-					case JET_coltypUnsignedByte:
-					{
-						// Handles Type(s): VT_I1, VT_UI1, anything else from JET_coltypBit
-
-						format = ( t_ci->Type == VT_I1 ? L"%d" : L"%lu" );
-						buf_count = _scwprintf( format, t_ci->data[ 0 ] );
-						if ( buf_count > 0 )
-						{
-							t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-							swprintf_s( t_ei->property_value, buf_count + 1, format, t_ci->data[ 0 ] );
-						}
-					}
-					break;
-
-					case JET_coltypShort:
-					case JET_coltypUnsignedShort:
-					{
-						// Handles Type(s): VT_UI2
-
-						unsigned short val = 0;
-						memcpy_s( &val, sizeof( unsigned short ), t_ci->data, sizeof( unsigned short ) );
-
-						format = ( t_ci->column_type == JET_coltypShort ? L"%d" : L"%lu" );
-						buf_count = _scwprintf( format, val );
-						if ( buf_count > 0 )
-						{
-							t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-							swprintf_s( t_ei->property_value, buf_count + 1, format, val );
-						}
-					}
-					break;
-
-					case JET_coltypLong:
-					case JET_coltypUnsignedLong:
-					{
-						// Handles Type(s): VT_I4, VT_UI4
-
-						unsigned long val = 0;
-						memcpy_s( &val, sizeof( unsigned long ), t_ci->data, sizeof( unsigned long ) );
-
-						if ( t_ci->Name_byte_length == 42 && wcscmp( t_ci->Name, L"System_FileAttributes" ) == 0 )
-						{
-							t_ei->property_value = GetFileAttributesStr( val );
-						}
-						else if ( ( t_ci->Name_byte_length == 34 && wcscmp( t_ci->Name, L"System_SFGAOFlags" ) == 0 ) ||
-								  ( t_ci->Name_byte_length == 56 && wcscmp( t_ci->Name, L"System_Link_TargetSFGAOFlags" ) == 0 ) )
-						{
-							t_ei->property_value = GetSFGAOStr( val );
-						}
-						else
-						{
-							format = ( t_ci->column_type == JET_coltypLong ? L"%d" : L"%lu" );
-							buf_count = _scwprintf( format, val );
-							if ( buf_count > 0 )
-							{
-								t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-								swprintf_s( t_ei->property_value, buf_count + 1, format, val );
-							}
-						}
-					}
-					break;
-
-					case JET_coltypIEEEDouble:
-					{
-						// Handles Type(s): VT_R8
-
-						double val = 0.0f;
-						memcpy_s( &val, sizeof( double ), t_ci->data, sizeof( double ) );
-
-						buf_count = _scwprintf( L"%f", val );
-						if ( buf_count > 0 )
-						{
-							t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-							swprintf_s( t_ei->property_value, buf_count + 1, L"%f", val );
-						}
-					}
-					break;
-
-					case JET_coltypCurrency:
-					case JET_coltypBinary:		// May be compressed. We'll fall through to JET_coltypLongBinary to handle uncompressing it.
-					case JET_coltypLongLong:
-					{
-						// Handles Type(s): VT_FILETIME, VT_UI8, VT_LPWSTR
-
-						unsigned long long val = 0;
-						memcpy_s( &val, sizeof( unsigned long long ), t_ci->data, sizeof( unsigned long long ) );
-
-						if ( g_use_big_endian )
-						{
-							val = ntohll( val );
-						}
-
-						if ( t_ci->Type == VT_FILETIME )	// FILETIME
-						{
-							SYSTEMTIME st;
-							FILETIME ft;
-							ft.dwLowDateTime = ( DWORD )val;
-							ft.dwHighDateTime = ( DWORD )( val >> 32 );
-							FileTimeToSystemTime( &ft, &st );
-
-							buf_count = _scwprintf( L"%d/%d/%d (%02d:%02d:%02d.%d) [UTC]", st.wMonth, st.wDay, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds );
-							if ( buf_count > 0 )
-							{
-								t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-								swprintf_s( t_ei->property_value, buf_count + 1, L"%d/%d/%d (%02d:%02d:%02d.%d) [UTC]", st.wMonth, st.wDay, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds );
-							}
-
-							break;
-						}
-						else
-						{
-							if ( t_ci->Name_byte_length == 22 && wcscmp( t_ci->Name, L"System_Size" ) == 0 )
-							{
-								buf_count = _scwprintf( L"%llu", val );
-								if ( buf_count > 0 )
-								{
-									t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 6 + 1 ) );
-									swprintf_s( t_ei->property_value, buf_count + 6 + 1, L"%llu bytes", val );
-								}
-
-								break;
-							}
-							else if ( t_ci->Name_byte_length == 46 && wcscmp( t_ci->Name, L"System_ThumbnailCacheId" ) == 0 )
-							{
-								t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * 17 );
-								swprintf_s( t_ei->property_value, 17, L"%016llx", val );
-
-								break;
-							}
-							else if ( t_ci->Name_byte_length == 30 && wcscmp( t_ci->Name, L"InvertedOnlyMD5" ) == 0 )
-							{
-								// Output hex values.
-								unsigned long property_value_offset = 0;
-								buf_count = ( ( g_rc_array[ i ].cbActual * 2 ) + 1 );
-								t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
-								for ( unsigned long h = 0; h < g_rc_array[ i ].cbActual; ++h )
-								{
-									property_value_offset += swprintf_s( t_ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", t_ci->data[ h ] );
-								}
-
-								break;
-							}
-							else
-							{
-								if ( !t_ci->JetCompress )
-								{
-									// Handle 8 byte values. For everything else, fall through.
-									if ( g_rc_array[ i ].cbActual == sizeof( unsigned long long ) )
-									{
-										format = ( t_ci->column_type == JET_coltypLongLong ? L"%lld" : L"%llu" );
-										buf_count = _scwprintf( format, val );
-										if ( buf_count > 0 )
-										{
-											t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-											swprintf_s( t_ei->property_value, buf_count + 1, format, val );
-										}
-
-										break;
-									}
-								}
-
-								// Fall through to JET_coltypLongBinary.
-							}
-						}
-					}
-
-					case JET_coltypText:
-					case JET_coltypLongBinary:
-					case JET_coltypLongText:
-					case JET_coltypGUID:
-					{
-						// Handles Type(s): VT_NULL, VT_LPWSTR, ( VT_VECTOR | VT_LPWSTR ), VT_BLOB, anything else from JET_coltypBinary
-
-						if ( t_ci->column_type == JET_coltypGUID )
-						{
-							if ( g_rc_array[ i ].cbActual == 16 )
-							{
-								// Output GUID formatted value.
-								unsigned long val_1 = 0;
-								unsigned short val_2 = 0, val_3 = 0;
-
-								memcpy_s( &val_1, sizeof( unsigned long ), t_ci->data, sizeof( unsigned long ) );
-								memcpy_s( &val_2, sizeof( unsigned short ), t_ci->data + sizeof( unsigned long ), sizeof( unsigned short ) );
-								memcpy_s( &val_3, sizeof( unsigned short ), t_ci->data + sizeof( unsigned long ) + sizeof( unsigned short ), sizeof( unsigned short ) );
-
-								buf_count = ( ( g_rc_array[ i ].cbActual * 2 ) + 6 + 1 );
-								t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
-
-								unsigned long property_value_offset = swprintf_s( t_ei->property_value, buf_count, L"{%08x-%04x-%04x-", val_1, val_2, val_3 );
-								for ( unsigned long h = sizeof( unsigned long ) + ( sizeof( unsigned short ) * 2 ); h < g_rc_array[ i ].cbActual; ++h )
-								{
-									if ( h == 10 )
-									{
-										t_ei->property_value[ property_value_offset ] = L'-';
-										++property_value_offset;
-									}
-									property_value_offset += swprintf_s( t_ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", t_ci->data[ h ] );
-								}
-								t_ei->property_value[ buf_count - 2 ] = L'}';
-								t_ei->property_value[ buf_count - 1 ] = 0;	// Sanity.
-
-								break;
-							}
-
-							// Fall through to default.
-						}
-						else
-						{
-							// On Vista, if Type == ( VT_VECTOR | VT_LPWSTR ), then the first 2 bytes (little-endian) = array count?
-							if ( t_ci->JetCompress )
-							{
-								// Make a copy first because we may need to reuse t_ci->data and don't want it modified.
-								unsigned char *data_copy = ( unsigned char * )malloc( sizeof( unsigned char ) * g_rc_array[ i ].cbActual );
-								memcpy_s( data_copy, sizeof( unsigned char ) * g_rc_array[ i ].cbActual, t_ci->data, g_rc_array[ i ].cbActual );
-
-								t_ei->property_value = UncompressValue( data_copy, g_rc_array[ i ].cbActual );
-
-								free( data_copy );
-
-								break;
-							}
-							else
-							{
-								if ( t_ci->Name_byte_length == 32 && wcscmp( t_ci->Name, L"InvertedOnlyPids" ) == 0 )
-								{
-									// Output hex values.
-									unsigned long property_value_offset = 0;
-									buf_count = ( ( g_rc_array[ i ].cbActual * 2 ) + 1 );
-									t_ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
-									for ( unsigned long h = 0; h < g_rc_array[ i ].cbActual; ++h )
-									{
-										property_value_offset += swprintf_s( t_ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", t_ci->data[ h ] );
-									}
-
-									break;
-								}
-
-								// Fall through to default.
-							}
-						}
-					}
-
-					default:
-					{
-						// This is usually wchar strings.
-
-						t_ei->property_value = ( wchar_t * )malloc( sizeof( char ) * ( g_rc_array[ i ].cbActual + sizeof( wchar_t ) ) );	// Include the NULL terminator.
-						memcpy_s( t_ei->property_value, sizeof( char ) * ( g_rc_array[ i ].cbActual + sizeof( wchar_t ) ), t_ci->data, g_rc_array[ i ].cbActual );
-
-						unsigned long property_value_size = g_rc_array[ i ].cbActual / sizeof( wchar_t );
-						t_ei->property_value[ property_value_size ] = 0;	// Sanity.
-
-						// See if we have any string arrays.
-						if ( wcslen( t_ei->property_value ) < property_value_size )
-						{
-							// Replace the NULL character at the end of each string (except the last) with a ';' separator.
-							wchar_t *t_val = t_ei->property_value;
-							while ( t_val < ( t_ei->property_value + property_value_size ) )
-							{
-								if ( *t_val == 0 )
-								{
-									*t_val = L';';
-								}
-
-								++t_val;
-							}
-						}
-					}
-					break;
+					// Output GUID formatted value.
+					return BufferWriteGUIDW( values, data );
 				}
-			}
 
-			if ( l_ei != NULL )
+				// Fall through to default.
+			}
+			else if ( ci->JetCompress )
 			{
-				l_ei->next = t_ei;
+				// On Vista, if Type == ( VT_VECTOR | VT_LPWSTR ), then the first 2 bytes (little-endian) = array count?
+				return UncompressValue( data, data_length, values );
 			}
-			else
+			else if ( ci->format == PROPERTY_FORMAT_INVERTED_PIDS )
 			{
-				*ei = t_ei;
+				// Output hex values.
+				return BufferWriteHexBytesW( values, data, data_length );
 			}
 
-			l_ei = t_ei;
+			// Fall through to default.
+		}
 
-			// Go to the next Windows property.
-			t_ci = t_ci->next;
+		default:
+		{
+			// This is usually wchar strings. Any string arrays have a ';' separator.
+			return BufferWriteStringListW( values, data, data_length / sizeof( wchar_t ) );
 		}
-		else
+	}
+}
+
+// Converts the value of each column in g_ci. column_data and column_length are in the same order as g_ci. A length of 0 means the value wasn't retrieved.
+// The record's nodes and values are formatted into values, which is reused, and then copied into a single allocation that's appended to ei.
+void ConvertRecord( EXTENDED_INFO **ei, unsigned char **column_data, unsigned long *column_length, OUTPUT_BUFFER *values )
+{
+	unsigned int node_count = 0;
+	COLUMN_INFO *t_ci = g_ci;
+	for ( unsigned long i = 0; i < g_column_count && t_ci != NULL; ++i, t_ci = t_ci->next )
+	{
+		// System_ThumbnailCacheId is retrieved to find the rows, but it isn't converted unless it was projected.
+		if ( t_ci->projected )
 		{
-			break;
+			++node_count;
 		}
 	}
+
+	// The nodes come first. Until the record is copied, they refer to their values by offset since values can be reallocated.
+	values->length = 0;
+	if ( node_count == 0 || !BufferReserve( values, sizeof( EXTENDED_INFO ) * node_count ) )
+	{
+		return;
+	}
+
+	values->length = sizeof( EXTENDED_INFO ) * node_count;
+
+	unsigned int node_index = 0;
+	t_ci = g_ci;
+	for ( unsigned long i = 0; i < g_column_count && t_ci != NULL; ++i, t_ci = t_ci->next )
+	{
+		if ( !t_ci->projected )
+		{
+			continue;
+		}
+
+		unsigned int value_offset = values->length;
+
+		// See if the property value was retrieved. Every value is NULL terminated.
+		bool converted = ( column_length[ i ] != 0 &&
+						   ConvertColumnValue( t_ci, column_data[ i ], column_length[ i ], values ) &&
+						   BufferWrite( values, L"", sizeof( wchar_t ) ) );
+		if ( !converted )
+		{
+			values->length = value_offset;
+		}
+
+		EXTENDED_INFO *t_ei = ( EXTENDED_INFO * )values->buffer + node_index++;
+		t_ei->si = ( void * )t_ci;
+		t_ei->property_value = ( converted ? ( wchar_t * )( size_t )value_offset : NULL );
+		t_ei->next = NULL;
+		t_ei->block = false;
+	}
+
+	EXTENDED_INFO *record = ( EXTENDED_INFO * )malloc( values->length );
+	if ( record == NULL )
+	{
+		return;
+	}
+
+	memcpy_s( record, values->length, values->buffer, values->length );
+
+	for ( unsigned int n = 0; n < node_index; ++n )
+	{
+		if ( record[ n ].property_value != NULL )
+		{
+			record[ n ].property_value = ( wchar_t * )( ( char * )record + ( size_t )record[ n ].property_value );
+		}
+
+		record[ n ].next = ( n + 1 < node_index ? &record[ n + 1 ] : NULL );
+	}
+
+	record[ 0 ].block = true;
+
+	// Append the record to any existing values.
+	while ( *ei != NULL )
+	{
+		ei = &( *ei )->next;
+	}
+
+	*ei = record;
+}
+
+// Converts the values that were retrieved into g_rc_array. Truncated values aren't converted.
+void ConvertValues( EXTENDED_INFO **ei )
+{
+	for ( unsigned long i = 0; i < g_column_count; ++i )
+	{
+		g_column_length[ i ] = ( g_rc_array[ i ].cbActual <= g_rc_array[ i ].cbData ? g_rc_array[ i ].cbActual : 0 );
+	}
+
+	ConvertRecord( ei, g_column_data, g_column_length, &g_values );
 }
 
 void CleanupESEDBInfo()
 {
+	// The readers' buffers are freed using g_column_count.
+	CleanupNativeESEDatabase();
+
 	// Reverse the steps of initializing the Jet database engine, etc.
 	if ( g_sesid != JET_sesidNil )
 	{
@@ -453,6 +418,13 @@ void CleanupESEDBInfo()
 	free( g_rc_array );
 	g_rc_array = NULL;
 
+	free( g_column_data );
+	g_column_data = NULL;
+	free( g_column_length );
+	g_column_length = NULL;
+
+	FreeBuffer( &g_values );
+
 	COLUMN_INFO *t_ci = g_ci;
 	COLUMN_INFO *d_ci = NULL;
 	while ( t_ci != NULL )
@@ -467,27 +439,40 @@ void CleanupESEDBInfo()
 	}
 	g_ci = NULL;
 
-	// Free the values of the file info tree.
-	node_type *node = dllrbt_get_head( g_file_info_tree );
-	while ( node != NULL )
+	// Clean up our file info table. Its values are row indices.
+	hash_table_delete( g_file_info_table );
+	g_file_info_table = NULL;
+}
+
+// Takes the columns out of g_ci so that the converted values that refer to them outlive the database. Their retrieval buffers are freed.
+// Must be called before CleanupESEDBInfo(). The columns are freed with FreeColumnInfo().
+COLUMN_INFO *DetachColumnInfo()
+{
+	COLUMN_INFO *ci = g_ci;
+
+	for ( COLUMN_INFO *t_ci = g_ci; t_ci != NULL; t_ci = t_ci->next )
 	{
-		// Free the linked list if there is one.
-		LINKED_LIST *fi_node = ( LINKED_LIST * )node->val;
-		while ( fi_node != NULL )
-		{
-			LINKED_LIST *del_fi_node = fi_node;
+		free( t_ci->data );
+		t_ci->data = NULL;
+	}
 
-			fi_node = fi_node->next;
+	g_ci = NULL;
+	g_thumbnail_cache_id = NULL;
 
-			free( del_fi_node );
-		}
+	return ci;
+}
 
-		node = node->next;
-	}
+void FreeColumnInfo( COLUMN_INFO *ci )
+{
+	while ( ci != NULL )
+	{
+		COLUMN_INFO *d_ci = ci;
+		ci = ci->next;
 
-	// Clean up our file info tree.
-	dllrbt_delete_recursively( g_file_info_tree );
-	g_file_info_tree = NULL;
+		free( d_ci->data );
+		free( d_ci->Name );
+		free( d_ci );
+	}
 }
 
 void SetErrorMessage( char *msg )
@@ -518,7 +503,7 @@ void HandleESEDBError()
 			}
 		}
 
-		printf( "%s\n", g_error );
+		wprintf( L"%hs\n", g_error );
 
 		g_error_offset = 0;
 	}
@@ -971,6 +956,46 @@ CLEANUP:
 
 // Build the retrieve column array's values from the columns list.
 // g_rc_array is freed in CleanupESEDBInfo().
+// Removes the columns whose Windows Property isn't in the projection so that they're never retrieved or converted.
+// Must be called before BuildRetrieveColumnArray().
+void ProjectColumns()
+{
+	COLUMN_INFO *t_ci = g_ci;
+	COLUMN_INFO *last_ci = NULL;
+
+	while ( t_ci != NULL )
+	{
+		COLUMN_INFO *next_ci = t_ci->next;
+
+		t_ci->projected = IsPropertyProjected( t_ci->Name, t_ci->Name_byte_length / sizeof( wchar_t ) );
+		t_ci->format = GetPropertyFormat( t_ci->Name, t_ci->Name_byte_length / sizeof( wchar_t ) );
+
+		if ( t_ci->projected || t_ci == g_thumbnail_cache_id )
+		{
+			last_ci = t_ci;
+		}
+		else
+		{
+			if ( last_ci != NULL )
+			{
+				last_ci->next = next_ci;
+			}
+			else
+			{
+				g_ci = next_ci;
+			}
+
+			free( t_ci->data );
+			free( t_ci->Name );
+			free( t_ci );
+
+			--g_column_count;
+		}
+
+		t_ci = next_ci;
+	}
+}
+
 void BuildRetrieveColumnArray()
 {
 	if ( g_ci == NULL || g_column_count == 0 )
@@ -983,6 +1008,9 @@ void BuildRetrieveColumnArray()
 	g_rc_array = ( JET_RETRIEVECOLUMN * )malloc( sizeof( JET_RETRIEVECOLUMN ) * g_column_count );
 	memset( g_rc_array, 0, sizeof( JET_RETRIEVECOLUMN ) * g_column_count );
 
+	g_column_data = ( unsigned char ** )malloc( sizeof( unsigned char * ) * g_column_count );
+	g_column_length = ( unsigned long * )malloc( sizeof( unsigned long ) * g_column_count );
+
 	for ( unsigned long i = 0; i < g_column_count; ++i )
 	{
 		if ( t_ci != NULL )
@@ -990,6 +1018,8 @@ void BuildRetrieveColumnArray()
 			t_ci->data = ( unsigned char * )malloc( sizeof( unsigned char ) * t_ci->max_size );
 			memset( t_ci->data, 0, sizeof( char ) * t_ci->max_size );
 
+			g_column_data[ i ] = t_ci->data;
+
 			g_rc_array[ i ].columnid = t_ci->column_id;
 			g_rc_array[ i ].pvData = ( void * )t_ci->data;
 			g_rc_array[ i ].cbData = t_ci->max_size;
@@ -24,7 +24,7 @@
 #include <wtypes.h>
 
 #include "globals.h"
-#include "dllrbt.h"
+#include "hash_table.h"
 
 #define ERROR_BUFFER_SIZE	1024
 
@@ -44,18 +44,25 @@ struct COLUMN_INFO
 	long column_id;					// The column ID.
 	unsigned long max_size;			// The maximum size of the column's records.
 	bool JetCompress;				// The column has compressed data.
+	bool projected;					// The property is converted. Only System_ThumbnailCacheId is kept without being projected.
+	unsigned char format;			// PROPERTY_FORMAT_* of the Windows Property. Set by ProjectColumns().
 };
 
 JET_ERR InitESEDBInfo( wchar_t *database_filepath, unsigned long revision, unsigned long page_size );
 JET_ERR OpenTable( JET_PCSTR szTableName, JET_TABLEID *ptableid );
 JET_ERR GetTableColumnInfo( JET_TABLEID tableid, JET_PCSTR szColumnName, JET_COLUMNDEF *pcolumndef );
 void CleanupESEDBInfo();
+COLUMN_INFO *DetachColumnInfo();
+void FreeColumnInfo( COLUMN_INFO *ci );
 
 JET_ERR GetColumnInfo();		// tableid_0A and tableid_0P will be opened on success.
 JET_ERR GetColumnInfoWin8();	// tableid_0A and tableid_0P will be opened on success.
 void BuildRetrieveColumnArray();
-wchar_t *UncompressValue( unsigned char *value, unsigned long value_length );
+char *GetColumnName( wchar_t *name, unsigned long name_length );
+bool UncompressValue( unsigned char *value, unsigned long value_length, OUTPUT_BUFFER *values );
+void ConvertRecord( EXTENDED_INFO **ei, unsigned char **column_data, unsigned long *column_length, OUTPUT_BUFFER *values );
 void ConvertValues( EXTENDED_INFO **ei );
+void ProjectColumns();
 
 void SetErrorMessage( char *msg );
 void HandleESEDBError();
@@ -67,6 +74,8 @@ extern JET_SESID g_sesid;
 extern JET_DBID g_dbid;
 extern JET_TABLEID g_tableid_0P, g_tableid_0A;
 extern JET_RETRIEVECOLUMN *g_rc_array;
+extern unsigned char **g_column_data;
+extern unsigned long *g_column_length;
 extern unsigned long g_column_count;
 extern char *g_ascii_filepath;
 extern COLUMN_INFO *g_ci;
@@ -81,6 +90,6 @@ extern int g_error_offset;
 extern char g_error[ ERROR_BUFFER_SIZE ];
 extern unsigned char g_error_state;
 
-extern dllrbt_tree *g_file_info_tree;
+extern hash_table *g_file_info_table;	// Maps each System_ThumbnailCacheId to its row index.
 
 #endif
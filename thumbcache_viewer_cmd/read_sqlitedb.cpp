@@ -19,76 +19,92 @@
 #include "lite_sqlite3.h"
 
 #include "read_sqlitedb.h"
+#include "map_entries.h"
 #include "utilities.h"
-#include "dllrbt.h"
+#include "hash_table.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 
 void *g_sql_db = NULL;
-dllrbt_tree *g_property_tree = NULL;
+void *g_hash_stmt = NULL;				// Selects the properties of the files whose System_ThumbnailCacheId is the bound hash.
+hash_table *g_property_table = NULL;	// Maps each property Id to its index in g_property_info.
+PROPERTY_INFO *g_property_info = NULL;
+unsigned int g_property_count = 0;
+unsigned int g_property_size = 0;
+OUTPUT_BUFFER g_property_values = { NULL };	// Reused to format each value before it's allocated along with its node.
 
-int dllrbt_property_compare( void *a, void *b )
+void CleanupSQLiteInfo()
 {
-	unsigned long id1 = ( unsigned long )a;
-	unsigned long id2 = ( unsigned long )b;
-
-	if ( id1 > id2 )
+	if ( g_hash_stmt != NULL )
 	{
-		return 1;
+		sqlite3_finalize( g_hash_stmt );
+		g_hash_stmt = NULL;
 	}
 
-	if ( id1 < id2 )
+	sqlite3_close( g_sql_db );
+	g_sql_db = NULL;
+
+	// Free the values of the property table.
+	for ( unsigned int i = 0; i < g_property_count; ++i )
 	{
-		return -1;
+		PROPERTY_INFO *pi = &g_property_info[ i ];
+		if ( pi->sei != NULL  )
+		{
+			free( pi->sei->windows_property );
+			free( pi->sei );
+		}
 	}
 
-	return 0;
+	free( g_property_info );
+	g_property_info = NULL;
+	g_property_count = 0;
+	g_property_size = 0;
+
+	// Clean up our property table.
+	hash_table_delete( g_property_table );
+	g_property_table = NULL;
+
+	FreeBuffer( &g_property_values );
 }
 
-void CleanupSQLiteInfo()
+// Moves the properties out of the property table and appends them to sei so that the values that refer to them outlive the database.
+// If sei can't be grown, then the properties are leaked rather than freed. Must be called before CleanupSQLiteInfo().
+void DetachPropertyInfo( SHARED_EXTENDED_INFO ***sei, unsigned int *count )
 {
-	sqlite3_close( g_sql_db );
-	g_sql_db = NULL;
-
-	// Free the values of the property tree.
-	node_type *node = dllrbt_get_head( g_property_tree );
-	while ( node != NULL )
+	SHARED_EXTENDED_INFO **realloc_sei = ( SHARED_EXTENDED_INFO ** )realloc( *sei, sizeof( SHARED_EXTENDED_INFO * ) * ( ( *count + g_property_count ) > 0 ? ( *count + g_property_count ) : 1 ) );
+	if ( realloc_sei != NULL )
 	{
-		// Free the linked list if there is one.
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )node->val;
-
-		node = node->next;
+		*sei = realloc_sei;
+	}
 
-		if ( pi != NULL )
+	for ( unsigned int i = 0; i < g_property_count; ++i )
+	{
+		if ( g_property_info[ i ].sei != NULL )
 		{
-			if ( pi->sei != NULL  )
+			if ( realloc_sei != NULL )
 			{
-				free( pi->sei->windows_property );
-				free( pi->sei );
+				( *sei )[ ( *count )++ ] = g_property_info[ i ].sei;
 			}
-			free( pi );
+
+			g_property_info[ i ].sei = NULL;
 		}
 	}
-
-	// Clean up our property tree.
-	dllrbt_delete_recursively( g_property_tree );
-	g_property_tree = NULL;
 }
 
-int GetLengthCallback( void *arg, int argc, char **argv, char ** /*azColName*/ )
+void FreePropertyInfo( SHARED_EXTENDED_INFO **sei, unsigned int count )
 {
-	unsigned long *length = ( unsigned long * )arg;
-
-	if ( length != NULL && argc == 1 )
+	if ( sei != NULL )
 	{
-		*length = strtoul( argv[ 0 ], NULL, 10 );
-	}
+		for ( unsigned int i = 0; i < count; ++i )
+		{
+			free( sei[ i ]->windows_property );
+			free( sei[ i ] );
+		}
 
-	return 0;
+		free( sei );
+	}
 }
-int WINAPI	s_GetLengthCallback( void *arg, int argc, char **argv, char **azColName ) { return GetLengthCallback( arg, argc, argv, azColName ); }
-int WINAPIV	c_GetLengthCallback( void *arg, int argc, char **argv, char **azColName ) { return GetLengthCallback( arg, argc, argv, azColName ); }
 
 // argv[ 0 ] = Id
 // argv[ 1 ] = UniqueKey
@@ -113,22 +129,52 @@ int BuildPropertyTreeCallback( void * /*arg*/, int argc, char **argv, char ** /*
 		sei->windows_property = ( wchar_t * )malloc( sizeof( wchar_t ) * property_name_length );
 		property_name_length = MultiByteToWideChar( CP_UTF8, 0, prop_name, -1, sei->windows_property, property_name_length ) - 1;
 
-		// Create the file info tree if it doesn't exist.
-		if ( g_property_tree == NULL )
+		// Properties that aren't projected are never added, so their values are skipped.
+		if ( !IsPropertyProjected( sei->windows_property, property_name_length ) )
+		{
+			free( sei->windows_property );
+			free( sei );
+
+			return 0;
+		}
+
+		// Create the property table if it doesn't exist.
+		if ( g_property_table == NULL )
 		{
-			g_property_tree = dllrbt_create( dllrbt_property_compare );
+			g_property_table = hash_table_create( 0 );
 		}
 
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )malloc( sizeof( PROPERTY_INFO ) );
+		// The properties are stored together and the table refers to them by index.
+		if ( g_property_count == g_property_size )
+		{
+			unsigned int size = ( g_property_size > 0 ? g_property_size * 2 : 256 );
+			PROPERTY_INFO *realloc_info = ( PROPERTY_INFO * )realloc( g_property_info, sizeof( PROPERTY_INFO ) * size );
+			if ( realloc_info == NULL )
+			{
+				free( sei->windows_property );
+				free( sei );
+
+				return 0;
+			}
+
+			g_property_info = realloc_info;
+			g_property_size = size;
+		}
+
+		PROPERTY_INFO *pi = &g_property_info[ g_property_count ];
 		pi->sei = sei;
 		pi->id = ( argv[ 0 ] != NULL ? strtoul( argv[ 0 ], NULL, 10 ) : 0 );
 		pi->property_name_length = property_name_length;
+		pi->format = GetPropertyFormat( sei->windows_property, property_name_length );
 
-		if ( dllrbt_insert( g_property_tree, ( void * )pi->id, pi ) != DLLRBT_STATUS_OK )
+		if ( hash_table_insert( g_property_table, pi->id, g_property_count ) == HASH_TABLE_STATUS_OK )
+		{
+			++g_property_count;
+		}
+		else
 		{
 			free( pi->sei->windows_property );
 			free( pi->sei );
-			free( pi );
 		}
 	}
 
@@ -137,266 +183,185 @@ int BuildPropertyTreeCallback( void * /*arg*/, int argc, char **argv, char ** /*
 int WINAPI	s_BuildPropertyTreeCallback( void *arg, int argc, char **argv, char **azColName ) { return BuildPropertyTreeCallback( arg, argc, argv, azColName ); }
 int WINAPIV	c_BuildPropertyTreeCallback( void *arg, int argc, char **argv, char **azColName ) { return BuildPropertyTreeCallback( arg, argc, argv, azColName ); }
 
-/*
-argv[ 0 ] = WorkId
-argv[ 1 ] = Id
-argv[ 2 ] = UniqueKey
-argv[ 3 ] = Value
-argv[ 4 ] = VariantType
-*/
-int CreatePropertyInfoCallback( void *arg, int argc, char **argv, char ** /*azColName*/ )
+// Converts the property in the current row of a statement and adds it to the front of the list.
+// The row has the ColumnId, Value, and VariantType at column, column + 1, and column + 2.
+// The value is read as text or as a blob depending on its variant type so that it's only converted once.
+void AddPropertyInfo( EXTENDED_INFO **ei_list, void *stmt, int column )
 {
-	FILE_INFO *fi = ( FILE_INFO * )arg;
-	if ( fi != NULL && argc == 5 )
+	SHARED_EXTENDED_INFO *sei = NULL;
+
+	unsigned long Id_num = ( unsigned long )sqlite3_column_int64( stmt, column );
+	PROPERTY_INFO *pi = NULL;
+	unsigned int index = 0;
+	if ( hash_table_find( g_property_table, Id_num, &index ) )
 	{
-		SHARED_EXTENDED_INFO *sei = NULL;
+		pi = &g_property_info[ index ];
+	}
 
-		unsigned long Id_num = ( argv[ 1 ] != NULL ? strtoul( argv[ 1 ], NULL, 10 ) : 0 );
-		PROPERTY_INFO *pi = ( PROPERTY_INFO * )dllrbt_find( g_property_tree, ( void * )Id_num, true );
-		if ( pi != NULL && pi->sei != NULL )
-		{
-			sei = pi->sei;
-		}
-		else
-		{
-			return 0;
-		}
+	if ( pi != NULL && pi->sei != NULL )
+	{
+		sei = pi->sei;
+	}
+	else
+	{
+		return;
+	}
 
-		EXTENDED_INFO *ei = ( EXTENDED_INFO * )malloc( sizeof( EXTENDED_INFO ) );
-		ei->si = ( void * )sei;
-		ei->property_value = NULL;
-		ei->next = NULL;
+	VARENUM Type = ( VARENUM )sqlite3_column_int64( stmt, column + 2 );
 
-		// Windows 8+ columns have a hex number followed by a '-' separating the Windows Property.
-		char *prop_name = strchr( argv[ 2 ], '-' );
-		if ( prop_name == NULL )
-		{
-			prop_name = argv[ 2 ];
-		}
-		else
+	const char *val = NULL;
+	unsigned long length = 0;
+
+	// These are stored as numbers or UTF-8 text.
+	if ( Type == VT_BOOL || Type == VT_LPWSTR || Type == VT_R8 || Type == VT_UI4 )
+	{
+		val = ( const char * )sqlite3_column_text( stmt, column + 1 );
+		length = sqlite3_column_bytes( stmt, column + 1 );	// Excludes the NULL character.
+	}
+	else
+	{
+		val = ( const char * )sqlite3_column_blob( stmt, column + 1 );
+		length = sqlite3_column_bytes( stmt, column + 1 );
+
+		// The fixed size values are read directly.
+		if ( ( ( Type == VT_FILETIME || Type == VT_UI8 ) && length < sizeof( unsigned long long ) ) ||
+			 ( Type == VT_CLSID && length < 16 ) )
 		{
-			++prop_name;
+			Type = VT_EMPTY;
 		}
+	}
 
-		VARENUM Type = ( VARENUM )( argv[ 4 ] != NULL ? strtoul( argv[ 4 ], NULL, 10 ) : 0 );
-		char *val = argv[ 3 ];
+	if ( val == NULL )
+	{
+		return;
+	}
 
-		char *WorkId = argv[ 0 ];
-		char *Id = argv[ 1 ];	// Property type numeric value.
+	// The value is formatted into a reusable buffer so that it can be allocated along with its node.
+	g_property_values.length = 0;
 
-		int buf_count = 0;
+	bool converted = false;
 
-		switch ( Type )
+	switch ( Type )
+	{
+		case VT_BOOL:
 		{
-			case VT_BOOL:
-			{
-				buf_count = ( *val != '0' ? 4 : 5 );	// "true" or "false"
-				ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-				wcscpy_s( ei->property_value, buf_count + 1, ( *val != '0' ? L"true" : L"false" ) );
-			}
-			break;
+			converted = ( *val != '0' ? BufferWriteW( &g_property_values, L"true", 4 ) : BufferWriteW( &g_property_values, L"false", 5 ) );
+		}
+		break;
 
-			case VT_LPWSTR:
+		case VT_UI4:
+		{
+			if ( pi->format == PROPERTY_FORMAT_FILE_ATTRIBUTES )
 			{
-				int val_length = MultiByteToWideChar( CP_UTF8, 0, val, -1, NULL, 0 );	// Include the NULL terminator.
-				ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * val_length );
-				MultiByteToWideChar( CP_UTF8, 0, val, -1, ei->property_value, val_length );
-			}
-			break;
+				converted = BufferWriteFileAttributesW( &g_property_values, strtoul( val, NULL, 10 ) );
 
-			case VT_R8:
-			{
-				int val_length = MultiByteToWideChar( CP_UTF8, 0, val, -1, NULL, 0 );	// Include the NULL terminator.
-				ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * val_length );
-				MultiByteToWideChar( CP_UTF8, 0, val, -1, ei->property_value, val_length );
+				break;
 			}
-			break;
-
-			case VT_FILETIME:
+			else if ( pi->format == PROPERTY_FORMAT_SFGAO )
 			{
-				unsigned long long time = 0;
-				memcpy_s( &time, sizeof( unsigned long long ), val, sizeof( unsigned long long ) );
-
-				SYSTEMTIME st;
-				FILETIME ft;
-				ft.dwLowDateTime = ( DWORD )time;
-				ft.dwHighDateTime = ( DWORD )( time >> 32 );
-				FileTimeToSystemTime( &ft, &st );
+				converted = BufferWriteSFGAOW( &g_property_values, strtoul( val, NULL, 10 ) );
 
-				buf_count = _scwprintf( L"%d/%d/%d (%02d:%02d:%02d.%d) [UTC]", st.wMonth, st.wDay, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds );
-				if ( buf_count > 0 )
-				{
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( buf_count + 1 ) );
-					swprintf_s( ei->property_value, buf_count + 1, L"%d/%d/%d (%02d:%02d:%02d.%d) [UTC]", st.wMonth, st.wDay, st.wYear, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds );
-				}
+				break;
 			}
-			break;
 
-			case VT_UI4:
-			{
-				unsigned long num_val = strtoul( val, NULL, 10 );
+			// Fall through to VT_LPWSTR.
+		}
 
-				if ( pi->property_name_length == 21 && wcscmp( sei->windows_property, L"System_FileAttributes" ) == 0 )
-				{
-					ei->property_value = GetFileAttributesStr( num_val );
-				}
-				else if ( ( pi->property_name_length == 17 && wcscmp( sei->windows_property, L"System_SFGAOFlags" ) == 0 ) ||
-						  ( pi->property_name_length == 28 && wcscmp( sei->windows_property, L"System_Link_TargetSFGAOFlags" ) == 0 ) )
-				{
-					ei->property_value = GetSFGAOStr( num_val );
-				}
-				else
-				{
-					int val_length = MultiByteToWideChar( CP_UTF8, 0, val, -1, NULL, 0 );	// Include the NULL terminator.
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * val_length );
-					MultiByteToWideChar( CP_UTF8, 0, val, -1, ei->property_value, val_length );
-				}
+		case VT_LPWSTR:
+		case VT_R8:
+		{
+			// A UTF-8 string has at least as many bytes as it has UTF-16 characters.
+			if ( length == 0 )
+			{
+				converted = true;
 			}
-			break;
-
-			case VT_UI8:
+			else if ( BufferReserve( &g_property_values, sizeof( wchar_t ) * length ) )
 			{
-				unsigned long long ui8_val = 0;
-				memcpy_s( &ui8_val, sizeof( unsigned long long ), val, sizeof( unsigned long long ) );
-
-				if ( pi->property_name_length == 23 && wcscmp( sei->windows_property, L"System_ThumbnailCacheId" ) == 0 )
-				{
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * 17 );
-					swprintf_s( ei->property_value, 17, L"%016llx", ui8_val );
-				}
-				else if ( pi->property_name_length == 11 && wcscmp( sei->windows_property, L"System_Size" ) == 0 )
-				{
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( 15 ) );
-					swprintf_s( ei->property_value, 15, L"%llu bytes", ui8_val );
-				}
-				else
+				int val_length = MultiByteToWideChar( CP_UTF8, 0, val, length, ( wchar_t * )g_property_values.buffer, length );
+				if ( val_length > 0 )
 				{
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * ( 9 ) );
-					swprintf_s( ei->property_value, 9, L"%llu", ui8_val );
+					g_property_values.length = sizeof( wchar_t ) * val_length;
+					converted = true;
 				}
 			}
-			break;
+		}
+		break;
 
-			case VT_CLSID:
-			{
-				// Output GUID formatted value.
-				unsigned long val_1 = 0;
-				unsigned short val_2 = 0, val_3 = 0;
+		case VT_FILETIME:
+		{
+			unsigned long long time = 0;
+			memcpy_s( &time, sizeof( unsigned long long ), val, sizeof( unsigned long long ) );
 
-				memcpy_s( &val_1, sizeof( unsigned long ), val, sizeof( unsigned long ) );
-				memcpy_s( &val_2, sizeof( unsigned short ), val + sizeof( unsigned long ), sizeof( unsigned short ) );
-				memcpy_s( &val_3, sizeof( unsigned short ), val + sizeof( unsigned long ) + sizeof( unsigned short ), sizeof( unsigned short ) );
+			converted = BufferWriteFileTimeW( &g_property_values, time );
+		}
+		break;
 
-				buf_count = ( 32 + 6 + 1 );
-				ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
+		case VT_UI8:
+		{
+			unsigned long long ui8_val = 0;
+			memcpy_s( &ui8_val, sizeof( unsigned long long ), val, sizeof( unsigned long long ) );
 
-				unsigned long property_value_offset = swprintf_s( ei->property_value, buf_count, L"{%08x-%04x-%04x-", val_1, val_2, val_3 );
-				for ( unsigned long h = sizeof( unsigned long ) + ( sizeof( unsigned short ) * 2 ); h < 16; ++h )
-				{
-					if ( h == 10 )
-					{
-						ei->property_value[ property_value_offset ] = L'-';
-						++property_value_offset;
-					}
-					property_value_offset += swprintf_s( ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", ( ( unsigned char * )val )[ h ] );
-				}
-				ei->property_value[ buf_count - 2 ] = L'}';
-				ei->property_value[ buf_count - 1 ] = 0;	// Sanity.
+			if ( pi->format == PROPERTY_FORMAT_CACHE_ID )
+			{
+				converted = BufferWriteHexW( &g_property_values, ui8_val, 16 );
 			}
-			break;
-
-			case VT_BLOB:
+			else if ( pi->format == PROPERTY_FORMAT_SIZE )
 			{
-				if ( pi->property_name_length == 11 && wcscmp( sei->windows_property, L"System_Kind" ) == 0 )
-				{
-					unsigned long length = 0;
-
-					char query[ 256 ];
-					sprintf_s( query, 256, "SELECT length(Value) FROM SystemIndex_1_PropertyStore WHERE WorkId = %s AND ColumnId = %s", WorkId, Id );
-					int sql_rc = sqlite3_exec( g_sql_db, query, GetLengthCallback, ( void * )&length, NULL/*&sql_err_msg*/ );
-					if ( sql_rc == SQLITE_OK )
-					{
-						ei->property_value = ( wchar_t * )malloc( sizeof( char ) * ( length + sizeof( wchar_t ) ) );	// Include the NULL terminator.
-						memcpy_s( ei->property_value, sizeof( char ) * ( length + sizeof( wchar_t ) ), val, length );
-
-						unsigned long property_value_size = length / sizeof( wchar_t );
-						ei->property_value[ property_value_size ] = 0;	// Sanity.
-
-						// See if we have any string arrays.
-						if ( wcslen( ei->property_value ) < property_value_size )
-						{
-							// Replace the NULL character at the end of each string (except the last) with a ';' separator.
-							wchar_t *t_val = ei->property_value;
-							while ( t_val < ( ei->property_value + property_value_size ) )
-							{
-								if ( *t_val == 0 )
-								{
-									*t_val = L';';
-								}
-
-								++t_val;
-							}
-						}
-					}
-					/*else
-					{
-						sqlite3_free( sql_err_msg );
-					}*/
-
-					break;
-				}
-				/*else if ( ( pi->property_name_length == 16 && wcscmp( sei->windows_property, L"InvertedOnlyPids" ) == 0 ) ||
-						  ( pi->property_name_length == 15 && wcscmp( sei->windows_property, L"InvertedOnlyMD5" ) == 0 ) )
-				{
-					// Output hex values.
-					unsigned long property_value_offset = 0;
-
-					buf_count = ( length * 2 ) + 1;
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
-					for ( unsigned long h = 0; h < length; ++h )
-					{
-						property_value_offset += swprintf_s( ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", ( ( unsigned char * )val )[ h ] );
-					}
-				}*/
-
-				// Fall through for everything else and output hex values.
+				converted = ( BufferWriteUnsignedW( &g_property_values, ui8_val ) && BufferWriteW( &g_property_values, L" bytes", 6 ) );
 			}
+			else
+			{
+				converted = BufferWriteUnsignedW( &g_property_values, ui8_val );
+			}
+		}
+		break;
+
+		case VT_CLSID:
+		{
+			// Output GUID formatted value.
+			converted = BufferWriteGUIDW( &g_property_values, ( unsigned char * )val );
+		}
+		break;
 
-			default:
+		case VT_BLOB:
+		{
+			if ( pi->format == PROPERTY_FORMAT_KIND )
 			{
-				unsigned long length = 0;
+				// Any string arrays have a ';' separator.
+				converted = BufferWriteStringListW( &g_property_values, ( unsigned char * )val, length / sizeof( wchar_t ) );
 
-				char query[ 256 ];
-				sprintf_s( query, 256, "SELECT length(Value) FROM SystemIndex_1_PropertyStore WHERE WorkId = %s AND ColumnId = %s", WorkId, Id );
-				int sql_rc = sqlite3_exec( g_sql_db, query, GetLengthCallback, ( void * )&length, NULL/*&sql_err_msg*/ );
-				if ( sql_rc == SQLITE_OK )
-				{
-					// Output hex values.
-					unsigned long property_value_offset = 0;
-
-					buf_count = ( length * 2 ) + 1;
-					ei->property_value = ( wchar_t * )malloc( sizeof( wchar_t ) * buf_count );
-					for ( unsigned long h = 0; h < length; ++h )
-					{
-						property_value_offset += swprintf_s( ei->property_value + property_value_offset, buf_count - property_value_offset, L"%02x", ( ( unsigned char * )val )[ h ] );
-					}
-				}
-				/*else
-				{
-					sqlite3_free( sql_err_msg );
-				}*/
+				break;
 			}
-			break;
+
+			// Fall through for everything else and output hex values.
 		}
 
-		if ( fi->ei != NULL )
+		default:
 		{
-			ei->next = fi->ei;
+			// Output hex values.
+			converted = BufferWriteHexBytesW( &g_property_values, ( unsigned char * )val, length );
 		}
+		break;
+	}
 
-		fi->ei = ei;
+	// Every value is NULL terminated.
+	if ( !converted || !BufferWrite( &g_property_values, L"", sizeof( wchar_t ) ) )
+	{
+		return;
 	}
-	return 0;
+
+	EXTENDED_INFO *ei = ( EXTENDED_INFO * )malloc( sizeof( EXTENDED_INFO ) + g_property_values.length );
+	if ( ei == NULL )
+	{
+		return;
+	}
+
+	ei->si = ( void * )sei;
+	ei->property_value = ( wchar_t * )( ei + 1 );
+	ei->block = true;
+
+	memcpy_s( ei->property_value, g_property_values.length, g_property_values.buffer, g_property_values.length );
+
+	ei->next = *ei_list;
+	*ei_list = ei;
 }
-int WINAPI	s_CreatePropertyInfoCallback( void *arg, int argc, char **argv, char **azColName ) { return CreatePropertyInfoCallback( arg, argc, argv, azColName ); }
-int WINAPIV	c_CreatePropertyInfoCallback( void *arg, int argc, char **argv, char **azColName ) { return CreatePropertyInfoCallback( arg, argc, argv, azColName ); }
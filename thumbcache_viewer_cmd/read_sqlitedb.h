@@ -33,19 +33,24 @@ struct PROPERTY_INFO
 	SHARED_EXTENDED_INFO *sei;
 	unsigned long property_name_length;
 	unsigned long id;
+	unsigned char format;	// PROPERTY_FORMAT_* of the Windows Property.
 };
 
 void CleanupSQLiteInfo();
+void DetachPropertyInfo( SHARED_EXTENDED_INFO ***sei, unsigned int *count );
+void FreePropertyInfo( SHARED_EXTENDED_INFO **sei, unsigned int count );
 
 int BuildPropertyTreeCallback( void * /*arg*/, int argc, char **argv, char ** /*azColName*/ );
-int CreatePropertyInfoCallback( void *arg, int argc, char **argv, char ** /*azColName*/ );
 
 int WINAPIV c_BuildPropertyTreeCallback( void *arg, int argc, char **argv, char **azColName );
-int WINAPIV c_CreatePropertyInfoCallback( void *arg, int argc, char **argv, char **azColName );
 
 int WINAPI s_BuildPropertyTreeCallback( void *arg, int argc, char **argv, char **azColName );
-int WINAPI s_CreatePropertyInfoCallback( void *arg, int argc, char **argv, char **azColName );
+
+void AddPropertyInfo( EXTENDED_INFO **ei_list, void *stmt, int column );
 
 extern void *g_sql_db;
+extern void *g_hash_stmt;
+extern PROPERTY_INFO *g_property_info;
+extern unsigned int g_property_count;
 
 #endif
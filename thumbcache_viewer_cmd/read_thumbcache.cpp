@@ -0,0 +1,2558 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "read_thumbcache.h"
+#include "crc64.h"
+#include "find_signature.h"
+#include "map_entries.h"
+#include "utilities.h"
+
+#include <process.h>
+
+#ifdef _WIN64
+	#define MAP_VIEW_SIZE	0						// Map the entire database at once.
+#else
+	#define MAP_VIEW_SIZE	( 64 * 1024 * 1024 )	// Map 64 megabytes at a time so that large databases don't exhaust our address space.
+#endif
+
+#define SCAN_CHUNK_SIZE		( 1024 * 1024 )
+
+#define FLUSH_THRESHOLD		( 1024 * 1024 )	// Write the output of the job at commit_index once it has this many bytes buffered.
+
+// A header that begins at the end of a region is read along with it. The Windows Vista and 8 headers are the largest.
+#define CARVE_OVERLAP		( max( sizeof( database_cache_entry_vista ), sizeof( database_cache_entry_8 ) ) - 1 )
+
+unsigned long g_allocation_granularity = 0;
+
+// Cache types are indexed by the type value in the database header.
+
+// Windows Vista & 7: 00 = 32, 01 = 96, 02 = 256, 03 = 1024, 04 = sr
+static const CACHE_TYPE cache_types_7[] =
+{
+	{ "thumbcache_32.db", "32x32" },
+	{ "thumbcache_96.db", "96x96" },
+	{ "thumbcache_256.db", "256x256" },
+	{ "thumbcache_1024.db", "1024x1024" },
+	{ "thumbcache_sr.db", NULL }
+};
+
+// Windows 8: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 1024, 06 = sr, 07 = wide, 08 = exif
+static const CACHE_TYPE cache_types_8[] =
+{
+	{ "thumbcache_16.db", "16x16" },
+	{ "thumbcache_32.db", "32x32" },
+	{ "thumbcache_48.db", "48x48" },
+	{ "thumbcache_96.db", "96x96" },
+	{ "thumbcache_256.db", "256x256" },
+	{ "thumbcache_1024.db", "1024x1024" },
+	{ "thumbcache_sr.db", NULL },
+	{ "thumbcache_wide.db", NULL },
+	{ "thumbcache_exif.db", NULL }
+};
+
+// Windows 8.1: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 1024, 06 = 1600, 07 = sr, 08 = wide, 09 = exif, 0A = wide_alternate
+static const CACHE_TYPE cache_types_8_1[] =
+{
+	{ "thumbcache_16.db", "16x16" },
+	{ "thumbcache_32.db", "32x32" },
+	{ "thumbcache_48.db", "48x48" },
+	{ "thumbcache_96.db", "96x96" },
+	{ "thumbcache_256.db", "256x256" },
+	{ "thumbcache_1024.db", "1024x1024" },
+	{ "thumbcache_1600.db", "1600x1600" },
+	{ "thumbcache_sr.db", NULL },
+	{ "thumbcache_wide.db", NULL },
+	{ "thumbcache_exif.db", NULL },
+	{ "thumbcache_wide_alternate.db", NULL }
+};
+
+// Windows 10: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 768, 06 = 1280, 07 = 1920, 08 = 2560, 09 = sr, 0A = wide, 0B = exif, 0C = wide_alternate, 0D = custom_stream
+static const CACHE_TYPE cache_types_10[] =
+{
+	{ "thumbcache_16.db", "16x16" },
+	{ "thumbcache_32.db", "32x32" },
+	{ "thumbcache_48.db", "48x48" },
+	{ "thumbcache_96.db", "96x96" },
+	{ "thumbcache_256.db", "256x256" },
+	{ "thumbcache_768.db", "768x768" },
+	{ "thumbcache_1280.db", "1280x1280" },
+	{ "thumbcache_1920.db", "1920x1920" },
+	{ "thumbcache_2560.db", "2560x2560" },
+	{ "thumbcache_sr.db", NULL },
+	{ "thumbcache_wide.db", NULL },
+	{ "thumbcache_exif.db", NULL },
+	{ "thumbcache_wide_alternate.db", NULL },
+	{ "thumbcache_custom_stream.db", NULL }
+};
+
+bool OpenDatabaseMap( HANDLE hFile, DATABASE_MAP *dm, bool read_ranges )
+{
+	memset( dm, 0, sizeof( DATABASE_MAP ) );
+
+	dm->hFile = hFile;
+	dm->read_ranges = read_ranges;
+
+	LARGE_INTEGER file_size;
+	if ( GetFileSizeEx( hFile, &file_size ) == FALSE )
+	{
+		return false;
+	}
+
+	dm->size = file_size.QuadPart;
+
+	// A mapping can't be created for an empty file. Every view request will simply fail.
+	if ( dm->size > 0 && !read_ranges )
+	{
+		dm->hMapping = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+		if ( dm->hMapping == NULL )
+		{
+			return false;
+		}
+	}
+
+	if ( g_allocation_granularity == 0 )
+	{
+		SYSTEM_INFO si;
+		GetSystemInfo( &si );
+		g_allocation_granularity = si.dwAllocationGranularity;
+	}
+
+	return true;
+}
+
+void CloseDatabaseMap( DATABASE_MAP *dm )
+{
+	CloseDatabaseView( dm );
+
+	if ( dm->hMapping != NULL )
+	{
+		CloseHandle( dm->hMapping );
+		dm->hMapping = NULL;
+	}
+}
+
+// Copies the mapping of src so that another thread can have its own views of it. The copy does not own the mapping.
+void ShareDatabaseMap( const DATABASE_MAP *src, DATABASE_MAP *dm )
+{
+	memset( dm, 0, sizeof( DATABASE_MAP ) );
+
+	dm->hFile = src->hFile;
+	dm->hMapping = src->hMapping;
+	dm->size = src->size;
+	dm->read_ranges = src->read_ranges;
+}
+
+void CloseDatabaseView( DATABASE_MAP *dm )
+{
+	if ( dm->view != NULL )
+	{
+		UnmapViewOfFile( dm->view );
+		dm->view = NULL;
+	}
+
+	free( dm->buffer );
+	dm->buffer = NULL;
+	dm->buffer_size = 0;
+}
+
+// Returns a pointer to length bytes at offset, or NULL if the range extends beyond the end of the database.
+unsigned char *GetMapView( DATABASE_MAP *dm, unsigned long long offset, unsigned int length )
+{
+	if ( offset > dm->size || length > ( dm->size - offset ) )
+	{
+		return NULL;
+	}
+
+	if ( dm->read_ranges )
+	{
+		// Always have a buffer so that an empty range still succeeds.
+		if ( dm->buffer == NULL || length > dm->buffer_size )
+		{
+			unsigned int buffer_size = max( length, 256 );
+			unsigned char *realloc_buffer = ( unsigned char * )realloc( dm->buffer, sizeof( unsigned char ) * buffer_size );
+			if ( realloc_buffer == NULL )
+			{
+				return NULL;
+			}
+
+			dm->buffer = realloc_buffer;
+			dm->buffer_size = buffer_size;
+		}
+
+		// The read is positioned so that the workers sharing the handle don't need to move its file pointer.
+		OVERLAPPED ol = { 0 };
+		ol.Offset = ( DWORD )offset;
+		ol.OffsetHigh = ( DWORD )( offset >> 32 );
+
+		DWORD read = 0;
+		if ( length > 0 && ( ReadFile( dm->hFile, dm->buffer, length, &read, &ol ) == FALSE || read != length ) )
+		{
+			return NULL;
+		}
+
+		return dm->buffer;
+	}
+
+	if ( dm->hMapping == NULL )
+	{
+		return NULL;
+	}
+
+	// Remap if the range isn't entirely within our current view.
+	if ( dm->view == NULL || offset < dm->view_offset || ( offset + length ) > ( dm->view_offset + dm->view_size ) )
+	{
+		if ( dm->view != NULL )
+		{
+			UnmapViewOfFile( dm->view );
+			dm->view = NULL;
+		}
+
+		// Views must begin on a multiple of the allocation granularity.
+		unsigned long long view_offset = offset - ( offset % g_allocation_granularity );
+		unsigned long long view_size = dm->size - view_offset;
+
+		if ( MAP_VIEW_SIZE != 0 )
+		{
+			// Make sure the view is at least large enough to hold the range.
+			unsigned long long min_view_size = max( MAP_VIEW_SIZE, ( offset - view_offset ) + length );
+			if ( view_size > min_view_size )
+			{
+				view_size = min_view_size;
+			}
+		}
+
+		dm->view = ( unsigned char * )MapViewOfFile( dm->hMapping, FILE_MAP_READ, ( DWORD )( view_offset >> 32 ), ( DWORD )view_offset, ( SIZE_T )view_size );
+		if ( dm->view == NULL )
+		{
+			return NULL;
+		}
+
+		dm->view_offset = view_offset;
+		dm->view_size = view_size;
+	}
+
+	return dm->view + ( offset - dm->view_offset );
+}
+
+// Sets offset to the location of the next magic identifier at or beyond offset.
+bool scan_memory( DATABASE_MAP *dm, unsigned long long &offset )
+{
+	while ( offset < dm->size && ( dm->size - offset ) >= 4 )
+	{
+		// Scan the database in 1 megabyte chunks. This value is arbitrary, but keeps each view well within a 32-bit map window.
+		unsigned int length = ( unsigned int )min( SCAN_CHUNK_SIZE, dm->size - offset );
+
+		unsigned char *buf = GetMapView( dm, offset, length );
+		if ( buf == NULL )
+		{
+			return false;
+		}
+
+		size_t index = find_signature( buf, length );
+		if ( index < length )
+		{
+			offset += index;
+
+			return true;
+		}
+
+		// Overlap the next chunk by 3 bytes in case we truncated the magic identifier.
+		offset += ( length - 3 );
+	}
+
+	return false;
+}
+
+// Returns NULL if the database version is not supported.
+const char *GetVersionName( unsigned int version )
+{
+	const char *version_name = NULL;
+
+	switch ( version )
+	{
+		case WINDOWS_VISTA:
+		{
+			version_name = "Windows Vista";
+		}
+		break;
+
+		case WINDOWS_7:
+		{
+			version_name = "Windows 7";
+		}
+		break;
+
+		case WINDOWS_8:
+		case WINDOWS_8v2:
+		case WINDOWS_8v3:
+		{
+			version_name = "Windows 8";
+		}
+		break;
+
+		case WINDOWS_8_1:
+		{
+			version_name = "Windows 8.1";
+		}
+		break;
+
+		case WINDOWS_10:
+		{
+			version_name = "Windows 10";
+		}
+		break;
+	}
+
+	return version_name;
+}
+
+// Returns NULL if the cache type is unknown.
+const CACHE_TYPE *GetCacheType( unsigned int version, unsigned int type )
+{
+	const CACHE_TYPE *cache_types = NULL;
+	unsigned int cache_type_count = 0;
+
+	switch ( version )
+	{
+		case WINDOWS_VISTA:
+		case WINDOWS_7:
+		{
+			cache_types = cache_types_7;
+			cache_type_count = sizeof( cache_types_7 ) / sizeof( CACHE_TYPE );
+		}
+		break;
+
+		case WINDOWS_8:
+		case WINDOWS_8v2:
+		case WINDOWS_8v3:
+		{
+			cache_types = cache_types_8;
+			cache_type_count = sizeof( cache_types_8 ) / sizeof( CACHE_TYPE );
+		}
+		break;
+
+		case WINDOWS_8_1:
+		{
+			cache_types = cache_types_8_1;
+			cache_type_count = sizeof( cache_types_8_1 ) / sizeof( CACHE_TYPE );
+		}
+		break;
+
+		case WINDOWS_10:
+		{
+			cache_types = cache_types_10;
+			cache_type_count = sizeof( cache_types_10 ) / sizeof( CACHE_TYPE );
+		}
+		break;
+	}
+
+	return ( type < cache_type_count ? &cache_types[ type ] : NULL );
+}
+
+// Compares thumbnail filenames the same way the file system does.
+int dllrbt_filename_compare( void *a, void *b )
+{
+	return _wcsicmp( ( wchar_t * )a, ( wchar_t * )b );
+}
+
+// Selects the lock and tree that guard a thumbnail filename.
+unsigned int GetFilenameStripe( const wchar_t *filename )
+{
+	unsigned int hash = 2166136261;	// FNV-1a
+
+	while ( *filename != NULL )
+	{
+		hash ^= towlower( *filename++ );
+		hash *= 16777619;
+	}
+
+	return hash % THUMBNAIL_LOCK_COUNT;
+}
+
+// Databases of different sizes share entry hashes, and a database can hold the same hash more than once, so two workers can write thumbnails with the same filename.
+// The entry that comes last in the input order must win, just as it would if the entries were extracted one at a time.
+// sequence is the job index in the high 32 bits and the step index in the low 32 bits.
+bool WriteThumbnail( EXTRACT_INFO *ei, unsigned long long sequence, wchar_t *filename, unsigned char *data, unsigned int data_size )
+{
+	bool ret = false;
+	DWORD written = 0;
+
+	CRITICAL_SECTION *thumbnail_cs = NULL;
+
+	if ( ei->thread_count > 1 )
+	{
+		unsigned int stripe = GetFilenameStripe( filename );
+
+		thumbnail_cs = &ei->thumbnail_cs[ stripe ];
+		EnterCriticalSection( thumbnail_cs );
+
+		node_type *node = ( node_type * )dllrbt_find( ei->thumbnail_tree[ stripe ], ( void * )filename, false );
+		if ( node != NULL )
+		{
+			// An entry that comes after this one has already written the file. Report it as written since it would have been overwritten anyway.
+			if ( *( unsigned long long * )node->val > sequence )
+			{
+				LeaveCriticalSection( thumbnail_cs );
+
+				return true;
+			}
+
+			*( unsigned long long * )node->val = sequence;
+		}
+		else
+		{
+			wchar_t *key = _wcsdup( filename );
+			unsigned long long *val = ( unsigned long long * )malloc( sizeof( unsigned long long ) );
+			if ( key != NULL && val != NULL )
+			{
+				*val = sequence;
+
+				if ( dllrbt_insert( ei->thumbnail_tree[ stripe ], ( void * )key, ( void * )val ) == DLLRBT_STATUS_OK )
+				{
+					key = NULL;
+					val = NULL;
+				}
+			}
+
+			free( val );
+			free( key );
+		}
+	}
+
+	HANDLE hFile_save = CreateFile( filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile_save != INVALID_HANDLE_VALUE )
+	{
+		WriteFile( hFile_save, data, data_size, &written, NULL );
+		CloseHandle( hFile_save );
+
+		ret = true;
+	}
+
+	if ( thumbnail_cs != NULL )
+	{
+		LeaveCriticalSection( thumbnail_cs );
+	}
+
+	return ret;
+}
+
+// Creates the report files if they haven't been created yet and begins the job's section in each.
+void StartReports( EXTRACT_INFO *ei )
+{
+	DWORD written = 0;
+
+	char output_filename[ 64 ] = { 0 };
+	int output_filename_length = 0;
+
+	if ( ( ei->output_html && ei->hFile_html == INVALID_HANDLE_VALUE ) || ( ei->output_csv && ei->hFile_csv == INVALID_HANDLE_VALUE ) )
+	{
+		SYSTEMTIME st;
+		GetLocalTime( &st );
+
+		output_filename_length = sprintf_s( output_filename, 64, "report_%04lu%02lu%02lu_%02lu%02lu%02lu.", st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond );
+	}
+
+	// Create the HTML report file.
+	if ( ei->output_html )
+	{
+		if ( ei->hFile_html == INVALID_HANDLE_VALUE )
+		{
+			output_filename[ output_filename_length + 0 ] = 'h';
+			output_filename[ output_filename_length + 1 ] = 't';
+			output_filename[ output_filename_length + 2 ] = 'm';
+			output_filename[ output_filename_length + 3 ] = 'l';
+			output_filename[ output_filename_length + 4 ] = 0;
+
+			ei->hFile_html = CreateFileA( output_filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+			if ( ei->hFile_html == INVALID_HANDLE_VALUE )
+			{
+				wprintf( L"HTML report could not be created.\n" );
+				ei->output_html = false;
+			}
+			else
+			{
+				// Add UTF-8 marker (BOM) if we're at the beginning of the file.
+				if ( SetFilePointer( ei->hFile_html, 0, NULL, FILE_END ) == 0 )
+				{
+					WriteFile( ei->hFile_html, "\xEF\xBB\xBF", 3, &written, NULL );
+				}
+
+				WriteFile( ei->hFile_html, "<!DOCTYPE html><html><head><title>HTML Report</title><style>pre{font-family:inherit;margin:0;}</style></head><body>", 115, &written, NULL );
+			}
+		}
+	}
+
+	// Create the CSV report file.
+	if ( ei->output_csv )
+	{
+		if ( ei->hFile_csv == INVALID_HANDLE_VALUE )
+		{
+			output_filename[ output_filename_length + 0 ] = 'c';
+			output_filename[ output_filename_length + 1 ] = 's';
+			output_filename[ output_filename_length + 2 ] = 'v';
+			output_filename[ output_filename_length + 3 ] = 0;
+
+			ei->hFile_csv = CreateFileA( output_filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+			if ( ei->hFile_csv == INVALID_HANDLE_VALUE )
+			{
+				wprintf( L"CVS report could not be created.\n" );
+				ei->output_csv = false;
+			}
+			else
+			{
+				// Add UTF-8 marker (BOM) if we're at the beginning of the file.
+				if ( SetFilePointer( ei->hFile_csv, 0, NULL, FILE_END ) == 0 )
+				{
+					WriteFile( ei->hFile_csv, "\xEF\xBB\xBF", 3, &written, NULL );
+				}
+			}
+		}
+		else
+		{
+			WriteFile( ei->hFile_csv, "\r\n", 2, &written, NULL );
+		}
+	}
+}
+
+// Writes and empties the job's buffers. Only the job at commit_index may call this.
+void FlushJob( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	DWORD written = 0;
+
+	if ( !job->started )
+	{
+		job->started = true;
+
+		// Separate the output of each database.
+		if ( job->index > 0 )
+		{
+			wprintf( L"\n" );
+		}
+	}
+
+	if ( job->console.length > 0 )
+	{
+		// The console is in Unicode mode for the whole run. See wmain.
+		fputws( ( wchar_t * )job->console.buffer, stdout );
+
+		job->console.length = 0;
+	}
+
+	if ( job->start_reports )
+	{
+		job->start_reports = false;
+
+		StartReports( ei );
+	}
+
+	if ( job->html.length > 0 )
+	{
+		if ( ei->hFile_html != INVALID_HANDLE_VALUE )
+		{
+			WriteFile( ei->hFile_html, job->html.buffer, job->html.length, &written, NULL );
+		}
+
+		job->html.length = 0;
+	}
+
+	if ( job->csv.length > 0 )
+	{
+		if ( ei->hFile_csv != INVALID_HANDLE_VALUE )
+		{
+			WriteFile( ei->hFile_csv, job->csv.buffer, job->csv.length, &written, NULL );
+		}
+
+		job->csv.length = 0;
+	}
+}
+
+// Walks the cache entries by following the cache entry sizes and adds to the list of steps that ExtractSteps will extract.
+// first_entry is the number of entries before current_position. The step list must not have room for more steps.
+// Only the entry headers and the first bytes of the data are read. Returns false if the step list could not be allocated.
+template < typename T >
+bool WalkEntries( EXTRACT_JOB *job, DATABASE_MAP *dm, unsigned long long current_position, unsigned int first_entry )
+{
+	unsigned int step_size = job->step_count;
+
+	T dce;
+
+	for ( unsigned int i = first_entry; true; )
+	{
+		if ( job->step_count == step_size )
+		{
+			step_size = ( step_size > 0 ? step_size * 2 : 1024 );
+			ENTRY_INDEX_RECORD *realloc_buffer = ( ENTRY_INDEX_RECORD * )realloc( job->steps, sizeof( ENTRY_INDEX_RECORD ) * step_size );
+			if ( realloc_buffer == NULL )
+			{
+				return false;
+			}
+
+			job->steps = realloc_buffer;
+		}
+
+		ENTRY_INDEX_RECORD *step = &job->steps[ job->step_count++ ];
+		memset( step, 0, sizeof( ENTRY_INDEX_RECORD ) );
+		step->offset = current_position;
+		step->number = i + 1;
+
+		job->entry_count = i;
+
+		unsigned char *view = GetMapView( dm, current_position, sizeof( T ) );
+		if ( view == NULL )
+		{
+			step->type = STEP_END_OF_FILE;
+			break;
+		}
+
+		// If we find the beginning of the next entry, then it gets the same entry number.
+		if ( memcmp( view, "CMMM", 4 ) != 0 )
+		{
+			if ( scan_memory( dm, current_position ) )
+			{
+				step->type = STEP_SCAN_FOUND;
+				continue;
+			}
+
+			step->type = STEP_SCAN_FAILED;
+			break;
+		}
+
+		memcpy( &dce, view, sizeof( T ) );
+
+		// Skip the header of an empty entry. It also keeps the same entry number.
+		if ( dce.entry_hash == 0 )
+		{
+			step->type = STEP_EMPTY;
+			current_position += sizeof( T );
+			continue;
+		}
+
+		step->type = STEP_ENTRY;
+		step->entry_hash = dce.entry_hash;
+		step->data_checksum = dce.data_checksum;
+		step->header_checksum = dce.header_checksum;
+		step->data_size = dce.data_size;
+
+		// These are the same checks that end the extraction in ExtractSteps.
+		unsigned long long filename_position = current_position + sizeof( T );
+		if ( dce.filename_length != 0 && filename_position >= dm->size )
+		{
+			break;
+		}
+
+		unsigned long long data_position = filename_position + dce.filename_length + dce.padding_size;
+		if ( dce.data_size != 0 && data_position >= dm->size )
+		{
+			break;
+		}
+
+		step->data_offset = data_position;
+
+		// Our longest identifier is 8 bytes.
+		unsigned int type_length = ( unsigned int )min( min( dce.data_size, 8 ), dm->size - data_position );
+		view = GetMapView( dm, data_position, type_length );
+		if ( view != NULL )
+		{
+			if ( type_length >= 2 && memcmp( view, FILE_TYPE_BMP, 2 ) == 0 )
+			{
+				step->file_type = ENTRY_FILE_TYPE_BMP;
+			}
+			else if ( type_length >= 4 && memcmp( view, FILE_TYPE_JPEG, 4 ) == 0 )
+			{
+				step->file_type = ENTRY_FILE_TYPE_JPG;
+			}
+			else if ( type_length >= 8 && memcmp( view, FILE_TYPE_PNG, 8 ) == 0 )
+			{
+				step->file_type = ENTRY_FILE_TYPE_PNG;
+			}
+		}
+
+		++i;
+
+		// An entry that doesn't advance our position would be read forever.
+		if ( dce.cache_entry_size == 0 )
+		{
+			job->entry_count = i;
+			break;
+		}
+
+		current_position += dce.cache_entry_size;
+	}
+
+	return true;
+}
+
+// Extracts the steps in [ first, last ) to the given buffers.
+// The step loop is instantiated once for each entry layout so that the database version only needs to be checked once.
+template < typename T >
+void ExtractSteps( EXTRACT_INFO *ei, EXTRACT_JOB *job, DATABASE_MAP *dm, unsigned int first, unsigned int last, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html, OUTPUT_BUFFER *csv )
+{
+	unsigned char *view = NULL;
+	char stmp[ 5 ] = { 0 };
+
+	bool output_html = ei->output_html;
+	bool output_csv = ei->output_csv;
+	bool skip_blank = ei->skip_blank;
+	bool extract_thumbnails = ei->extract_thumbnails;
+	bool verify = ei->verify;
+
+	// Our filename and report buffers are reused for every entry.
+	wchar_t *filename = NULL;
+	unsigned int filename_buffer_size = 0;
+	char *utf8_filename = NULL;
+	int utf8_filename_buffer_size = 0;
+
+	// Each entry header is copied out of the map since it's not guaranteed to be aligned.
+	T dce;
+
+	for ( unsigned int s = first; s < last; ++s )
+	{
+		ENTRY_INDEX_RECORD *step = &job->steps[ s ];
+
+		BufferPrintfW( console, L"\n---------------------------------------------\n" );
+		BufferPrintfW( console, L"Extracting cache entry %lu at %llu bytes.\n", step->number, step->offset );
+		BufferPrintfW( console, L"---------------------------------------------\n" );
+
+		if ( step->type == STEP_END_OF_FILE )
+		{
+			BufferPrintfW( console, L"End of file reached. There are no more entries.\n" );
+			break;
+		}
+		else if ( step->type == STEP_SCAN_FOUND || step->type == STEP_SCAN_FAILED )
+		{
+			BufferPrintfW( console, L"Invalid cache entry located at %llu bytes.\n", step->offset );
+			BufferPrintfW( console, L"Attempting to scan for next entry.\n" );
+
+			if ( step->type == STEP_SCAN_FOUND )
+			{
+				BufferPrintfW( console, L"A valid entry has been found.\n" );
+				BufferPrintfW( console, L"---------------------------------------------\n" );
+				continue;
+			}
+
+			BufferPrintfW( console, L"Scan failed to find any valid entries.\n" );
+			BufferPrintfW( console, L"---------------------------------------------\n" );
+			break;
+		}
+		else if ( step->type == STEP_EMPTY )	// I think this signifies the end of a valid database and everything beyond this is data that's been overwritten.
+		{
+			BufferPrintfW( console, L"Empty cache entry located at %llu bytes.\n", step->offset );
+			BufferPrintfW( console, L"Adjusting offset for next entry.\n" );
+			BufferPrintfW( console, L"---------------------------------------------\n" );
+			continue;
+		}
+
+		view = GetMapView( dm, step->offset, sizeof( T ) );
+		if ( view == NULL )
+		{
+			BufferPrintfW( console, L"End of file reached. There are no more entries.\n" );
+			break;
+		}
+
+		memcpy( &dce, view, sizeof( T ) );
+
+		// The identifier string begins immediately after the header.
+		unsigned long long filename_position = step->offset + sizeof( T );
+
+		// Cache size includes the 4 byte signature and itself ( 4 bytes ).
+		unsigned int cache_entry_size = dce.cache_entry_size;
+
+		// The magic identifier for the current entry.
+		memcpy( stmp, dce.magic_identifier, sizeof( char ) * 4 );
+		BufferPrintfW( console, L"Signature (magic identifier): %S\n", stmp );
+
+		// Entries carved from a disk image can have any layout.
+		if ( job->carve )
+		{
+			BufferPrintfW( console, L"Entry layout: %s\n", ( step->layout == WINDOWS_VISTA ? L"Windows Vista" : ( step->layout == WINDOWS_7 ? L"Windows 7" : L"Windows 8/8.1/10" ) ) );
+		}
+
+		BufferPrintfW( console, L"Cache size: %lu bytes\n", cache_entry_size );
+
+		// The entry hash may be the same as the filename.
+		char s_entry_hash[ 17 ] = { 0 };
+		sprintf_s( s_entry_hash, 17, "%016llx", dce.entry_hash );	// This will probably be the same as the file name.
+		BufferPrintfW( console, L"Entry hash: %S\n", s_entry_hash );
+
+		// Windows Vista
+		const wchar_t *extension = entry_extension( dce );
+		if ( extension != NULL )
+		{
+			// UTF-16 file extension.
+			BufferPrintfW( console, L"File extension: %.4s\n", extension );
+		}
+
+		// The length of our filename.
+		unsigned int filename_length = dce.filename_length;
+		BufferPrintfW( console, L"Identifier string size: %lu bytes\n", filename_length );
+
+		// Padding size.
+		unsigned int padding_size = dce.padding_size;
+		BufferPrintfW( console, L"Padding size: %lu bytes\n", padding_size );
+
+		// The size of our data.
+		unsigned int data_size = dce.data_size;
+		BufferPrintfW( console, L"Data size: %lu bytes\n", data_size );
+
+		// Windows 8/8.1/10 contains the width and height of the image.
+		unsigned int width = 0, height = 0;
+		bool has_dimensions = entry_dimensions( dce, width, height );
+		if ( has_dimensions )
+		{
+			BufferPrintfW( console, L"Dimensions: %lux%lu\n", width, height );
+		}
+
+		// Unknown value.
+		unsigned int unknown = dce.unknown;
+		BufferPrintfW( console, L"Unknown value: 0x%04x\n", unknown );
+
+		// CRC-64 data checksum.
+		char s_data_checksum[ 17 ] = { 0 };
+		sprintf_s( s_data_checksum, 17, "%016llx", dce.data_checksum );
+		BufferPrintfW( console, L"Data checksum (CRC-64): %S\n", s_data_checksum );
+
+		// CRC-64 header checksum.
+		char s_header_checksum[ 17 ] = { 0 };
+		sprintf_s( s_header_checksum, 17, "%016llx", dce.header_checksum );
+		BufferPrintfW( console, L"Header checksum (CRC-64): %S\n", s_header_checksum );
+
+		// The header checksum covers everything before it and uses an initial CRC of -1.
+		unsigned long long v_header_checksum = 0, v_data_checksum = 0;
+		if ( verify )
+		{
+			v_header_checksum = crc64( ( char * )&dce, sizeof( T ) - sizeof( dce.header_checksum ), 0xFFFFFFFFFFFFFFFF );
+		}
+
+		// Since the database can store CLSIDs that extend beyond MAX_PATH, we'll have to set a larger truncation length. A length of 32767 would probably never be seen. 
+		unsigned int filename_truncate_length = min( filename_length, ( sizeof( wchar_t ) * SHRT_MAX ) );
+
+		// Only read what remains of the database if the identifier string runs beyond it.
+		if ( filename_truncate_length > ( dm->size - filename_position ) )
+		{
+			filename_truncate_length = ( unsigned int )( dm->size - filename_position );
+		}
+
+		if ( filename_truncate_length == 0 && filename_length != 0 )
+		{
+			BufferPrintfW( console, L"End of file reached. There are no more valid entries.\n" );
+			break;
+		}
+
+		// UTF-16 filename. Make room for the filename length plus 6 for the unicode extension and null character.
+		if ( filename_truncate_length + ( sizeof( wchar_t ) * 6 ) > filename_buffer_size )
+		{
+			filename_buffer_size = filename_truncate_length + ( sizeof( wchar_t ) * 6 );
+			wchar_t *realloc_buffer = ( wchar_t * )realloc( filename, filename_buffer_size );
+			if ( realloc_buffer == NULL )
+			{
+				BufferPrintfW( console, L"Failed to allocate the identifier string.\n" );
+				break;
+			}
+			filename = realloc_buffer;
+		}
+
+		view = GetMapView( dm, filename_position, filename_truncate_length );
+		if ( view == NULL )
+		{
+			BufferPrintfW( console, L"End of file reached. There are no more valid entries.\n" );
+			break;
+		}
+
+		memcpy( filename, view, filename_truncate_length );
+		memset( ( char * )filename + filename_truncate_length, 0, sizeof( wchar_t ) * 6 );
+
+		// The data begins after the identifier string and padding. This really shouldn't be truncated unless someone tampered with the database, or it became corrupt.
+		unsigned long long data_position = filename_position + filename_length + padding_size;
+
+		// Retrieve a view of the data content.
+		unsigned char *buf = NULL;
+
+		if ( data_size != 0 )
+		{
+			// Only use what remains of the database if the data runs beyond it.
+			if ( data_position >= dm->size )
+			{
+				BufferPrintfW( console, L"End of file reached. There are no more valid entries.\n" );
+				break;
+			}
+			else if ( data_size > ( dm->size - data_position ) )
+			{
+				data_size = ( unsigned int )( dm->size - data_position );
+			}
+
+			// Only the file type is needed if we're not writing or verifying the data.
+			buf = GetMapView( dm, data_position, ( extract_thumbnails || verify ? data_size : min( data_size, 8 ) ) );
+			if ( buf == NULL )
+			{
+				BufferPrintfW( console, L"End of file reached. There are no more valid entries.\n" );
+				break;
+			}
+
+			// The checksum is taken from the same view that we write. A truncated entry won't match.
+			if ( verify )
+			{
+				v_data_checksum = GetDataChecksum( buf, data_size );
+			}
+
+			// Detect the file extension and copy it into the filename string.
+			if ( data_size >= 2 && memcmp( buf, FILE_TYPE_BMP, 2 ) == 0 )			// First 3 bytes
+			{
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ), 4, L".bmp", 4 );
+			}
+			else if ( data_size >= 4 && memcmp( buf, FILE_TYPE_JPEG, 4 ) == 0 )	// First 4 bytes
+			{
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ), 4, L".jpg", 4 );
+			}
+			else if ( data_size >= 8 && memcmp( buf, FILE_TYPE_PNG, 8 ) == 0 )	// First 8 bytes
+			{
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ), 4, L".png", 4 );
+			}
+			else if ( extension != NULL && extension[ 0 ] != NULL )	// If it's a Windows Vista thumbcache file and we can't detect the extension, then use the one given.
+			{
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ), 1, L".", 1 );
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ) + 1, 4, extension, 4 );
+			}
+		}
+		else
+		{
+			// Windows Vista thumbcache files should include the extension.
+			if ( extension != NULL && extension[ 0 ] != NULL )
+			{
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ), 1, L".", 1 );
+				wmemcpy_s( filename + ( filename_truncate_length / sizeof( wchar_t ) ) + 1, 4, extension, 4 );
+			}
+		}
+
+		BufferPrintfW( console, L"Identifier string: %s\n", filename );
+
+		char s_v_data_checksum[ 17 ] = { 0 };
+		char s_v_header_checksum[ 17 ] = { 0 };
+		const char *mismatch = "";
+
+		if ( verify )
+		{
+			bool data_mismatch = ( v_data_checksum != ( unsigned long long )dce.data_checksum );
+			bool header_mismatch = ( v_header_checksum != ( unsigned long long )dce.header_checksum );
+
+			sprintf_s( s_v_data_checksum, 17, "%016llx", v_data_checksum );
+			sprintf_s( s_v_header_checksum, 17, "%016llx", v_header_checksum );
+
+			BufferPrintfW( console, L"Verified data checksum (CRC-64): %S%s\n", s_v_data_checksum, ( data_mismatch ? L" (Mismatch)" : L"" ) );
+			BufferPrintfW( console, L"Verified header checksum (CRC-64): %S%s\n", s_v_header_checksum, ( header_mismatch ? L" (Mismatch)" : L"" ) );
+
+			if ( data_mismatch )
+			{
+				InterlockedIncrement( &job->data_mismatches );
+			}
+
+			if ( header_mismatch )
+			{
+				InterlockedIncrement( &job->header_mismatches );
+			}
+
+			mismatch = ( header_mismatch ? ( data_mismatch ? "Header and data" : "Header" ) : ( data_mismatch ? "Data" : "" ) );
+		}
+
+		int utf8_filename_length = 0;
+
+		// Convert the filename once if we're going to output a report.
+		if ( ( output_csv || output_html ) && ( !skip_blank || ( skip_blank && data_size > 0 ) ) )
+		{
+			utf8_filename_length = WideCharToMultiByte( CP_UTF8, 0, filename, -1, NULL, 0, NULL, NULL );	// Includes NULL character.
+
+			// Make room for the longest HTML suffix.
+			if ( utf8_filename_length + 33 > utf8_filename_buffer_size )
+			{
+				utf8_filename_buffer_size = utf8_filename_length + 33;
+				char *realloc_buffer = ( char * )realloc( utf8_filename, sizeof( char ) * utf8_filename_buffer_size );
+				if ( realloc_buffer == NULL )
+				{
+					BufferPrintfW( console, L"Failed to allocate the identifier string.\n" );
+					break;
+				}
+				utf8_filename = realloc_buffer;
+			}
+
+			WideCharToMultiByte( CP_UTF8, 0, filename, -1, utf8_filename, utf8_filename_length, NULL, NULL );
+		}
+
+		// Write the entry to a new line in the CSV report file.
+		if ( output_csv && ( !skip_blank || ( skip_blank && data_size > 0 ) ) )
+		{
+			if ( has_dimensions )	// Windows 8/8.1/10 includes dimensions (width x height)
+			{
+				BufferPrintf( csv, "%lu,%llu,%lu,%lu,%lux%lu,%s,%s,%s,", step->number, step->offset, cache_entry_size, data_size, width, height, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+			else if ( job->carve )	// A disk image can hold every layout, so its report always has the column.
+			{
+				BufferPrintf( csv, "%lu,%llu,%lu,%lu,,%s,%s,%s,", step->number, step->offset, cache_entry_size, data_size, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+			else
+			{
+				BufferPrintf( csv, "%lu,%llu,%lu,%lu,%s,%s,%s,", step->number, step->offset, cache_entry_size, data_size, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+
+			if ( verify )
+			{
+				BufferPrintf( csv, "%s,%s,%s,", s_v_data_checksum, s_v_header_checksum, mismatch );
+			}
+
+			BufferWrite( csv, "\"", 1 );
+			BufferWrite( csv, utf8_filename, utf8_filename_length - 1 );
+			BufferWrite( csv, "\"\r\n", 3 );
+		}
+
+		// Write the entry to a new table row in the HTML report file.
+		if ( output_html && ( !skip_blank || ( skip_blank && data_size > 0 ) ) )
+		{
+			if ( has_dimensions )	// Windows 8/8.1/10 includes dimensions (width x height)
+			{
+				BufferPrintf( html, "<tr><td>%lu</td><td>%llu</td><td>%lu</td><td>%lu</td><td>%lux%lu</td><td>%s</td><td>%s</td><td>%s</td>", step->number, step->offset, cache_entry_size, data_size, width, height, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+			else if ( job->carve )	// A disk image can hold every layout, so its report always has the column.
+			{
+				BufferPrintf( html, "<tr><td>%lu</td><td>%llu</td><td>%lu</td><td>%lu</td><td></td><td>%s</td><td>%s</td><td>%s</td>", step->number, step->offset, cache_entry_size, data_size, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+			else
+			{
+				BufferPrintf( html, "<tr><td>%lu</td><td>%llu</td><td>%lu</td><td>%lu</td><td>%s</td><td>%s</td><td>%s</td>", step->number, step->offset, cache_entry_size, data_size, s_entry_hash, s_data_checksum, s_header_checksum );
+			}
+
+			if ( verify )
+			{
+				BufferPrintf( html, "<td>%s</td><td>%s</td><td>%s</td>", s_v_data_checksum, s_v_header_checksum, mismatch );
+			}
+
+			BufferWrite( html, "<td>", 4 );
+			BufferWrite( html, utf8_filename, utf8_filename_length - 1 );
+
+			// If there's an image we want to extract, then insert it into the last column.
+			if ( data_size != 0 && extract_thumbnails )
+			{
+				// Replace any invalid filename characters with an underscore "_".
+				char *filename_ptr = utf8_filename;
+				while( filename_ptr != NULL && *filename_ptr != NULL )
+				{
+					if ( *filename_ptr == '\\' ||
+						 *filename_ptr == '/' ||
+						 *filename_ptr == ':' ||
+						 *filename_ptr == '*' ||
+						 *filename_ptr == '?' ||
+						 *filename_ptr == '\"' ||
+						 *filename_ptr == '<' ||
+						 *filename_ptr == '>' ||
+						 *filename_ptr == '|' )
+					{
+						*filename_ptr = '_';
+					}
+
+					++filename_ptr;
+				}
+
+				BufferWrite( html, "</td><td><img src=\"", 19 );
+				BufferWrite( html, utf8_filename, utf8_filename_length - 1 );
+				BufferWrite( html, "\" /></td></tr>", 14 );
+			}
+			else	// Otherwise, the column will remain empty.
+			{
+				BufferWrite( html, "</td><td></td></tr>", 19 );
+			}
+		}
+
+		if ( !skip_blank || ( skip_blank && data_size > 0 ) )
+		{
+			MapHash( dce.entry_hash, console, ( output_html ? html : NULL ) );
+		}
+
+		// Output the data with the given (UTF-16) filename.
+		BufferPrintfW( console, L"---------------------------------------------\n" );
+		if ( data_size != 0 && extract_thumbnails )
+		{
+			// Replace any invalid filename characters with an underscore "_".
+			wchar_t *filename_ptr = filename;
+			while( filename_ptr != NULL && *filename_ptr != NULL )
+			{
+				if ( *filename_ptr == L'\\' ||
+					 *filename_ptr == L'/' ||
+					 *filename_ptr == L':' ||
+					 *filename_ptr == L'*' ||
+					 *filename_ptr == L'?' ||
+					 *filename_ptr == L'\"' ||
+					 *filename_ptr == L'<' ||
+					 *filename_ptr == L'>' ||
+					 *filename_ptr == L'|' )
+				{
+					*filename_ptr = L'_';
+				}
+
+				++filename_ptr;
+			}
+
+			BufferPrintfW( console, L"Writing data to file.\n" );
+			// Attempt to save the mapped data to a file.
+			if ( WriteThumbnail( ei, ( ( unsigned long long )job->index << 32 ) | s, filename, buf, data_size ) )
+			{
+				BufferPrintfW( console, L"Writing complete.\n" );
+			}
+			else
+			{
+				BufferPrintfW( console, L"Writing failed.\n" );
+			}
+		}
+		else if ( !extract_thumbnails )
+		{
+			BufferPrintfW( console, L"Writing skipped.\n" );
+		}
+		else
+		{
+			BufferPrintfW( console, L"No data to write.\n" );
+		}
+		BufferPrintfW( console, L"---------------------------------------------\n" );
+
+		// Write what we have so far if we're writing to the job's buffers and every database before this one has been written.
+		if ( console == &job->console && ( job->console.length + job->html.length + job->csv.length ) >= FLUSH_THRESHOLD && ( LONG )job->index == ei->commit_index )
+		{
+			FlushJob( ei, job );
+		}
+	}
+
+	// Delete our reusable buffers.
+	free( utf8_filename );
+	free( filename );
+}
+
+// Moves the contents of src to the end of dst and empties src.
+void MoveBuffer( OUTPUT_BUFFER *dst, OUTPUT_BUFFER *src )
+{
+	if ( dst->length == 0 )
+	{
+		// Take the buffer rather than copying it.
+		FreeBuffer( dst );
+		*dst = *src;
+		memset( src, 0, sizeof( OUTPUT_BUFFER ) );
+	}
+	else
+	{
+		// The console buffer must remain NULL terminated, so include the room that BufferReserve leaves for it.
+		if ( src->length > 0 && BufferWrite( dst, src->buffer, src->length ) )
+		{
+			*( wchar_t * )( dst->buffer + dst->length ) = 0;
+		}
+
+		FreeBuffer( src );
+	}
+}
+
+// Marks a chunk as decoded and moves the output of every decoded chunk that no longer has to wait on the chunks before it to the job.
+void CommitChunk( EXTRACT_INFO *ei, EXTRACT_JOB *job, ENTRY_CHUNK *chunk )
+{
+	EnterCriticalSection( &job->chunk_cs );
+
+	chunk->done = true;
+
+	while ( job->commit_chunk < job->chunk_count && job->chunks[ job->commit_chunk ].done )
+	{
+		ENTRY_CHUNK *commit_chunk = &job->chunks[ job->commit_chunk ];
+
+		MoveBuffer( &job->console, &commit_chunk->console );
+		MoveBuffer( &job->html, &commit_chunk->html );
+		MoveBuffer( &job->csv, &commit_chunk->csv );
+
+		++job->commit_chunk;
+	}
+
+	// Write what we have so far if every database before this one has been written.
+	if ( ( job->console.length + job->html.length + job->csv.length ) >= FLUSH_THRESHOLD && ( LONG )job->index == ei->commit_index )
+	{
+		FlushJob( ei, job );
+	}
+
+	bool finished = ( job->commit_chunk == job->chunk_count );
+
+	LeaveCriticalSection( &job->chunk_cs );
+
+	// The owner deletes the lock once it's signaled.
+	if ( finished )
+	{
+		SetEvent( job->hChunksDone );
+	}
+}
+
+// Lets the idle workers know that the job has chunks for them to claim.
+void PublishChunks( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	EnterCriticalSection( &ei->work_cs );
+
+	InterlockedExchange( &job->extracting_chunks, 1 );
+
+	++ei->chunked_jobs;
+	SetEvent( ei->hWorkAvailable );
+
+	LeaveCriticalSection( &ei->work_cs );
+}
+
+// Called by the worker that claims the last chunk of a job. The idle workers wait again if no other job has chunks to claim.
+void ClaimedChunks( EXTRACT_INFO *ei )
+{
+	EnterCriticalSection( &ei->work_cs );
+
+	if ( --ei->chunked_jobs == 0 && ei->pending_jobs > 0 )
+	{
+		ResetEvent( ei->hWorkAvailable );
+	}
+
+	LeaveCriticalSection( &ei->work_cs );
+}
+
+// Called once a job has been extracted. The idle workers are released after the last one.
+void FinishExtracting( EXTRACT_INFO *ei )
+{
+	EnterCriticalSection( &ei->work_cs );
+
+	if ( --ei->pending_jobs == 0 )
+	{
+		SetEvent( ei->hWorkAvailable );
+	}
+
+	LeaveCriticalSection( &ei->work_cs );
+}
+
+// Claims and decodes chunks of the job until none are left. Each worker gets its own views of the job's mapping.
+void ExtractChunks( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	DATABASE_MAP dm;
+	bool shared = false;
+
+	for ( ;; )
+	{
+		unsigned int index = ( unsigned int )( InterlockedIncrement( &job->next_chunk ) - 1 );
+		if ( index >= job->chunk_count )
+		{
+			break;
+		}
+
+		if ( index == job->chunk_count - 1 )
+		{
+			ClaimedChunks( ei );
+		}
+
+		// The mapping stays open until every claimed chunk has been committed.
+		if ( !shared )
+		{
+			ShareDatabaseMap( job->dm, &dm );
+			shared = true;
+		}
+
+		unsigned int first = index * ENTRY_CHUNK_SIZE;
+		unsigned int last = min( first + ENTRY_CHUNK_SIZE, job->step_count );
+
+		ENTRY_CHUNK *chunk = &job->chunks[ index ];
+
+		job->extract_steps( ei, job, &dm, first, last, &chunk->console, &chunk->html, &chunk->csv );
+
+		CommitChunk( ei, job, chunk );
+	}
+
+	if ( shared )
+	{
+		CloseDatabaseView( &dm );
+	}
+}
+
+// Extracts every step of the job. The steps are split into chunks that idle workers can help with if there are enough of them.
+void ExtractJobSteps( EXTRACT_INFO *ei, EXTRACT_JOB *job, DATABASE_MAP *dm, EXTRACT_STEPS extract_steps )
+{
+	if ( ei->thread_count > 1 && job->step_count > ENTRY_CHUNK_SIZE )
+	{
+		job->chunk_count = ( job->step_count + ENTRY_CHUNK_SIZE - 1 ) / ENTRY_CHUNK_SIZE;
+		job->chunks = ( ENTRY_CHUNK * )calloc( job->chunk_count, sizeof( ENTRY_CHUNK ) );
+		job->hChunksDone = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+		if ( job->chunks != NULL && job->hChunksDone != NULL )
+		{
+			job->dm = dm;
+			job->extract_steps = extract_steps;
+			job->next_chunk = 0;
+			job->commit_chunk = 0;
+			InitializeCriticalSection( &job->chunk_cs );
+
+			// Let the idle workers find the job.
+			PublishChunks( ei, job );
+
+			ExtractChunks( ei, job );
+
+			// Wait for the chunks that other workers claimed.
+			WaitForSingleObject( job->hChunksDone, INFINITE );
+
+			InterlockedExchange( &job->extracting_chunks, 0 );
+
+			DeleteCriticalSection( &job->chunk_cs );
+		}
+		else
+		{
+			// Extract everything ourself.
+			job->chunk_count = 0;
+			extract_steps( ei, job, dm, 0, job->step_count, &job->console, &job->html, &job->csv );
+		}
+
+		if ( job->hChunksDone != NULL )
+		{
+			CloseHandle( job->hChunksDone );
+			job->hChunksDone = NULL;
+		}
+
+		// next_chunk is left as is so that a worker that finds the job late has nothing to claim.
+		free( job->chunks );
+		job->chunks = NULL;
+	}
+	else
+	{
+		extract_steps( ei, job, dm, 0, job->step_count, &job->console, &job->html, &job->csv );
+	}
+}
+
+// Returns the old record with the same offset as the step if neither have changed, or NULL if the step has to be extracted.
+const ENTRY_INDEX_RECORD *FindUnchangedRecord( const ENTRY_INDEX_RECORD *records, unsigned int record_count, const ENTRY_INDEX_RECORD *step )
+{
+	if ( step->type != STEP_ENTRY )
+	{
+		return NULL;
+	}
+
+	// The records are in the order they were walked, so their offsets increase.
+	unsigned int low = 0, high = record_count;
+	while ( low < high )
+	{
+		unsigned int mid = low + ( ( high - low ) / 2 );
+		if ( records[ mid ].offset < step->offset )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	if ( low < record_count )
+	{
+		const ENTRY_INDEX_RECORD *record = &records[ low ];
+		if ( record->offset == step->offset &&
+			 record->type == STEP_ENTRY &&
+			 record->entry_hash == step->entry_hash &&
+			 record->data_checksum == step->data_checksum &&
+			 record->header_checksum == step->header_checksum &&
+			 record->data_offset == step->data_offset &&
+			 record->data_size == step->data_size )
+		{
+			return record;
+		}
+	}
+
+	return NULL;
+}
+
+// Walks the entries that were appended or changed since the index was saved, saves the new index, and leaves only those entries in the step list.
+// Every entry is walked and kept if the database was truncated or rewritten. Returns false if the step list could not be allocated.
+template < typename T >
+bool UpdateEntries( EXTRACT_JOB *job, DATABASE_MAP *dm, const ENTRY_INDEX *index, ENTRY_INDEX_HEADER *eih, unsigned long long current_position )
+{
+	const ENTRY_INDEX_RECORD *records = index->records;
+	unsigned int record_count = index->header->record_count;
+
+	unsigned int resume = 0;	// The first record that has to be walked again.
+
+	// Nothing has been written to the database if the key still matches.
+	if ( memcmp( index->header, eih, offsetof( ENTRY_INDEX_HEADER, record_count ) ) == 0 )
+	{
+		resume = record_count;
+	}
+	else if ( eih->database_size >= index->header->database_size && record_count > 0 )	// A smaller database has been truncated.
+	{
+		T dce;
+
+		// Keep each record whose entry is unchanged. The last record is where the walk stopped, so there may be new entries beyond it.
+		for ( ; resume < record_count - 1; ++resume )
+		{
+			const ENTRY_INDEX_RECORD *record = &records[ resume ];
+
+			unsigned char *view = GetMapView( dm, record->offset, sizeof( T ) );
+			if ( view == NULL )
+			{
+				break;
+			}
+
+			// The entry was invalid and must still be.
+			if ( record->type == STEP_SCAN_FOUND )
+			{
+				if ( memcmp( view, "CMMM", 4 ) == 0 )
+				{
+					break;
+				}
+
+				continue;
+			}
+
+			if ( memcmp( view, "CMMM", 4 ) != 0 )
+			{
+				break;
+			}
+
+			memcpy( &dce, view, sizeof( T ) );
+
+			if ( record->type == STEP_EMPTY )
+			{
+				if ( dce.entry_hash != 0 )
+				{
+					break;
+				}
+			}
+			else if ( record->type != STEP_ENTRY ||
+					  dce.entry_hash != record->entry_hash ||
+					  dce.data_checksum != record->data_checksum ||
+					  dce.header_checksum != record->header_checksum ||
+					  dce.data_size != record->data_size )
+			{
+				break;
+			}
+		}
+	}
+
+	if ( resume == 0 && record_count > 0 )
+	{
+		BufferPrintfW( &job->console, L"The database was truncated or rewritten since the last run. Every entry will be extracted.\n" );
+	}
+
+	// Copy the records that we're keeping so that the walk can add to them.
+	if ( resume > 0 )
+	{
+		job->steps = ( ENTRY_INDEX_RECORD * )malloc( sizeof( ENTRY_INDEX_RECORD ) * resume );
+		if ( job->steps == NULL )
+		{
+			return false;
+		}
+
+		memcpy( job->steps, records, sizeof( ENTRY_INDEX_RECORD ) * resume );
+		job->step_count = resume;
+	}
+
+	if ( resume < record_count )
+	{
+		if ( !WalkEntries< T >( job, dm, ( resume > 0 ? records[ resume ].offset : current_position ), ( resume > 0 ? records[ resume ].number - 1 : 0 ) ) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		job->entry_count = index->header->entry_count;
+	}
+
+	// The index only needs to be saved again if something was walked.
+	if ( resume < record_count )
+	{
+		eih->record_count = job->step_count;
+		eih->entry_count = job->entry_count;
+
+		SaveEntryIndex( job->name, eih, job->steps, NULL );
+	}
+
+	// Remove the steps we kept and any of the walked entries that are unchanged.
+	unsigned int skipped_count = 0;
+	unsigned int step_count = 0;
+
+	for ( unsigned int s = 0; s < job->step_count; ++s )
+	{
+		ENTRY_INDEX_RECORD *step = &job->steps[ s ];
+
+		if ( s < resume || ( resume > 0 && FindUnchangedRecord( records + resume, record_count - resume, step ) != NULL ) )
+		{
+			if ( step->type == STEP_ENTRY )
+			{
+				++skipped_count;
+			}
+		}
+		else
+		{
+			job->steps[ step_count++ ] = *step;
+		}
+	}
+
+	job->step_count = step_count;
+	job->entry_count -= min( skipped_count, job->entry_count );
+
+	BufferPrintfW( &job->console, L"Skipped %lu entries that haven't changed since the last run.\n", skipped_count );
+
+	return true;
+}
+
+// Walks the database's entries, then extracts them. Large databases are split into chunks that idle workers help to extract.
+// Returns the number of entries that were processed.
+template < typename T >
+unsigned int ExtractEntries( EXTRACT_INFO *ei, EXTRACT_JOB *job, DATABASE_MAP *dm, unsigned long long current_position )
+{
+	ENTRY_INDEX_HEADER eih;
+	ENTRY_INDEX *index = NULL;
+	bool save_index = false;
+	bool walked = false;
+
+	// An index is only valid for the exact database that it was saved for, unless we're updating it.
+	if ( ( ei->use_index || ei->incremental ) && GetEntryIndexKey( dm->hFile, ENTRY_INDEX_CREATOR_CMD, &eih ) )
+	{
+		index = LoadEntryIndex( job->name, &eih, !ei->incremental );
+		save_index = ( index == NULL );
+	}
+
+	if ( index != NULL && ei->incremental )
+	{
+		// The new index is saved before the unchanged steps are removed.
+		walked = UpdateEntries< T >( job, dm, index, &eih, current_position );
+
+		FreeEntryIndex( index );
+	}
+	else if ( index != NULL )
+	{
+		job->entry_index = index;
+		job->steps = index->records;
+		job->step_count = index->header->record_count;
+		job->entry_count = index->header->entry_count;
+
+		BufferPrintfW( &job->console, L"Loaded %lu entries from the entry index.\n", job->entry_count );
+
+		walked = true;
+	}
+	else
+	{
+		walked = WalkEntries< T >( job, dm, current_position, 0 );
+	}
+
+	if ( save_index && walked )
+	{
+		eih.record_count = job->step_count;
+		eih.entry_count = job->entry_count;
+
+		SaveEntryIndex( job->name, &eih, job->steps, NULL );
+	}
+
+	if ( !walked )
+	{
+		BufferPrintfW( &job->console, L"Failed to allocate the entry list.\n" );
+	}
+	else
+	{
+		ExtractJobSteps( ei, job, dm, &ExtractSteps< T > );
+	}
+
+	if ( job->entry_index != NULL )
+	{
+		FreeEntryIndex( job->entry_index );
+		job->entry_index = NULL;
+	}
+	else
+	{
+		free( job->steps );
+	}
+
+	job->steps = NULL;
+
+	return job->entry_count;
+}
+
+// Parses the database header and extracts its entries to the job's buffers.
+void ExtractDatabase( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	OUTPUT_BUFFER *console = &job->console;
+
+	BufferPrintfW( console, L"Attempting to open the thumbcache database: %s\n", job->name );
+
+	// Attempt to open our database file. If we're only listing the entries, then we'll skip over most of it and there's no point in reading ahead.
+	HANDLE hFile = CreateFile( job->name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, ( ei->list_only ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL ), NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		// See if they typed an incorrect filename.
+		if ( GetLastError() == ERROR_FILE_NOT_FOUND )
+		{
+			BufferPrintfW( console, L"The thumbcache database does not exist.\n" );
+		}
+		else	// For all other errors, it probably failed to open.
+		{
+			BufferPrintfW( console, L"The thumbcache database failed to open.\n" );
+		}
+
+		return;
+	}
+
+	DATABASE_MAP dm;
+	if ( !OpenDatabaseMap( hFile, &dm, ei->list_only ) )
+	{
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"The thumbcache database failed to open.\n" );
+		return;
+	}
+
+	database_header dh = { 0 };
+
+	// Make sure it's a thumbcache database and the structure was filled correctly.
+	unsigned char *view = GetMapView( &dm, 0, sizeof( database_header ) );
+	if ( view == NULL || memcmp( view, "CMMM", 4 ) != 0 )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"The file is not a thumbcache database.\n" );
+		return;
+	}
+
+	memcpy( &dh, view, sizeof( database_header ) );
+
+	BufferPrintfW( console, L"---------------------------------------------\n" );
+	BufferPrintfW( console, L"Extracting file header (%s bytes).\n", ( dh.version != WINDOWS_8v2 ? L"24" : L"28" ) );
+	BufferPrintfW( console, L"---------------------------------------------\n" );
+
+	// Magic identifer.
+	char stmp[ 5 ] = { 0 };
+	memcpy( stmp, dh.magic_identifier, sizeof( char ) * 4 );
+	BufferPrintfW( console, L"Signature (magic identifier): %S\n", stmp );
+
+	// Version of database.
+	const char *version_name = GetVersionName( dh.version );
+	if ( version_name == NULL )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"The thumbcache database version is not supported.\n" );
+		return;
+	}
+
+	BufferPrintfW( console, L"Version: %S\n", version_name );
+
+	// Type of thumbcache database.
+	const CACHE_TYPE *cache_type = GetCacheType( dh.version, dh.type );
+	if ( cache_type == NULL )
+	{
+		BufferPrintfW( console, L"Cache type: Unknown\n" );
+	}
+	else if ( cache_type->dimensions == NULL )
+	{
+		BufferPrintfW( console, L"Cache type: %S\n", cache_type->name );
+	}
+	else
+	{
+		BufferPrintfW( console, L"Cache type: %S, %S\n", cache_type->name, cache_type->dimensions );
+	}
+
+	const char *cache_type_name = ( cache_type != NULL ? cache_type->name : "Unknown" );
+
+	// Windows 8/8.1/10 entries include the dimensions of the image.
+	bool has_dimensions = ( dh.version != WINDOWS_VISTA && dh.version != WINDOWS_7 );
+
+	unsigned int first_cache_entry = 0;
+	unsigned int available_cache_entry = 0;
+	unsigned int number_of_cache_entries = 0;
+
+	// WINDOWS_8v2 has an additional 4 bytes before the entry information.
+	if ( dh.version == WINDOWS_8v2 )
+	{
+		database_header_entry_info_v2 dhei = { 0 };
+		view = GetMapView( &dm, sizeof( database_header ), sizeof( database_header_entry_info_v2 ) );
+		if ( view != NULL )
+		{
+			memcpy( &dhei, view, sizeof( database_header_entry_info_v2 ) );
+		}
+		first_cache_entry = dhei.first_cache_entry;
+		available_cache_entry = dhei.available_cache_entry;
+		number_of_cache_entries = dhei.number_of_cache_entries;
+	}
+	else if ( dh.version == WINDOWS_8v3 || dh.version == WINDOWS_8_1 || dh.version == WINDOWS_10 )
+	{
+		database_header_entry_info_v3 dhei = { 0 };
+		view = GetMapView( &dm, sizeof( database_header ), sizeof( database_header_entry_info_v3 ) );
+		if ( view != NULL )
+		{
+			memcpy( &dhei, view, sizeof( database_header_entry_info_v3 ) );
+		}
+		first_cache_entry = dhei.first_cache_entry;
+		available_cache_entry = dhei.available_cache_entry;
+	}
+	else
+	{
+		database_header_entry_info dhei = { 0 };
+		view = GetMapView( &dm, sizeof( database_header ), sizeof( database_header_entry_info ) );
+		if ( view != NULL )
+		{
+			memcpy( &dhei, view, sizeof( database_header_entry_info ) );
+		}
+		first_cache_entry = dhei.first_cache_entry;
+		available_cache_entry = dhei.available_cache_entry;
+		number_of_cache_entries = dhei.number_of_cache_entries;
+	}
+
+	// Offset to the first cache entry.
+	BufferPrintfW( console, L"Offset to first cache entry: %lu bytes\n", first_cache_entry );
+
+	// Offset to the available cache entry.
+	BufferPrintfW( console, L"Offset to available cache entry: %lu bytes\n", available_cache_entry );
+
+	char entries[ 11 ] = { 0 };
+
+	// Number of cache entries.
+	if ( dh.version != WINDOWS_8v3 && dh.version != WINDOWS_8_1 && dh.version != WINDOWS_10 )
+	{
+		sprintf_s( entries, 11, "%lu", number_of_cache_entries );
+	}
+	else
+	{
+		sprintf_s( entries, 11, "Unknown" );
+	}
+
+	BufferPrintfW( console, L"Number of cache entries: %S\n", entries );
+
+	BufferPrintfW( console, L"---------------------------------------------\n" );
+
+	// Set our position to the first possible cache entry. (Should be at an offset equal to the size of the header)
+	unsigned long long current_position = ( dh.version != WINDOWS_8v2 ? 24 : 28 );
+
+	// The report files are created and this database's sections are started when its output is written.
+	job->start_reports = true;
+
+	// Convert the database path to UTF-8 if we're going to output a report.
+	if ( ei->output_html || ei->output_csv )
+	{
+		int utf8_name_length = WideCharToMultiByte( CP_UTF8, 0, job->name, -1, NULL, 0, NULL, NULL );
+		char *utf8_name = ( char * )malloc( sizeof( char ) * utf8_name_length );
+		WideCharToMultiByte( CP_UTF8, 0, job->name, -1, utf8_name, utf8_name_length, NULL, NULL );
+
+		if ( ei->output_html )
+		{
+			BufferPrintf( &job->html,
+						  "Filename: %s<br />" \
+						  "Version: %s<br />" \
+						  "Type: %s<br />" \
+						  "Offset to first cache entry (bytes): %lu<br />" \
+						  "Offset to available cache entry (bytes): %lu<br />" \
+						  "Number of cache entries: %s<br />" \
+						  "Output path: %s\\<br /><br />" \
+						  "<table border=1 cellspacing=0><tr><td>Index</td><td>Offset (bytes)</td><td>Cache Size (bytes)</td><td>Data Size (bytes)</td>%s<td>Entry Hash</td><td>Data Checksum</td><td>Header Checksum</td>%s<td>Identifier String</td><td>Image</td></tr>",
+						  utf8_name, version_name, cache_type_name,
+						  first_cache_entry, available_cache_entry, entries, ei->utf8_path, ( has_dimensions ? "<td>Dimensions</td>" : "" ),
+						  ( ei->verify ? "<td>Verified Data Checksum</td><td>Verified Header Checksum</td><td>Checksum Mismatch</td>" : "" ) );
+		}
+
+		if ( ei->output_csv )
+		{
+			BufferPrintf( &job->csv,
+						  "Filename,\"%s\"\r\n" \
+						  "Version,%s\r\n" \
+						  "Type,%s\r\n" \
+						  "Offset to first cache entry (bytes),%lu\r\n" \
+						  "Offset to available cache entry (bytes),%lu\r\n" \
+						  "Number of cache entries,%s\r\n" \
+						  "Output path,\"%s\\\"\r\n\r\n" \
+						  "Index,Offset (bytes),Cache Size (bytes),Data Size (bytes),%sEntry Hash,Data Checksum,Header Checksum,%sIdentifier String\r\n",
+						  utf8_name, version_name, cache_type_name,
+						  first_cache_entry, available_cache_entry, entries, ei->utf8_path, ( has_dimensions ? "Dimensions," : "" ),
+						  ( ei->verify ? "Verified Data Checksum,Verified Header Checksum,Checksum Mismatch," : "" ) );
+		}
+
+		// Free our UTF-8 string.
+		free( utf8_name );
+	}
+
+	LARGE_INTEGER start_time, end_time, frequency;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &start_time );
+
+	unsigned int entry_count = 0;
+
+	// Go through our database and attempt to extract each cache entry.
+	if ( dh.version == WINDOWS_VISTA )
+	{
+		entry_count = ExtractEntries< database_cache_entry_vista >( ei, job, &dm, current_position );
+	}
+	else if ( dh.version == WINDOWS_7 )
+	{
+		entry_count = ExtractEntries< database_cache_entry_7 >( ei, job, &dm, current_position );
+	}
+	else	// Windows 8/8.1/10
+	{
+		entry_count = ExtractEntries< database_cache_entry_8 >( ei, job, &dm, current_position );
+	}
+
+	QueryPerformanceCounter( &end_time );
+
+	double elapsed_time = ( double )( end_time.QuadPart - start_time.QuadPart ) / ( double )frequency.QuadPart;
+	BufferPrintfW( console, L"\nProcessed %lu cache entries in %.3f seconds (%.0f entries per second).\n", entry_count, elapsed_time, ( elapsed_time > 0.0 ? entry_count / elapsed_time : 0.0 ) );
+
+	if ( ei->verify )
+	{
+		BufferPrintfW( console, L"Found %lu header and %lu data checksum mismatches.\n", job->header_mismatches, job->data_mismatches );
+	}
+
+	if ( ei->output_html )
+	{
+		BufferWrite( &job->html, "</table><br />", 14 );
+	}
+
+	// Close the input file.
+	CloseDatabaseMap( &dm );
+	CloseHandle( hFile );
+}
+
+// Fills in the step if buf begins with an entry header of layout T whose header checksum is valid.
+// The checksum makes it unlikely that anything other than an entry header would be accepted.
+template < typename T >
+bool CarveEntryHeader( const unsigned char *buf, size_t length, unsigned long long offset, unsigned char layout, ENTRY_INDEX_RECORD *step )
+{
+	if ( length < sizeof( T ) )
+	{
+		return false;
+	}
+
+	T dce;
+	memcpy( &dce, buf, sizeof( T ) );
+
+	// The header checksum covers everything before it and uses an initial CRC of -1.
+	if ( crc64( ( char * )buf, sizeof( T ) - sizeof( dce.header_checksum ), 0xFFFFFFFFFFFFFFFF ) != ( unsigned long long )dce.header_checksum )
+	{
+		return false;
+	}
+
+	// An empty entry has nothing to extract.
+	if ( dce.entry_hash == 0 )
+	{
+		return false;
+	}
+
+	memset( step, 0, sizeof( ENTRY_INDEX_RECORD ) );
+	step->type = STEP_ENTRY;
+	step->layout = layout;
+	step->offset = offset;
+	step->data_offset = offset + sizeof( T ) + dce.filename_length + dce.padding_size;
+	step->entry_hash = dce.entry_hash;
+	step->data_checksum = dce.data_checksum;
+	step->header_checksum = dce.header_checksum;
+	step->data_size = dce.data_size;
+
+	return true;
+}
+
+// Reads a region of the disk image, along with enough of the next region to hold a header that begins at its end, and records every valid entry header that begins in it.
+void CarveRegion( CARVE_INFO *ci, HANDLE hFile, unsigned char *buf, unsigned int index )
+{
+	CARVE_REGION *region = &ci->regions[ index ];
+
+	unsigned long long offset = ( unsigned long long )index * CARVE_REGION_SIZE;
+	unsigned int length = ( unsigned int )min( CARVE_REGION_SIZE + CARVE_OVERLAP, ci->size - offset );
+
+	// The read is positioned so that every worker can read a different region.
+	OVERLAPPED ol = { 0 };
+	ol.Offset = ( DWORD )offset;
+	ol.OffsetHigh = ( DWORD )( offset >> 32 );
+
+	DWORD read = 0;
+	if ( ReadFile( hFile, buf, length, &read, &ol ) == FALSE )
+	{
+		region->failed = true;
+		return;
+	}
+
+	unsigned int step_size = 0;
+
+	// Headers that begin in the overlap belong to the next region.
+	size_t position = 0;
+	while ( position < CARVE_REGION_SIZE && position < read )
+	{
+		position += find_signature( buf + position, read - position );
+		if ( position >= CARVE_REGION_SIZE || position >= read )
+		{
+			break;
+		}
+
+		if ( region->step_count == step_size )
+		{
+			step_size = ( step_size > 0 ? step_size * 2 : 64 );
+			ENTRY_INDEX_RECORD *realloc_buffer = ( ENTRY_INDEX_RECORD * )realloc( region->steps, sizeof( ENTRY_INDEX_RECORD ) * step_size );
+			if ( realloc_buffer == NULL )
+			{
+				region->failed = true;
+				return;
+			}
+
+			region->steps = realloc_buffer;
+		}
+
+		ENTRY_INDEX_RECORD *step = &region->steps[ region->step_count ];
+
+		// Windows 8/8.1/10 entries are the most common, so their layout is tried first.
+		if ( CarveEntryHeader< database_cache_entry_8 >( buf + position, read - position, offset + position, WINDOWS_8, step ) ||
+			 CarveEntryHeader< database_cache_entry_7 >( buf + position, read - position, offset + position, WINDOWS_7, step ) ||
+			 CarveEntryHeader< database_cache_entry_vista >( buf + position, read - position, offset + position, WINDOWS_VISTA, step ) )
+		{
+			++region->step_count;
+		}
+
+		// The magic identifier can't overlap itself.
+		position += 4;
+	}
+}
+
+// Claims and scans regions of the disk image until none are left.
+void CarveRegions( CARVE_INFO *ci )
+{
+	// Each region is only read once, so let the cache read ahead of us and drop the pages behind us.
+	HANDLE hFile = CreateFile( ci->name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	unsigned char *buf = ( unsigned char * )malloc( sizeof( unsigned char ) * ( CARVE_REGION_SIZE + CARVE_OVERLAP ) );
+
+	for ( ;; )
+	{
+		unsigned int index = ( unsigned int )( InterlockedIncrement( &ci->next_region ) - 1 );
+		if ( index >= ci->region_count )
+		{
+			break;
+		}
+
+		if ( hFile == INVALID_HANDLE_VALUE || buf == NULL )
+		{
+			ci->regions[ index ].failed = true;
+		}
+		else
+		{
+			CarveRegion( ci, hFile, buf, index );
+		}
+	}
+
+	free( buf );
+
+	if ( hFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( hFile );
+	}
+}
+
+unsigned __stdcall carve_image( void *pArguments )
+{
+	CarveRegions( ( CARVE_INFO * )pArguments );
+
+	_endthreadex( 0 );
+	return 0;
+}
+
+// Extracts the carved steps in [ first, last ). Each run of steps that have the same layout is extracted together.
+void ExtractCarvedSteps( EXTRACT_INFO *ei, EXTRACT_JOB *job, DATABASE_MAP *dm, unsigned int first, unsigned int last, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html, OUTPUT_BUFFER *csv )
+{
+	while ( first < last )
+	{
+		unsigned char layout = job->steps[ first ].layout;
+
+		unsigned int run_last = first + 1;
+		while ( run_last < last && job->steps[ run_last ].layout == layout )
+		{
+			++run_last;
+		}
+
+		if ( layout == WINDOWS_VISTA )
+		{
+			ExtractSteps< database_cache_entry_vista >( ei, job, dm, first, run_last, console, html, csv );
+		}
+		else if ( layout == WINDOWS_7 )
+		{
+			ExtractSteps< database_cache_entry_7 >( ei, job, dm, first, run_last, console, html, csv );
+		}
+		else	// Windows 8/8.1/10
+		{
+			ExtractSteps< database_cache_entry_8 >( ei, job, dm, first, run_last, console, html, csv );
+		}
+
+		first = run_last;
+	}
+}
+
+// Scans an entire disk image for entry headers of every layout and keeps the ones that have a valid header checksum as the job's steps.
+// This finds the entries of deleted databases and entries that are no longer reachable from a database's header.
+// The steps are left NULL if the image couldn't be scanned.
+void ScanImage( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	OUTPUT_BUFFER *console = &job->console;
+
+	BufferPrintfW( console, L"Attempting to carve the disk image: %s\n", job->name );
+
+	// The regions are scanned with their own handles. This one is only used to get the size of the image.
+	HANDLE hFile = CreateFile( job->name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		// See if they typed an incorrect filename.
+		if ( GetLastError() == ERROR_FILE_NOT_FOUND )
+		{
+			BufferPrintfW( console, L"The disk image does not exist.\n" );
+		}
+		else	// For all other errors, it probably failed to open.
+		{
+			BufferPrintfW( console, L"The disk image failed to open.\n" );
+		}
+
+		return;
+	}
+
+	// The regions are scanned with reads since each is only needed once.
+	DATABASE_MAP dm;
+	if ( !OpenDatabaseMap( hFile, &dm, true ) || dm.size == 0 )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"The disk image failed to open.\n" );
+		return;
+	}
+
+	CARVE_INFO ci;
+	memset( &ci, 0, sizeof( CARVE_INFO ) );
+	ci.name = job->name;
+	ci.size = dm.size;
+	ci.region_count = ( unsigned int )( ( dm.size + CARVE_REGION_SIZE - 1 ) / CARVE_REGION_SIZE );
+	ci.regions = ( CARVE_REGION * )calloc( ci.region_count, sizeof( CARVE_REGION ) );
+	if ( ci.regions == NULL )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"Failed to allocate the regions of the disk image.\n" );
+		return;
+	}
+
+	BufferPrintfW( console, L"---------------------------------------------\n" );
+	BufferPrintfW( console, L"Scanning %llu bytes for cache entries.\n", dm.size );
+	BufferPrintfW( console, L"---------------------------------------------\n" );
+
+	LARGE_INTEGER start_time, end_time, frequency;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &start_time );
+
+	// Every worker scans regions so that several reads are in flight at once. We're one of them.
+	HANDLE threads[ MAXIMUM_WAIT_OBJECTS ];
+	unsigned int thread_count = 0;
+
+	for ( ; ( thread_count + 1 ) < ei->thread_count && ( thread_count + 1 ) < ci.region_count; ++thread_count )
+	{
+		threads[ thread_count ] = ( HANDLE )_beginthreadex( NULL, 0, &carve_image, ( void * )&ci, 0, NULL );
+		if ( threads[ thread_count ] == NULL )
+		{
+			break;
+		}
+	}
+
+	CarveRegions( &ci );
+
+	if ( thread_count > 0 )
+	{
+		WaitForMultipleObjects( thread_count, threads, TRUE, INFINITE );
+
+		for ( unsigned int i = 0; i < thread_count; ++i )
+		{
+			CloseHandle( threads[ i ] );
+		}
+	}
+
+	// Gather the steps of every region in the order they appear in the image.
+	unsigned int step_count = 0;
+	for ( unsigned int i = 0; i < ci.region_count; ++i )
+	{
+		step_count += ci.regions[ i ].step_count;
+	}
+
+	job->steps = ( ENTRY_INDEX_RECORD * )malloc( sizeof( ENTRY_INDEX_RECORD ) * ( step_count > 0 ? step_count : 1 ) );
+
+	for ( unsigned int i = 0; i < ci.region_count; ++i )
+	{
+		CARVE_REGION *region = &ci.regions[ i ];
+
+		if ( region->failed )
+		{
+			BufferPrintfW( console, L"Failed to scan the region at %llu bytes.\n", ( unsigned long long )i * CARVE_REGION_SIZE );
+		}
+
+		if ( job->steps != NULL )
+		{
+			for ( unsigned int j = 0; j < region->step_count; ++j )
+			{
+				ENTRY_INDEX_RECORD *step = &job->steps[ job->step_count++ ];
+				*step = region->steps[ j ];
+				step->number = job->step_count;
+			}
+		}
+
+		free( region->steps );
+	}
+
+	free( ci.regions );
+
+	QueryPerformanceCounter( &end_time );
+
+	double elapsed_time = ( double )( end_time.QuadPart - start_time.QuadPart ) / ( double )frequency.QuadPart;
+	BufferPrintfW( console, L"Found %lu cache entries in %.3f seconds (%.0f megabytes per second).\n", step_count, elapsed_time, ( elapsed_time > 0.0 ? ( dm.size / ( 1024.0 * 1024.0 ) ) / elapsed_time : 0.0 ) );
+
+	if ( job->steps == NULL )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"Failed to allocate the entry list.\n" );
+		return;
+	}
+
+	job->entry_count = job->step_count;
+
+	CloseDatabaseMap( &dm );
+	CloseHandle( hFile );
+}
+
+// Extracts the entries that were found when the disk image was scanned.
+void CarveImage( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	// The reason it couldn't be scanned has already been written.
+	if ( job->steps == NULL )
+	{
+		return;
+	}
+
+	OUTPUT_BUFFER *console = &job->console;
+
+	// If we're only listing the carved entries, then most of the image is skipped and there's no point in reading ahead.
+	HANDLE hFile = CreateFile( job->name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, ( ei->list_only ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL ), NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		BufferPrintfW( console, L"The disk image failed to open.\n" );
+
+		free( job->steps );
+		job->steps = NULL;
+		return;
+	}
+
+	// The carved entries are extracted from a mapping of the image.
+	DATABASE_MAP dm;
+	if ( !OpenDatabaseMap( hFile, &dm, ei->list_only ) )
+	{
+		CloseDatabaseMap( &dm );
+		CloseHandle( hFile );
+		BufferPrintfW( console, L"The disk image failed to open.\n" );
+
+		free( job->steps );
+		job->steps = NULL;
+		return;
+	}
+
+	LARGE_INTEGER start_time, end_time, frequency;
+	QueryPerformanceFrequency( &frequency );
+
+	// The report files are created and this image's sections are started when its output is written.
+	job->start_reports = true;
+
+	// Convert the image path to UTF-8 if we're going to output a report.
+	if ( ei->output_html || ei->output_csv )
+	{
+		int utf8_name_length = WideCharToMultiByte( CP_UTF8, 0, job->name, -1, NULL, 0, NULL, NULL );
+		char *utf8_name = ( char * )malloc( sizeof( char ) * utf8_name_length );
+		WideCharToMultiByte( CP_UTF8, 0, job->name, -1, utf8_name, utf8_name_length, NULL, NULL );
+
+		if ( ei->output_html )
+		{
+			BufferPrintf( &job->html,
+						  "Disk image: %s<br />" \
+						  "Image size (bytes): %llu<br />" \
+						  "Number of carved entries: %lu<br />" \
+						  "Output path: %s\\<br /><br />" \
+						  "<table border=1 cellspacing=0><tr><td>Index</td><td>Offset (bytes)</td><td>Cache Size (bytes)</td><td>Data Size (bytes)</td><td>Dimensions</td><td>Entry Hash</td><td>Data Checksum</td><td>Header Checksum</td>%s<td>Identifier String</td><td>Image</td></tr>",
+						  utf8_name, dm.size, job->step_count, ei->utf8_path,
+						  ( ei->verify ? "<td>Verified Data Checksum</td><td>Verified Header Checksum</td><td>Checksum Mismatch</td>" : "" ) );
+		}
+
+		if ( ei->output_csv )
+		{
+			BufferPrintf( &job->csv,
+						  "Disk image,\"%s\"\r\n" \
+						  "Image size (bytes),%llu\r\n" \
+						  "Number of carved entries,%lu\r\n" \
+						  "Output path,\"%s\\\"\r\n\r\n" \
+						  "Index,Offset (bytes),Cache Size (bytes),Data Size (bytes),Dimensions,Entry Hash,Data Checksum,Header Checksum,%sIdentifier String\r\n",
+						  utf8_name, dm.size, job->step_count, ei->utf8_path,
+						  ( ei->verify ? "Verified Data Checksum,Verified Header Checksum,Checksum Mismatch," : "" ) );
+		}
+
+		// Free our UTF-8 string.
+		free( utf8_name );
+	}
+
+	QueryPerformanceCounter( &start_time );
+
+	ExtractJobSteps( ei, job, &dm, &ExtractCarvedSteps );
+
+	QueryPerformanceCounter( &end_time );
+
+	double elapsed_time = ( double )( end_time.QuadPart - start_time.QuadPart ) / ( double )frequency.QuadPart;
+	BufferPrintfW( console, L"\nProcessed %lu cache entries in %.3f seconds (%.0f entries per second).\n", job->entry_count, elapsed_time, ( elapsed_time > 0.0 ? job->entry_count / elapsed_time : 0.0 ) );
+
+	if ( ei->verify )
+	{
+		BufferPrintfW( console, L"Found %lu header and %lu data checksum mismatches.\n", job->header_mismatches, job->data_mismatches );
+	}
+
+	if ( ei->output_html )
+	{
+		BufferWrite( &job->html, "</table><br />", 14 );
+	}
+
+	free( job->steps );
+	job->steps = NULL;
+
+	CloseDatabaseMap( &dm );
+	CloseHandle( hFile );
+}
+
+// Writes the output of every finished job that no longer has to wait on the jobs before it.
+void FinishJob( EXTRACT_INFO *ei, EXTRACT_JOB *job )
+{
+	EnterCriticalSection( &ei->commit_cs );
+
+	job->done = true;
+
+	while ( ( unsigned int )ei->commit_index < ei->job_count && ei->jobs[ ei->commit_index ].done )
+	{
+		EXTRACT_JOB *commit_job = &ei->jobs[ ei->commit_index ];
+
+		FlushJob( ei, commit_job );
+
+		FreeBuffer( &commit_job->console );
+		FreeBuffer( &commit_job->html );
+		FreeBuffer( &commit_job->csv );
+
+		InterlockedIncrement( &ei->commit_index );
+	}
+
+	LeaveCriticalSection( &ei->commit_cs );
+}
+
+// Helps extract the chunks of any job that has some left. Returns false if there were none.
+bool HelpExtractChunks( EXTRACT_INFO *ei )
+{
+	bool helped = false;
+
+	for ( unsigned int i = ( unsigned int )ei->commit_index; i < ei->job_count; ++i )
+	{
+		EXTRACT_JOB *job = &ei->jobs[ i ];
+
+		if ( job->extracting_chunks != 0 && job->next_chunk < ( LONG )job->chunk_count )
+		{
+			ExtractChunks( ei, job );
+
+			helped = true;
+		}
+	}
+
+	return helped;
+}
+
+void ProcessJobs( EXTRACT_INFO *ei )
+{
+	for ( ;; )
+	{
+		unsigned int index = ( unsigned int )( InterlockedIncrement( &ei->next_job ) - 1 );
+		if ( index < ei->job_count )
+		{
+			if ( ei->jobs[ index ].carve )
+			{
+				CarveImage( ei, &ei->jobs[ index ] );
+			}
+			else
+			{
+				ExtractDatabase( ei, &ei->jobs[ index ] );
+			}
+
+			FinishExtracting( ei );
+
+			FinishJob( ei, &ei->jobs[ index ] );
+		}
+		else if ( !HelpExtractChunks( ei ) )	// There are no more jobs to claim, but the ones being extracted may be split into chunks.
+		{
+			if ( ei->pending_jobs == 0 )
+			{
+				break;
+			}
+
+			// Wait until a job has chunks to claim or every job has been extracted.
+			WaitForSingleObject( ei->hWorkAvailable, INFINITE );
+		}
+	}
+}
+
+unsigned __stdcall extract_thumbcache( void *pArguments )
+{
+	ProcessJobs( ( EXTRACT_INFO * )pArguments );
+
+	_endthreadex( 0 );
+	return 0;
+}
+
+// Adds the entry hashes of the steps to the set.
+void InsertEntryHashes( hash_table *entry_hashes, const ENTRY_INDEX_RECORD *steps, unsigned int step_count )
+{
+	for ( unsigned int i = 0; steps != NULL && i < step_count; ++i )
+	{
+		if ( steps[ i ].type == STEP_ENTRY )
+		{
+			hash_table_insert( entry_hashes, steps[ i ].entry_hash, 0 );
+		}
+	}
+}
+
+// Walks the entry headers of every database and returns the set of their hashes.
+// This lets the Windows Search database be joined to the entries in a single pass rather than be searched for each entry.
+// The hashes of a database with a valid entry index are taken from the index. The entries of disk images are taken from the steps that ScanImages() found.
+hash_table *CollectEntryHashes( EXTRACT_INFO *ei )
+{
+	hash_table *entry_hashes = hash_table_create( 0 );
+	if ( entry_hashes == NULL )
+	{
+		return NULL;
+	}
+
+	for ( unsigned int i = 0; i < ei->job_count; ++i )
+	{
+		if ( ei->jobs[ i ].carve )
+		{
+			InsertEntryHashes( entry_hashes, ei->jobs[ i ].steps, ei->jobs[ i ].step_count );
+
+			continue;
+		}
+
+		HANDLE hFile = CreateFile( ei->jobs[ i ].name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL );
+		if ( hFile == INVALID_HANDLE_VALUE )
+		{
+			continue;
+		}
+
+		// The index is only used if it was saved for the exact database. It's loaded again when the database is extracted.
+		ENTRY_INDEX_HEADER eih;
+		ENTRY_INDEX *index = NULL;
+		if ( ei->use_index && GetEntryIndexKey( hFile, ENTRY_INDEX_CREATOR_CMD, &eih ) )
+		{
+			index = LoadEntryIndex( ei->jobs[ i ].name, &eih, true );
+		}
+
+		if ( index != NULL )
+		{
+			InsertEntryHashes( entry_hashes, index->records, index->header->record_count );
+
+			FreeEntryIndex( index );
+		}
+		else
+		{
+			// Only the entry headers are read.
+			DATABASE_MAP dm;
+			if ( OpenDatabaseMap( hFile, &dm, true ) )
+			{
+				database_header dh = { 0 };
+
+				unsigned char *view = GetMapView( &dm, 0, sizeof( database_header ) );
+				if ( view != NULL && memcmp( view, "CMMM", 4 ) == 0 )
+				{
+					memcpy( &dh, view, sizeof( database_header ) );
+				}
+
+				if ( GetVersionName( dh.version ) != NULL )
+				{
+					EXTRACT_JOB job;
+					memset( &job, 0, sizeof( EXTRACT_JOB ) );
+
+					unsigned long long current_position = ( dh.version != WINDOWS_8v2 ? 24 : 28 );
+
+					if ( dh.version == WINDOWS_VISTA )
+					{
+						WalkEntries< database_cache_entry_vista >( &job, &dm, current_position, 0 );
+					}
+					else if ( dh.version == WINDOWS_7 )
+					{
+						WalkEntries< database_cache_entry_7 >( &job, &dm, current_position, 0 );
+					}
+					else	// Windows 8/8.1/10
+					{
+						WalkEntries< database_cache_entry_8 >( &job, &dm, current_position, 0 );
+					}
+
+					InsertEntryHashes( entry_hashes, job.steps, job.step_count );
+
+					free( job.steps );
+				}
+
+				CloseDatabaseMap( &dm );
+			}
+		}
+
+		CloseHandle( hFile );
+	}
+
+	return entry_hashes;
+}
+
+// Adds a database, or a disk image to carve, to the end of the job list.
+bool AddExtractJob( EXTRACT_INFO *ei, wchar_t *name, bool carve )
+{
+	if ( ei->job_count == ei->job_size )
+	{
+		unsigned int job_size = ( ei->job_size > 0 ? ei->job_size * 2 : 16 );
+		EXTRACT_JOB *realloc_buffer = ( EXTRACT_JOB * )realloc( ei->jobs, sizeof( EXTRACT_JOB ) * job_size );
+		if ( realloc_buffer == NULL )
+		{
+			return false;
+		}
+
+		ei->jobs = realloc_buffer;
+		ei->job_size = job_size;
+	}
+
+	// The workers change the current directory to the output path, so we need the full path of the database.
+	DWORD name_length = GetFullPathNameW( name, 0, NULL, NULL );
+	if ( name_length == 0 )
+	{
+		return false;
+	}
+
+	EXTRACT_JOB *job = &ei->jobs[ ei->job_count ];
+	memset( job, 0, sizeof( EXTRACT_JOB ) );
+
+	job->name = ( wchar_t * )malloc( sizeof( wchar_t ) * name_length );
+	if ( job->name == NULL )
+	{
+		return false;
+	}
+
+	GetFullPathNameW( name, name_length, job->name, NULL );
+
+	job->carve = carve;
+	job->index = ei->job_count++;
+
+	return true;
+}
+
+// Every processor gets a worker, even if there are fewer jobs, since large databases and disk images are split between them.
+void SetWorkerCount( EXTRACT_INFO *ei )
+{
+	SYSTEM_INFO si;
+	GetSystemInfo( &si );
+
+	ei->thread_count = min( si.dwNumberOfProcessors, MAXIMUM_WAIT_OBJECTS );
+	if ( ei->thread_count == 0 )
+	{
+		ei->thread_count = 1;
+	}
+}
+
+// Scans every disk image in the job list. This is done before any job is extracted so that the hashes of the carved entries
+// can be joined to the Windows Search databases along with the rest. Each image is scanned by every worker.
+void ScanImages( EXTRACT_INFO *ei )
+{
+	SetWorkerCount( ei );
+
+	for ( unsigned int i = 0; i < ei->job_count; ++i )
+	{
+		if ( ei->jobs[ i ].carve )
+		{
+			ScanImage( ei, &ei->jobs[ i ] );
+		}
+	}
+}
+
+// Extracts every database in the job list, one per worker. The output is written in the order the jobs were added.
+// Idle workers help extract the chunks of large databases.
+void RunExtractJobs( EXTRACT_INFO *ei )
+{
+	if ( ei->job_count == 0 )
+	{
+		return;
+	}
+
+	SetWorkerCount( ei );
+
+	ei->next_job = 0;
+	ei->commit_index = 0;
+	ei->pending_jobs = ei->job_count;
+	ei->chunked_jobs = 0;
+	InitializeCriticalSection( &ei->commit_cs );
+	InitializeCriticalSection( &ei->work_cs );
+
+	// The idle workers need something to wait on. Without it, each job is extracted by a single worker.
+	ei->hWorkAvailable = CreateEvent( NULL, TRUE, FALSE, NULL );
+	if ( ei->hWorkAvailable == NULL )
+	{
+		ei->thread_count = 1;
+	}
+
+	for ( unsigned int i = 0; i < THUMBNAIL_LOCK_COUNT; ++i )
+	{
+		ei->thumbnail_tree[ i ] = dllrbt_create( dllrbt_filename_compare );
+		InitializeCriticalSection( &ei->thumbnail_cs[ i ] );
+	}
+
+	HANDLE threads[ MAXIMUM_WAIT_OBJECTS ];
+	unsigned int thread_count = 0;
+
+	if ( ei->thread_count > 1 )
+	{
+		for ( ; thread_count < ei->thread_count; ++thread_count )
+		{
+			threads[ thread_count ] = ( HANDLE )_beginthreadex( NULL, 0, &extract_thumbcache, ( void * )ei, 0, NULL );
+			if ( threads[ thread_count ] == NULL )
+			{
+				break;
+			}
+		}
+	}
+
+	if ( thread_count > 0 )
+	{
+		WaitForMultipleObjects( thread_count, threads, TRUE, INFINITE );
+
+		for ( unsigned int i = 0; i < thread_count; ++i )
+		{
+			CloseHandle( threads[ i ] );
+		}
+	}
+
+	// Process anything the workers didn't, or everything if there's only one job or no workers could be created.
+	ProcessJobs( ei );
+
+	for ( unsigned int i = 0; i < THUMBNAIL_LOCK_COUNT; ++i )
+	{
+		// Free the filenames and sequences.
+		node_type *node = dllrbt_get_head( ei->thumbnail_tree[ i ] );
+		while ( node != NULL )
+		{
+			free( node->val );
+			free( node->key );
+			node = node->next;
+		}
+
+		dllrbt_delete_recursively( ei->thumbnail_tree[ i ] );
+		ei->thumbnail_tree[ i ] = NULL;
+
+		DeleteCriticalSection( &ei->thumbnail_cs[ i ] );
+	}
+
+	if ( ei->hWorkAvailable != NULL )
+	{
+		CloseHandle( ei->hWorkAvailable );
+		ei->hWorkAvailable = NULL;
+	}
+
+	DeleteCriticalSection( &ei->work_cs );
+	DeleteCriticalSection( &ei->commit_cs );
+}
@@ -0,0 +1,278 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef READ_THUMBCACHE_H
+#define READ_THUMBCACHE_H
+
+#include "globals.h"
+#include "dllrbt.h"
+#include "entry_index.h"
+#include "hash_table.h"
+
+// Magic identifiers for various image formats.
+#define FILE_TYPE_BMP	"BM"
+#define FILE_TYPE_JPEG	"\xFF\xD8\xFF\xE0"
+#define FILE_TYPE_PNG	"\x89\x50\x4E\x47\x0D\x0A\x1A\x0A"
+
+// Database version.
+#define WINDOWS_VISTA	0x14
+#define WINDOWS_7		0x15
+#define WINDOWS_8		0x1A
+#define WINDOWS_8v2		0x1C
+#define WINDOWS_8v3		0x1E
+#define WINDOWS_8_1		0x1F
+#define WINDOWS_10		0x20
+
+// Thumbcache header information.
+struct database_header
+{
+	char magic_identifier[ 4 ];
+	unsigned int version;
+	unsigned int type;	// Windows Vista & 7: 00 = 32, 01 = 96, 02 = 256, 03 = 1024, 04 = sr
+};						// Windows 8: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 1024, 06 = sr, 07 = wide, 08 = exif
+						// Windows 8.1: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 1024, 06 = 1600, 07 = sr, 08 = wide, 09 = exif, 0A = wide_alternate
+						// Windows 10: 00 = 16, 01 = 32, 02 = 48, 03 = 96, 04 = 256, 05 = 768, 06 = 1280, 07 = 1920, 08 = 2560, 09 = sr, 0A = wide, 0B = exif, 0C = wide_alternate, 0D = custom_stream
+
+// Found in WINDOWS_VISTA/7/8 databases.
+struct database_header_entry_info
+{
+	unsigned int first_cache_entry;
+	unsigned int available_cache_entry;
+	unsigned int number_of_cache_entries;
+};
+
+// Found in WINDOWS_8v2 databases.
+struct database_header_entry_info_v2
+{
+	unsigned int unknown;
+	unsigned int first_cache_entry;
+	unsigned int available_cache_entry;
+	unsigned int number_of_cache_entries;
+};
+
+// Found in WINDOWS_8v3/8_1/10 databases.
+struct database_header_entry_info_v3
+{
+	unsigned int unknown;
+	unsigned int first_cache_entry;
+	unsigned int available_cache_entry;
+};
+
+// Window 7 Thumbcache entry.
+struct database_cache_entry_7
+{
+	char magic_identifier[ 4 ];
+	unsigned int cache_entry_size;
+	long long entry_hash;
+	unsigned int filename_length;
+	unsigned int padding_size;
+	unsigned int data_size;
+	unsigned int unknown;
+	long long data_checksum;
+	long long header_checksum;
+};
+
+// Window 8 Thumbcache entry.
+struct database_cache_entry_8
+{
+	char magic_identifier[ 4 ];
+	unsigned int cache_entry_size;
+	long long entry_hash;
+	unsigned int filename_length;
+	unsigned int padding_size;
+	unsigned int data_size;
+	unsigned int width;
+	unsigned int height;
+	unsigned int unknown;
+	long long data_checksum;
+	long long header_checksum;
+};
+
+// Windows Vista Thumbcache entry.
+struct database_cache_entry_vista
+{
+	char magic_identifier[ 4 ];
+	unsigned int cache_entry_size;
+	long long entry_hash;
+	wchar_t extension[ 4 ];
+	unsigned int filename_length;
+	unsigned int padding_size;
+	unsigned int data_size;
+	unsigned int unknown;
+	long long data_checksum;
+	long long header_checksum;
+};
+
+// Name and dimensions of a cache type. dimensions is NULL for the non-square caches (sr, wide, exif, etc.).
+struct CACHE_TYPE
+{
+	const char *name;
+	const char *dimensions;
+};
+
+// Windows Vista is the only layout that stores the file extension in the entry.
+inline const wchar_t *entry_extension( const database_cache_entry_vista &dce ) { return dce.extension; }
+template < typename T > inline const wchar_t *entry_extension( const T & ) { return NULL; }
+
+// Windows 8/8.1/10 is the only layout that stores the width and height of the image.
+inline bool entry_dimensions( const database_cache_entry_8 &dce, unsigned int &width, unsigned int &height ) { width = dce.width; height = dce.height; return true; }
+template < typename T > inline bool entry_dimensions( const T &, unsigned int &, unsigned int & ) { return false; }
+
+// A read-only mapping of a thumbcache database. Views into it are only valid until the next call to GetMapView.
+// If only ranges are read, then each view is read into buffer instead so that nothing around it is paged in.
+struct DATABASE_MAP
+{
+	HANDLE hFile;						// The database file. The map does not own this handle.
+	HANDLE hMapping;					// NULL if the database is empty or only ranges are read.
+	unsigned char *view;				// The currently mapped view.
+	unsigned long long view_offset;		// Database offset of the mapped view.
+	unsigned long long view_size;		// Size of the mapped view.
+	unsigned long long size;			// Size of the database.
+	unsigned char *buffer;				// The range that was last read.
+	unsigned int buffer_size;
+	bool read_ranges;
+};
+
+#define THUMBNAIL_LOCK_COUNT	64
+
+// Number of steps in each chunk when a database is split between workers.
+#define ENTRY_CHUNK_SIZE	256
+
+// A range of steps. Its output is held until every chunk before it has been moved to the job.
+struct ENTRY_CHUNK
+{
+	OUTPUT_BUFFER console;
+	OUTPUT_BUFFER html;
+	OUTPUT_BUFFER csv;
+	bool done;
+};
+
+// Size of each region of a disk image that a worker reads and scans for entry headers.
+#define CARVE_REGION_SIZE	( 16 * 1024 * 1024 )
+
+// Entry headers whose checksum was valid in a region of a disk image.
+struct CARVE_REGION
+{
+	ENTRY_INDEX_RECORD *steps;
+	unsigned int step_count;
+	bool failed;				// The region could not be read or its steps could not be allocated.
+};
+
+// Shared between the workers that scan a disk image.
+struct CARVE_INFO
+{
+	wchar_t *name;					// Full path of the disk image. Each worker opens its own handle so that their reads aren't serialized.
+	unsigned long long size;
+	CARVE_REGION *regions;
+	unsigned int region_count;
+	volatile LONG next_region;		// The next region to be claimed by a worker.
+};
+
+struct EXTRACT_INFO;
+struct EXTRACT_JOB;
+
+typedef void ( *EXTRACT_STEPS )( EXTRACT_INFO *ei, EXTRACT_JOB *job, DATABASE_MAP *dm, unsigned int first, unsigned int last, OUTPUT_BUFFER *console, OUTPUT_BUFFER *html, OUTPUT_BUFFER *csv );
+
+// A database to extract. Its output is held until every database before it has been written.
+struct EXTRACT_JOB
+{
+	wchar_t *name;				// Full path of the database.
+	OUTPUT_BUFFER console;		// UTF-16 console output.
+	OUTPUT_BUFFER html;			// UTF-8 HTML report output.
+	OUTPUT_BUFFER csv;			// UTF-8 CSV report output.
+	unsigned int index;			// Position in the input order.
+	bool start_reports;			// The database was valid and its report sections need to be started.
+	bool carve;					// The file is a disk image whose entries are carved rather than walked.
+	bool started;				// Some of the job's output has been written.
+	bool done;
+
+	ENTRY_INDEX_RECORD *steps;	// Built by walking the entries before any of them are extracted, or loaded from the database's index.
+	unsigned int step_count;
+	unsigned int entry_count;	// Number of entries that were processed.
+	volatile LONG header_mismatches;	// Number of entries whose checksums didn't match the ones that were computed.
+	volatile LONG data_mismatches;
+	ENTRY_INDEX *entry_index;	// Holds the steps if they were loaded from the database's index.
+
+	// Used while the steps are extracted in chunks by more than one worker.
+	DATABASE_MAP *dm;						// The worker that owns the job holds the mapping open.
+	EXTRACT_STEPS extract_steps;			// Extracts the steps for the database's entry layout.
+	ENTRY_CHUNK *chunks;
+	unsigned int chunk_count;
+	volatile LONG next_chunk;				// The next chunk to be claimed by a worker.
+	unsigned int commit_chunk;				// The next chunk to be moved to the job. Guarded by chunk_cs.
+	CRITICAL_SECTION chunk_cs;
+	HANDLE hChunksDone;						// Signaled once every chunk has been moved to the job.
+	volatile LONG extracting_chunks;		// 1 if workers may claim chunks.
+};
+
+// Shared between the workers that extract the databases.
+struct EXTRACT_INFO
+{
+	EXTRACT_JOB *jobs;
+	unsigned int job_count;
+	unsigned int job_size;
+
+	unsigned int thread_count;
+
+	volatile LONG next_job;		// The next job to be claimed by a worker.
+	volatile LONG commit_index;	// The job whose output is being written. Every job before it has been written.
+	volatile LONG pending_jobs;	// Jobs that haven't been extracted. Idle workers wait for them in case they need help. Guarded by work_cs.
+	CRITICAL_SECTION commit_cs;
+
+	unsigned int chunked_jobs;	// Jobs that have chunks left to claim. Guarded by work_cs.
+	CRITICAL_SECTION work_cs;
+	HANDLE hWorkAvailable;		// Signaled while a job has chunks left to claim, or once every job has been extracted. Idle workers wait on it.
+
+	// Thumbnail filenames that have been written and the sequence (job index and step) of the entry that wrote them. Each tree is guarded by its own lock.
+	dllrbt_tree *thumbnail_tree[ THUMBNAIL_LOCK_COUNT ];
+	CRITICAL_SECTION thumbnail_cs[ THUMBNAIL_LOCK_COUNT ];
+
+	HANDLE hFile_html;
+	HANDLE hFile_csv;
+
+	char *utf8_path;			// The output path for our reports.
+	int utf8_path_length;
+
+	bool output_html;
+	bool output_csv;
+	bool skip_blank;
+	bool extract_thumbnails;
+	bool verify;				// Compute the header and data checksum of each entry and compare them to the ones that were stored.
+	bool list_only;				// Only read the entry headers, identifier strings, and the first bytes of the data that identify the file type.
+	bool use_index;				// Load the steps from each database's index, or save them to it.
+	bool incremental;			// Only extract the entries that were added or changed since each database's index was saved.
+};
+
+bool OpenDatabaseMap( HANDLE hFile, DATABASE_MAP *dm, bool read_ranges );
+void CloseDatabaseMap( DATABASE_MAP *dm );
+void ShareDatabaseMap( const DATABASE_MAP *src, DATABASE_MAP *dm );
+void CloseDatabaseView( DATABASE_MAP *dm );
+unsigned char *GetMapView( DATABASE_MAP *dm, unsigned long long offset, unsigned int length );
+
+bool scan_memory( DATABASE_MAP *dm, unsigned long long &offset );
+
+const char *GetVersionName( unsigned int version );
+const CACHE_TYPE *GetCacheType( unsigned int version, unsigned int type );
+
+hash_table *CollectEntryHashes( EXTRACT_INFO *ei );
+
+bool AddExtractJob( EXTRACT_INFO *ei, wchar_t *name, bool carve );
+void ScanImages( EXTRACT_INFO *ei );
+void RunExtractJobs( EXTRACT_INFO *ei );
+
+#endif
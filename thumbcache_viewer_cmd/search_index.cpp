@@ -0,0 +1,207 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "search_index.h"
+
+#include <stddef.h>
+
+// Indices larger than this are ignored so that they can be read at once.
+#define MAX_SEARCH_INDEX_SIZE	0x7FFFFFFF
+
+// Returns the database path with the index extension appended to it.
+wchar_t *GetSearchIndexPath( const wchar_t *database_path )
+{
+	int database_path_length = ( int )wcslen( database_path );
+	int index_path_length = database_path_length + ( sizeof( SEARCH_INDEX_EXTENSION ) / sizeof( wchar_t ) );	// Includes the NULL character.
+
+	wchar_t *index_path = ( wchar_t * )malloc( sizeof( wchar_t ) * index_path_length );
+	if ( index_path != NULL )
+	{
+		swprintf_s( index_path, index_path_length, L"%s" SEARCH_INDEX_EXTENSION, database_path );
+	}
+
+	return index_path;
+}
+
+// Fills in the fields that identify the database. The file pointer is left at an undefined position.
+bool GetSearchIndexKey( HANDLE hFile, unsigned long revision, unsigned long page_size, SEARCH_INDEX_HEADER *sih )
+{
+	LARGE_INTEGER file_size;
+	FILETIME last_write_time;
+	if ( GetFileSizeEx( hFile, &file_size ) == FALSE || GetFileTime( hFile, NULL, NULL, &last_write_time ) == FALSE )
+	{
+		return false;
+	}
+
+	// The header is the first page of the database.
+	unsigned char *header = ( unsigned char * )malloc( sizeof( unsigned char ) * page_size );
+	if ( header == NULL )
+	{
+		return false;
+	}
+
+	DWORD read = 0;
+	if ( SetFilePointer( hFile, 0, NULL, FILE_BEGIN ) == INVALID_SET_FILE_POINTER || ReadFile( hFile, header, page_size, &read, NULL ) == FALSE || read != page_size )
+	{
+		free( header );
+		return false;
+	}
+
+	// FNV-1a
+	unsigned long long header_hash = 14695981039346656037ULL;
+	for ( DWORD i = 0; i < read; ++i )
+	{
+		header_hash ^= header[ i ];
+		header_hash *= 1099511628211ULL;
+	}
+
+	free( header );
+
+	memset( sih, 0, sizeof( SEARCH_INDEX_HEADER ) );
+	memcpy( sih->magic_identifier, "TCSX", 4 );
+	sih->version = SEARCH_INDEX_VERSION;
+	sih->database_size = file_size.QuadPart;
+	sih->database_write_time = ( ( unsigned long long )last_write_time.dwHighDateTime << 32 ) | last_write_time.dwLowDateTime;
+	sih->header_hash = header_hash;
+	sih->revision = revision;
+	sih->page_size = page_size;
+
+	return true;
+}
+
+// Returns NULL if the index doesn't exist, is damaged, or was saved for a different version of the database.
+SEARCH_INDEX *LoadSearchIndex( const wchar_t *database_path, const SEARCH_INDEX_HEADER *key )
+{
+	SEARCH_INDEX *index = NULL;
+
+	wchar_t *index_path = GetSearchIndexPath( database_path );
+	if ( index_path == NULL )
+	{
+		return NULL;
+	}
+
+	HANDLE hFile = CreateFile( index_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+	free( index_path );
+
+	if ( hFile == INVALID_HANDLE_VALUE )
+	{
+		return NULL;
+	}
+
+	LARGE_INTEGER file_size;
+	if ( GetFileSizeEx( hFile, &file_size ) != FALSE && file_size.QuadPart >= sizeof( SEARCH_INDEX_HEADER ) && file_size.QuadPart <= MAX_SEARCH_INDEX_SIZE )
+	{
+		unsigned int index_size = ( unsigned int )file_size.QuadPart;
+		DWORD read = 0;
+
+		unsigned char *buffer = ( unsigned char * )malloc( sizeof( unsigned char ) * index_size );
+		if ( buffer != NULL && ReadFile( hFile, buffer, index_size, &read, NULL ) != FALSE && read == index_size )
+		{
+			SEARCH_INDEX_HEADER *sih = ( SEARCH_INDEX_HEADER * )buffer;
+
+			unsigned long long columns_size = ( unsigned long long )sih->column_count * sizeof( SEARCH_INDEX_COLUMN );
+			unsigned long long rows_size = ( unsigned long long )sih->row_count * sizeof( SEARCH_INDEX_ROW );
+
+			// The database must not have changed since the index was saved, and the columns, rows, and names must fill the rest of the index.
+			if ( memcmp( sih, key, offsetof( SEARCH_INDEX_HEADER, column_count ) ) == 0 &&
+				 columns_size + rows_size + sih->name_size == index_size - sizeof( SEARCH_INDEX_HEADER ) )
+			{
+				SEARCH_INDEX_COLUMN *columns = ( SEARCH_INDEX_COLUMN * )( buffer + sizeof( SEARCH_INDEX_HEADER ) );
+
+				// Every column name must be within the names.
+				unsigned int i = 0;
+				for ( ; i < sih->column_count; ++i )
+				{
+					if ( columns[ i ].name_offset > sih->name_size || columns[ i ].name_length > sih->name_size - columns[ i ].name_offset )
+					{
+						break;
+					}
+				}
+
+				if ( i == sih->column_count )
+				{
+					index = ( SEARCH_INDEX * )malloc( sizeof( SEARCH_INDEX ) );
+					if ( index != NULL )
+					{
+						index->buffer = buffer;
+						index->header = sih;
+						index->columns = columns;
+						index->rows = ( SEARCH_INDEX_ROW * )( buffer + sizeof( SEARCH_INDEX_HEADER ) + columns_size );
+						index->names = buffer + sizeof( SEARCH_INDEX_HEADER ) + columns_size + rows_size;
+					}
+				}
+			}
+		}
+
+		if ( index == NULL )
+		{
+			free( buffer );
+		}
+	}
+
+	CloseHandle( hFile );
+
+	return index;
+}
+
+// The counts and name size are taken from sih. A partially written index is deleted.
+bool SaveSearchIndex( const wchar_t *database_path, const SEARCH_INDEX_HEADER *sih, const SEARCH_INDEX_COLUMN *columns, const SEARCH_INDEX_ROW *rows, const void *names )
+{
+	bool ret = false;
+	DWORD written = 0;
+
+	wchar_t *index_path = GetSearchIndexPath( database_path );
+	if ( index_path == NULL )
+	{
+		return false;
+	}
+
+	// This will fail if the database is on read-only media. We'll simply parse it each time.
+	HANDLE hFile = CreateFile( index_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile != INVALID_HANDLE_VALUE )
+	{
+		unsigned int columns_size = sih->column_count * sizeof( SEARCH_INDEX_COLUMN );
+		unsigned int rows_size = sih->row_count * sizeof( SEARCH_INDEX_ROW );
+
+		ret = ( WriteFile( hFile, sih, sizeof( SEARCH_INDEX_HEADER ), &written, NULL ) != FALSE && written == sizeof( SEARCH_INDEX_HEADER ) &&
+				( columns_size == 0 || ( WriteFile( hFile, columns, columns_size, &written, NULL ) != FALSE && written == columns_size ) ) &&
+				( rows_size == 0 || ( WriteFile( hFile, rows, rows_size, &written, NULL ) != FALSE && written == rows_size ) ) &&
+				( sih->name_size == 0 || ( WriteFile( hFile, names, sih->name_size, &written, NULL ) != FALSE && written == sih->name_size ) ) );
+
+		CloseHandle( hFile );
+
+		if ( !ret )
+		{
+			DeleteFile( index_path );
+		}
+	}
+
+	free( index_path );
+
+	return ret;
+}
+
+void FreeSearchIndex( SEARCH_INDEX *index )
+{
+	if ( index != NULL )
+	{
+		free( index->buffer );
+		free( index );
+	}
+}
@@ -0,0 +1,85 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include "globals.h"
+#include "parse_esedb.h"
+
+// The index of a Windows Search database is saved next to it with this extension appended to its name.
+#define SEARCH_INDEX_EXTENSION	L".tcsidx"
+
+#define SEARCH_INDEX_VERSION	1
+
+// Everything up to column_count identifies the database that the index was saved for.
+struct SEARCH_INDEX_HEADER
+{
+	char magic_identifier[ 4 ];				// "TCSX"
+	unsigned short version;
+	unsigned short reserved;
+	unsigned long long database_size;
+	unsigned long long database_write_time;	// FILETIME of the last write.
+	unsigned long long header_hash;			// FNV-1a hash of the database's header page. Its database time changes whenever the database is written to.
+	unsigned int revision;
+	unsigned int page_size;
+	unsigned int column_count;
+	unsigned int row_count;
+	unsigned int name_size;					// Size of the column names that follow the rows.
+	unsigned int reserved2;
+	ESE_TABLE table;						// The layout of the property table's records.
+};
+
+// A Windows Property and the column that holds it.
+struct SEARCH_INDEX_COLUMN
+{
+	unsigned int name_offset;				// Offset of the name from the beginning of the names.
+	unsigned int name_length;				// In bytes.
+	unsigned int column_type;
+	unsigned int column_id;					// 0 if the property's column wasn't found.
+	unsigned int max_size;
+	unsigned short type;					// VARENUM
+	unsigned char jet_compress;
+	unsigned char reserved;
+};
+
+// A row of the property table in the order of the table.
+struct SEARCH_INDEX_ROW
+{
+	unsigned long long hash;				// System_ThumbnailCacheId
+	unsigned int page_number;
+	unsigned short tag;
+	unsigned short reserved;
+};
+
+// An index that was loaded with a single read. Everything points into buffer.
+struct SEARCH_INDEX
+{
+	SEARCH_INDEX_HEADER *header;
+	SEARCH_INDEX_COLUMN *columns;
+	SEARCH_INDEX_ROW *rows;
+	unsigned char *names;
+	unsigned char *buffer;
+};
+
+bool GetSearchIndexKey( HANDLE hFile, unsigned long revision, unsigned long page_size, SEARCH_INDEX_HEADER *sih );
+SEARCH_INDEX *LoadSearchIndex( const wchar_t *database_path, const SEARCH_INDEX_HEADER *key );
+bool SaveSearchIndex( const wchar_t *database_path, const SEARCH_INDEX_HEADER *sih, const SEARCH_INDEX_COLUMN *columns, const SEARCH_INDEX_ROW *rows, const void *names );
+void FreeSearchIndex( SEARCH_INDEX *index );
+
+#endif
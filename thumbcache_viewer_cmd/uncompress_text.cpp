@@ -0,0 +1,231 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "uncompress_text.h"
+
+#include <limits.h>
+
+// Values are obfuscated with a key that's derived from their size. Each byte is XORed with a byte of the key and its own offset.
+inline unsigned char GetTextByte( const unsigned char *src, unsigned int key, size_t offset )
+{
+	return src[ offset ] ^ ( unsigned char )( key >> ( ( offset & 0x03 ) * 8 ) ) ^ ( unsigned char )offset;
+}
+
+inline void PutByte( TEXT_OUTPUT *output, unsigned char value )
+{
+	if ( output->length < output->dst_size )
+	{
+		output->dst[ output->length ] = value;
+	}
+
+	++output->length;
+}
+
+// Each run is a count, the upper byte that its characters share, and then the lower byte of each character.
+// The upper byte is always present, so a run with a count of 0 is two bytes that add nothing.
+inline void PutRunLengthByte( TEXT_OUTPUT *output, unsigned char value )
+{
+	if ( output->state == 0 )
+	{
+		output->run_remaining = value;
+		output->state = 1;
+	}
+	else if ( output->state == 1 )
+	{
+		output->upper_byte = value;
+		output->state = ( output->run_remaining > 0 ? 2 : 0 );
+	}
+	else
+	{
+		PutByte( output, value );
+		PutByte( output, output->upper_byte );
+
+		if ( --output->run_remaining == 0 )
+		{
+			output->state = 0;
+		}
+	}
+}
+
+inline void PutTextByte( TEXT_OUTPUT *output, unsigned char value, bool run_length )
+{
+	if ( run_length )
+	{
+		PutRunLengthByte( output, value );
+	}
+	else
+	{
+		PutByte( output, value );
+	}
+}
+
+inline unsigned int GetTextUShort( const unsigned char *src, size_t src_size, unsigned int key, size_t offset )
+{
+	// The bit stream is padded with 0s.
+	unsigned int value = ( offset < src_size ? GetTextByte( src, key, offset ) : 0 );
+	if ( offset + 1 < src_size )
+	{
+		value |= ( GetTextByte( src, key, offset + 1 ) << 8 );
+	}
+
+	return value;
+}
+
+// The uncompressed size is followed by the code lengths of the 256 byte values, two to a byte, and then the bit stream.
+// The codes are canonical: shorter codes come first, and codes of the same length are in the order of their byte values.
+bool DecodeByteIndexed( const unsigned char *src, size_t src_size, unsigned int key, TEXT_OUTPUT *output, bool run_length )
+{
+	size_t offset = 1;
+
+	if ( src_size < offset + sizeof( unsigned short ) + ( TEXT_HUFFMAN_SYMBOL_COUNT / 2 ) )
+	{
+		return false;
+	}
+
+	unsigned int uncompressed_size = GetTextUShort( src, src_size, key, offset );
+	offset += sizeof( unsigned short );
+
+	unsigned char code_lengths[ TEXT_HUFFMAN_SYMBOL_COUNT ];
+	unsigned int length_counts[ TEXT_HUFFMAN_MAX_CODE_LENGTH + 1 ] = { 0 };
+
+	for ( unsigned int i = 0; i < TEXT_HUFFMAN_SYMBOL_COUNT; i += 2, ++offset )
+	{
+		unsigned char lengths = GetTextByte( src, key, offset );
+
+		code_lengths[ i ] = lengths & 0x0F;
+		code_lengths[ i + 1 ] = lengths >> 4;
+
+		if ( code_lengths[ i ] > TEXT_HUFFMAN_MAX_CODE_LENGTH || code_lengths[ i + 1 ] > TEXT_HUFFMAN_MAX_CODE_LENGTH )
+		{
+			return false;
+		}
+
+		++length_counts[ code_lengths[ i ] ];
+		++length_counts[ code_lengths[ i + 1 ] ];
+	}
+
+	// Find where each code length begins in the table. The codes must fill it exactly.
+	unsigned int table_offsets[ TEXT_HUFFMAN_MAX_CODE_LENGTH + 1 ] = { 0 };
+	unsigned int table_used = 0;
+
+	for ( unsigned int length = 1; length <= TEXT_HUFFMAN_MAX_CODE_LENGTH; ++length )
+	{
+		table_offsets[ length ] = table_used;
+		table_used += ( length_counts[ length ] << ( TEXT_HUFFMAN_MAX_CODE_LENGTH - length ) );
+	}
+
+	if ( table_used != TEXT_HUFFMAN_TABLE_SIZE )
+	{
+		return false;
+	}
+
+	// Each entry is the byte value in the upper bits and the code length in the lower 4 bits.
+	unsigned short table[ TEXT_HUFFMAN_TABLE_SIZE ];
+
+	for ( unsigned int symbol = 0; symbol < TEXT_HUFFMAN_SYMBOL_COUNT; ++symbol )
+	{
+		unsigned int length = code_lengths[ symbol ];
+		if ( length > 0 )
+		{
+			unsigned int entry_count = 1 << ( TEXT_HUFFMAN_MAX_CODE_LENGTH - length );
+			for ( unsigned int i = 0; i < entry_count; ++i )
+			{
+				table[ table_offsets[ length ] + i ] = ( unsigned short )( ( symbol << 4 ) | length );
+			}
+
+			table_offsets[ length ] += entry_count;
+		}
+	}
+
+	// The bit stream is read as 16-bit little-endian words, most significant bit first.
+	unsigned int bits = ( GetTextUShort( src, src_size, key, offset ) << 16 ) | GetTextUShort( src, src_size, key, offset + 2 );
+	unsigned int bit_count = 32;
+	offset += 4;
+
+	for ( unsigned int i = 0; i < uncompressed_size; ++i )
+	{
+		unsigned short entry = table[ bits >> ( 32 - TEXT_HUFFMAN_MAX_CODE_LENGTH ) ];
+		unsigned int length = entry & 0x0F;
+
+		PutTextByte( output, ( unsigned char )( entry >> 4 ), run_length );
+
+		bits <<= length;
+		bit_count -= length;
+
+		if ( bit_count < 16 )
+		{
+			// Allow the padding of the last word, but no more.
+			if ( offset >= src_size + sizeof( unsigned short ) )
+			{
+				return ( i + 1 == uncompressed_size );
+			}
+
+			bits |= ( GetTextUShort( src, src_size, key, offset ) << ( 16 - bit_count ) );
+			bit_count += 16;
+			offset += sizeof( unsigned short );
+		}
+	}
+
+	return true;
+}
+
+int UncompressText( const unsigned char *src, size_t src_size, wchar_t *dst, size_t dst_size )
+{
+	if ( src == NULL || src_size == 0 || ( dst == NULL && dst_size > 0 ) )
+	{
+		return -1;
+	}
+
+	unsigned int key = 0x05000113 ^ ( unsigned int )src_size;
+
+	TEXT_OUTPUT output;
+	memset( &output, 0, sizeof( TEXT_OUTPUT ) );
+	output.dst = ( unsigned char * )dst;
+	output.dst_size = dst_size;
+
+	unsigned char compression = GetTextByte( src, key, 0 );
+	bool run_length = ( compression & TEXT_COMPRESSION_RUN_LENGTH ? true : false );
+
+	if ( compression & ~( TEXT_COMPRESSION_RUN_LENGTH | TEXT_COMPRESSION_BYTE_INDEXED ) )
+	{
+		return -1;
+	}
+
+	if ( compression & TEXT_COMPRESSION_BYTE_INDEXED )
+	{
+		if ( !DecodeByteIndexed( src, src_size, key, &output, run_length ) )
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		for ( size_t offset = 1; offset < src_size; ++offset )
+		{
+			PutTextByte( &output, GetTextByte( src, key, offset ), run_length );
+		}
+	}
+
+	// A run can't be cut short, and the output has to be UTF-16.
+	if ( output.state != 0 || ( output.length & 1 ) || output.length > INT_MAX )
+	{
+		return -1;
+	}
+
+	return ( int )output.length;
+}
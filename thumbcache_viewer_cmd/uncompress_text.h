@@ -0,0 +1,59 @@
+/*
+	thumbcache_viewer_cmd will extract thumbnail images from thumbcache database files.
+	Copyright (C) 2011-2023 Eric Kutcher
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef UNCOMPRESS_TEXT_H
+#define UNCOMPRESS_TEXT_H
+
+#define STRICT
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+// The first byte of a value (once it's unobfuscated) says how it was compressed.
+#define TEXT_COMPRESSION_RUN_LENGTH		0x01	// Runs of UTF-16 characters that share their upper byte.
+#define TEXT_COMPRESSION_BYTE_INDEXED	0x02	// Huffman coded bytes. Can be combined with TEXT_COMPRESSION_RUN_LENGTH.
+
+#define TEXT_HUFFMAN_SYMBOL_COUNT		256
+#define TEXT_HUFFMAN_MAX_CODE_LENGTH	11
+#define TEXT_HUFFMAN_TABLE_SIZE			( 1 << TEXT_HUFFMAN_MAX_CODE_LENGTH )
+
+// Collects the uncompressed bytes. Nothing is written past dst_size, but length counts every byte.
+struct TEXT_OUTPUT
+{
+	unsigned char *dst;
+	size_t dst_size;
+	size_t length;
+
+	// Run-length state.
+	unsigned char state;			// 0 = expecting a run's count, 1 = expecting its upper byte, 2 = in the run.
+	unsigned char upper_byte;
+	unsigned char run_remaining;
+};
+
+// in:		src:		A compressed value from a JetCompress column of the Windows Search database (not NULL terminated). It is not modified.
+// in:		src_size:	Size in bytes of the src buffer.
+// out:		dst:		A wide character buffer to hold the uncompressed output (is not NULL terminated). Can be NULL if dst_size is 0.
+// in:		dst_size:	Size in bytes of the dst buffer.
+//
+// On success: Returns the length in bytes of the uncompressed value. If dst_size is too small, then only dst_size bytes are written.
+// On failure: Returns -1.
+//
+// Remarks: No memory is allocated, so the function can be called from any number of threads.
+//
+int UncompressText( const unsigned char *src, size_t src_size, wchar_t *dst, size_t dst_size );
+
+#endif
@@ -18,144 +18,381 @@
 
 #include "utilities.h"
 
-wchar_t *GetSFGAOStr( unsigned long sfgao_flags )
-{
-	wchar_t *ret = NULL;
-	if ( sfgao_flags == 0 )
-	{
-		ret = ( wchar_t * )malloc( sizeof( wchar_t ) * 5 );
-		wmemcpy_s( ret, 5, L"None\0", 5 );
-	}
-
-	int size = _scwprintf( L"%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
-						( ( sfgao_flags & SFGAO_CANCOPY ) ? L"SFGAO_CANCOPY, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANMOVE ) ? L"SFGAO_CANMOVE, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANLINK ) ? L"SFGAO_CANLINK, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGE ) ? L"SFGAO_STORAGE, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANRENAME ) ? L"SFGAO_CANRENAME, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANDELETE ) ? L"SFGAO_CANDELETE, " : L"" ),
-						( ( sfgao_flags & SFGAO_HASPROPSHEET ) ? L"SFGAO_HASPROPSHEET, " : L"" ),
-						( ( sfgao_flags & SFGAO_DROPTARGET ) ? L"SFGAO_DROPTARGET, " : L"" ),
-						( ( sfgao_flags & SFGAO_CAPABILITYMASK ) ? L"SFGAO_CAPABILITYMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_ENCRYPTED ) ? L"SFGAO_ENCRYPTED, " : L"" ),
-						( ( sfgao_flags & SFGAO_ISSLOW ) ? L"SFGAO_ISSLOW, " : L"" ),
-						( ( sfgao_flags & SFGAO_GHOSTED ) ? L"SFGAO_GHOSTED, " : L"" ),
-						( ( sfgao_flags & SFGAO_LINK ) ? L"SFGAO_LINK, " : L"" ),
-						( ( sfgao_flags & SFGAO_SHARE ) ? L"SFGAO_SHARE, " : L"" ),
-						( ( sfgao_flags & SFGAO_READONLY ) ? L"SFGAO_READONLY, " : L"" ),
-						( ( sfgao_flags & SFGAO_HIDDEN ) ? L"SFGAO_HIDDEN, " : L"" ),
-						( ( sfgao_flags & SFGAO_DISPLAYATTRMASK ) ? L"SFGAO_DISPLAYATTRMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_FILESYSANCESTOR ) ? L"SFGAO_FILESYSANCESTOR, " : L"" ),
-						( ( sfgao_flags & SFGAO_FOLDER ) ? L"SFGAO_FOLDER, " : L"" ),
-						( ( sfgao_flags & SFGAO_FILESYSTEM ) ? L"SFGAO_FILESYSTEM, " : L"" ),
-						( ( sfgao_flags & SFGAO_HASSUBFOLDER ) ? L"SFGAO_HASSUBFOLDER / SFGAO_CONTENTSMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_VALIDATE ) ? L"SFGAO_VALIDATE, " : L"" ),
-						( ( sfgao_flags & SFGAO_REMOVABLE ) ? L"SFGAO_REMOVABLE, " : L"" ),
-						( ( sfgao_flags & SFGAO_COMPRESSED ) ? L"SFGAO_COMPRESSED, " : L"" ),
-						( ( sfgao_flags & SFGAO_BROWSABLE ) ? L"SFGAO_BROWSABLE, " : L"" ),
-						( ( sfgao_flags & SFGAO_NONENUMERATED ) ? L"SFGAO_NONENUMERATED, " : L"" ),
-						( ( sfgao_flags & SFGAO_NEWCONTENT ) ? L"SFGAO_NEWCONTENT, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANMONIKER ) ? L"SFGAO_CANMONIKER / SFGAO_HASSTORAGE / SFGAO_STREAM, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGEANCESTOR ) ? L"SFGAO_STORAGEANCESTOR, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGECAPMASK ) ? L"SFGAO_STORAGECAPMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_PKEYSFGAOMASK ) ? L"SFGAO_PKEYSFGAOMASK" : L"" ) );
-
-	ret = ( wchar_t * )malloc( sizeof( wchar_t ) * ( size + 1 ) );
-
-	size = swprintf_s( ret, size + 1, L"%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
-						( ( sfgao_flags & SFGAO_CANCOPY ) ? L"SFGAO_CANCOPY, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANMOVE ) ? L"SFGAO_CANMOVE, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANLINK ) ? L"SFGAO_CANLINK, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGE ) ? L"SFGAO_STORAGE, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANRENAME ) ? L"SFGAO_CANRENAME, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANDELETE ) ? L"SFGAO_CANDELETE, " : L"" ),
-						( ( sfgao_flags & SFGAO_HASPROPSHEET ) ? L"SFGAO_HASPROPSHEET, " : L"" ),
-						( ( sfgao_flags & SFGAO_DROPTARGET ) ? L"SFGAO_DROPTARGET, " : L"" ),
-						( ( sfgao_flags & SFGAO_CAPABILITYMASK ) ? L"SFGAO_CAPABILITYMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_ENCRYPTED ) ? L"SFGAO_ENCRYPTED, " : L"" ),
-						( ( sfgao_flags & SFGAO_ISSLOW ) ? L"SFGAO_ISSLOW, " : L"" ),
-						( ( sfgao_flags & SFGAO_GHOSTED ) ? L"SFGAO_GHOSTED, " : L"" ),
-						( ( sfgao_flags & SFGAO_LINK ) ? L"SFGAO_LINK, " : L"" ),
-						( ( sfgao_flags & SFGAO_SHARE ) ? L"SFGAO_SHARE, " : L"" ),
-						( ( sfgao_flags & SFGAO_READONLY ) ? L"SFGAO_READONLY, " : L"" ),
-						( ( sfgao_flags & SFGAO_HIDDEN ) ? L"SFGAO_HIDDEN, " : L"" ),
-						( ( sfgao_flags & SFGAO_DISPLAYATTRMASK ) ? L"SFGAO_DISPLAYATTRMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_FILESYSANCESTOR ) ? L"SFGAO_FILESYSANCESTOR, " : L"" ),
-						( ( sfgao_flags & SFGAO_FOLDER ) ? L"SFGAO_FOLDER, " : L"" ),
-						( ( sfgao_flags & SFGAO_FILESYSTEM ) ? L"SFGAO_FILESYSTEM, " : L"" ),
-						( ( sfgao_flags & SFGAO_HASSUBFOLDER ) ? L"SFGAO_HASSUBFOLDER / SFGAO_CONTENTSMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_VALIDATE ) ? L"SFGAO_VALIDATE, " : L"" ),
-						( ( sfgao_flags & SFGAO_REMOVABLE ) ? L"SFGAO_REMOVABLE, " : L"" ),
-						( ( sfgao_flags & SFGAO_COMPRESSED ) ? L"SFGAO_COMPRESSED, " : L"" ),
-						( ( sfgao_flags & SFGAO_BROWSABLE ) ? L"SFGAO_BROWSABLE, " : L"" ),
-						( ( sfgao_flags & SFGAO_NONENUMERATED ) ? L"SFGAO_NONENUMERATED, " : L"" ),
-						( ( sfgao_flags & SFGAO_NEWCONTENT ) ? L"SFGAO_NEWCONTENT, " : L"" ),
-						( ( sfgao_flags & SFGAO_CANMONIKER ) ? L"SFGAO_CANMONIKER / SFGAO_HASSTORAGE / SFGAO_STREAM, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGEANCESTOR ) ? L"SFGAO_STORAGEANCESTOR, " : L"" ),
-						( ( sfgao_flags & SFGAO_STORAGECAPMASK ) ? L"SFGAO_STORAGECAPMASK, " : L"" ),
-						( ( sfgao_flags & SFGAO_PKEYSFGAOMASK ) ? L"SFGAO_PKEYSFGAOMASK" : L"" ) );
-
-	// Remove any trailing ", ".
-	if ( size > 1 && ret[ size - 1 ] == L' ' )
-	{
-		ret[ size - 2 ] = L'\0';
-	}
-
-	return ret;
-}
-
-wchar_t *GetFileAttributesStr( unsigned long fa_flags )
-{
-	wchar_t *ret = NULL;
-	if ( fa_flags == 0 )
-	{
-		ret = ( wchar_t * )malloc( sizeof( wchar_t ) * 5 );
-		wmemcpy_s( ret, 5, L"None\0", 5 );
-	}
-	else
-	{
-		int size = _scwprintf( L"%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
-							( ( fa_flags & FILE_ATTRIBUTE_READONLY ) ? L"FILE_ATTRIBUTE_READONLY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_HIDDEN ) ? L"FILE_ATTRIBUTE_HIDDEN, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_SYSTEM ) ? L"FILE_ATTRIBUTE_SYSTEM, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_DIRECTORY ) ? L"FILE_ATTRIBUTE_DIRECTORY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_ARCHIVE ) ? L"FILE_ATTRIBUTE_ARCHIVE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_DEVICE ) ? L"FILE_ATTRIBUTE_DEVICE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_NORMAL ) ? L"FILE_ATTRIBUTE_NORMAL, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_TEMPORARY ) ? L"FILE_ATTRIBUTE_TEMPORARY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_SPARSE_FILE ) ? L"FILE_ATTRIBUTE_SPARSE_FILE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_REPARSE_POINT ) ? L"FILE_ATTRIBUTE_REPARSE_POINT, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_COMPRESSED ) ? L"FILE_ATTRIBUTE_COMPRESSED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_OFFLINE ) ? L"FILE_ATTRIBUTE_OFFLINE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED ) ? L"FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_ENCRYPTED ) ? L"FILE_ATTRIBUTE_ENCRYPTED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_VIRTUAL ) ? L"FILE_ATTRIBUTE_VIRTUAL" : L"" ) );
-
-		ret = ( wchar_t * )malloc( sizeof( wchar_t ) * ( size + 1 ) );
-
-		size = swprintf_s( ret, size + 1, L"%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s",
-							( ( fa_flags & FILE_ATTRIBUTE_READONLY ) ? L"FILE_ATTRIBUTE_READONLY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_HIDDEN ) ? L"FILE_ATTRIBUTE_HIDDEN, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_SYSTEM ) ? L"FILE_ATTRIBUTE_SYSTEM, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_DIRECTORY ) ? L"FILE_ATTRIBUTE_DIRECTORY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_ARCHIVE ) ? L"FILE_ATTRIBUTE_ARCHIVE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_DEVICE ) ? L"FILE_ATTRIBUTE_DEVICE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_NORMAL ) ? L"FILE_ATTRIBUTE_NORMAL, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_TEMPORARY ) ? L"FILE_ATTRIBUTE_TEMPORARY, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_SPARSE_FILE ) ? L"FILE_ATTRIBUTE_SPARSE_FILE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_REPARSE_POINT ) ? L"FILE_ATTRIBUTE_REPARSE_POINT, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_COMPRESSED ) ? L"FILE_ATTRIBUTE_COMPRESSED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_OFFLINE ) ? L"FILE_ATTRIBUTE_OFFLINE, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED ) ? L"FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_ENCRYPTED ) ? L"FILE_ATTRIBUTE_ENCRYPTED, " : L"" ),
-							( ( fa_flags & FILE_ATTRIBUTE_VIRTUAL ) ? L"FILE_ATTRIBUTE_VIRTUAL" : L"" ) );
-
-		// Remove any trailing ", ".
-		if ( size > 1 && ret[ size - 1 ] == L' ' )
+// A flag and the name that it's written as.
+struct FLAG_NAME
+{
+	unsigned long flag;
+	const wchar_t *name;
+	unsigned int name_length;
+};
+
+#define FLAG_NAME_ENTRY( flag, name ) { flag, name, ( sizeof( name ) / sizeof( wchar_t ) ) - 1 }
+
+static const FLAG_NAME g_sfgao_names[] =
+{
+	FLAG_NAME_ENTRY( SFGAO_CANCOPY, L"SFGAO_CANCOPY" ),
+	FLAG_NAME_ENTRY( SFGAO_CANMOVE, L"SFGAO_CANMOVE" ),
+	FLAG_NAME_ENTRY( SFGAO_CANLINK, L"SFGAO_CANLINK" ),
+	FLAG_NAME_ENTRY( SFGAO_STORAGE, L"SFGAO_STORAGE" ),
+	FLAG_NAME_ENTRY( SFGAO_CANRENAME, L"SFGAO_CANRENAME" ),
+	FLAG_NAME_ENTRY( SFGAO_CANDELETE, L"SFGAO_CANDELETE" ),
+	FLAG_NAME_ENTRY( SFGAO_HASPROPSHEET, L"SFGAO_HASPROPSHEET" ),
+	FLAG_NAME_ENTRY( SFGAO_DROPTARGET, L"SFGAO_DROPTARGET" ),
+	FLAG_NAME_ENTRY( SFGAO_CAPABILITYMASK, L"SFGAO_CAPABILITYMASK" ),
+	FLAG_NAME_ENTRY( SFGAO_ENCRYPTED, L"SFGAO_ENCRYPTED" ),
+	FLAG_NAME_ENTRY( SFGAO_ISSLOW, L"SFGAO_ISSLOW" ),
+	FLAG_NAME_ENTRY( SFGAO_GHOSTED, L"SFGAO_GHOSTED" ),
+	FLAG_NAME_ENTRY( SFGAO_LINK, L"SFGAO_LINK" ),
+	FLAG_NAME_ENTRY( SFGAO_SHARE, L"SFGAO_SHARE" ),
+	FLAG_NAME_ENTRY( SFGAO_READONLY, L"SFGAO_READONLY" ),
+	FLAG_NAME_ENTRY( SFGAO_HIDDEN, L"SFGAO_HIDDEN" ),
+	FLAG_NAME_ENTRY( SFGAO_DISPLAYATTRMASK, L"SFGAO_DISPLAYATTRMASK" ),
+	FLAG_NAME_ENTRY( SFGAO_FILESYSANCESTOR, L"SFGAO_FILESYSANCESTOR" ),
+	FLAG_NAME_ENTRY( SFGAO_FOLDER, L"SFGAO_FOLDER" ),
+	FLAG_NAME_ENTRY( SFGAO_FILESYSTEM, L"SFGAO_FILESYSTEM" ),
+	FLAG_NAME_ENTRY( SFGAO_HASSUBFOLDER, L"SFGAO_HASSUBFOLDER / SFGAO_CONTENTSMASK" ),
+	FLAG_NAME_ENTRY( SFGAO_VALIDATE, L"SFGAO_VALIDATE" ),
+	FLAG_NAME_ENTRY( SFGAO_REMOVABLE, L"SFGAO_REMOVABLE" ),
+	FLAG_NAME_ENTRY( SFGAO_COMPRESSED, L"SFGAO_COMPRESSED" ),
+	FLAG_NAME_ENTRY( SFGAO_BROWSABLE, L"SFGAO_BROWSABLE" ),
+	FLAG_NAME_ENTRY( SFGAO_NONENUMERATED, L"SFGAO_NONENUMERATED" ),
+	FLAG_NAME_ENTRY( SFGAO_NEWCONTENT, L"SFGAO_NEWCONTENT" ),
+	FLAG_NAME_ENTRY( SFGAO_CANMONIKER, L"SFGAO_CANMONIKER / SFGAO_HASSTORAGE / SFGAO_STREAM" ),
+	FLAG_NAME_ENTRY( SFGAO_STORAGEANCESTOR, L"SFGAO_STORAGEANCESTOR" ),
+	FLAG_NAME_ENTRY( SFGAO_STORAGECAPMASK, L"SFGAO_STORAGECAPMASK" ),
+	FLAG_NAME_ENTRY( SFGAO_PKEYSFGAOMASK, L"SFGAO_PKEYSFGAOMASK" )
+};
+
+static const FLAG_NAME g_file_attribute_names[] =
+{
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_READONLY, L"FILE_ATTRIBUTE_READONLY" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_HIDDEN, L"FILE_ATTRIBUTE_HIDDEN" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_SYSTEM, L"FILE_ATTRIBUTE_SYSTEM" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_DIRECTORY, L"FILE_ATTRIBUTE_DIRECTORY" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_ARCHIVE, L"FILE_ATTRIBUTE_ARCHIVE" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_DEVICE, L"FILE_ATTRIBUTE_DEVICE" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_NORMAL, L"FILE_ATTRIBUTE_NORMAL" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_TEMPORARY, L"FILE_ATTRIBUTE_TEMPORARY" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_SPARSE_FILE, L"FILE_ATTRIBUTE_SPARSE_FILE" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_REPARSE_POINT, L"FILE_ATTRIBUTE_REPARSE_POINT" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_COMPRESSED, L"FILE_ATTRIBUTE_COMPRESSED" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_OFFLINE, L"FILE_ATTRIBUTE_OFFLINE" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_NOT_CONTENT_INDEXED, L"FILE_ATTRIBUTE_NOT_CONTENT_INDEXED" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_ENCRYPTED, L"FILE_ATTRIBUTE_ENCRYPTED" ),
+	FLAG_NAME_ENTRY( FILE_ATTRIBUTE_VIRTUAL, L"FILE_ATTRIBUTE_VIRTUAL" )
+};
+
+// A Windows Property whose value isn't formatted by its type alone.
+struct PROPERTY_FORMAT_NAME
+{
+	const wchar_t *name;
+	unsigned long name_length;
+	unsigned char format;
+};
+
+#define PROPERTY_FORMAT_ENTRY( name, format ) { name, ( sizeof( name ) / sizeof( wchar_t ) ) - 1, format }
+
+static const PROPERTY_FORMAT_NAME g_property_formats[] =
+{
+	PROPERTY_FORMAT_ENTRY( L"System_FileAttributes", PROPERTY_FORMAT_FILE_ATTRIBUTES ),
+	PROPERTY_FORMAT_ENTRY( L"System_SFGAOFlags", PROPERTY_FORMAT_SFGAO ),
+	PROPERTY_FORMAT_ENTRY( L"System_Link_TargetSFGAOFlags", PROPERTY_FORMAT_SFGAO ),
+	PROPERTY_FORMAT_ENTRY( L"System_Size", PROPERTY_FORMAT_SIZE ),
+	PROPERTY_FORMAT_ENTRY( L"System_ThumbnailCacheId", PROPERTY_FORMAT_CACHE_ID ),
+	PROPERTY_FORMAT_ENTRY( L"System_Kind", PROPERTY_FORMAT_KIND ),
+	PROPERTY_FORMAT_ENTRY( L"InvertedOnlyMD5", PROPERTY_FORMAT_INVERTED_MD5 ),
+	PROPERTY_FORMAT_ENTRY( L"InvertedOnlyPids", PROPERTY_FORMAT_INVERTED_PIDS )
+};
+
+static const wchar_t g_hex_digits[] = L"0123456789abcdef";
+
+// Classifies a Windows Property once so that its values don't have to compare its name. name_length excludes the NULL character.
+unsigned char GetPropertyFormat( const wchar_t *name, unsigned long name_length )
+{
+	for ( unsigned int i = 0; i < ( sizeof( g_property_formats ) / sizeof( g_property_formats[ 0 ] ) ); ++i )
+	{
+		if ( g_property_formats[ i ].name_length == name_length && wcsncmp( g_property_formats[ i ].name, name, name_length ) == 0 )
+		{
+			return g_property_formats[ i ].format;
+		}
+	}
+
+	return PROPERTY_FORMAT_NONE;
+}
+
+// Makes room for length more bytes plus a UTF-16 NULL character.
+bool BufferReserve( OUTPUT_BUFFER *ob, unsigned int length )
+{
+	if ( ob->length + length + sizeof( wchar_t ) > ob->size )
+	{
+		unsigned int size = max( ob->size * 2, ob->length + length + sizeof( wchar_t ) );
+		size = max( size, 4096 );
+
+		char *realloc_buffer = ( char * )realloc( ob->buffer, sizeof( char ) * size );
+		if ( realloc_buffer == NULL )
+		{
+			return false;
+		}
+
+		ob->buffer = realloc_buffer;
+		ob->size = size;
+	}
+
+	return true;
+}
+
+bool BufferWrite( OUTPUT_BUFFER *ob, const void *data, unsigned int length )
+{
+	if ( !BufferReserve( ob, length ) )
+	{
+		return false;
+	}
+
+	memcpy( ob->buffer + ob->length, data, length );
+	ob->length += length;
+
+	return true;
+}
+
+bool BufferPrintf( OUTPUT_BUFFER *ob, const char *format, ... )
+{
+	va_list arg_list;
+
+	va_start( arg_list, format );
+	int length = _vscprintf( format, arg_list );
+	va_end( arg_list );
+
+	if ( length < 0 || !BufferReserve( ob, length + 1 ) )
+	{
+		return false;
+	}
+
+	va_start( arg_list, format );
+	length = vsprintf_s( ob->buffer + ob->length, ob->size - ob->length, format, arg_list );
+	va_end( arg_list );
+
+	ob->length += length;	// Excludes the NULL character.
+
+	return true;
+}
+
+// The buffer is always NULL terminated so that it can be written with fputws.
+bool BufferPrintfW( OUTPUT_BUFFER *ob, const wchar_t *format, ... )
+{
+	va_list arg_list;
+
+	va_start( arg_list, format );
+	int length = _vscwprintf( format, arg_list );
+	va_end( arg_list );
+
+	if ( length < 0 || !BufferReserve( ob, sizeof( wchar_t ) * ( length + 1 ) ) )
+	{
+		return false;
+	}
+
+	va_start( arg_list, format );
+	length = vswprintf_s( ( wchar_t * )( ob->buffer + ob->length ), ( ob->size - ob->length ) / sizeof( wchar_t ), format, arg_list );
+	va_end( arg_list );
+
+	ob->length += ( sizeof( wchar_t ) * length );	// Excludes the NULL character.
+
+	return true;
+}
+
+// The Buffer*W functions below write UTF-16 characters without a NULL character. Room for one is always reserved.
+bool BufferWriteW( OUTPUT_BUFFER *ob, const wchar_t *str, unsigned int length )
+{
+	return BufferWrite( ob, str, sizeof( wchar_t ) * length );
+}
+
+bool BufferWriteUnsignedW( OUTPUT_BUFFER *ob, unsigned long long value )
+{
+	wchar_t digits[ 20 ];
+	unsigned int i = 20;
+
+	do
+	{
+		digits[ --i ] = ( wchar_t )( L'0' + ( value % 10 ) );
+		value /= 10;
+	}
+	while ( value != 0 );
+
+	return BufferWriteW( ob, digits + i, 20 - i );
+}
+
+bool BufferWriteSignedW( OUTPUT_BUFFER *ob, long long value )
+{
+	if ( value < 0 )
+	{
+		// Negate as unsigned so that the smallest value doesn't overflow.
+		return BufferWriteW( ob, L"-", 1 ) && BufferWriteUnsignedW( ob, 0 - ( unsigned long long )value );
+	}
+
+	return BufferWriteUnsignedW( ob, ( unsigned long long )value );
+}
+
+// Writes the lowest digits of value as lowercase hex, padded with zeros.
+bool BufferWriteHexW( OUTPUT_BUFFER *ob, unsigned long long value, unsigned int digits )
+{
+	if ( !BufferReserve( ob, sizeof( wchar_t ) * digits ) )
+	{
+		return false;
+	}
+
+	wchar_t *buffer = ( wchar_t * )( ob->buffer + ob->length );
+	for ( unsigned int i = digits; i > 0; --i )
+	{
+		buffer[ i - 1 ] = g_hex_digits[ value & 0x0F ];
+		value >>= 4;
+	}
+
+	ob->length += ( sizeof( wchar_t ) * digits );
+
+	return true;
+}
+
+bool BufferWriteHexBytesW( OUTPUT_BUFFER *ob, const unsigned char *data, unsigned long length )
+{
+	if ( !BufferReserve( ob, sizeof( wchar_t ) * length * 2 ) )
+	{
+		return false;
+	}
+
+	wchar_t *buffer = ( wchar_t * )( ob->buffer + ob->length );
+	for ( unsigned long i = 0; i < length; ++i )
+	{
+		*buffer++ = g_hex_digits[ data[ i ] >> 4 ];
+		*buffer++ = g_hex_digits[ data[ i ] & 0x0F ];
+	}
+
+	ob->length += ( sizeof( wchar_t ) * length * 2 );
+
+	return true;
+}
+
+// Writes 16 bytes as {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}. The first three fields are little-endian.
+bool BufferWriteGUIDW( OUTPUT_BUFFER *ob, const unsigned char *data )
+{
+	unsigned long val_1 = 0;
+	unsigned short val_2 = 0, val_3 = 0;
+
+	memcpy_s( &val_1, sizeof( unsigned long ), data, sizeof( unsigned long ) );
+	memcpy_s( &val_2, sizeof( unsigned short ), data + sizeof( unsigned long ), sizeof( unsigned short ) );
+	memcpy_s( &val_3, sizeof( unsigned short ), data + sizeof( unsigned long ) + sizeof( unsigned short ), sizeof( unsigned short ) );
+
+	return ( BufferWriteW( ob, L"{", 1 ) &&
+			 BufferWriteHexW( ob, val_1, 8 ) && BufferWriteW( ob, L"-", 1 ) &&
+			 BufferWriteHexW( ob, val_2, 4 ) && BufferWriteW( ob, L"-", 1 ) &&
+			 BufferWriteHexW( ob, val_3, 4 ) && BufferWriteW( ob, L"-", 1 ) &&
+			 BufferWriteHexBytesW( ob, data + 8, 2 ) && BufferWriteW( ob, L"-", 1 ) &&
+			 BufferWriteHexBytesW( ob, data + 10, 6 ) && BufferWriteW( ob, L"}", 1 ) );
+}
+
+// Writes a FILETIME as M/D/YYYY (hh:mm:ss.ms) [UTC] without calling FileTimeToSystemTime.
+bool BufferWriteFileTimeW( OUTPUT_BUFFER *ob, unsigned long long filetime )
+{
+	unsigned long long seconds = filetime / 10000000ULL;
+	unsigned int milliseconds = ( unsigned int )( ( filetime / 10000ULL ) % 1000 );
+	unsigned int second_of_day = ( unsigned int )( seconds % 86400 );
+
+	// Convert the days since January 1, 1601 into a civil date. The year is counted from March so that the leap day is the last day of the year.
+	unsigned long long days = ( seconds / 86400 ) + 584694;	// Days since March 1, 0000.
+	unsigned long long era = days / 146097;
+	unsigned int day_of_era = ( unsigned int )( days - ( era * 146097 ) );
+	unsigned int year_of_era = ( day_of_era - ( day_of_era / 1460 ) + ( day_of_era / 36524 ) - ( day_of_era / 146096 ) ) / 365;
+	unsigned int day_of_year = day_of_era - ( ( 365 * year_of_era ) + ( year_of_era / 4 ) - ( year_of_era / 100 ) );
+	unsigned int month_index = ( ( 5 * day_of_year ) + 2 ) / 153;
+	unsigned int day = day_of_year - ( ( ( 153 * month_index ) + 2 ) / 5 ) + 1;
+	unsigned int month = ( month_index < 10 ? month_index + 3 : month_index - 9 );
+	unsigned long long year = year_of_era + ( era * 400 ) + ( month <= 2 ? 1 : 0 );
+
+	if ( !( BufferWriteUnsignedW( ob, month ) && BufferWriteW( ob, L"/", 1 ) &&
+			BufferWriteUnsignedW( ob, day ) && BufferWriteW( ob, L"/", 1 ) &&
+			BufferWriteUnsignedW( ob, year ) && BufferWriteW( ob, L" (", 2 ) &&
+			BufferReserve( ob, sizeof( wchar_t ) * 8 ) ) )
+	{
+		return false;
+	}
+
+	wchar_t *buffer = ( wchar_t * )( ob->buffer + ob->length );
+	unsigned int hour = second_of_day / 3600, minute = ( second_of_day / 60 ) % 60, second = second_of_day % 60;
+	buffer[ 0 ] = ( wchar_t )( L'0' + ( hour / 10 ) );
+	buffer[ 1 ] = ( wchar_t )( L'0' + ( hour % 10 ) );
+	buffer[ 2 ] = L':';
+	buffer[ 3 ] = ( wchar_t )( L'0' + ( minute / 10 ) );
+	buffer[ 4 ] = ( wchar_t )( L'0' + ( minute % 10 ) );
+	buffer[ 5 ] = L':';
+	buffer[ 6 ] = ( wchar_t )( L'0' + ( second / 10 ) );
+	buffer[ 7 ] = ( wchar_t )( L'0' + ( second % 10 ) );
+	ob->length += ( sizeof( wchar_t ) * 8 );
+
+	return ( BufferWriteW( ob, L".", 1 ) && BufferWriteUnsignedW( ob, milliseconds ) && BufferWriteW( ob, L") [UTC]", 7 ) );
+}
+
+// Writes the names of the flags that are set, separated by ", ". 0 is written as "None".
+bool BufferWriteFlagsW( OUTPUT_BUFFER *ob, unsigned long flags, const FLAG_NAME *names, unsigned int name_count )
+{
+	if ( flags == 0 )
+	{
+		return BufferWriteW( ob, L"None", 4 );
+	}
+
+	bool first = true;
+	for ( unsigned int i = 0; i < name_count; ++i )
+	{
+		if ( flags & names[ i ].flag )
+		{
+			if ( ( !first && !BufferWriteW( ob, L", ", 2 ) ) || !BufferWriteW( ob, names[ i ].name, names[ i ].name_length ) )
+			{
+				return false;
+			}
+
+			first = false;
+		}
+	}
+
+	return true;
+}
+
+bool BufferWriteSFGAOW( OUTPUT_BUFFER *ob, unsigned long sfgao_flags )
+{
+	return BufferWriteFlagsW( ob, sfgao_flags, g_sfgao_names, sizeof( g_sfgao_names ) / sizeof( g_sfgao_names[ 0 ] ) );
+}
+
+bool BufferWriteFileAttributesW( OUTPUT_BUFFER *ob, unsigned long fa_flags )
+{
+	return BufferWriteFlagsW( ob, fa_flags, g_file_attribute_names, sizeof( g_file_attribute_names ) / sizeof( g_file_attribute_names[ 0 ] ) );
+}
+
+// Writes the UTF-16 characters in data with each NULL character replaced by a ';' separator. length is in characters.
+// data doesn't have to be aligned.
+bool BufferWriteStringListW( OUTPUT_BUFFER *ob, const unsigned char *data, unsigned int length )
+{
+	if ( !BufferReserve( ob, sizeof( wchar_t ) * length ) )
+	{
+		return false;
+	}
+
+	wchar_t *buffer = ( wchar_t * )( ob->buffer + ob->length );
+	memcpy_s( buffer, sizeof( wchar_t ) * length, data, sizeof( wchar_t ) * length );
+
+	for ( unsigned int i = 0; i < length; ++i )
+	{
+		if ( buffer[ i ] == 0 )
 		{
-			ret[ size - 2 ] = L'\0';
+			buffer[ i ] = L';';
 		}
 	}
 
-	return ret;
+	ob->length += ( sizeof( wchar_t ) * length );
+
+	return true;
+}
+
+void FreeBuffer( OUTPUT_BUFFER *ob )
+{
+	free( ob->buffer );
+	ob->buffer = NULL;
+	ob->length = 0;
+	ob->size = 0;
 }
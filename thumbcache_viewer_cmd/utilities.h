@@ -28,7 +28,32 @@
 
 #define ntohll( i ) ( ( ( __int64 )ntohl( i & 0xFFFFFFFFU ) << 32 ) | ntohl( ( __int64 )( i >> 32 ) ) )
 
-wchar_t *GetFileAttributesStr( unsigned long fa_flags );
-wchar_t *GetSFGAOStr( unsigned long sfgao_flags );
+// How a Windows Property's value is formatted beyond what its type implies.
+#define PROPERTY_FORMAT_NONE			0
+#define PROPERTY_FORMAT_FILE_ATTRIBUTES	1	// System_FileAttributes
+#define PROPERTY_FORMAT_SFGAO			2	// System_SFGAOFlags and System_Link_TargetSFGAOFlags
+#define PROPERTY_FORMAT_SIZE			3	// System_Size
+#define PROPERTY_FORMAT_CACHE_ID		4	// System_ThumbnailCacheId
+#define PROPERTY_FORMAT_KIND			5	// System_Kind
+#define PROPERTY_FORMAT_INVERTED_MD5	6	// InvertedOnlyMD5
+#define PROPERTY_FORMAT_INVERTED_PIDS	7	// InvertedOnlyPids
+
+unsigned char GetPropertyFormat( const wchar_t *name, unsigned long name_length );
+
+bool BufferReserve( OUTPUT_BUFFER *ob, unsigned int length );
+bool BufferWrite( OUTPUT_BUFFER *ob, const void *data, unsigned int length );
+bool BufferPrintf( OUTPUT_BUFFER *ob, const char *format, ... );
+bool BufferPrintfW( OUTPUT_BUFFER *ob, const wchar_t *format, ... );
+bool BufferWriteW( OUTPUT_BUFFER *ob, const wchar_t *str, unsigned int length );
+bool BufferWriteUnsignedW( OUTPUT_BUFFER *ob, unsigned long long value );
+bool BufferWriteSignedW( OUTPUT_BUFFER *ob, long long value );
+bool BufferWriteHexW( OUTPUT_BUFFER *ob, unsigned long long value, unsigned int digits );
+bool BufferWriteHexBytesW( OUTPUT_BUFFER *ob, const unsigned char *data, unsigned long length );
+bool BufferWriteGUIDW( OUTPUT_BUFFER *ob, const unsigned char *data );
+bool BufferWriteFileTimeW( OUTPUT_BUFFER *ob, unsigned long long filetime );
+bool BufferWriteSFGAOW( OUTPUT_BUFFER *ob, unsigned long sfgao_flags );
+bool BufferWriteFileAttributesW( OUTPUT_BUFFER *ob, unsigned long fa_flags );
+bool BufferWriteStringListW( OUTPUT_BUFFER *ob, const unsigned char *data, unsigned int length );
+void FreeBuffer( OUTPUT_BUFFER *ob );
 
 #endif